@@ -0,0 +1,209 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "FittingComponent.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fitting Stats Flush"), STAT_FittingStatsFlush, STATGROUP_Inventory);
+
+UFittingComponent::UFittingComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UFittingComponent::BeginPlay()
+{
+	MaxSlots = SlotLayout.Num();
+
+	Super::BeginPlay();
+
+	ResizeSlotModifiers();
+
+	for (const TPair<FName, float>& BaseStat : BaseStats)
+	{
+		StatGraph.SetBaseValue(BaseStat.Key, BaseStat.Value);
+	}
+
+	// Pick up anything fitted before play started
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		ApplySlotModifiers(i);
+	}
+
+	RequestStatsFlush();
+}
+
+void UFittingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(FlushTimerHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+float UFittingComponent::GetStatValue(FName Stat)
+{
+	return StatGraph.GetValue(Stat);
+}
+
+void UFittingComponent::SetBaseStat(FName Stat, float Value)
+{
+	BaseStats.Add(Stat, Value);
+	StatGraph.SetBaseValue(Stat, Value);
+	RequestStatsFlush();
+}
+
+EFittingSlotType UFittingComponent::GetSlotType(int32 SlotIndex) const
+{
+	return SlotLayout.IsValidIndex(SlotIndex) ? SlotLayout[SlotIndex] : EFittingSlotType::None;
+}
+
+bool UFittingComponent::FitItem(UInventoryComponent* SourceInventory, int32 SourceSlot, int32& OutFittingSlot)
+{
+	OutFittingSlot = -1;
+
+	if (!SourceInventory || SourceInventory->IsSlotEmpty(SourceSlot))
+	{
+		return false;
+	}
+
+	const FInventoryItem Item = SourceInventory->GetItemAtSlot(SourceSlot);
+	const int32 FreeSlot = FindEmptySlotForItem(Item.ItemData);
+	if (FreeSlot == -1)
+	{
+		return false;
+	}
+
+	// Fit a single module out of the stack
+	if (!SourceInventory->TransferItem(SourceSlot, this, FreeSlot, 1))
+	{
+		return false;
+	}
+
+	OutFittingSlot = FreeSlot;
+	return true;
+}
+
+bool UFittingComponent::UnfitItem(int32 FittingSlot, UInventoryComponent* TargetInventory)
+{
+	if (!TargetInventory || IsSlotEmpty(FittingSlot))
+	{
+		return false;
+	}
+
+	const int32 FreeSlot = TargetInventory->FindEmptySlotForItem(Items[FittingSlot].ItemData);
+	if (FreeSlot == -1)
+	{
+		return false;
+	}
+
+	return TransferItem(FittingSlot, TargetInventory, FreeSlot);
+}
+
+bool UFittingComponent::CanPlaceItemInSlot(const UInventoryItemData* ItemData, int32 SlotIndex) const
+{
+	if (!ItemData || !SlotLayout.IsValidIndex(SlotIndex))
+	{
+		return false;
+	}
+
+	return ItemData->FittingSlot != EFittingSlotType::None && ItemData->FittingSlot == SlotLayout[SlotIndex];
+}
+
+void UFittingComponent::SortInventory(bool bByName)
+{
+	UE_LOG(LogOutercorp, Verbose, TEXT("Sorting is not supported on fitting component '%s'"), *GetNameSafe(this));
+}
+
+void UFittingComponent::NotifySlotChanged(int32 SlotIndex)
+{
+	ApplySlotModifiers(SlotIndex);
+	RequestStatsFlush();
+
+	Super::NotifySlotChanged(SlotIndex);
+}
+
+void UFittingComponent::NotifyCapacityChanged()
+{
+	ResizeSlotModifiers();
+	RequestStatsFlush();
+
+	Super::NotifyCapacityChanged();
+}
+
+void UFittingComponent::ResizeSlotModifiers()
+{
+	for (int32 i = Items.Num(); i < SlotModifiers.Num(); ++i)
+	{
+		for (FStatModifierHandle& Handle : SlotModifiers[i])
+		{
+			StatGraph.RemoveModifier(Handle);
+		}
+	}
+	SlotModifiers.SetNum(Items.Num());
+}
+
+void UFittingComponent::ApplySlotModifiers(int32 SlotIndex)
+{
+	// Replicated slots may grow the array without a capacity change
+	if (SlotModifiers.Num() != Items.Num())
+	{
+		ResizeSlotModifiers();
+	}
+
+	if (!SlotModifiers.IsValidIndex(SlotIndex))
+	{
+		return;
+	}
+
+	TArray<FStatModifierHandle>& Handles = SlotModifiers[SlotIndex];
+	for (FStatModifierHandle& Handle : Handles)
+	{
+		StatGraph.RemoveModifier(Handle);
+	}
+	Handles.Reset();
+
+	const FInventoryItem& Item = Items[SlotIndex];
+	if (!Item.IsValid())
+	{
+		return;
+	}
+
+	for (const FItemStatModifier& Modifier : Item.ItemData->StatModifiers)
+	{
+		FStatModifierHandle Handle = StatGraph.AddModifier(Modifier);
+		if (Handle.IsValid())
+		{
+			Handles.Add(Handle);
+		}
+	}
+}
+
+void UFittingComponent::RequestStatsFlush()
+{
+	UWorld* World = GetWorld();
+	if (!World || !StatGraph.HasPendingChanges() || FlushTimerHandle.IsValid())
+	{
+		return;
+	}
+
+	FlushTimerHandle = World->GetTimerManager().SetTimerForNextTick(this, &UFittingComponent::FlushStats);
+}
+
+void UFittingComponent::FlushStats()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FittingStatsFlush);
+
+	FlushTimerHandle.Invalidate();
+
+	TArray<FName> ChangedStats;
+	StatGraph.Evaluate(&ChangedStats);
+
+	if (ChangedStats.Num() > 0)
+	{
+		OnStatsChanged.Broadcast(ChangedStats);
+	}
+}
@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryComponent.h"
+#include "StatModifierGraph.h"
+#include "FittingComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFittingStatsChanged, const TArray<FName>&, ChangedStats);
+
+/**
+ * Inventory of typed fitting slots that turns fitted modules and weapons into stats
+ * Each slot only accepts items whose FittingSlot matches the layout, and holds a single module
+ * however far the item would stack elsewhere. Fitted item modifiers
+ * feed a FStatModifierGraph, so a fit change recomputes only the stats it touches.
+ * Change notifications are coalesced and broadcast once per frame.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class OUTERCORP_API UFittingComponent : public UInventoryComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFittingComponent();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	/** Slot type of each fitting slot, defines MaxSlots */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fitting")
+	TArray<EFittingSlotType> SlotLayout;
+
+	/** Unmodified stat values (hull attributes) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Fitting")
+	TMap<FName, float> BaseStats;
+
+	/** Called once per frame with the stats whose value changed */
+	UPROPERTY(BlueprintAssignable, Category = "Fitting")
+	FOnFittingStatsChanged OnStatsChanged;
+
+	/** Get the current value of a stat */
+	UFUNCTION(BlueprintCallable, Category = "Fitting")
+	float GetStatValue(FName Stat);
+
+	/** Set the unmodified value of a stat */
+	UFUNCTION(BlueprintCallable, Category = "Fitting")
+	void SetBaseStat(FName Stat, float Value);
+
+	/** Get slot type of a fitting slot */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Fitting")
+	EFittingSlotType GetSlotType(int32 SlotIndex) const;
+
+	/** Fit an item from another inventory into the first compatible free slot */
+	UFUNCTION(BlueprintCallable, Category = "Fitting")
+	bool FitItem(UInventoryComponent* SourceInventory, int32 SourceSlot, int32& OutFittingSlot);
+
+	/** Move a fitted item back into another inventory */
+	UFUNCTION(BlueprintCallable, Category = "Fitting")
+	bool UnfitItem(int32 FittingSlot, UInventoryComponent* TargetInventory);
+
+	virtual bool CanPlaceItemInSlot(const UInventoryItemData* ItemData, int32 SlotIndex) const override;
+
+	/** One module per slot, so stacking, merges and transfers never fit several into one */
+	virtual int32 GetMaxStackSize(const UInventoryItemData* ItemData) const override { return 1; }
+
+	/** The slot count is fixed by SlotLayout */
+	virtual bool IsCapacityAllowed(int32 NumSlots) const override { return NumSlots == SlotLayout.Num(); }
+
+	/** Fitting slots have fixed positions, sorting is not supported */
+	virtual void SortInventory(bool bByName = true) override;
+
+protected:
+	virtual void NotifySlotChanged(int32 SlotIndex) override;
+	virtual void NotifyCapacityChanged() override;
+
+	/** Match SlotModifiers to the slot array, removing the modifiers of slots that no longer exist */
+	void ResizeSlotModifiers();
+
+	/** Replace the modifiers contributed by a slot with those of its current item */
+	void ApplySlotModifiers(int32 SlotIndex);
+
+	/** Schedule a stats flush for the end of this frame */
+	void RequestStatsFlush();
+
+	/** Evaluate dirty stats and broadcast changes */
+	void FlushStats();
+
+private:
+	FStatModifierGraph StatGraph;
+
+	/** Modifier handles contributed by each slot */
+	TArray<TArray<FStatModifierHandle>> SlotModifiers;
+
+	FTimerHandle FlushTimerHandle;
+};
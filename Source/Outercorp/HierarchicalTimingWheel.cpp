@@ -0,0 +1,187 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HierarchicalTimingWheel.h"
+
+FHierarchicalTimingWheel::FHierarchicalTimingWheel()
+{
+	BucketHeads.Init(INDEX_NONE, NumLevels * BucketsPerLevel);
+}
+
+FTimingWheelHandle FHierarchicalTimingWheel::Schedule(const FGuid& Key, int32 Tag, uint64 ExpiryTick)
+{
+	// A timer always fires on a future tick, and never further out than the top level covers
+	ExpiryTick = FMath::Clamp(ExpiryTick, CurrentTick + 1, CurrentTick + MaxDelayTicks);
+
+	int32 NodeIndex = FreeHead;
+	if (NodeIndex != INDEX_NONE)
+	{
+		FreeHead = Nodes[NodeIndex].Next;
+	}
+	else
+	{
+		NodeIndex = Nodes.AddDefaulted();
+	}
+
+	FNode& Node = Nodes[NodeIndex];
+	Node.Key = Key;
+	Node.Tag = Tag;
+	Node.ExpiryTick = ExpiryTick;
+
+	Insert(NodeIndex);
+	++NumPending;
+
+	FTimingWheelHandle Handle;
+	Handle.Index = NodeIndex;
+	Handle.Generation = Node.Generation;
+	return Handle;
+}
+
+bool FHierarchicalTimingWheel::Cancel(FTimingWheelHandle& Handle)
+{
+	if (!IsHandleLive(Handle))
+	{
+		Handle.Invalidate();
+		return false;
+	}
+
+	Unlink(Handle.Index);
+	Release(Handle.Index);
+	--NumPending;
+
+	Handle.Invalidate();
+	return true;
+}
+
+uint64 FHierarchicalTimingWheel::GetExpiryTick(const FTimingWheelHandle& Handle) const
+{
+	return IsHandleLive(Handle) ? Nodes[Handle.Index].ExpiryTick : 0;
+}
+
+void FHierarchicalTimingWheel::Advance(uint64 TargetTick, TArray<FTimingWheelEntry>& OutFired)
+{
+	while (CurrentTick < TargetTick)
+	{
+		// Nothing pending - skip straight to the target instead of walking empty buckets
+		if (NumPending == 0)
+		{
+			CurrentTick = TargetTick;
+			return;
+		}
+
+		++CurrentTick;
+
+		// Pull the next window of each higher level down once the level below wraps
+		for (int32 Level = 1; Level < NumLevels; ++Level)
+		{
+			const uint64 LowerMask = (uint64(1) << (Level * BitsPerLevel)) - 1;
+			if ((CurrentTick & LowerMask) != 0)
+			{
+				break;
+			}
+			Cascade(Level);
+		}
+
+		// Fire everything in the current level 0 bucket
+		int32& Head = BucketHeads[static_cast<int32>(CurrentTick & (BucketsPerLevel - 1))];
+		while (Head != INDEX_NONE)
+		{
+			const int32 NodeIndex = Head;
+			const FNode& Node = Nodes[NodeIndex];
+
+			FTimingWheelEntry& Entry = OutFired.AddDefaulted_GetRef();
+			Entry.Key = Node.Key;
+			Entry.Tag = Node.Tag;
+			Entry.ExpiryTick = Node.ExpiryTick;
+
+			Unlink(NodeIndex);
+			Release(NodeIndex);
+			--NumPending;
+		}
+	}
+}
+
+void FHierarchicalTimingWheel::Reset(uint64 NewCurrentTick)
+{
+	check(NumPending == 0);
+	CurrentTick = NewCurrentTick;
+}
+
+void FHierarchicalTimingWheel::Insert(int32 NodeIndex)
+{
+	FNode& Node = Nodes[NodeIndex];
+	const uint64 Delta = Node.ExpiryTick > CurrentTick ? Node.ExpiryTick - CurrentTick : 0;
+
+	int32 Level = 0;
+	while (Level < NumLevels - 1 && Delta >= (uint64(1) << ((Level + 1) * BitsPerLevel)))
+	{
+		++Level;
+	}
+
+	const uint64 BucketTick = Delta == 0 ? CurrentTick : Node.ExpiryTick;
+	const int32 Slot = static_cast<int32>((BucketTick >> (Level * BitsPerLevel)) & (BucketsPerLevel - 1));
+	const int32 Bucket = Level * BucketsPerLevel + Slot;
+
+	Node.Bucket = Bucket;
+	Node.Prev = INDEX_NONE;
+	Node.Next = BucketHeads[Bucket];
+	if (Node.Next != INDEX_NONE)
+	{
+		Nodes[Node.Next].Prev = NodeIndex;
+	}
+	BucketHeads[Bucket] = NodeIndex;
+}
+
+void FHierarchicalTimingWheel::Unlink(int32 NodeIndex)
+{
+	FNode& Node = Nodes[NodeIndex];
+
+	if (Node.Prev != INDEX_NONE)
+	{
+		Nodes[Node.Prev].Next = Node.Next;
+	}
+	else
+	{
+		BucketHeads[Node.Bucket] = Node.Next;
+	}
+
+	if (Node.Next != INDEX_NONE)
+	{
+		Nodes[Node.Next].Prev = Node.Prev;
+	}
+
+	Node.Prev = INDEX_NONE;
+	Node.Next = INDEX_NONE;
+	Node.Bucket = INDEX_NONE;
+}
+
+void FHierarchicalTimingWheel::Release(int32 NodeIndex)
+{
+	FNode& Node = Nodes[NodeIndex];
+	++Node.Generation;
+	Node.Bucket = INDEX_NONE;
+	Node.Next = FreeHead;
+	FreeHead = NodeIndex;
+}
+
+void FHierarchicalTimingWheel::Cascade(int32 Level)
+{
+	const int32 Slot = static_cast<int32>((CurrentTick >> (Level * BitsPerLevel)) & (BucketsPerLevel - 1));
+	int32& Head = BucketHeads[Level * BucketsPerLevel + Slot];
+
+	int32 NodeIndex = Head;
+	Head = INDEX_NONE;
+
+	while (NodeIndex != INDEX_NONE)
+	{
+		const int32 NextIndex = Nodes[NodeIndex].Next;
+		Insert(NodeIndex);
+		NodeIndex = NextIndex;
+	}
+}
+
+bool FHierarchicalTimingWheel::IsHandleLive(const FTimingWheelHandle& Handle) const
+{
+	return Nodes.IsValidIndex(Handle.Index)
+		&& Nodes[Handle.Index].Generation == Handle.Generation
+		&& Nodes[Handle.Index].Bucket != INDEX_NONE;
+}
@@ -0,0 +1,110 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Handle to a timer scheduled in a FHierarchicalTimingWheel
+ * Generation guards against reuse of the underlying node
+ */
+struct FTimingWheelHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Generation = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; Generation = 0; }
+
+	bool operator==(const FTimingWheelHandle& Other) const
+	{
+		return Index == Other.Index && Generation == Other.Generation;
+	}
+};
+
+/**
+ * Timer that fired during FHierarchicalTimingWheel::Advance
+ */
+struct FTimingWheelEntry
+{
+	/** Identity the timer was scheduled for */
+	FGuid Key;
+
+	/** Caller defined discriminator (timer type, job kind, ...) */
+	int32 Tag = 0;
+
+	/** Tick the timer was due on */
+	uint64 ExpiryTick = 0;
+};
+
+/**
+ * Hierarchical timing wheel (Varghese & Lauck)
+ * Four levels of 256 buckets give O(1) schedule/cancel and amortised O(1) expiry
+ * for delays up to 2^32 ticks. Nodes live in a pooled array with intrusive lists,
+ * so scheduling thousands of timers does not allocate once the pool is warm.
+ */
+class OUTERCORP_API FHierarchicalTimingWheel
+{
+public:
+	static constexpr int32 NumLevels = 4;
+	static constexpr int32 BitsPerLevel = 8;
+	static constexpr int32 BucketsPerLevel = 1 << BitsPerLevel;
+	static constexpr uint64 MaxDelayTicks = (uint64(1) << (NumLevels * BitsPerLevel)) - 1;
+
+	FHierarchicalTimingWheel();
+
+	/** Schedule a timer to fire on ExpiryTick (clamped to at least one tick from now) */
+	FTimingWheelHandle Schedule(const FGuid& Key, int32 Tag, uint64 ExpiryTick);
+
+	/** Cancel a pending timer, returns false if it already fired or was cancelled */
+	bool Cancel(FTimingWheelHandle& Handle);
+
+	/** Tick a pending timer is due on, or 0 if the handle is stale */
+	uint64 GetExpiryTick(const FTimingWheelHandle& Handle) const;
+
+	/** Advance the wheel up to and including TargetTick, appending fired timers in tick order */
+	void Advance(uint64 TargetTick, TArray<FTimingWheelEntry>& OutFired);
+
+	/** Jump the wheel to a new tick, only valid while no timers are pending */
+	void Reset(uint64 NewCurrentTick);
+
+	/** Current wheel tick */
+	uint64 GetCurrentTick() const { return CurrentTick; }
+
+	/** Number of pending timers */
+	int32 Num() const { return NumPending; }
+
+	bool IsEmpty() const { return NumPending == 0; }
+
+private:
+	struct FNode
+	{
+		FGuid Key;
+		uint64 ExpiryTick = 0;
+		int32 Tag = 0;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		int32 Bucket = INDEX_NONE;
+		uint32 Generation = 1;
+	};
+
+	/** Link a node into the bucket matching its expiry relative to CurrentTick */
+	void Insert(int32 NodeIndex);
+
+	/** Unlink a node from its bucket */
+	void Unlink(int32 NodeIndex);
+
+	/** Return a node to the free list */
+	void Release(int32 NodeIndex);
+
+	/** Re-insert every node of a higher level bucket into lower levels */
+	void Cascade(int32 Level);
+
+	bool IsHandleLive(const FTimingWheelHandle& Handle) const;
+
+	TArray<FNode> Nodes;
+	TArray<int32> BucketHeads;
+	int32 FreeHead = INDEX_NONE;
+	int32 NumPending = 0;
+	uint64 CurrentTick = 0;
+};
@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "InventoryItemData.h"
+#include "IndustryRecipe.generated.h"
+
+/**
+ * Data asset describing a manufacturing or refining process
+ */
+UCLASS(BlueprintType)
+class OUTERCORP_API UIndustryRecipe : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Display name shown in UI */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Industry")
+	FText RecipeName;
+
+	/** Items consumed per run */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Industry")
+	TArray<FItemQuantity> Inputs;
+
+	/** Items produced per run */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Industry")
+	TArray<FItemQuantity> Outputs;
+
+	/** Seconds per run */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Industry", meta = (ClampMin = "0"))
+	float Duration = 60.0f;
+};
@@ -0,0 +1,499 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IndustrySubsystem.h"
+#include "IndustryRecipe.h"
+#include "InventoryComponent.h"
+#include "InventoryHangarSubsystem.h"
+#include "InventorySaveSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Industry Complete Jobs"), STAT_IndustryCompleteJobs, STATGROUP_Inventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Industry Jobs Running"), STAT_IndustryJobsRunning, STATGROUP_Inventory);
+
+void UIndustrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Wheel.Reset(GetWorldTick());
+
+	TearDownHandle = FWorldDelegates::OnWorldBeginTearDown.AddUObject(this, &UIndustrySubsystem::HandleWorldBeginTearDown);
+}
+
+void UIndustrySubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldBeginTearDown.Remove(TearDownHandle);
+
+	// Normally done at teardown; what is left can only reach the inventories' stores now
+	bInventoriesEnded = true;
+	ReturnJobItems();
+
+	for (const TPair<FGuid, FIndustryJob>& Pair : Jobs)
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("Industry shut down with %d undelivered stacks on job %s"), Pair.Value.PendingOutputs.Num(), *Pair.Key.ToString());
+	}
+
+	Jobs.Empty();
+	ActiveRecipes.Empty();
+
+	Super::Deinitialize();
+}
+
+void UIndustrySubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IndustryCompleteJobs);
+
+	DueEntries.Reset();
+	Wheel.Advance(GetWorldTick(), DueEntries);
+
+	SET_DWORD_STAT(STAT_IndustryJobsRunning, Wheel.Num());
+
+	if (DueEntries.Num() == 0)
+	{
+		return;
+	}
+
+	// Group finished jobs by destination so each inventory gets one bulk insert
+	TMap<UInventoryComponent*, TArray<FGuid>> JobsByDestination;
+	TArray<FGuid> OrphanedJobs;
+
+	for (const FTimingWheelEntry& Entry : DueEntries)
+	{
+		FIndustryJob* Job = Jobs.Find(Entry.Key);
+		if (!Job)
+		{
+			continue;
+		}
+
+		Job->TimerHandle.Invalidate();
+		Job->State = EIndustryJobState::Ready;
+
+		if (const UIndustryRecipe* Recipe = Job->Recipe.Get())
+		{
+			// StartJob checked these fit in int32
+			for (const FItemQuantity& Output : Recipe->Outputs)
+			{
+				AddQuantity(Job->PendingOutputs, Output.ItemData, Output.Quantity * Job->Runs);
+			}
+		}
+
+		if (UInventoryComponent* Destination = Job->Destination.Get())
+		{
+			JobsByDestination.FindOrAdd(Destination).Add(Entry.Key);
+		}
+		else
+		{
+			OrphanedJobs.Add(Entry.Key);
+		}
+	}
+
+	TArray<FIndustryJobEvent> Events;
+	Events.Reserve(DueEntries.Num());
+
+	auto AddEvent = [this, &Events](const FGuid& JobID)
+	{
+		const FIndustryJob& Job = Jobs.FindChecked(JobID);
+
+		FIndustryJobEvent& Event = Events.AddDefaulted_GetRef();
+		Event.JobID = JobID;
+		Event.Recipe = Job.Recipe.Get();
+		Event.State = Job.PendingOutputs.Num() == 0 ? EIndustryJobState::Delivered : EIndustryJobState::Ready;
+	};
+
+	for (const TPair<UInventoryComponent*, TArray<FGuid>>& Pair : JobsByDestination)
+	{
+		DeliverOutputs(Pair.Key, Pair.Value);
+
+		for (const FGuid& JobID : Pair.Value)
+		{
+			AddEvent(JobID);
+			if (Jobs[JobID].PendingOutputs.Num() == 0)
+			{
+				RemoveJob(JobID);
+			}
+		}
+	}
+
+	// Jobs whose destination is gone stay Ready until delivered elsewhere
+	for (const FGuid& JobID : OrphanedJobs)
+	{
+		AddEvent(JobID);
+		if (Jobs[JobID].PendingOutputs.Num() == 0)
+		{
+			RemoveJob(JobID);
+		}
+	}
+
+	OnJobsCompleted.Broadcast(Events);
+}
+
+ETickableTickType UIndustrySubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UIndustrySubsystem::IsTickable() const
+{
+	return !Wheel.IsEmpty();
+}
+
+TStatId UIndustrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UIndustrySubsystem, STATGROUP_Tickables);
+}
+
+FGuid UIndustrySubsystem::StartJob(UIndustryRecipe* Recipe, UInventoryComponent* SourceInventory, UInventoryComponent* DestinationInventory, int32 Runs)
+{
+	if (!Recipe || !SourceInventory || !DestinationInventory || Runs <= 0)
+	{
+		return FGuid();
+	}
+
+	// Totals that don't fit in int32 would wrap, reserving nothing or delivering a negative stack
+	TArray<FItemQuantity> Required;
+	TArray<FItemQuantity> Produced;
+	if (!ScaleByRuns(Recipe->Inputs, Runs, Required) || !ScaleByRuns(Recipe->Outputs, Runs, Produced))
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("Industry job of %d runs of '%s' refused, its quantities overflow"), Runs, *GetNameSafe(Recipe));
+		return FGuid();
+	}
+
+	// Check every input before taking any, so a failed start leaves the source untouched
+	if (!SourceInventory->CanModifyContents())
+	{
+		return FGuid();
+	}
+
+	for (const FItemQuantity& Input : Required)
+	{
+		if (SourceInventory->GetItemCount(Input.ItemData) < Input.Quantity)
+		{
+			return FGuid();
+		}
+	}
+
+	// A job without its inputs reserved would make its outputs out of nothing, put back what was taken if any removal fails
+	for (int32 i = 0; i < Required.Num(); ++i)
+	{
+		if (SourceInventory->RemoveItems(Required[i].ItemData, Required[i].Quantity))
+		{
+			continue;
+		}
+
+		TArray<FItemQuantity> Taken(Required.GetData(), i);
+		DeliverItems(SourceInventory, SourceInventory->Storage == EInventoryStorage::Hangar ? SourceInventory->PersistenceKey : NAME_None, Taken);
+		if (Taken.Num() > 0)
+		{
+			UE_LOG(LogOutercorp, Error, TEXT("Industry job could not reserve its inputs in '%s', and %d stacks taken could not be put back"), *GetNameSafe(SourceInventory), Taken.Num());
+		}
+		return FGuid();
+	}
+
+	const uint64 NowTick = GetWorldTick();
+	if (Wheel.IsEmpty())
+	{
+		Wheel.Reset(NowTick);
+	}
+
+	const FGuid JobID = FGuid::NewGuid();
+	const uint64 DurationTicks = FMath::Max<uint64>(1, FMath::CeilToInt64(Recipe->Duration * Runs / TickInterval));
+
+	FIndustryJob& Job = Jobs.Add(JobID);
+	Job.Recipe = Recipe;
+	Job.Source = SourceInventory;
+	Job.Destination = DestinationInventory;
+	Job.SourceHangarKey = SourceInventory->Storage == EInventoryStorage::Hangar ? SourceInventory->PersistenceKey : NAME_None;
+	Job.DestinationHangarKey = DestinationInventory->Storage == EInventoryStorage::Hangar ? DestinationInventory->PersistenceKey : NAME_None;
+	Job.Runs = Runs;
+	Job.TimerHandle = Wheel.Schedule(JobID, 0, NowTick + DurationTicks);
+
+	++ActiveRecipes.FindOrAdd(Recipe);
+
+	return JobID;
+}
+
+bool UIndustrySubsystem::CancelJob(FGuid JobID)
+{
+	FIndustryJob* Job = Jobs.Find(JobID);
+	if (!Job || Job->State != EIndustryJobState::Running)
+	{
+		return false;
+	}
+
+	Wheel.Cancel(Job->TimerHandle);
+
+	// Inputs were taken when the job started, they are owed back like outputs would have been
+	Job->State = EIndustryJobState::Cancelled;
+	Job->PendingOutputs.Reset();
+	if (const UIndustryRecipe* Recipe = Job->Recipe.Get())
+	{
+		for (const FItemQuantity& Input : Recipe->Inputs)
+		{
+			AddQuantity(Job->PendingOutputs, Input.ItemData, Input.Quantity * Job->Runs);
+		}
+	}
+
+	RefundInputs(JobID);
+	return true;
+}
+
+bool UIndustrySubsystem::DeliverJob(FGuid JobID)
+{
+	FIndustryJob* Job = Jobs.Find(JobID);
+	if (Job && Job->State == EIndustryJobState::Cancelled)
+	{
+		return RefundInputs(JobID);
+	}
+
+	if (!Job || Job->State != EIndustryJobState::Ready)
+	{
+		return false;
+	}
+
+	UInventoryComponent* Destination = Job->Destination.Get();
+	if (Destination && !bInventoriesEnded)
+	{
+		DeliverOutputs(Destination, MakeArrayView(&JobID, 1));
+	}
+
+	// A hangar destination takes the rest in its database, even once its inventory is gone
+	DeliverItems(bInventoriesEnded ? Destination : nullptr, Job->DestinationHangarKey, Job->PendingOutputs);
+
+	if (Job->PendingOutputs.Num() == 0)
+	{
+		RemoveJob(JobID);
+		return true;
+	}
+	return false;
+}
+
+EIndustryJobState UIndustrySubsystem::GetJobState(FGuid JobID) const
+{
+	const FIndustryJob* Job = Jobs.Find(JobID);
+	return Job ? Job->State : EIndustryJobState::None;
+}
+
+float UIndustrySubsystem::GetJobRemainingTime(FGuid JobID) const
+{
+	const FIndustryJob* Job = Jobs.Find(JobID);
+	if (!Job || Job->State != EIndustryJobState::Running)
+	{
+		return 0.0f;
+	}
+
+	const uint64 ExpiryTick = Wheel.GetExpiryTick(Job->TimerHandle);
+	const uint64 NowTick = GetWorldTick();
+	return ExpiryTick > NowTick ? static_cast<float>(ExpiryTick - NowTick) * TickInterval : 0.0f;
+}
+
+uint64 UIndustrySubsystem::GetWorldTick() const
+{
+	const UWorld* World = GetWorld();
+	const double WorldTime = World ? World->GetTimeSeconds() : 0.0;
+	return static_cast<uint64>(WorldTime / TickInterval);
+}
+
+bool UIndustrySubsystem::ScaleByRuns(TConstArrayView<FItemQuantity> PerRun, int32 Runs, TArray<FItemQuantity>& OutTotals)
+{
+	TArray<int64, TInlineAllocator<8>> Totals;
+	OutTotals.Reset();
+	for (const FItemQuantity& Item : PerRun)
+	{
+		if (!Item.ItemData || Item.Quantity <= 0)
+		{
+			continue;
+		}
+
+		const int32 Index = OutTotals.IndexOfByPredicate([&Item](const FItemQuantity& Other)
+		{
+			return Other.ItemData == Item.ItemData;
+		});
+
+		if (Index == INDEX_NONE)
+		{
+			OutTotals.Emplace(Item.ItemData, 0);
+			Totals.Add(static_cast<int64>(Item.Quantity) * Runs);
+		}
+		else
+		{
+			Totals[Index] += static_cast<int64>(Item.Quantity) * Runs;
+		}
+	}
+
+	for (int32 i = 0; i < Totals.Num(); ++i)
+	{
+		if (Totals[i] > MAX_int32)
+		{
+			return false;
+		}
+		OutTotals[i].Quantity = static_cast<int32>(Totals[i]);
+	}
+	return true;
+}
+
+void UIndustrySubsystem::AddQuantity(TArray<FItemQuantity>& Items, UInventoryItemData* ItemData, int32 Quantity)
+{
+	if (!ItemData || Quantity <= 0)
+	{
+		return;
+	}
+
+	FItemQuantity* Existing = Items.FindByPredicate([ItemData](const FItemQuantity& Other)
+	{
+		return Other.ItemData == ItemData;
+	});
+
+	if (Existing)
+	{
+		Existing->Quantity += Quantity;
+	}
+	else
+	{
+		Items.Emplace(ItemData, Quantity);
+	}
+}
+
+void UIndustrySubsystem::DeliverOutputs(UInventoryComponent* Destination, TConstArrayView<FGuid> JobIDs)
+{
+	TArray<FItemQuantity> Delivery;
+	for (const FGuid& JobID : JobIDs)
+	{
+		for (const FItemQuantity& Output : Jobs[JobID].PendingOutputs)
+		{
+			AddQuantity(Delivery, Output.ItemData, Output.Quantity);
+		}
+	}
+
+	TArray<FItemQuantity> Rejected;
+	Destination->AddItems(Delivery, Rejected);
+
+	// Attribute anything that did not fit back to the most recent jobs, the rest are delivered
+	for (int32 i = JobIDs.Num() - 1; i >= 0; --i)
+	{
+		FIndustryJob& Job = Jobs[JobIDs[i]];
+		TArray<FItemQuantity> StillPending;
+
+		for (const FItemQuantity& Output : Job.PendingOutputs)
+		{
+			FItemQuantity* Shortfall = Rejected.FindByPredicate([&Output](const FItemQuantity& Other)
+			{
+				return Other.ItemData == Output.ItemData && Other.Quantity > 0;
+			});
+
+			if (Shortfall)
+			{
+				const int32 Undelivered = FMath::Min(Shortfall->Quantity, Output.Quantity);
+				Shortfall->Quantity -= Undelivered;
+				StillPending.Emplace(Output.ItemData, Undelivered);
+			}
+		}
+
+		Job.PendingOutputs = MoveTemp(StillPending);
+		Job.State = Job.PendingOutputs.Num() == 0 ? EIndustryJobState::Delivered : EIndustryJobState::Ready;
+	}
+}
+
+bool UIndustrySubsystem::RefundInputs(const FGuid& JobID)
+{
+	FIndustryJob& Job = Jobs.FindChecked(JobID);
+
+	DeliverItems(Job.Source.Get(), Job.SourceHangarKey, Job.PendingOutputs);
+
+	if (Job.PendingOutputs.Num() > 0)
+	{
+		if (Job.Source.IsValid())
+		{
+			UE_LOG(LogOutercorp, Verbose, TEXT("Refund of cancelled industry job to '%s' deferred, %d stacks did not fit"), *GetNameSafe(Job.Source.Get()), Job.PendingOutputs.Num());
+		}
+		else
+		{
+			UE_LOG(LogOutercorp, Warning, TEXT("Source of a cancelled industry job is gone, keeping %d refund stacks on the job"), Job.PendingOutputs.Num());
+		}
+		return false;
+	}
+
+	RemoveJob(JobID);
+	return true;
+}
+
+void UIndustrySubsystem::DeliverItems(UInventoryComponent* Inventory, FName HangarKey, TArray<FItemQuantity>& Items)
+{
+	const UGameInstance* GameInstance = GetWorld()->GetGameInstance();
+
+	if (Inventory && Items.Num() > 0)
+	{
+		TArray<FItemQuantity> Rejected;
+		if (!bInventoriesEnded)
+		{
+			Inventory->AddItems(Items, Rejected);
+			Items = MoveTemp(Rejected);
+		}
+		else if (Inventory->Storage == EInventoryStorage::SaveFile)
+		{
+			// Its actor has ended play, so the change would not be journaled: save it with the items
+			UInventorySaveSubsystem* Saves = GameInstance ? GameInstance->GetSubsystem<UInventorySaveSubsystem>() : nullptr;
+			if (Saves && Saves->DeliverItems(Inventory, Items, Rejected))
+			{
+				Items = MoveTemp(Rejected);
+			}
+		}
+	}
+
+	// A hangar takes the rest in its database, whether it is full, still loading or unloaded
+	UInventoryHangarSubsystem* Hangars = GameInstance ? GameInstance->GetSubsystem<UInventoryHangarSubsystem>() : nullptr;
+	if (Items.Num() > 0 && !HangarKey.IsNone() && Hangars && Hangars->DeliverItems(HangarKey, Items))
+	{
+		Items.Reset();
+	}
+}
+
+void UIndustrySubsystem::RemoveJob(const FGuid& JobID)
+{
+	FIndustryJob Job;
+	if (!Jobs.RemoveAndCopyValue(JobID, Job))
+	{
+		return;
+	}
+
+	// Retained by ActiveRecipes, so still alive here
+	UIndustryRecipe* Recipe = Job.Recipe.Get();
+	int32* NumJobs = Recipe ? ActiveRecipes.Find(Recipe) : nullptr;
+	if (NumJobs && --(*NumJobs) <= 0)
+	{
+		ActiveRecipes.Remove(Recipe);
+	}
+}
+
+void UIndustrySubsystem::ReturnJobItems()
+{
+	TArray<FGuid> JobIDs;
+	Jobs.GenerateKeyArray(JobIDs);
+
+	for (const FGuid& JobID : JobIDs)
+	{
+		switch (Jobs[JobID].State)
+		{
+		case EIndustryJobState::Running:
+			CancelJob(JobID);
+			break;
+		case EIndustryJobState::Cancelled:
+			RefundInputs(JobID);
+			break;
+		case EIndustryJobState::Ready:
+			DeliverJob(JobID);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void UIndustrySubsystem::HandleWorldBeginTearDown(UWorld* World)
+{
+	// Actors have not ended play yet, so inventories still journal and save what they are given
+	if (World == GetWorld())
+	{
+		ReturnJobItems();
+	}
+}
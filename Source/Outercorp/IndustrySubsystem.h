@@ -0,0 +1,171 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HierarchicalTimingWheel.h"
+#include "InventoryItemData.h"
+#include "IndustrySubsystem.generated.h"
+
+class UIndustryRecipe;
+class UInventoryComponent;
+
+/**
+ * State of an industry job
+ */
+UENUM(BlueprintType)
+enum class EIndustryJobState : uint8
+{
+	None		UMETA(DisplayName = "None"),
+	Running		UMETA(DisplayName = "Running"),
+	/** Finished, but the outputs did not fit in the destination yet */
+	Ready		UMETA(DisplayName = "Ready"),
+	Delivered	UMETA(DisplayName = "Delivered"),
+	/** Cancelled, but the refunded inputs did not fit in the source yet */
+	Cancelled	UMETA(DisplayName = "Cancelled")
+};
+
+/**
+ * Industry job that finished this frame
+ */
+USTRUCT(BlueprintType)
+struct FIndustryJobEvent
+{
+	GENERATED_BODY()
+
+	/** Job identifier */
+	UPROPERTY(BlueprintReadOnly, Category = "Industry")
+	FGuid JobID;
+
+	/** Recipe that was run */
+	UPROPERTY(BlueprintReadOnly, Category = "Industry")
+	TObjectPtr<UIndustryRecipe> Recipe;
+
+	/** Delivered or Ready (if the destination was full) */
+	UPROPERTY(BlueprintReadOnly, Category = "Industry")
+	EIndustryJobState State = EIndustryJobState::None;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnIndustryJobsCompleted, const TArray<FIndustryJobEvent>&, CompletedJobs);
+
+/**
+ * Scheduler for manufacturing and refining jobs
+ * Inputs are reserved (removed) from the source inventory when a job starts. Running jobs
+ * sit in a hierarchical timing wheel, so scheduling is O(1) and idle jobs cost nothing per
+ * frame. Jobs that come due together are completed as a batch with one AddItems call per
+ * destination inventory. When the world is torn down, running and cancelled jobs hand their
+ * inputs back and finished ones their outputs, before the inventories' actors end play.
+ */
+UCLASS()
+class OUTERCORP_API UIndustrySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	/** Called once per frame with every job that finished */
+	UPROPERTY(BlueprintAssignable, Category = "Industry")
+	FOnIndustryJobsCompleted OnJobsCompleted;
+
+	/** Reserve inputs for Runs runs of a recipe and start the job. Returns an invalid guid on failure, or if Runs scales a quantity past int32 */
+	UFUNCTION(BlueprintCallable, Category = "Industry")
+	FGuid StartJob(UIndustryRecipe* Recipe, UInventoryComponent* SourceInventory, UInventoryComponent* DestinationInventory, int32 Runs = 1);
+
+	/** Cancel a running job and return its inputs to the source inventory; what doesn't fit stays on the job as Cancelled */
+	UFUNCTION(BlueprintCallable, Category = "Industry")
+	bool CancelJob(FGuid JobID);
+
+	/** Retry delivery of a job that finished while its destination was full, or the refund of one cancelled while its source was */
+	UFUNCTION(BlueprintCallable, Category = "Industry")
+	bool DeliverJob(FGuid JobID);
+
+	/** Get job state */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Industry")
+	EIndustryJobState GetJobState(FGuid JobID) const;
+
+	/** Seconds until a running job finishes */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Industry")
+	float GetJobRemainingTime(FGuid JobID) const;
+
+	/** Number of running jobs */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Industry")
+	int32 GetNumRunningJobs() const { return Wheel.Num(); }
+
+	/** Number of recipes kept loaded by jobs */
+	int32 GetNumActiveRecipes() const { return ActiveRecipes.Num(); }
+
+	/** Wheel resolution in seconds */
+	static constexpr float TickInterval = 0.1f;
+
+protected:
+	struct FIndustryJob
+	{
+		TWeakObjectPtr<UIndustryRecipe> Recipe;
+		TWeakObjectPtr<UInventoryComponent> Source;
+		TWeakObjectPtr<UInventoryComponent> Destination;
+
+		/** Source's PersistenceKey if it is a hangar, refunds reach it through the hangar database then */
+		FName SourceHangarKey;
+
+		/** Destination's PersistenceKey if it is a hangar, outputs reach it through the hangar database then */
+		FName DestinationHangarKey;
+
+		int32 Runs = 1;
+		EIndustryJobState State = EIndustryJobState::Running;
+		FTimingWheelHandle TimerHandle;
+
+		/** Outputs not yet delivered, filled in when the job finishes; inputs not yet refunded once cancelled */
+		TArray<FItemQuantity> PendingOutputs;
+	};
+
+	uint64 GetWorldTick() const;
+
+	/** Add Quantity of an item type to a list, merging with an existing entry */
+	static void AddQuantity(TArray<FItemQuantity>& Items, UInventoryItemData* ItemData, int32 Quantity);
+
+	/** Quantities of Runs runs, merged per item type. False if any total doesn't fit in int32 */
+	static bool ScaleByRuns(TConstArrayView<FItemQuantity> PerRun, int32 Runs, TArray<FItemQuantity>& OutTotals);
+
+	/** Deliver the pending outputs of jobs sharing a destination with one bulk insert */
+	void DeliverOutputs(UInventoryComponent* Destination, TConstArrayView<FGuid> JobIDs);
+
+	/** Return the pending inputs of a cancelled job to its source, forgetting the job once all are back. True if they are */
+	bool RefundInputs(const FGuid& JobID);
+
+	/**
+	 * Add items to an inventory, or to the store behind it: a hangar's database takes what the inventory
+	 * doesn't, and saved inventories whose actor has ended play are saved with them. What's left stays in Items
+	 */
+	void DeliverItems(UInventoryComponent* Inventory, FName HangarKey, TArray<FItemQuantity>& Items);
+
+	/** Forget a job, releasing its recipe once no other job uses it */
+	void RemoveJob(const FGuid& JobID);
+
+	/** Cancel running jobs and hand back every job's inputs or outputs; jobs whose items found nowhere to go are kept */
+	void ReturnJobItems();
+
+	void HandleWorldBeginTearDown(UWorld* World);
+
+	/** Recipes referenced by jobs, with the number of jobs using each */
+	UPROPERTY()
+	TMap<TObjectPtr<UIndustryRecipe>, int32> ActiveRecipes;
+
+private:
+	FHierarchicalTimingWheel Wheel;
+	TMap<FGuid, FIndustryJob> Jobs;
+
+	/** Scratch buffer reused every frame */
+	TArray<FTimingWheelEntry> DueEntries;
+
+	/** Set in Deinitialize: inventories no longer store changes themselves, deliveries go through their stores */
+	bool bInventoriesEnded = false;
+
+	FDelegateHandle TearDownHandle;
+};
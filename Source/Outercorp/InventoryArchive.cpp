@@ -0,0 +1,539 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryArchive.h"
+#include "Algo/BinarySearch.h"
+#include "Misc/Compression.h"
+#include "Misc/Crc.h"
+
+namespace InventoryArchive
+{
+	namespace
+	{
+		constexpr uint32 Magic = 0x5649434F; // "OCIV"
+		constexpr uint32 JournalMagic = 0x4A49434F; // "OCIJ"
+		/** 1: slots without instance IDs, 2: slots carry their instance ID */
+		constexpr uint16 JournalVersion = 2;
+		constexpr uint16 JournalVersionInstanceIDs = 2;
+
+		enum EFlags : uint8
+		{
+			Flag_Compressed = 1 << 0
+		};
+
+		/** Payloads past this are treated as corrupt rather than allocated */
+		constexpr uint64 MaxPayloadSize = 64 * 1024 * 1024;
+
+		struct FWriter
+		{
+			TArray<uint8>& Bytes;
+
+			void WriteU8(uint8 Value)
+			{
+				Bytes.Add(Value);
+			}
+
+			void WriteU16(uint16 Value)
+			{
+				WriteU8(static_cast<uint8>(Value));
+				WriteU8(static_cast<uint8>(Value >> 8));
+			}
+
+			void WriteU32(uint32 Value)
+			{
+				WriteU16(static_cast<uint16>(Value));
+				WriteU16(static_cast<uint16>(Value >> 16));
+			}
+
+			/** LEB128, most quantities and indices fit in one byte */
+			void WriteVarInt(uint64 Value)
+			{
+				do
+				{
+					uint8 Byte = Value & 0x7F;
+					Value >>= 7;
+					if (Value)
+					{
+						Byte |= 0x80;
+					}
+					WriteU8(Byte);
+				}
+				while (Value);
+			}
+
+			void WriteGuid(const FGuid& Value)
+			{
+				WriteU32(Value.A);
+				WriteU32(Value.B);
+				WriteU32(Value.C);
+				WriteU32(Value.D);
+			}
+
+			void WriteString(const FString& Value)
+			{
+				const FTCHARToUTF8 Utf8(*Value);
+				WriteVarInt(Utf8.Length());
+				Bytes.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+			}
+		};
+
+		struct FReader
+		{
+			TConstArrayView<uint8> Bytes;
+			int32 Offset = 0;
+			bool bError = false;
+
+			uint8 ReadU8()
+			{
+				if (Offset >= Bytes.Num())
+				{
+					bError = true;
+					return 0;
+				}
+				return Bytes[Offset++];
+			}
+
+			uint16 ReadU16()
+			{
+				const uint16 Low = ReadU8();
+				return Low | (static_cast<uint16>(ReadU8()) << 8);
+			}
+
+			uint32 ReadU32()
+			{
+				const uint32 Low = ReadU16();
+				return Low | (static_cast<uint32>(ReadU16()) << 16);
+			}
+
+			FGuid ReadGuid()
+			{
+				const uint32 A = ReadU32();
+				const uint32 B = ReadU32();
+				const uint32 C = ReadU32();
+				return FGuid(A, B, C, ReadU32());
+			}
+
+			uint64 ReadVarInt()
+			{
+				uint64 Value = 0;
+				for (int32 Shift = 0; Shift < 64; Shift += 7)
+				{
+					const uint8 Byte = ReadU8();
+					Value |= static_cast<uint64>(Byte & 0x7F) << Shift;
+					if (!(Byte & 0x80))
+					{
+						return Value;
+					}
+				}
+				bError = true;
+				return 0;
+			}
+
+			/** Varint that must be a valid index or count below Limit */
+			int32 ReadIndex(int64 Limit)
+			{
+				const uint64 Value = ReadVarInt();
+				if (Value >= static_cast<uint64>(Limit))
+				{
+					bError = true;
+					return 0;
+				}
+				return static_cast<int32>(Value);
+			}
+
+			FString ReadString()
+			{
+				const int32 Length = ReadIndex(Bytes.Num() - Offset + 1);
+				if (bError)
+				{
+					return FString();
+				}
+
+				const FUTF8ToTCHAR Converted(reinterpret_cast<const UTF8CHAR*>(Bytes.GetData() + Offset), Length);
+				Offset += Length;
+				return FString(Converted.Length(), Converted.Get());
+			}
+		};
+
+		/** Interns strings so each name, item ID and metadata value is stored once */
+		struct FStringTable
+		{
+			TArray<FString> Strings;
+			TMap<FString, int32> Lookup;
+
+			int32 Add(const FString& Value)
+			{
+				if (const int32* Existing = Lookup.Find(Value))
+				{
+					return *Existing;
+				}
+				const int32 Index = Strings.Add(Value);
+				Lookup.Add(Value, Index);
+				return Index;
+			}
+		};
+
+		/** Slot indices and counts must stay below this; MaxSlots 0 (unknown) allows any index */
+		int64 GetSlotLimit(int32 MaxSlots)
+		{
+			return MaxSlots > 0 ? MaxSlots : MAX_int32;
+		}
+
+		void EncodePayload(const FInventorySnapshot& Snapshot, TArray<uint8>& OutPayload)
+		{
+			FStringTable Table;
+			const int32 KeyIndex = Table.Add(Snapshot.PersistenceKey.ToString());
+			for (const FInventorySnapshotSlot& Slot : Snapshot.Slots)
+			{
+				Table.Add(Slot.ItemID.ToString());
+				for (const TPair<FName, FString>& Pair : Slot.Metadata)
+				{
+					Table.Add(Pair.Key.ToString());
+					Table.Add(Pair.Value);
+				}
+			}
+
+			FWriter Writer{OutPayload};
+			Writer.WriteVarInt(Table.Strings.Num());
+			for (const FString& String : Table.Strings)
+			{
+				Writer.WriteString(String);
+			}
+
+			// A capacity the slots don't fit in would not decode, store it as unknown instead
+			int32 MaxSlots = FMath::Max(Snapshot.MaxSlots, 0);
+			if (Snapshot.Slots.Num() > 0 && Snapshot.Slots.Last().SlotIndex >= GetSlotLimit(MaxSlots))
+			{
+				MaxSlots = 0;
+			}
+
+			Writer.WriteVarInt(KeyIndex);
+			Writer.WriteVarInt(MaxSlots);
+			Writer.WriteVarInt(Snapshot.Slots.Num());
+
+			int32 NextSlot = 0;
+			for (const FInventorySnapshotSlot& Slot : Snapshot.Slots)
+			{
+				check(Slot.SlotIndex >= NextSlot && Slot.SlotIndex < GetSlotLimit(MaxSlots));
+				Writer.WriteVarInt(Slot.SlotIndex - NextSlot);
+				NextSlot = Slot.SlotIndex + 1;
+
+				Writer.WriteVarInt(Table.Lookup[Slot.ItemID.ToString()]);
+				Writer.WriteVarInt(FMath::Max(Slot.Quantity, 0));
+				Writer.WriteGuid(Slot.InstanceID);
+				Writer.WriteVarInt(Slot.Metadata.Num());
+				for (const TPair<FName, FString>& Pair : Slot.Metadata)
+				{
+					Writer.WriteVarInt(Table.Lookup[Pair.Key.ToString()]);
+					Writer.WriteVarInt(Table.Lookup[Pair.Value]);
+				}
+			}
+		}
+
+		bool DecodePayload(FReader& Reader, EVersion Version, FInventorySnapshot& OutSnapshot)
+		{
+			const int32 NumStrings = Reader.ReadIndex(Reader.Bytes.Num() + 1);
+			TArray<FString> Strings;
+			Strings.Reserve(NumStrings);
+			for (int32 i = 0; i < NumStrings && !Reader.bError; ++i)
+			{
+				Strings.Add(Reader.ReadString());
+			}
+
+			auto ReadString = [&Reader, &Strings]()
+			{
+				const int32 Index = Reader.ReadIndex(Strings.Num());
+				return Reader.bError ? FString() : Strings[Index];
+			};
+
+			OutSnapshot.PersistenceKey = FName(*ReadString());
+			OutSnapshot.MaxSlots = Reader.ReadIndex(MAX_int32);
+			const int64 SlotLimit = GetSlotLimit(OutSnapshot.MaxSlots);
+
+			const int32 NumSlots = Reader.ReadIndex(SlotLimit + 1);
+			OutSnapshot.Slots.Reset(NumSlots);
+
+			int64 NextSlot = 0;
+			for (int32 i = 0; i < NumSlots && !Reader.bError; ++i)
+			{
+				FInventorySnapshotSlot& Slot = OutSnapshot.Slots.AddDefaulted_GetRef();
+
+				const int64 SlotIndex = NextSlot + Reader.ReadIndex(SlotLimit - NextSlot);
+				Slot.SlotIndex = static_cast<int32>(SlotIndex);
+				NextSlot = SlotIndex + 1;
+
+				Slot.ItemID = FName(*ReadString());
+				Slot.Quantity = Reader.ReadIndex(MAX_int32);
+				if (Version >= EVersion::InstanceIDs)
+				{
+					Slot.InstanceID = Reader.ReadGuid();
+				}
+
+				const int32 NumMetadata = Reader.ReadIndex(Reader.Bytes.Num() + 1);
+				for (int32 j = 0; j < NumMetadata && !Reader.bError; ++j)
+				{
+					const FName Key(*ReadString());
+					Slot.Metadata.Emplace(Key, ReadString());
+				}
+			}
+
+			return !Reader.bError;
+		}
+
+		void EncodeSlot(FWriter& Writer, const FInventorySnapshotSlot& Slot)
+		{
+			Writer.WriteVarInt(FMath::Max(Slot.SlotIndex, 0));
+			Writer.WriteString(Slot.ItemID.ToString());
+			Writer.WriteVarInt(FMath::Max(Slot.Quantity, 0));
+			Writer.WriteGuid(Slot.InstanceID);
+			Writer.WriteVarInt(Slot.Metadata.Num());
+			for (const TPair<FName, FString>& Pair : Slot.Metadata)
+			{
+				Writer.WriteString(Pair.Key.ToString());
+				Writer.WriteString(Pair.Value);
+			}
+		}
+
+		void DecodeSlot(FReader& Reader, uint16 Version, FInventorySnapshotSlot& OutSlot)
+		{
+			OutSlot.SlotIndex = Reader.ReadIndex(MAX_int32);
+			OutSlot.ItemID = FName(*Reader.ReadString());
+			OutSlot.Quantity = Reader.ReadIndex(MAX_int32);
+			if (Version >= JournalVersionInstanceIDs)
+			{
+				OutSlot.InstanceID = Reader.ReadGuid();
+			}
+
+			const int32 NumMetadata = Reader.ReadIndex(Reader.Bytes.Num() + 1);
+			for (int32 i = 0; i < NumMetadata && !Reader.bError; ++i)
+			{
+				const FName Key(*Reader.ReadString());
+				OutSlot.Metadata.Emplace(Key, Reader.ReadString());
+			}
+		}
+	}
+
+	void Encode(const FInventorySnapshot& Snapshot, TArray<uint8>& OutBytes)
+	{
+		TArray<uint8> Payload;
+		EncodePayload(Snapshot, Payload);
+
+		// Oodle only pays off once the string table is sizeable, small inventories stay raw
+		TArray<uint8> Compressed;
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Oodle, Payload.Num());
+		Compressed.SetNumUninitialized(CompressedSize);
+		const bool bCompressed = FCompression::CompressMemory(NAME_Oodle, Compressed.GetData(), CompressedSize, Payload.GetData(), Payload.Num())
+			&& CompressedSize < Payload.Num();
+
+		OutBytes.Reset();
+		FWriter Writer{OutBytes};
+		Writer.WriteU32(Magic);
+		Writer.WriteU16(static_cast<uint16>(EVersion::Latest));
+		Writer.WriteU8(bCompressed ? Flag_Compressed : 0);
+		Writer.WriteVarInt(Payload.Num());
+
+		if (bCompressed)
+		{
+			OutBytes.Append(Compressed.GetData(), CompressedSize);
+		}
+		else
+		{
+			OutBytes.Append(Payload);
+		}
+	}
+
+	bool Decode(TConstArrayView<uint8> Bytes, FInventorySnapshot& OutSnapshot, FString& OutError)
+	{
+		FReader Header{Bytes};
+		if (Header.ReadU32() != Magic)
+		{
+			OutError = TEXT("not an inventory save");
+			return false;
+		}
+
+		const uint16 Version = Header.ReadU16();
+		const uint8 Flags = Header.ReadU8();
+		const uint64 PayloadSize = Header.ReadVarInt();
+		if (Header.bError || PayloadSize > MaxPayloadSize)
+		{
+			OutError = TEXT("truncated header");
+			return false;
+		}
+
+		TConstArrayView<uint8> Body = Bytes.RightChop(Header.Offset);
+
+		TArray<uint8> Uncompressed;
+		if (Flags & Flag_Compressed)
+		{
+			Uncompressed.SetNumUninitialized(static_cast<int32>(PayloadSize));
+			if (!FCompression::UncompressMemory(NAME_Oodle, Uncompressed.GetData(), Uncompressed.Num(), Body.GetData(), Body.Num()))
+			{
+				OutError = TEXT("decompression failed");
+				return false;
+			}
+			Body = Uncompressed;
+		}
+		else if (Body.Num() != static_cast<int32>(PayloadSize))
+		{
+			OutError = TEXT("payload size mismatch");
+			return false;
+		}
+
+		OutSnapshot = FInventorySnapshot();
+		FReader Reader{Body};
+
+		bool bDecoded = false;
+		switch (static_cast<EVersion>(Version))
+		{
+		case EVersion::Initial:
+		case EVersion::InstanceIDs:
+			bDecoded = DecodePayload(Reader, static_cast<EVersion>(Version), OutSnapshot);
+			break;
+		default:
+			OutError = FString::Printf(TEXT("unsupported version %u"), Version);
+			return false;
+		}
+
+		if (!bDecoded)
+		{
+			OutError = TEXT("corrupt payload");
+			return false;
+		}
+
+		return true;
+	}
+
+	void EncodeMetadata(TConstArrayView<TPair<FName, FString>> Metadata, TArray<uint8>& OutBytes)
+	{
+		FWriter Writer{OutBytes};
+		Writer.WriteVarInt(Metadata.Num());
+		for (const TPair<FName, FString>& Pair : Metadata)
+		{
+			Writer.WriteString(Pair.Key.ToString());
+			Writer.WriteString(Pair.Value);
+		}
+	}
+
+	bool DecodeMetadata(TConstArrayView<uint8> Bytes, TArray<TPair<FName, FString>>& OutMetadata)
+	{
+		FReader Reader{Bytes};
+		const int32 NumMetadata = Reader.ReadIndex(Bytes.Num() + 1);
+		for (int32 i = 0; i < NumMetadata && !Reader.bError; ++i)
+		{
+			const FName Key(*Reader.ReadString());
+			OutMetadata.Emplace(Key, Reader.ReadString());
+		}
+		return !Reader.bError;
+	}
+
+	void EncodeJournalHeader(TArray<uint8>& OutBytes)
+	{
+		FWriter Writer{OutBytes};
+		Writer.WriteU32(JournalMagic);
+		Writer.WriteU16(JournalVersion);
+	}
+
+	void EncodeJournalRecord(const FInventoryJournalRecord& Record, TArray<uint8>& OutBytes)
+	{
+		TArray<uint8> Payload;
+		FWriter PayloadWriter{Payload};
+		PayloadWriter.WriteU8(static_cast<uint8>(Record.Type));
+		PayloadWriter.WriteString(Record.PersistenceKey.ToString());
+		if (Record.Type == FInventoryJournalRecord::EType::SetSlot)
+		{
+			EncodeSlot(PayloadWriter, Record.Slot);
+		}
+		else
+		{
+			PayloadWriter.WriteVarInt(FMath::Max(Record.MaxSlots, 0));
+		}
+
+		FWriter Writer{OutBytes};
+		Writer.WriteU32(Payload.Num());
+		Writer.WriteU32(FCrc::MemCrc32(Payload.GetData(), Payload.Num()));
+		OutBytes.Append(Payload);
+	}
+
+	bool DecodeJournal(TConstArrayView<uint8> Bytes, TArray<FInventoryJournalRecord>& OutRecords)
+	{
+		// Segments left by an older build are still replayed
+		FReader Reader{Bytes};
+		const uint32 SegmentMagic = Reader.ReadU32();
+		const uint16 Version = Reader.ReadU16();
+		if (Reader.bError || SegmentMagic != JournalMagic || Version == 0 || Version > JournalVersion)
+		{
+			return false;
+		}
+
+		while (Reader.Offset < Bytes.Num())
+		{
+			const uint32 Size = Reader.ReadU32();
+			const uint32 Crc = Reader.ReadU32();
+			if (Reader.bError || Size > static_cast<uint32>(Bytes.Num() - Reader.Offset))
+			{
+				return false;
+			}
+
+			TConstArrayView<uint8> Payload = Bytes.Slice(Reader.Offset, Size);
+			if (FCrc::MemCrc32(Payload.GetData(), Payload.Num()) != Crc)
+			{
+				return false;
+			}
+			Reader.Offset += Size;
+
+			FReader RecordReader{Payload};
+			FInventoryJournalRecord Record;
+			const uint8 Type = RecordReader.ReadU8();
+			Record.PersistenceKey = FName(*RecordReader.ReadString());
+			switch (static_cast<FInventoryJournalRecord::EType>(Type))
+			{
+			case FInventoryJournalRecord::EType::SetSlot:
+				Record.Type = FInventoryJournalRecord::EType::SetSlot;
+				DecodeSlot(RecordReader, Version, Record.Slot);
+				break;
+			case FInventoryJournalRecord::EType::SetCapacity:
+				Record.Type = FInventoryJournalRecord::EType::SetCapacity;
+				Record.MaxSlots = RecordReader.ReadIndex(MAX_int32);
+				break;
+			default:
+				return false;
+			}
+
+			if (RecordReader.bError)
+			{
+				return false;
+			}
+			OutRecords.Add(MoveTemp(Record));
+		}
+
+		return true;
+	}
+
+	void ApplyJournalRecord(FInventorySnapshot& Snapshot, const FInventoryJournalRecord& Record)
+	{
+		if (Record.Type == FInventoryJournalRecord::EType::SetCapacity)
+		{
+			Snapshot.MaxSlots = Record.MaxSlots;
+			return;
+		}
+
+		const int32 Position = Algo::LowerBoundBy(Snapshot.Slots, Record.Slot.SlotIndex, &FInventorySnapshotSlot::SlotIndex);
+		const bool bExists = Snapshot.Slots.IsValidIndex(Position) && Snapshot.Slots[Position].SlotIndex == Record.Slot.SlotIndex;
+		const bool bEmpty = Record.Slot.ItemID.IsNone() || Record.Slot.Quantity <= 0;
+
+		if (bEmpty)
+		{
+			if (bExists)
+			{
+				Snapshot.Slots.RemoveAt(Position);
+			}
+		}
+		else if (bExists)
+		{
+			Snapshot.Slots[Position] = Record.Slot;
+		}
+		else
+		{
+			Snapshot.Slots.Insert(Record.Slot, Position);
+		}
+	}
+}
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** One occupied slot of an inventory snapshot */
+struct FInventorySnapshotSlot
+{
+	int32 SlotIndex = 0;
+
+	/** Item type, resolved through the item catalog on load */
+	FName ItemID;
+
+	int32 Quantity = 0;
+
+	/** Stack identity, invalid when not stored (older saves and journal segments) */
+	FGuid InstanceID;
+
+	/** FInventoryItem::InstanceMetadata */
+	TArray<TPair<FName, FString>> Metadata;
+};
+
+/**
+ * Copy of an inventory's contents with no object references
+ * Captured on the game thread, then owned by whichever thread encodes or applies it.
+ */
+struct FInventorySnapshot
+{
+	/** UInventoryComponent::PersistenceKey */
+	FName PersistenceKey;
+
+	/** 0 when unknown (rebuilt from a journal with no capacity record), the inventory keeps its own */
+	int32 MaxSlots = 0;
+
+	/** Occupied slots only, in ascending slot order */
+	TArray<FInventorySnapshotSlot> Slots;
+};
+
+/** One committed inventory change, as written to the journal */
+struct FInventoryJournalRecord
+{
+	enum class EType : uint8
+	{
+		/** Slot now holds Slot (ItemID None = emptied) */
+		SetSlot,
+
+		/** MaxSlots changed */
+		SetCapacity
+	};
+
+	EType Type = EType::SetSlot;
+	FName PersistenceKey;
+	FInventorySnapshotSlot Slot;
+	int32 MaxSlots = 0;
+};
+
+/**
+ * Binary inventory save format
+ * Header: magic, version, flags, payload size. The payload (Oodle compressed when that is
+ * smaller) holds a string table for names, item IDs and metadata, then the occupied slots
+ * as varints: slot index delta, item ID string, quantity, instance ID and metadata string pairs.
+ */
+namespace InventoryArchive
+{
+	enum class EVersion : uint16
+	{
+		Initial = 1,
+
+		/** Slots carry their instance ID */
+		InstanceIDs,
+
+		// Add new versions above, Decode handles each one it can migrate from
+		VersionPlusOne,
+		Latest = VersionPlusOne - 1
+	};
+
+	/** Encode a snapshot at the latest version */
+	OUTERCORP_API void Encode(const FInventorySnapshot& Snapshot, TArray<uint8>& OutBytes);
+
+	/** Decode any supported version. Returns false with a reason on corrupt or unknown data */
+	OUTERCORP_API bool Decode(TConstArrayView<uint8> Bytes, FInventorySnapshot& OutSnapshot, FString& OutError);
+
+	/** Encode slot metadata on its own, for stores that keep slots as rows */
+	OUTERCORP_API void EncodeMetadata(TConstArrayView<TPair<FName, FString>> Metadata, TArray<uint8>& OutBytes);
+
+	OUTERCORP_API bool DecodeMetadata(TConstArrayView<uint8> Bytes, TArray<TPair<FName, FString>>& OutMetadata);
+
+	/** Header written at the start of every journal segment */
+	OUTERCORP_API void EncodeJournalHeader(TArray<uint8>& OutBytes);
+
+	/**
+	 * Append one journal record: size, CRC, then the record. Records hold the resulting slot
+	 * state rather than the operation, so replaying one twice is harmless.
+	 */
+	OUTERCORP_API void EncodeJournalRecord(const FInventoryJournalRecord& Record, TArray<uint8>& OutBytes);
+
+	/** Decode a journal segment, stopping at the first torn or corrupt record (the tail of a crashed write). Returns false if it stopped early */
+	OUTERCORP_API bool DecodeJournal(TConstArrayView<uint8> Bytes, TArray<FInventoryJournalRecord>& OutRecords);
+
+	/** Replay a journal record onto a snapshot */
+	OUTERCORP_API void ApplyJournalRecord(FInventorySnapshot& Snapshot, const FInventoryJournalRecord& Record);
+}
@@ -1,10 +1,102 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "InventoryComponent.h"
+#include "InventoryArchive.h"
+#include "InventoryItemCatalog.h"
+#include "InventoryHangarSubsystem.h"
+#include "InventoryPagingSubsystem.h"
+#include "InventoryPredictionComponent.h"
+#include "InventoryPrefetchSubsystem.h"
+#include "InventorySaveSubsystem.h"
+#include "ItemTimerSubsystem.h"
+#include "OutercorpPlayerController.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/GameInstance.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/NetworkSubsystem.h"
+#include "Net/UnrealNetwork.h"
+#include "Outercorp.h"
+#include "TimerManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory AddItems"), STAT_InventoryAddItems, STATGROUP_Inventory);
+
+namespace
+{
+	UInventoryItemCatalogSubsystem* GetCatalog(const UWorld* World)
+	{
+		const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		return GameInstance ? GameInstance->GetSubsystem<UInventoryItemCatalogSubsystem>() : nullptr;
+	}
+}
 
 UInventoryComponent::UInventoryComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+
+	ReplicatedContents = CreateDefaultSubobject<UInventoryReplicatedContents>(TEXT("ReplicatedContents"));
+}
+
+void UInventoryComponent::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	// After the archetype's properties were copied, which would carry its own pointer
+	if (ReplicatedContents)
+	{
+		ReplicatedContents->Slots.Owner = this;
+	}
+}
+
+void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Mutators mark these dirty, nothing is compared per frame
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, MaxSlots, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, Summary, Params);
+}
+
+void UInventoryComponent::ReadyForReplication()
+{
+	Super::ReadyForReplication();
+
+	// The contents only replicate to members of this inventory's group
+	ObserverGroup = FName(TEXT("InventoryObservers"), static_cast<int32>(GetUniqueID()));
+	if (UNetworkSubsystem* Network = GetWorld()->GetSubsystem<UNetworkSubsystem>())
+	{
+		Network->GetNetConditionGroupManager().RegisterSubObjectInGroup(ReplicatedContents, ObserverGroup);
+	}
+	AddReplicatedSubObject(ReplicatedContents, COND_NetGroup);
+
+	UpdateOwnerObserver();
+	for (const TWeakObjectPtr<APlayerController>& Observer : Observers)
+	{
+		if (Observer.IsValid())
+		{
+			Observer->IncludeInNetConditionGroup(ObserverGroup);
+		}
+	}
+}
+
+bool UInventoryComponent::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
+{
+	bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+
+	// Owners still on the legacy subobject path; with the registered list the net group does this
+	const APlayerController* Viewer = Channel->Connection ? Channel->Connection->PlayerController : nullptr;
+	if (ReplicatedContents && IsObservedBy(Viewer))
+	{
+		bWroteSomething |= Channel->ReplicateSubobject(ReplicatedContents, *Bunch, *RepFlags);
+	}
+
+	return bWroteSomething;
 }
 
 void UInventoryComponent::BeginPlay()
@@ -13,11 +105,111 @@ void UInventoryComponent::BeginPlay()
 
 	// Initialize inventory array
 	Items.SetNum(MaxSlots);
+
+	if (UInventoryPrefetchSubsystem* Prefetch = GetWorld()->GetSubsystem<UInventoryPrefetchSubsystem>())
+	{
+		Prefetch->RegisterContainer(this);
+	}
+
+	// Only the authority's copy is saved or paged
+	if (GetOwner()->HasAuthority())
+	{
+		PagingSubsystem = GetWorld()->GetSubsystem<UInventoryPagingSubsystem>();
+		if (PagingSubsystem.IsValid())
+		{
+			PagingSubsystem->RegisterInventory(this);
+		}
+	}
+
+	if (!PersistenceKey.IsNone() && GetOwner()->HasAuthority())
+	{
+		if (UGameInstance* GameInstance = GetWorld()->GetGameInstance())
+		{
+			if (Storage == EInventoryStorage::Hangar)
+			{
+				HangarSubsystem = GameInstance->GetSubsystem<UInventoryHangarSubsystem>();
+				if (HangarSubsystem.IsValid())
+				{
+					HangarSubsystem->RegisterInventory(this);
+				}
+			}
+			else
+			{
+				SaveSubsystem = GameInstance->GetSubsystem<UInventorySaveSubsystem>();
+				if (SaveSubsystem.IsValid())
+				{
+					SaveSubsystem->RegisterInventory(this);
+				}
+			}
+		}
+	}
+}
+
+void UInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UInventoryPrefetchSubsystem* Prefetch = GetWorld()->GetSubsystem<UInventoryPrefetchSubsystem>())
+	{
+		Prefetch->UnregisterContainer(this);
+	}
+
+	if (UInventoryItemCatalogSubsystem* Catalog = GetCatalog(GetWorld()))
+	{
+		Catalog->OnCatalogLoaded.RemoveDynamic(this, &UInventoryComponent::HandleCatalogLoaded);
+	}
+
+	if (UInventorySaveSubsystem* Saves = SaveSubsystem.Get())
+	{
+		Saves->UnregisterInventory(this);
+		SaveSubsystem.Reset();
+	}
+
+	if (UInventoryHangarSubsystem* Hangars = HangarSubsystem.Get())
+	{
+		Hangars->UnregisterInventory(this);
+		HangarSubsystem.Reset();
+	}
+
+	// Last, the stores above may still read paged contents
+	if (UInventoryPagingSubsystem* Paging = PagingSubsystem.Get())
+	{
+		Paging->UnregisterInventory(this);
+		PagingSubsystem.Reset();
+	}
+
+	if (!ObserverGroup.IsNone())
+	{
+		for (const TWeakObjectPtr<APlayerController>& Observer : Observers)
+		{
+			if (Observer.IsValid())
+			{
+				Observer->RemoveFromNetConditionGroup(ObserverGroup);
+			}
+		}
+
+		if (APlayerController* Owner = OwnerObserver.Get())
+		{
+			Owner->RemoveFromNetConditionGroup(ObserverGroup);
+		}
+
+		if (UNetworkSubsystem* Network = GetWorld()->GetSubsystem<UNetworkSubsystem>())
+		{
+			Network->GetNetConditionGroupManager().UnregisterSubObjectFromGroup(ReplicatedContents, ObserverGroup);
+		}
+		RemoveReplicatedSubObject(ReplicatedContents);
+		ObserverGroup = NAME_None;
+	}
+	Observers.Empty();
+	OwnerObserver.Reset();
+	GetWorld()->GetTimerManager().ClearTimer(ObserverCheckTimer);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 bool UInventoryComponent::AddItem(UInventoryItemData* ItemData, int32 Quantity, int32& OutSlotIndex)
 {
-	if (!ItemData || Quantity <= 0)
+	EnsureResident();
+
+	if (!ItemData || Quantity <= 0 || !CanModifyContents())
 	{
 		OutSlotIndex = -1;
 		return false;
@@ -32,7 +224,7 @@ bool UInventoryComponent::AddItem(UInventoryItemData* ItemData, int32 Quantity,
 	int32 RemainingQuantity = Quantity;
 
 	// Try to stack with existing items first
-	if (ItemData->MaxStackSize > 1)
+	if (GetMaxStackSize(ItemData) > 1)
 	{
 		if (TryStackItem(ItemData, RemainingQuantity, OutSlotIndex))
 		{
@@ -46,14 +238,14 @@ bool UInventoryComponent::AddItem(UInventoryItemData* ItemData, int32 Quantity,
 	// Add to empty slots
 	while (RemainingQuantity > 0)
 	{
-		int32 EmptySlot = FindEmptySlot();
+		int32 EmptySlot = FindEmptySlotForItem(ItemData);
 		if (EmptySlot == -1)
 		{
 			OutSlotIndex = -1;
 			return false;
 		}
 
-		int32 QuantityToAdd = FMath::Min(RemainingQuantity, ItemData->MaxStackSize);
+		int32 QuantityToAdd = FMath::Min(RemainingQuantity, GetMaxStackSize(ItemData));
 
 		FInventoryItem NewItem(ItemData, QuantityToAdd);
 		Items[EmptySlot] = NewItem;
@@ -61,15 +253,156 @@ bool UInventoryComponent::AddItem(UInventoryItemData* ItemData, int32 Quantity,
 		OutSlotIndex = EmptySlot;
 		RemainingQuantity -= QuantityToAdd;
 
-		OnInventoryUpdated.Broadcast(EmptySlot, NewItem);
+		NotifySlotChanged(EmptySlot);
 	}
 
 	return true;
 }
 
+bool UInventoryComponent::AddItems(const TArray<FItemQuantity>& ItemsToAdd, TArray<FItemQuantity>& OutRejected)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryAddItems);
+	EnsureResident();
+
+	OutRejected.Reset();
+
+	// Merge duplicate item types so each type is placed once
+	TArray<FItemQuantity, TInlineAllocator<16>> Requests;
+	for (const FItemQuantity& Request : ItemsToAdd)
+	{
+		if (!Request.ItemData || Request.Quantity <= 0)
+		{
+			continue;
+		}
+
+		FItemQuantity* Existing = Requests.FindByPredicate([&Request](const FItemQuantity& Other)
+		{
+			return Other.ItemData == Request.ItemData;
+		});
+
+		if (Existing)
+		{
+			Existing->Quantity += Request.Quantity;
+		}
+		else
+		{
+			Requests.Add(Request);
+		}
+	}
+
+	if (Requests.Num() == 0)
+	{
+		return true;
+	}
+
+	if (!CanModifyContents())
+	{
+		OutRejected.Append(Requests);
+		return false;
+	}
+
+	// One pass over the slots to find partial stacks and free slots
+	TMap<UInventoryItemData*, TArray<int32, TInlineAllocator<4>>> PartialStacks;
+	TArray<int32> FreeSlots;
+	float CurrentWeight = 0.0f;
+
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		const FInventoryItem& Item = Items[i];
+		if (!Item.IsValid())
+		{
+			FreeSlots.Add(i);
+			continue;
+		}
+
+		CurrentWeight += Item.GetTotalWeight();
+		if (Item.Quantity < GetMaxStackSize(Item.ItemData))
+		{
+			PartialStacks.FindOrAdd(Item.ItemData).Add(i);
+		}
+	}
+
+	TBitArray<> ChangedSlots(false, Items.Num());
+	int32 FreeCursor = 0;
+
+	for (const FItemQuantity& Request : Requests)
+	{
+		UInventoryItemData* ItemData = Request.ItemData;
+		int32 Remaining = Request.Quantity;
+
+		// Clamp to what the weight limit still allows
+		if (MaxWeight > 0.0f && ItemData->Weight > 0.0f)
+		{
+			const int32 WeightAllowance = FMath::FloorToInt((MaxWeight - CurrentWeight) / ItemData->Weight);
+			Remaining = FMath::Clamp(WeightAllowance, 0, Remaining);
+		}
+
+		const int32 Accepted = Remaining;
+
+		// Top up existing stacks
+		if (TArray<int32, TInlineAllocator<4>>* Stacks = PartialStacks.Find(ItemData))
+		{
+			for (int32 SlotIndex : *Stacks)
+			{
+				if (Remaining <= 0)
+				{
+					break;
+				}
+
+				const int32 QuantityToAdd = FMath::Min(Remaining, GetMaxStackSize(ItemData) - Items[SlotIndex].Quantity);
+				if (QuantityToAdd > 0)
+				{
+					Items[SlotIndex].Quantity += QuantityToAdd;
+					Remaining -= QuantityToAdd;
+					ChangedSlots[SlotIndex] = true;
+				}
+			}
+		}
+
+		// Fill free slots
+		for (int32 i = FreeCursor; i < FreeSlots.Num() && Remaining > 0; ++i)
+		{
+			const int32 SlotIndex = FreeSlots[i];
+			if (SlotIndex == INDEX_NONE || !CanPlaceItemInSlot(ItemData, SlotIndex))
+			{
+				continue;
+			}
+
+			const int32 QuantityToAdd = FMath::Min(Remaining, GetMaxStackSize(ItemData));
+			Items[SlotIndex] = FInventoryItem(ItemData, QuantityToAdd);
+			Remaining -= QuantityToAdd;
+			ChangedSlots[SlotIndex] = true;
+
+			// Consumed slots are tombstoned so later types skip them
+			FreeSlots[i] = INDEX_NONE;
+			if (i == FreeCursor)
+			{
+				++FreeCursor;
+			}
+		}
+
+		CurrentWeight += ItemData->Weight * (Accepted - Remaining);
+
+		const int32 Rejected = Request.Quantity - (Accepted - Remaining);
+		if (Rejected > 0)
+		{
+			OutRejected.Emplace(ItemData, Rejected);
+		}
+	}
+
+	for (TConstSetBitIterator<> It(ChangedSlots); It; ++It)
+	{
+		NotifySlotChanged(It.GetIndex());
+	}
+
+	return OutRejected.Num() == 0;
+}
+
 bool UInventoryComponent::RemoveItemAtSlot(int32 SlotIndex, int32 Quantity)
 {
-	if (!Items.IsValidIndex(SlotIndex) || !Items[SlotIndex].IsValid())
+	EnsureResident();
+
+	if (!Items.IsValidIndex(SlotIndex) || !Items[SlotIndex].IsValid() || !CanModifyContents())
 	{
 		return false;
 	}
@@ -83,15 +416,17 @@ bool UInventoryComponent::RemoveItemAtSlot(int32 SlotIndex, int32 Quantity)
 
 	if (Items[SlotIndex].Quantity <= 0)
 	{
-		Items[SlotIndex] = FInventoryItem();
+		DestroyStack(SlotIndex);
 	}
 
-	OnInventoryUpdated.Broadcast(SlotIndex, Items[SlotIndex]);
+	NotifySlotChanged(SlotIndex);
 	return true;
 }
 
 bool UInventoryComponent::RemoveItemByInstanceID(FGuid InstanceID, int32 Quantity)
 {
+	EnsureResident();
+
 	for (int32 i = 0; i < Items.Num(); ++i)
 	{
 		if (Items[i].IsValid() && Items[i].InstanceID == InstanceID)
@@ -102,14 +437,47 @@ bool UInventoryComponent::RemoveItemByInstanceID(FGuid InstanceID, int32 Quantit
 	return false;
 }
 
+bool UInventoryComponent::RemoveItems(UInventoryItemData* ItemData, int32 Quantity)
+{
+	EnsureResident();
+
+	if (!ItemData || Quantity <= 0 || !CanModifyContents() || GetItemCount(ItemData) < Quantity)
+	{
+		return false;
+	}
+
+	// Take from the last stacks first so the front of the inventory stays stable
+	int32 Remaining = Quantity;
+	for (int32 i = Items.Num() - 1; i >= 0 && Remaining > 0; --i)
+	{
+		if (Items[i].IsValid() && Items[i].ItemData == ItemData)
+		{
+			const int32 QuantityToRemove = FMath::Min(Remaining, Items[i].Quantity);
+			Items[i].Quantity -= QuantityToRemove;
+			Remaining -= QuantityToRemove;
+
+			if (Items[i].Quantity <= 0)
+			{
+				DestroyStack(i);
+			}
+
+			NotifySlotChanged(i);
+		}
+	}
+
+	return true;
+}
+
 bool UInventoryComponent::MoveItem(int32 FromSlot, int32 ToSlot, int32 Quantity)
 {
-	if (!Items.IsValidIndex(FromSlot) || !Items.IsValidIndex(ToSlot))
+	EnsureResident();
+
+	if (!Items.IsValidIndex(FromSlot) || !Items.IsValidIndex(ToSlot) || !CanModifyContents())
 	{
 		return false;
 	}
 
-	if (!Items[FromSlot].IsValid())
+	if (!Items[FromSlot].IsValid() || !CanPlaceItemInSlot(Items[FromSlot].ItemData, ToSlot))
 	{
 		return false;
 	}
@@ -132,8 +500,8 @@ bool UInventoryComponent::MoveItem(int32 FromSlot, int32 ToSlot, int32 Quantity)
 			return SplitStack(FromSlot, ToSlot, QuantityToMove);
 		}
 
-		OnInventoryUpdated.Broadcast(FromSlot, Items[FromSlot]);
-		OnInventoryUpdated.Broadcast(ToSlot, Items[ToSlot]);
+		NotifySlotChanged(FromSlot);
+		NotifySlotChanged(ToSlot);
 		return true;
 	}
 
@@ -144,20 +512,112 @@ bool UInventoryComponent::MoveItem(int32 FromSlot, int32 ToSlot, int32 Quantity)
 	}
 	else
 	{
+		if (!CanPlaceItemInSlot(Items[ToSlot].ItemData, FromSlot))
+		{
+			return false;
+		}
+
 		// Swap items
 		FInventoryItem Temp = Items[FromSlot];
 		Items[FromSlot] = Items[ToSlot];
 		Items[ToSlot] = Temp;
 
-		OnInventoryUpdated.Broadcast(FromSlot, Items[FromSlot]);
-		OnInventoryUpdated.Broadcast(ToSlot, Items[ToSlot]);
+		NotifySlotChanged(FromSlot);
+		NotifySlotChanged(ToSlot);
 		return true;
 	}
 }
 
+bool UInventoryComponent::TransferItem(int32 FromSlot, UInventoryComponent* TargetInventory, int32 ToSlot, int32 Quantity)
+{
+	EnsureResident();
+
+	if (TargetInventory == this)
+	{
+		return MoveItem(FromSlot, ToSlot, Quantity);
+	}
+
+	if (!TargetInventory)
+	{
+		return false;
+	}
+
+	TargetInventory->EnsureResident();
+	if (!Items.IsValidIndex(FromSlot) || !TargetInventory->Items.IsValidIndex(ToSlot) || !CanModifyContents() || !TargetInventory->CanModifyContents())
+	{
+		return false;
+	}
+
+	FInventoryItem& Source = Items[FromSlot];
+	if (!Source.IsValid() || !TargetInventory->CanPlaceItemInSlot(Source.ItemData, ToSlot))
+	{
+		return false;
+	}
+
+	int32 QuantityToMove = (Quantity <= 0) ? Source.Quantity : FMath::Min(Quantity, Source.Quantity);
+	QuantityToMove = FMath::Min(QuantityToMove, TargetInventory->GetMaxStackSize(Source.ItemData));
+
+	// Respect the target's weight limit
+	if (TargetInventory->MaxWeight > 0.0f)
+	{
+		float IncomingWeight = Source.ItemData->Weight * QuantityToMove;
+		if (TargetInventory->GetCurrentWeight() + IncomingWeight > TargetInventory->MaxWeight)
+		{
+			return false;
+		}
+	}
+
+	FInventoryItem& Target = TargetInventory->Items[ToSlot];
+
+	if (!Target.IsValid())
+	{
+		if (QuantityToMove == Source.Quantity)
+		{
+			// Whole stack keeps its identity so timers and references follow it
+			Target = Source;
+			Source = FInventoryItem();
+		}
+		else
+		{
+			FInventoryItem NewStack(Source.ItemData, QuantityToMove);
+			NewStack.InstanceMetadata = Source.InstanceMetadata;
+			Target = NewStack;
+			Source.Quantity -= QuantityToMove;
+		}
+	}
+	else if (TargetInventory->CanStack(Source, Target))
+	{
+		int32 SpaceAvailable = TargetInventory->GetMaxStackSize(Target.ItemData) - Target.Quantity;
+		QuantityToMove = FMath::Min(SpaceAvailable, QuantityToMove);
+		if (QuantityToMove <= 0)
+		{
+			return false;
+		}
+
+		Target.Quantity += QuantityToMove;
+		Source.Quantity -= QuantityToMove;
+
+		if (Source.Quantity <= 0)
+		{
+			DestroyStack(FromSlot);
+		}
+	}
+	else
+	{
+		// Swapping across inventories would need a weight check in both directions
+		return false;
+	}
+
+	NotifySlotChanged(FromSlot);
+	TargetInventory->NotifySlotChanged(ToSlot);
+	return true;
+}
+
 bool UInventoryComponent::SplitStack(int32 SourceSlot, int32 TargetSlot, int32 Quantity)
 {
-	if (!Items.IsValidIndex(SourceSlot) || !Items.IsValidIndex(TargetSlot))
+	EnsureResident();
+
+	if (!Items.IsValidIndex(SourceSlot) || !Items.IsValidIndex(TargetSlot) || !CanModifyContents())
 	{
 		return false;
 	}
@@ -167,6 +627,11 @@ bool UInventoryComponent::SplitStack(int32 SourceSlot, int32 TargetSlot, int32 Q
 		return false;
 	}
 
+	if (!CanPlaceItemInSlot(Items[SourceSlot].ItemData, TargetSlot))
+	{
+		return false;
+	}
+
 	if (Quantity <= 0 || Quantity >= Items[SourceSlot].Quantity)
 	{
 		return false;
@@ -179,15 +644,17 @@ bool UInventoryComponent::SplitStack(int32 SourceSlot, int32 TargetSlot, int32 Q
 	Items[TargetSlot] = NewStack;
 	Items[SourceSlot].Quantity -= Quantity;
 
-	OnInventoryUpdated.Broadcast(SourceSlot, Items[SourceSlot]);
-	OnInventoryUpdated.Broadcast(TargetSlot, Items[TargetSlot]);
+	NotifySlotChanged(SourceSlot);
+	NotifySlotChanged(TargetSlot);
 
 	return true;
 }
 
 bool UInventoryComponent::MergeStacks(int32 SourceSlot, int32 TargetSlot)
 {
-	if (!Items.IsValidIndex(SourceSlot) || !Items.IsValidIndex(TargetSlot))
+	EnsureResident();
+
+	if (!Items.IsValidIndex(SourceSlot) || !Items.IsValidIndex(TargetSlot) || !CanModifyContents())
 	{
 		return false;
 	}
@@ -197,7 +664,7 @@ bool UInventoryComponent::MergeStacks(int32 SourceSlot, int32 TargetSlot)
 		return false;
 	}
 
-	int32 SpaceAvailable = Items[TargetSlot].ItemData->MaxStackSize - Items[TargetSlot].Quantity;
+	int32 SpaceAvailable = GetMaxStackSize(Items[TargetSlot].ItemData) - Items[TargetSlot].Quantity;
 	int32 QuantityToMove = FMath::Min(SpaceAvailable, Items[SourceSlot].Quantity);
 
 	Items[TargetSlot].Quantity += QuantityToMove;
@@ -205,17 +672,19 @@ bool UInventoryComponent::MergeStacks(int32 SourceSlot, int32 TargetSlot)
 
 	if (Items[SourceSlot].Quantity <= 0)
 	{
-		Items[SourceSlot] = FInventoryItem();
+		DestroyStack(SourceSlot);
 	}
 
-	OnInventoryUpdated.Broadcast(SourceSlot, Items[SourceSlot]);
-	OnInventoryUpdated.Broadcast(TargetSlot, Items[TargetSlot]);
+	NotifySlotChanged(SourceSlot);
+	NotifySlotChanged(TargetSlot);
 
 	return true;
 }
 
 FInventoryItem UInventoryComponent::GetItemAtSlot(int32 SlotIndex) const
 {
+	EnsureResident();
+
 	if (Items.IsValidIndex(SlotIndex))
 	{
 		return Items[SlotIndex];
@@ -225,6 +694,8 @@ FInventoryItem UInventoryComponent::GetItemAtSlot(int32 SlotIndex) const
 
 bool UInventoryComponent::IsSlotEmpty(int32 SlotIndex) const
 {
+	EnsureResident();
+
 	if (Items.IsValidIndex(SlotIndex))
 	{
 		return !Items[SlotIndex].IsValid();
@@ -234,6 +705,8 @@ bool UInventoryComponent::IsSlotEmpty(int32 SlotIndex) const
 
 int32 UInventoryComponent::GetOccupiedSlots() const
 {
+	EnsureResident();
+
 	int32 Count = 0;
 	for (const FInventoryItem& Item : Items)
 	{
@@ -245,8 +718,25 @@ int32 UInventoryComponent::GetOccupiedSlots() const
 	return Count;
 }
 
+int32 UInventoryComponent::GetItemCount(const UInventoryItemData* ItemData) const
+{
+	EnsureResident();
+
+	int32 Count = 0;
+	for (const FInventoryItem& Item : Items)
+	{
+		if (Item.IsValid() && Item.ItemData == ItemData)
+		{
+			Count += Item.Quantity;
+		}
+	}
+	return Count;
+}
+
 float UInventoryComponent::GetCurrentWeight() const
 {
+	EnsureResident();
+
 	float TotalWeight = 0.0f;
 	for (const FInventoryItem& Item : Items)
 	{
@@ -266,7 +756,9 @@ float UInventoryComponent::GetCurrentVolume() const
 
 bool UInventoryComponent::CanAddItem(UInventoryItemData* ItemData, int32 Quantity) const
 {
-	if (!ItemData || Quantity <= 0)
+	EnsureResident();
+
+	if (!ItemData || Quantity <= 0 || !CanModifyContents())
 	{
 		return false;
 	}
@@ -285,13 +777,13 @@ bool UInventoryComponent::CanAddItem(UInventoryItemData* ItemData, int32 Quantit
 	int32 RemainingQuantity = Quantity;
 
 	// Check existing stacks
-	if (ItemData->MaxStackSize > 1)
+	if (GetMaxStackSize(ItemData) > 1)
 	{
 		for (const FInventoryItem& Item : Items)
 		{
 			if (Item.IsValid() && Item.ItemData == ItemData)
 			{
-				int32 SpaceInStack = ItemData->MaxStackSize - Item.Quantity;
+				int32 SpaceInStack = GetMaxStackSize(ItemData) - Item.Quantity;
 				RemainingQuantity -= SpaceInStack;
 				if (RemainingQuantity <= 0)
 				{
@@ -302,14 +794,23 @@ bool UInventoryComponent::CanAddItem(UInventoryItemData* ItemData, int32 Quantit
 	}
 
 	// Check empty slots
-	int32 RequiredSlots = FMath::CeilToInt(static_cast<float>(RemainingQuantity) / ItemData->MaxStackSize);
-	int32 EmptySlots = MaxSlots - GetOccupiedSlots();
-
+	int32 RequiredSlots = FMath::CeilToInt(static_cast<float>(RemainingQuantity) / GetMaxStackSize(ItemData));
+	int32 EmptySlots = 0;
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		if (!Items[i].IsValid() && CanPlaceItemInSlot(ItemData, i))
+		{
+			EmptySlots++;
+		}
+	}
+
 	return EmptySlots >= RequiredSlots;
 }
 
 int32 UInventoryComponent::FindEmptySlot() const
 {
+	EnsureResident();
+
 	for (int32 i = 0; i < Items.Num(); ++i)
 	{
 		if (!Items[i].IsValid())
@@ -320,8 +821,38 @@ int32 UInventoryComponent::FindEmptySlot() const
 	return -1;
 }
 
+int32 UInventoryComponent::FindEmptySlotForItem(const UInventoryItemData* ItemData) const
+{
+	EnsureResident();
+
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		if (!Items[i].IsValid() && CanPlaceItemInSlot(ItemData, i))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+int32 UInventoryComponent::FindSlotByInstanceID(FGuid InstanceID) const
+{
+	EnsureResident();
+
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		if (Items[i].IsValid() && Items[i].InstanceID == InstanceID)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
 int32 UInventoryComponent::FindItemByID(FName ItemID) const
 {
+	EnsureResident();
+
 	for (int32 i = 0; i < Items.Num(); ++i)
 	{
 		if (Items[i].IsValid() && Items[i].ItemData->ItemID == ItemID)
@@ -334,6 +865,20 @@ int32 UInventoryComponent::FindItemByID(FName ItemID) const
 
 void UInventoryComponent::SetMaxSlots(int32 NewMaxSlots)
 {
+	EnsureResident();
+
+	if (!CanModifyContents())
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("%s: cannot resize an inventory whose contents are still loading"), *GetPathName());
+		return;
+	}
+
+	if (!IsCapacityAllowed(NewMaxSlots))
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("%s: %d slots is not a capacity this inventory allows"), *GetPathName(), NewMaxSlots);
+		return;
+	}
+
 	if (NewMaxSlots < MaxSlots)
 	{
 		// Shrinking inventory - check if items would be lost
@@ -361,23 +906,415 @@ void UInventoryComponent::SetMaxSlots(int32 NewMaxSlots)
 	}
 
 	MaxSlots = NewMaxSlots;
-	OnInventoryCapacityChanged.Broadcast(MaxSlots);
+	MarkCapacityDirty();
+
+	NotifyCapacityStored();
+	NotifyCapacityChanged();
 }
 
 void UInventoryComponent::ClearInventory()
 {
+	EnsureResident();
+
+	if (!CanModifyContents())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		if (Items[i].IsValid())
+		{
+			DestroyStack(i);
+			NotifySlotChanged(i);
+		}
+	}
+}
+
+void UInventoryComponent::RequestContents(APlayerController* Viewer)
+{
+	if (UInventoryHangarSubsystem* Hangars = HangarSubsystem.Get())
+	{
+		Hangars->LoadInventory(this);
+	}
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		AddObserver(Viewer);
+		return;
+	}
+
+	if (Viewer)
+	{
+		LocalViewers.AddUnique(Viewer);
+	}
+
+	if (AOutercorpPlayerController* PlayerController = Cast<AOutercorpPlayerController>(Viewer))
+	{
+		PlayerController->ServerObserveInventory(this, true);
+	}
+}
+
+void UInventoryComponent::ReleaseContents(APlayerController* Viewer)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		RemoveObserver(Viewer);
+		return;
+	}
+
+	LocalViewers.Remove(Viewer);
+
+	if (AOutercorpPlayerController* PlayerController = Cast<AOutercorpPlayerController>(Viewer))
+	{
+		PlayerController->ServerObserveInventory(this, false);
+	}
+}
+
+void UInventoryComponent::AddObserver(APlayerController* Observer)
+{
+	if (!Observer || Observers.Contains(Observer))
+	{
+		return;
+	}
+
+	// The owner is in the group already
+	const bool bWasObserved = IsObservedBy(Observer);
+	Observers.Add(Observer);
+	if (!ObserverGroup.IsNone() && !bWasObserved)
+	{
+		Observer->IncludeInNetConditionGroup(ObserverGroup);
+	}
+
+	// Players walk away with the window open
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (ObserverCheckInterval > 0.0f && !TimerManager.IsTimerActive(ObserverCheckTimer))
+	{
+		TimerManager.SetTimer(ObserverCheckTimer, this, &UInventoryComponent::RemoveObserversOutOfRange, ObserverCheckInterval, true);
+	}
+}
+
+void UInventoryComponent::RemoveObserver(APlayerController* Observer)
+{
+	if (!Observer || Observers.Remove(Observer) == 0)
+	{
+		return;
+	}
+
+	// The owner keeps the contents with the window closed
+	if (!ObserverGroup.IsNone() && Observer != OwnerObserver.Get())
+	{
+		Observer->RemoveFromNetConditionGroup(ObserverGroup);
+	}
+
+	if (Observers.Num() == 0)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(ObserverCheckTimer);
+	}
+}
+
+void UInventoryComponent::RemoveObserversOutOfRange()
+{
+	TArray<APlayerController*, TInlineAllocator<4>> OutOfRange;
+	Observers.RemoveAll([](const TWeakObjectPtr<APlayerController>& Observer)
+	{
+		return !Observer.IsValid();
+	});
+	for (const TWeakObjectPtr<APlayerController>& Observer : Observers)
+	{
+		if (!CanBeOpenedBy(Observer.Get()))
+		{
+			OutOfRange.Add(Observer.Get());
+		}
+	}
+
+	for (APlayerController* Observer : OutOfRange)
+	{
+		UE_LOG(LogOutercorp, Verbose, TEXT("%s can no longer open %s, no longer sending it the contents"), *Observer->GetName(), *GetPathName());
+		RemoveObserver(Observer);
+	}
+
+	if (Observers.Num() == 0)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(ObserverCheckTimer);
+	}
+}
+
+bool UInventoryComponent::CanBeOpenedBy(const APlayerController* Viewer) const
+{
+	if (!Viewer)
+	{
+		return false;
+	}
+
+	if (IsOwnedBy(Viewer))
+	{
+		return true;
+	}
+
+	const APawn* Pawn = Viewer->GetPawn();
+	return OpenRange > 0.0f && Pawn && GetOwner()
+		&& FVector::DistSquared(Pawn->GetActorLocation(), GetOwner()->GetActorLocation()) <= FMath::Square(OpenRange);
+}
+
+bool UInventoryComponent::IsObservedBy(const APlayerController* Observer) const
+{
+	if (!Observer)
+	{
+		return false;
+	}
+
+	return OwnerObserver.Get() == Observer || Observers.ContainsByPredicate([Observer](const TWeakObjectPtr<APlayerController>& Other)
+	{
+		return Other.Get() == Observer;
+	});
+}
+
+bool UInventoryComponent::IsReceivingContents(const APlayerController* Player) const
+{
+	if (!Player)
+	{
+		return false;
+	}
+
+	return IsOwnedBy(Player) || LocalViewers.ContainsByPredicate([Player](const TWeakObjectPtr<APlayerController>& Other)
+	{
+		return Other.Get() == Player;
+	});
+}
+
+bool UInventoryComponent::IsOwnedBy(const APlayerController* Player) const
+{
+	// Same chain as UpdateOwnerObserver, which only runs on the server
+	for (const AActor* Actor = GetOwner(); Actor; Actor = Actor->GetOwner())
+	{
+		if (Actor == Player)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UInventoryComponent::UpdateOwnerObserver()
+{
+	// Pawns are owned by their controller, ships and containers by a pawn or controller
+	APlayerController* NewOwner = nullptr;
+	for (AActor* Actor = GetOwner(); Actor && !NewOwner; Actor = Actor->GetOwner())
+	{
+		NewOwner = Cast<APlayerController>(Actor);
+	}
+
+	APlayerController* PreviousOwner = OwnerObserver.Get();
+	if (NewOwner == PreviousOwner)
+	{
+		return;
+	}
+
+	OwnerObserver = NewOwner;
+	if (ObserverGroup.IsNone())
+	{
+		return;
+	}
+
+	if (PreviousOwner && !IsObservedBy(PreviousOwner))
+	{
+		PreviousOwner->RemoveFromNetConditionGroup(ObserverGroup);
+	}
+
+	if (NewOwner)
+	{
+		NewOwner->IncludeInNetConditionGroup(ObserverGroup);
+	}
+}
+
+uint32 UInventoryComponent::GetNetInstanceID(int32 SlotIndex) const
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return ReplicatedContents->Slots.FindNetInstanceID(SlotIndex);
+	}
+
+	// Stacks the client predicted have IDs of their own
+	return Items.IsValidIndex(SlotIndex) && Items[SlotIndex].IsValid() ? ReplicatedContents->Slots.ParseClientInstanceID(Items[SlotIndex].InstanceID) : 0;
+}
+
+bool UInventoryComponent::CaptureSnapshot(FInventorySnapshot& OutSnapshot) const
+{
+	OutSnapshot = FInventorySnapshot();
+
+	// Saving a cold inventory shouldn't bring it back in
+	if (bPagedOut)
+	{
+		if (const UInventoryPagingSubsystem* Paging = PagingSubsystem.Get())
+		{
+			if (Paging->GetPagedSnapshot(this, OutSnapshot))
+			{
+				return true;
+			}
+		}
+	}
+
+	EnsureResident();
+
+	// Still out when the page can't be read, the empty slot array isn't the contents
+	if (bPagedOut)
+	{
+		return false;
+	}
+
+	OutSnapshot.PersistenceKey = PersistenceKey;
+	OutSnapshot.MaxSlots = MaxSlots;
+
 	for (int32 i = 0; i < Items.Num(); ++i)
 	{
 		if (Items[i].IsValid())
 		{
-			Items[i] = FInventoryItem();
-			OnInventoryUpdated.Broadcast(i, Items[i]);
+			OutSnapshot.Slots.Add(CaptureSlot(i));
+		}
+	}
+
+	return true;
+}
+
+FInventorySnapshotSlot UInventoryComponent::CaptureSlot(int32 SlotIndex) const
+{
+	EnsureResident();
+
+	FInventorySnapshotSlot Slot;
+	Slot.SlotIndex = SlotIndex;
+
+	const FInventoryItem& Item = Items[SlotIndex];
+	if (Item.IsValid())
+	{
+		Slot.ItemID = Item.ItemData->ItemID;
+		Slot.Quantity = Item.Quantity;
+		Slot.InstanceID = Item.InstanceID;
+		Slot.Metadata.Reserve(Item.InstanceMetadata.Num());
+		for (const TPair<FName, FString>& Pair : Item.InstanceMetadata)
+		{
+			Slot.Metadata.Add(Pair);
+		}
+	}
+
+	return Slot;
+}
+
+int32 UInventoryComponent::ApplySnapshot(const FInventorySnapshot& Snapshot, const UInventoryItemCatalogSubsystem* Catalog)
+{
+	// Listeners compare against the current contents, paged out or not
+	EnsureResident();
+
+	TArray<FInventoryItem> NewItems;
+	const int32 NumUnresolved = ResolveSnapshot(Snapshot, Catalog, NewItems);
+	const int32 NumSlots = NewItems.Num();
+
+	if (!IsCapacityAllowed(NumSlots))
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("%s: saved contents have %d slots, which this inventory doesn't allow; keeping the current contents"), *GetPathName(), NumSlots);
+		return Snapshot.Slots.Num();
+	}
+
+	// Swap everything in before notifying so listeners see the loaded state as a whole
+	TArray<FInventoryItem> PreviousItems = MoveTemp(Items);
+	Items = MoveTemp(NewItems);
+
+	if (SearchIndex.IsBuilt())
+	{
+		// Rebuilt rather than patched, the slot count may have shrunk
+		SearchIndex.Build(Items);
+	}
+
+	const bool bCapacityChanged = NumSlots != MaxSlots;
+	MaxSlots = NumSlots;
+	if (bCapacityChanged)
+	{
+		MarkCapacityDirty();
+		if (GetOwnerRole() == ROLE_Authority && ReplicatedContents->Slots.Trim(MaxSlots))
+		{
+			ReplicatedContents->MarkSlotsDirty();
+			UpdateSummary();
+		}
+
+		NotifyCapacityStored();
+		NotifyCapacityChanged();
+	}
+
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		const bool bWasValid = PreviousItems.IsValidIndex(i) && PreviousItems[i].IsValid();
+		if (bWasValid || Items[i].IsValid())
+		{
+			NotifySlotChanged(i);
 		}
 	}
+
+	return NumUnresolved;
+}
+
+void UInventoryComponent::PageOut(TArray<uint8>& OutBlob)
+{
+	if (bPagedOut)
+	{
+		return;
+	}
+
+	FInventorySnapshot Snapshot;
+	CaptureSnapshot(Snapshot);
+	InventoryArchive::Encode(Snapshot, OutBlob);
+
+	// The blob only holds item IDs; keep the types so page-in doesn't depend on the catalog finding them
+	PagedItemTypes.Reset();
+	for (const FInventoryItem& Item : Items)
+	{
+		if (Item.IsValid())
+		{
+			PagedItemTypes.AddUnique(Item.ItemData);
+		}
+	}
+
+	// Nothing changed, so nobody is notified; the search index is rebuilt on its next use
+	Items.Empty();
+	SearchIndex.Release();
+	bPagedOut = true;
+}
+
+void UInventoryComponent::PageIn(const FInventorySnapshot& Snapshot, const UInventoryItemCatalogSubsystem* Catalog)
+{
+	if (!bPagedOut)
+	{
+		return;
+	}
+
+	ResolveSnapshot(Snapshot, Catalog, Items, PagedItemTypes);
+	PagedItemTypes.Empty();
+	bPagedOut = false;
+}
+
+SIZE_T UInventoryComponent::GetResidentSize() const
+{
+	SIZE_T Size = Items.GetAllocatedSize() + SearchIndex.GetAllocatedSize();
+	if (ReplicatedContents)
+	{
+		Size += ReplicatedContents->Slots.GetAllocatedSize();
+	}
+
+	for (const FInventoryItem& Item : Items)
+	{
+		Size += Item.InstanceMetadata.GetAllocatedSize();
+	}
+	return Size;
 }
 
 void UInventoryComponent::SortInventory(bool bByName)
 {
+	EnsureResident();
+
+	if (!CanModifyContents())
+	{
+		return;
+	}
+
 	// Extract valid items
 	TArray<FInventoryItem> ValidItems;
 	for (const FInventoryItem& Item : Items)
@@ -410,13 +1347,24 @@ void UInventoryComponent::SortInventory(bool bByName)
 	}
 
 	// Clear inventory
-	Items.Init(FInventoryItem(), Items.Num());
+	TArray<FInventoryItem> PreviousItems = MoveTemp(Items);
+	Items.Init(FInventoryItem(), PreviousItems.Num());
 
 	// Place sorted items back
 	for (int32 i = 0; i < ValidItems.Num(); ++i)
 	{
 		Items[i] = ValidItems[i];
-		OnInventoryUpdated.Broadcast(i, Items[i]);
+	}
+
+	// Notify every slot whose contents changed, including slots vacated at the end
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		const bool bWasValid = PreviousItems[i].IsValid();
+		const bool bIsValid = Items[i].IsValid();
+		if (bWasValid != bIsValid || (bIsValid && !(Items[i] == PreviousItems[i])))
+		{
+			NotifySlotChanged(i);
+		}
 	}
 }
 
@@ -428,7 +1376,7 @@ bool UInventoryComponent::TryStackItem(UInventoryItemData* ItemData, int32& Quan
 	{
 		if (Items[i].IsValid() && Items[i].ItemData == ItemData)
 		{
-			int32 SpaceInStack = ItemData->MaxStackSize - Items[i].Quantity;
+			int32 SpaceInStack = GetMaxStackSize(ItemData) - Items[i].Quantity;
 			if (SpaceInStack > 0)
 			{
 				int32 QuantityToAdd = FMath::Min(SpaceInStack, Quantity);
@@ -437,7 +1385,7 @@ bool UInventoryComponent::TryStackItem(UInventoryItemData* ItemData, int32& Quan
 				OutSlotIndex = i;
 				bStackedAny = true;
 
-				OnInventoryUpdated.Broadcast(i, Items[i]);
+				NotifySlotChanged(i);
 			}
 		}
 	}
@@ -445,6 +1393,337 @@ bool UInventoryComponent::TryStackItem(UInventoryItemData* ItemData, int32& Quan
 	return bStackedAny;
 }
 
+void UInventoryComponent::DestroyStack(int32 SlotIndex)
+{
+	// Timers follow the instance ID through moves, nothing would cancel them once the stack is gone.
+	// Clients only predict, a rolled back removal must find its timers still running
+	UWorld* World = GetWorld();
+	UItemTimerSubsystem* Timers = World ? World->GetSubsystem<UItemTimerSubsystem>() : nullptr;
+	if (Timers && GetOwnerRole() == ROLE_Authority)
+	{
+		Timers->CancelAllTimers(Items[SlotIndex].InstanceID);
+	}
+
+	Items[SlotIndex] = FInventoryItem();
+}
+
+bool UInventoryComponent::CanModifyContents() const
+{
+	// Callers ran EnsureResident, still paged out means the page couldn't be read
+	if (bPagedOut)
+	{
+		return false;
+	}
+
+	const UInventoryHangarSubsystem* Hangars = HangarSubsystem.Get();
+	return !Hangars || Hangars->IsInventoryLoaded(this);
+}
+
+bool UInventoryComponent::CanPlaceItemInSlot(const UInventoryItemData* ItemData, int32 SlotIndex) const
+{
+	// Any slot accepts any item by default
+	return true;
+}
+
+void UInventoryComponent::NotifySlotChanged(int32 SlotIndex)
+{
+	// EndPredictionReplay notifies the slots that came out different
+	if (bReplayingPrediction)
+	{
+		return;
+	}
+
+	if (SearchIndex.IsBuilt())
+	{
+		SearchIndex.UpdateSlot(SlotIndex, Items[SlotIndex]);
+	}
+
+	if (UInventorySaveSubsystem* Saves = SaveSubsystem.Get())
+	{
+		Saves->JournalSlot(*this, SlotIndex);
+	}
+	else if (UInventoryHangarSubsystem* Hangars = HangarSubsystem.Get())
+	{
+		Hangars->MarkSlotDirty(*this, SlotIndex);
+	}
+
+	if (GetIsReplicated() && GetOwnerRole() == ROLE_Authority && ReplicatedContents->Slots.SetSlot(SlotIndex, Items[SlotIndex]))
+	{
+		ReplicatedContents->MarkSlotsDirty();
+		UpdateSummary();
+	}
+
+	OnInventoryUpdated.Broadcast(SlotIndex, Items[SlotIndex]);
+}
+
+int32 UInventoryComponent::ResolveSnapshot(const FInventorySnapshot& Snapshot, const UInventoryItemCatalogSubsystem* Catalog, TArray<FInventoryItem>& OutItems,
+	TConstArrayView<TObjectPtr<UInventoryItemData>> KnownItemTypes) const
+{
+	int32 NumSlots = Snapshot.MaxSlots > 0 ? Snapshot.MaxSlots : MaxSlots;
+	for (const FInventorySnapshotSlot& Slot : Snapshot.Slots)
+	{
+		NumSlots = FMath::Max(NumSlots, Slot.SlotIndex + 1);
+	}
+
+	OutItems.Reset();
+	OutItems.SetNum(NumSlots);
+
+	int32 NumUnresolved = 0;
+	for (const FInventorySnapshotSlot& Slot : Snapshot.Slots)
+	{
+		const TObjectPtr<UInventoryItemData>* Known = KnownItemTypes.FindByPredicate([&Slot](const UInventoryItemData* ItemData)
+		{
+			return ItemData && ItemData->ItemID == Slot.ItemID;
+		});
+
+		UInventoryItemData* ItemData = Known ? Known->Get() : Catalog ? Catalog->FindItem(Slot.ItemID) : nullptr;
+		if (!ItemData)
+		{
+			UE_LOG(LogOutercorp, Warning, TEXT("%s: saved item '%s' in slot %d no longer exists, dropping %d"),
+				*GetPathName(), *Slot.ItemID.ToString(), Slot.SlotIndex, Slot.Quantity);
+			++NumUnresolved;
+			continue;
+		}
+
+		FInventoryItem& Item = OutItems[Slot.SlotIndex];
+		Item = FInventoryItem(ItemData, Slot.Quantity);
+		if (Slot.InstanceID.IsValid())
+		{
+			Item.InstanceID = Slot.InstanceID;
+		}
+		for (const TPair<FName, FString>& Pair : Slot.Metadata)
+		{
+			Item.InstanceMetadata.Add(Pair.Key, Pair.Value);
+		}
+	}
+
+	return NumUnresolved;
+}
+
+void UInventoryComponent::EnsureResident() const
+{
+	// Per-slot reads from widgets, queries and prediction replays come many times a frame, and idle time is measured in seconds
+	if (LastAccessFrame != GFrameCounter)
+	{
+		LastAccessFrame = GFrameCounter;
+		LastAccessTime = FPlatformTime::Seconds();
+	}
+
+	if (bPagedOut)
+	{
+		if (UInventoryPagingSubsystem* Paging = PagingSubsystem.Get())
+		{
+			// Logically const: the contents are the same, they just come back into memory
+			Paging->FaultIn(const_cast<UInventoryComponent*>(this));
+		}
+	}
+}
+
+void UInventoryComponent::NotifyCapacityStored()
+{
+	if (UInventorySaveSubsystem* Saves = SaveSubsystem.Get())
+	{
+		Saves->JournalCapacity(*this);
+	}
+	else if (UInventoryHangarSubsystem* Hangars = HangarSubsystem.Get())
+	{
+		Hangars->MarkCapacityDirty(*this);
+	}
+}
+
+void UInventoryComponent::OnRep_MaxSlots()
+{
+	// Slots beyond the new capacity were emptied first, their removes arrive separately
+	Items.SetNum(MaxSlots);
+
+	if (SearchIndex.IsBuilt())
+	{
+		SearchIndex.Build(Items);
+	}
+
+	NotifyCapacityChanged();
+}
+
+void UInventoryComponent::NotifyCapacityChanged()
+{
+	OnInventoryCapacityChanged.Broadcast(MaxSlots);
+}
+
+void UInventoryComponent::MarkCapacityDirty()
+{
+	MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, MaxSlots, this);
+}
+
+void UInventoryComponent::UpdateSummary()
+{
+	FInventorySummary NewSummary;
+	NewSummary.OccupiedSlots = ReplicatedContents->Slots.Slots.Num();
+	NewSummary.Weight = ReplicatedContents->Slots.GetTotalWeight();
+
+	for (const FInventoryReplicatedSlot& Slot : ReplicatedContents->Slots.Slots)
+	{
+		if (NewSummary.ItemTypes.Num() == FInventorySummary::MaxItemTypes)
+		{
+			break;
+		}
+
+		if (Slot.ItemData)
+		{
+			NewSummary.ItemTypes.AddUnique(Slot.ItemData);
+		}
+	}
+
+	if (!(NewSummary == Summary))
+	{
+		Summary = NewSummary;
+		MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, Summary, this);
+	}
+}
+
+void UInventoryComponent::ApplyReplicatedSlot(const FInventoryReplicatedSlot& Slot, bool bRemoved)
+{
+	// With predictions in flight the slot array is rebuilt from the entries once the whole update is in
+	if (Slot.SlotIndex < 0 || Predictor.IsValid())
+	{
+		return;
+	}
+
+	if (bRemoved)
+	{
+		// The slot may already hold a newer stack, added in the same update
+		if (!Items.IsValidIndex(Slot.SlotIndex) || Items[Slot.SlotIndex].InstanceID != Slot.InstanceID)
+		{
+			return;
+		}
+
+		Items[Slot.SlotIndex] = FInventoryItem();
+	}
+	else
+	{
+		// Contents can arrive before the capacity does
+		if (Slot.SlotIndex >= Items.Num())
+		{
+			Items.SetNum(Slot.SlotIndex + 1);
+		}
+
+		Slot.CopyTo(Items[Slot.SlotIndex]);
+	}
+
+	NotifySlotChanged(Slot.SlotIndex);
+}
+
+void UInventoryComponent::HandleReplicatedContents()
+{
+	if (UInventoryPredictionComponent* Prediction = Predictor.Get())
+	{
+		Prediction->Reconcile();
+	}
+}
+
+void UInventoryComponent::WaitForCatalog()
+{
+	// A loaded catalog that doesn't know the type won't learn it later
+	UInventoryItemCatalogSubsystem* Catalog = GetCatalog(GetWorld());
+	if (Catalog && !Catalog->IsCatalogLoaded())
+	{
+		Catalog->OnCatalogLoaded.AddUniqueDynamic(this, &UInventoryComponent::HandleCatalogLoaded);
+	}
+}
+
+void UInventoryComponent::HandleCatalogLoaded()
+{
+	UInventoryItemCatalogSubsystem* Catalog = GetCatalog(GetWorld());
+	if (!Catalog)
+	{
+		return;
+	}
+
+	Catalog->OnCatalogLoaded.RemoveDynamic(this, &UInventoryComponent::HandleCatalogLoaded);
+
+	// Predictions are replayed on top of the resolved entries
+	if (ReplicatedContents->Slots.ResolvePendingItems(Catalog) > 0)
+	{
+		HandleReplicatedContents();
+	}
+}
+
+void UInventoryComponent::BeginPredictionReplay()
+{
+	check(!bReplayingPrediction);
+
+	ReplayBaseline = MoveTemp(Items);
+	Items.Reset();
+	Items.SetNum(MaxSlots);
+
+	for (const FInventoryReplicatedSlot& Slot : ReplicatedContents->Slots.Slots)
+	{
+		if (Slot.SlotIndex < 0)
+		{
+			continue;
+		}
+
+		if (Slot.SlotIndex >= Items.Num())
+		{
+			Items.SetNum(Slot.SlotIndex + 1);
+		}
+		Slot.CopyTo(Items[Slot.SlotIndex]);
+	}
+
+	bReplayingPrediction = true;
+}
+
+void UInventoryComponent::EndPredictionReplay()
+{
+	check(bReplayingPrediction);
+	bReplayingPrediction = false;
+
+	if (SearchIndex.IsBuilt() && Items.Num() != ReplayBaseline.Num())
+	{
+		SearchIndex.Build(Items);
+	}
+
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		const FInventoryItem& Item = Items[i];
+		if (!ReplayBaseline.IsValidIndex(i))
+		{
+			if (Item.IsValid())
+			{
+				NotifySlotChanged(i);
+			}
+			continue;
+		}
+
+		// Empty slots get a fresh InstanceID on every rebuild, they only compare by being empty
+		const FInventoryItem& Before = ReplayBaseline[i];
+		const bool bSame = Before.IsValid() == Item.IsValid() && (!Item.IsValid() ||
+			(Before.InstanceID == Item.InstanceID && Before.ItemData == Item.ItemData && Before.Quantity == Item.Quantity
+				&& Before.InstanceMetadata.OrderIndependentCompareEqual(Item.InstanceMetadata)));
+		if (!bSame)
+		{
+			NotifySlotChanged(i);
+		}
+	}
+
+	ReplayBaseline.Empty();
+}
+
+const FInventorySearchIndex& UInventoryComponent::GetSearchIndex()
+{
+	EnsureResident();
+
+	if (!SearchIndex.IsBuilt())
+	{
+		SearchIndex.Build(Items);
+	}
+	return SearchIndex;
+}
+
+int32 UInventoryComponent::GetMaxStackSize(const UInventoryItemData* ItemData) const
+{
+	return ItemData ? FMath::Max(ItemData->MaxStackSize, 1) : 1;
+}
+
 bool UInventoryComponent::CanStack(const FInventoryItem& ItemA, const FInventoryItem& ItemB) const
 {
 	if (!ItemA.IsValid() || !ItemB.IsValid())
@@ -457,7 +1736,7 @@ bool UInventoryComponent::CanStack(const FInventoryItem& ItemA, const FInventory
 		return false;
 	}
 
-	if (ItemA.ItemData->MaxStackSize <= 1)
+	if (GetMaxStackSize(ItemA.ItemData) <= 1)
 	{
 		return false;
 	}
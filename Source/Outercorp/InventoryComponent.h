@@ -5,11 +5,30 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "InventoryItemData.h"
+#include "InventoryReplication.h"
+#include "InventorySearchIndex.h"
 #include "InventoryComponent.generated.h"
 
+struct FInventorySnapshot;
+struct FInventorySnapshotSlot;
+class UInventoryItemCatalogSubsystem;
+class UInventoryPredictionComponent;
+class APlayerController;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnInventoryUpdated, int32, SlotIndex, const FInventoryItem&, Item);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryCapacityChanged, int32, NewCapacity);
 
+/** Where a saved inventory's contents are kept */
+UENUM(BlueprintType)
+enum class EInventoryStorage : uint8
+{
+	/** Save file plus journal, loaded with the save (personal inventories) */
+	SaveFile,
+
+	/** Hangar database, read when first opened (station hangars, corp deliveries) */
+	Hangar
+};
+
 /**
  * Component that manages an inventory system
  * Inspired by Eve Online's container system
@@ -22,16 +41,30 @@ class OUTERCORP_API UInventoryComponent : public UActorComponent
 public:
 	UInventoryComponent();
 
+	virtual void PostInitProperties() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void ReadyForReplication() override;
+	virtual bool ReplicateSubobjects(class UActorChannel* Channel, class FOutBunch* Bunch, FReplicationFlags* RepFlags) override;
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	/** Array of inventory slots */
+	/** Array of inventory slots. On clients it is built from ReplicatedContents */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Inventory")
 	TArray<FInventoryItem> Items;
 
+	/** Occupied slots as sent to observing clients, kept in step with Items by NotifySlotChanged on the server */
+	UPROPERTY()
+	TObjectPtr<UInventoryReplicatedContents> ReplicatedContents;
+
+	/** Item types of the stacks while paged out, so every stack comes back even if the catalog can't find its type */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInventoryItemData>> PagedItemTypes;
+
 public:
 	/** Maximum number of item slots */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, ReplicatedUsing = OnRep_MaxSlots, Category = "Inventory")
 	int32 MaxSlots = 30;
 
 	/** Maximum weight capacity (0 = unlimited) */
@@ -41,6 +74,27 @@ public:
 	/** Maximum volume capacity (0 = unlimited) */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
 	float MaxVolume = 0.0f;
+
+	/** Name this inventory is saved under (None = not saved), must be unique across saved inventories */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
+	FName PersistenceKey;
+
+	/** Where the contents are saved when PersistenceKey is set */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory")
+	EInventoryStorage Storage = EInventoryStorage::SaveFile;
+
+	/** How close another player's pawn has to be to open the inventory, in cm (0 = only its owner can) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
+	float OpenRange = 500.0f;
+
+	/** How often players with the window open are checked against CanBeOpenedBy, in seconds (0 = never) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
+	float ObserverCheckInterval = 1.0f;
+
+	/** Slot count, weight and a few of the item types, replicated to every connection (contents only go to observers) */
+	UPROPERTY(Replicated, BlueprintReadOnly, Category = "Inventory")
+	FInventorySummary Summary;
+
 	/** Called when inventory is updated */
 	UPROPERTY(BlueprintAssignable, Category = "Inventory")
 	FOnInventoryUpdated OnInventoryUpdated;
@@ -53,6 +107,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	bool AddItem(UInventoryItemData* ItemData, int32 Quantity, int32& OutSlotIndex);
 
+	/** Add many items in one pass, anything that does not fit is returned in OutRejected */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool AddItems(const TArray<FItemQuantity>& ItemsToAdd, TArray<FItemQuantity>& OutRejected);
+
 	/** Remove item from specific slot */
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	bool RemoveItemAtSlot(int32 SlotIndex, int32 Quantity = 1);
@@ -61,10 +119,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	bool RemoveItemByInstanceID(FGuid InstanceID, int32 Quantity = 1);
 
+	/** Remove a quantity of an item type across stacks, fails without changes if not enough are held */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool RemoveItems(UInventoryItemData* ItemData, int32 Quantity);
+
 	/** Move item from one slot to another */
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	bool MoveItem(int32 FromSlot, int32 ToSlot, int32 Quantity = -1);
 
+	/** Move item into another inventory, keeping its instance ID when the whole stack moves */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool TransferItem(int32 FromSlot, UInventoryComponent* TargetInventory, int32 ToSlot, int32 Quantity = -1);
+
 	/** Split stack into new slot */
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	bool SplitStack(int32 SourceSlot, int32 TargetSlot, int32 Quantity);
@@ -83,12 +149,27 @@ public:
 
 	/** Get all items */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
-	TArray<FInventoryItem> GetAllItems() const { return Items; }
+	TArray<FInventoryItem> GetAllItems() const
+	{
+		EnsureResident();
+		return Items;
+	}
+
+	/** Read-only view of the slot array, without the copy GetAllItems makes */
+	const TArray<FInventoryItem>& GetItems() const
+	{
+		EnsureResident();
+		return Items;
+	}
 
 	/** Get current number of occupied slots */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
 	int32 GetOccupiedSlots() const;
 
+	/** Get total quantity held of an item type */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	int32 GetItemCount(const UInventoryItemData* ItemData) const;
+
 	/** Get current total weight */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
 	float GetCurrentWeight() const;
@@ -101,10 +182,26 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
 	bool CanAddItem(UInventoryItemData* ItemData, int32 Quantity = 1) const;
 
+	/** Whether the contents may change. False while a hangar's stored contents are still loading, or paged-out contents couldn't be read back; a change then would be overwritten by them */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	bool CanModifyContents() const;
+
 	/** Find first empty slot */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
 	int32 FindEmptySlot() const;
 
+	/** Find first empty slot that accepts the given item */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	int32 FindEmptySlotForItem(const UInventoryItemData* ItemData) const;
+
+	/** Check if a slot accepts the given item type (typed slots override this) */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	virtual bool CanPlaceItemInSlot(const UInventoryItemData* ItemData, int32 SlotIndex) const;
+
+	/** Find slot holding a specific item instance */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	int32 FindSlotByInstanceID(FGuid InstanceID) const;
+
 	/** Find item by ID */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
 	int32 FindItemByID(FName ItemID) const;
@@ -119,12 +216,188 @@ public:
 
 	/** Sort inventory by criteria */
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
-	void SortInventory(bool bByName = true);
+	virtual void SortInventory(bool bByName = true);
+
+	/** Name search index over the slots, built on first use and kept up to date afterwards */
+	const FInventorySearchIndex& GetSearchIndex();
+
+	/**
+	 * Make sure the contents are available, called when the inventory is opened. Hangar inventories
+	 * load here, asynchronously; on a client the viewing player is subscribed to the contents
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void RequestContents(APlayerController* Viewer = nullptr);
+
+	/** The viewing player no longer needs the contents, called when the inventory is closed */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void ReleaseContents(APlayerController* Viewer);
+
+	/** Whether a player may open the inventory: its owner always, anyone else from within OpenRange. The server checks it before sending the contents */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	bool CanBeOpenedBy(const APlayerController* Viewer) const;
+
+	/** Replicate the contents to a player (server), e.g. because they opened the window. The owning player always gets them */
+	void AddObserver(APlayerController* Observer);
+
+	/** Stop replicating the contents to a player (server) */
+	void RemoveObserver(APlayerController* Observer);
+
+	/** Whether a player gets the contents (server) */
+	bool IsObservedBy(const APlayerController* Observer) const;
+
+	/** Stop replicating to observers that can no longer open the inventory, e.g. out of OpenRange (server, every ObserverCheckInterval while observed) */
+	void RemoveObserversOutOfRange();
+
+	/** Whether the contents still arrive for a local player: it owns the inventory or has asked for them with RequestContents (client) */
+	bool IsReceivingContents(const APlayerController* Player) const;
+
+	/** Re-evaluate which player owns this inventory (server), call after the owning actor changes hands */
+	void UpdateOwnerObserver();
+
+	/** Network instance ID of the stack in a slot, 0 when empty or not (yet) known to the server */
+	uint32 GetNetInstanceID(int32 SlotIndex) const;
+
+	/** Serial of the last change to the replicated contents; on clients, of the last one received */
+	uint32 GetChangeSerial() const { return ReplicatedContents->ChangeSerial; }
+
+	/** Occupied slots as sent to observing clients */
+	UInventoryReplicatedContents* GetReplicatedContents() const { return ReplicatedContents; }
+
+	/** Copy the occupied slots for saving, safe to hand to another thread. False if the contents are paged out and their page can't be read */
+	bool CaptureSnapshot(FInventorySnapshot& OutSnapshot) const;
+
+	/** Copy one slot for saving (ItemID None when empty) */
+	FInventorySnapshotSlot CaptureSlot(int32 SlotIndex) const;
+
+	/** Replace the contents with a saved snapshot, resolving item IDs through the catalog. Returns the number of stacks that could not be resolved, all of them if the inventory doesn't allow the saved slot count */
+	int32 ApplySnapshot(const FInventorySnapshot& Snapshot, const UInventoryItemCatalogSubsystem* Catalog);
+
+	/** Encode the contents into a blob and free the slot array (UInventoryPagingSubsystem). Listeners are not told, nothing changed */
+	void PageOut(TArray<uint8>& OutBlob);
+
+	/** Restore contents paged out by PageOut, with the item types they held then */
+	void PageIn(const FInventorySnapshot& Snapshot, const UInventoryItemCatalogSubsystem* Catalog);
+
+	/** Whether the contents are currently paged out */
+	bool IsPagedOut() const { return bPagedOut; }
+
+	/** FPlatformTime::Seconds() of the first access through the public API in the frame of the last access */
+	double GetLastAccessTime() const { return LastAccessTime; }
+
+	/**
+	 * Heap memory held by the slots, search index and the server's replicated copy of them
+	 * The replicated copy stays resident while paged out, new observers are sent it whole.
+	 */
+	SIZE_T GetResidentSize() const;
+
+	/** Largest stack of an item type a slot of this inventory holds (typed slots may hold fewer than the item allows) */
+	virtual int32 GetMaxStackSize(const UInventoryItemData* ItemData) const;
+
+	/** Check if the inventory may have this many slots (fixed layouts allow only their own size) */
+	virtual bool IsCapacityAllowed(int32 NumSlots) const { return NumSlots >= 0; }
+
+	/** Check if two items can stack */
+	bool CanStack(const FInventoryItem& ItemA, const FInventoryItem& ItemB) const;
 
 protected:
 	/** Try to stack item with existing items */
 	bool TryStackItem(UInventoryItemData* ItemData, int32& Quantity, int32& OutSlotIndex);
 
-	/** Check if two items can stack */
-	bool CanStack(const FInventoryItem& ItemA, const FInventoryItem& ItemB) const;
+	/** Empty a slot whose stack ends there rather than moving elsewhere, cancelling the stack's item timers */
+	void DestroyStack(int32 SlotIndex);
+
+	/** Called after the contents of a slot changed, broadcasts OnInventoryUpdated */
+	virtual void NotifySlotChanged(int32 SlotIndex);
+
+	/** Called after the slot count changed, broadcasts OnInventoryCapacityChanged */
+	virtual void NotifyCapacityChanged();
+
+	/** Fault paged-out contents back in and record the access, once per frame. Every public entry point that reads or changes Items calls this */
+	void EnsureResident() const;
+
+	/** Build a slot array from a snapshot, preferring KnownItemTypes over the catalog. Returns the number of stacks whose item no longer exists */
+	int32 ResolveSnapshot(const FInventorySnapshot& Snapshot, const UInventoryItemCatalogSubsystem* Catalog, TArray<FInventoryItem>& OutItems,
+		TConstArrayView<TObjectPtr<UInventoryItemData>> KnownItemTypes = {}) const;
+
+	/** Tell the store a capacity change happened */
+	void NotifyCapacityStored();
+
+	/** Resize the client's slot array to the replicated capacity */
+	UFUNCTION()
+	virtual void OnRep_MaxSlots();
+
+	/** Mark MaxSlots for replication (push model) */
+	void MarkCapacityDirty();
+
+	/** Refresh Summary from the replicated contents (server) */
+	void UpdateSummary();
+
+	/** Search index, only maintained once something has searched */
+	FInventorySearchIndex SearchIndex;
+
+private:
+	friend struct FInventoryReplicatedSlot;
+	friend struct FInventoryReplicatedSlots;
+	friend class UInventoryReplicatedContents;
+	friend class UInventoryPredictionComponent;
+
+	/** Apply a replicated add, change or remove to the client's slot array */
+	void ApplyReplicatedSlot(const FInventoryReplicatedSlot& Slot, bool bRemoved);
+
+	/** A replicated update was applied as a whole */
+	void HandleReplicatedContents();
+
+	/** Whether a player is at the end of the inventory's actor's owner chain */
+	bool IsOwnedBy(const APlayerController* Player) const;
+
+	/** Resolve replicated item types once the catalog has loaded, for entries that arrived before it had (client) */
+	void WaitForCatalog();
+
+	UFUNCTION()
+	void HandleCatalogLoaded();
+
+	/** Reset the slot array to the replicated contents, without notifying, so predicted operations can be replayed on top */
+	void BeginPredictionReplay();
+
+	/** Notify the slots that came out of the replay different from before BeginPredictionReplay */
+	void EndPredictionReplay();
+
+	/** Journals changes of saved inventories, set in BeginPlay when PersistenceKey is set */
+	TWeakObjectPtr<class UInventorySaveSubsystem> SaveSubsystem;
+
+	/** Stores changes of hangar inventories, set in BeginPlay when PersistenceKey is set */
+	TWeakObjectPtr<class UInventoryHangarSubsystem> HangarSubsystem;
+
+	/** Pages the contents out while cold, set in BeginPlay on the authority */
+	TWeakObjectPtr<class UInventoryPagingSubsystem> PagingSubsystem;
+
+	/** Net condition group ReplicatedContents replicates to (server) */
+	FName ObserverGroup;
+
+	/** Players with the window open (server) */
+	TArray<TWeakObjectPtr<APlayerController>> Observers;
+
+	/** Player owning the inventory's actor (server) */
+	TWeakObjectPtr<APlayerController> OwnerObserver;
+
+	/** Runs RemoveObserversOutOfRange while Observers isn't empty (server) */
+	FTimerHandle ObserverCheckTimer;
+
+	/** Local players that asked for the contents and haven't released them (client) */
+	TArray<TWeakObjectPtr<APlayerController>> LocalViewers;
+
+	/** Has operations of this player in flight; replicated updates go through its Reconcile then (client) */
+	TWeakObjectPtr<UInventoryPredictionComponent> Predictor;
+
+	/** Slot array from before a prediction replay, to diff against */
+	TArray<FInventoryItem> ReplayBaseline;
+
+	bool bReplayingPrediction = false;
+
+	bool bPagedOut = false;
+
+	mutable double LastAccessTime = 0.0;
+
+	/** GFrameCounter when LastAccessTime was stamped, later accesses in that frame don't read the clock again */
+	mutable uint64 LastAccessFrame = MAX_uint64;
 };
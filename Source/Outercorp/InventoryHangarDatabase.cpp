@@ -0,0 +1,314 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryHangarDatabase.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Outercorp.h"
+
+FInventoryHangarDatabase::FInventoryHangarDatabase(const FString& Filename)
+{
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filename), true);
+
+	if (!Database.Open(*Filename))
+	{
+		UE_LOG(LogOutercorp, Error, TEXT("Failed to open hangar database %s: %s"), *Filename, *Database.GetLastError());
+		return;
+	}
+
+	// WAL keeps readers and the batch writer from blocking each other, NORMAL syncs once per checkpoint rather than per commit
+	Execute(TEXT("PRAGMA journal_mode=WAL;"));
+	Execute(TEXT("PRAGMA synchronous=NORMAL;"));
+
+	Execute(TEXT("CREATE TABLE IF NOT EXISTS inventories (key TEXT PRIMARY KEY, max_slots INTEGER NOT NULL) WITHOUT ROWID;"));
+	Execute(TEXT("CREATE TABLE IF NOT EXISTS stacks (key TEXT NOT NULL, slot INTEGER NOT NULL, item_id TEXT NOT NULL, quantity INTEGER NOT NULL, metadata BLOB, PRIMARY KEY (key, slot)) WITHOUT ROWID;"));
+	Execute(TEXT("CREATE INDEX IF NOT EXISTS stacks_by_item ON stacks (item_id);"));
+	Execute(TEXT("CREATE TABLE IF NOT EXISTS deliveries (id INTEGER PRIMARY KEY, key TEXT NOT NULL, item_id TEXT NOT NULL, quantity INTEGER NOT NULL);"));
+	Execute(TEXT("CREATE INDEX IF NOT EXISTS deliveries_by_key ON deliveries (key);"));
+
+	// Version 1 added stacks.instance_id, databases written before it get the column with NULLs (a fresh ID on load)
+	int32 SchemaVersion = 0;
+	Database.GetUserVersion(SchemaVersion);
+	if (SchemaVersion < 1 && Execute(TEXT("ALTER TABLE stacks ADD COLUMN instance_id TEXT;")))
+	{
+		Database.SetUserVersion(1);
+	}
+
+	constexpr ESQLitePreparedStatementFlags Persistent = ESQLitePreparedStatementFlags::Persistent;
+	EnsureInventory = Database.PrepareStatement(TEXT("INSERT OR IGNORE INTO inventories (key, max_slots) VALUES (?1, 0);"), Persistent);
+	UpsertInventory = Database.PrepareStatement(TEXT("INSERT INTO inventories (key, max_slots) VALUES (?1, ?2) ON CONFLICT (key) DO UPDATE SET max_slots = excluded.max_slots;"), Persistent);
+	UpsertStack = Database.PrepareStatement(TEXT("INSERT INTO stacks (key, slot, item_id, quantity, metadata, instance_id) VALUES (?1, ?2, ?3, ?4, ?5, ?6) ON CONFLICT (key, slot) DO UPDATE SET item_id = excluded.item_id, quantity = excluded.quantity, metadata = excluded.metadata, instance_id = excluded.instance_id;"), Persistent);
+	DeleteStack = Database.PrepareStatement(TEXT("DELETE FROM stacks WHERE key = ?1 AND slot = ?2;"), Persistent);
+	SelectInventory = Database.PrepareStatement(TEXT("SELECT max_slots FROM inventories WHERE key = ?1;"), Persistent);
+	SelectStacks = Database.PrepareStatement(TEXT("SELECT slot, item_id, quantity, metadata, instance_id FROM stacks WHERE key = ?1 ORDER BY slot;"), Persistent);
+	SelectStacksByItem = Database.PrepareStatement(TEXT("SELECT key, slot, quantity, metadata, instance_id FROM stacks WHERE item_id = ?1;"), Persistent);
+	InsertDelivery = Database.PrepareStatement(TEXT("INSERT INTO deliveries (key, item_id, quantity) VALUES (?1, ?2, ?3);"), Persistent);
+	SelectDeliveries = Database.PrepareStatement(TEXT("SELECT id, item_id, quantity FROM deliveries WHERE key = ?1 ORDER BY id;"), Persistent);
+	DeleteDeliveries = Database.PrepareStatement(TEXT("DELETE FROM deliveries WHERE key = ?1 AND id <= ?2;"), Persistent);
+}
+
+FInventoryHangarDatabase::~FInventoryHangarDatabase()
+{
+	// Statements must be finalized before the connection closes
+	EnsureInventory.Destroy();
+	UpsertInventory.Destroy();
+	UpsertStack.Destroy();
+	DeleteStack.Destroy();
+	SelectInventory.Destroy();
+	SelectStacks.Destroy();
+	SelectStacksByItem.Destroy();
+	InsertDelivery.Destroy();
+	SelectDeliveries.Destroy();
+	DeleteDeliveries.Destroy();
+
+	if (Database.IsValid())
+	{
+		Database.Close();
+	}
+}
+
+bool FInventoryHangarDatabase::WriteBatch(const FInventoryHangarBatch& Batch)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	if (!Execute(TEXT("BEGIN IMMEDIATE;")))
+	{
+		return false;
+	}
+
+	bool bSucceeded = true;
+	TArray<uint8> Metadata;
+
+	for (const FInventoryHangarBatch::FInventoryRows& Rows : Batch.Inventories)
+	{
+		const FString Key = Rows.PersistenceKey.ToString();
+
+		if (Rows.MaxSlots != INDEX_NONE)
+		{
+			UpsertInventory.SetBindingValueByIndex(1, Key);
+			UpsertInventory.SetBindingValueByIndex(2, static_cast<int64>(Rows.MaxSlots));
+			bSucceeded &= StepAndReset(UpsertInventory);
+		}
+		else
+		{
+			EnsureInventory.SetBindingValueByIndex(1, Key);
+			bSucceeded &= StepAndReset(EnsureInventory);
+		}
+
+		for (const FInventorySnapshotSlot& Slot : Rows.Slots)
+		{
+			if (Slot.ItemID.IsNone() || Slot.Quantity <= 0)
+			{
+				DeleteStack.SetBindingValueByIndex(1, Key);
+				DeleteStack.SetBindingValueByIndex(2, static_cast<int64>(Slot.SlotIndex));
+				bSucceeded &= StepAndReset(DeleteStack);
+				continue;
+			}
+
+			Metadata.Reset();
+			InventoryArchive::EncodeMetadata(Slot.Metadata, Metadata);
+
+			UpsertStack.SetBindingValueByIndex(1, Key);
+			UpsertStack.SetBindingValueByIndex(2, static_cast<int64>(Slot.SlotIndex));
+			UpsertStack.SetBindingValueByIndex(3, Slot.ItemID.ToString());
+			UpsertStack.SetBindingValueByIndex(4, static_cast<int64>(Slot.Quantity));
+			UpsertStack.SetBindingValueByIndex(5, TArrayView<const uint8>(Metadata));
+			UpsertStack.SetBindingValueByIndex(6, Slot.InstanceID.ToString(EGuidFormats::Digits));
+			bSucceeded &= StepAndReset(UpsertStack);
+		}
+
+		if (Rows.ClearDeliveriesThrough != INDEX_NONE)
+		{
+			DeleteDeliveries.SetBindingValueByIndex(1, Key);
+			DeleteDeliveries.SetBindingValueByIndex(2, Rows.ClearDeliveriesThrough);
+			bSucceeded &= StepAndReset(DeleteDeliveries);
+		}
+
+		if (!bSucceeded)
+		{
+			break;
+		}
+	}
+
+	if (!bSucceeded)
+	{
+		LogError(TEXT("write batch"));
+		Execute(TEXT("ROLLBACK;"));
+		return false;
+	}
+
+	// A failed COMMIT (e.g. disk full) can leave the transaction open, which would swallow every later batch
+	if (!Execute(TEXT("COMMIT;")))
+	{
+		Execute(TEXT("ROLLBACK;"));
+		return false;
+	}
+	return true;
+}
+
+bool FInventoryHangarDatabase::ReadInventory(FName PersistenceKey, FInventorySnapshot& OutSnapshot)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	const FString Key = PersistenceKey.ToString();
+
+	bool bFound = false;
+	SelectInventory.SetBindingValueByIndex(1, Key);
+	SelectInventory.Execute([&OutSnapshot, &bFound](const FSQLitePreparedStatement& Row)
+	{
+		int64 MaxSlots = 0;
+		Row.GetColumnValueByIndex(0, MaxSlots);
+		OutSnapshot.MaxSlots = static_cast<int32>(MaxSlots);
+		bFound = true;
+		return ESQLitePreparedStatementExecuteRowResult::Stop;
+	});
+	SelectInventory.Reset();
+	SelectInventory.ClearBindings();
+
+	if (!bFound)
+	{
+		return false;
+	}
+
+	OutSnapshot.PersistenceKey = PersistenceKey;
+	OutSnapshot.Slots.Reset();
+
+	SelectStacks.SetBindingValueByIndex(1, Key);
+	SelectStacks.Execute([&OutSnapshot](const FSQLitePreparedStatement& Row)
+	{
+		int64 SlotIndex = 0;
+		FString ItemID;
+		int64 Quantity = 0;
+		TArray<uint8> Metadata;
+		FString InstanceID;
+		Row.GetColumnValueByIndex(0, SlotIndex);
+		Row.GetColumnValueByIndex(1, ItemID);
+		Row.GetColumnValueByIndex(2, Quantity);
+		Row.GetColumnValueByIndex(3, Metadata);
+		Row.GetColumnValueByIndex(4, InstanceID);
+
+		FInventorySnapshotSlot& Slot = OutSnapshot.Slots.AddDefaulted_GetRef();
+		Slot.SlotIndex = static_cast<int32>(SlotIndex);
+		Slot.ItemID = FName(*ItemID);
+		Slot.Quantity = static_cast<int32>(Quantity);
+		InventoryArchive::DecodeMetadata(Metadata, Slot.Metadata);
+
+		// NULL in rows written before the column existed, the stack then gets a new ID
+		FGuid::Parse(InstanceID, Slot.InstanceID);
+		return ESQLitePreparedStatementExecuteRowResult::Continue;
+	});
+	SelectStacks.Reset();
+	SelectStacks.ClearBindings();
+
+	return true;
+}
+
+bool FInventoryHangarDatabase::AddDelivery(FName PersistenceKey, const FInventoryHangarDelivery& Delivery)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	InsertDelivery.SetBindingValueByIndex(1, PersistenceKey.ToString());
+	InsertDelivery.SetBindingValueByIndex(2, Delivery.ItemID.ToString());
+	InsertDelivery.SetBindingValueByIndex(3, static_cast<int64>(Delivery.Quantity));
+	if (!StepAndReset(InsertDelivery))
+	{
+		LogError(TEXT("add delivery"));
+		return false;
+	}
+	return true;
+}
+
+TArray<FInventoryHangarDelivery> FInventoryHangarDatabase::ReadDeliveries(FName PersistenceKey)
+{
+	TArray<FInventoryHangarDelivery> Deliveries;
+	if (!IsOpen())
+	{
+		return Deliveries;
+	}
+
+	SelectDeliveries.SetBindingValueByIndex(1, PersistenceKey.ToString());
+	SelectDeliveries.Execute([&Deliveries](const FSQLitePreparedStatement& Row)
+	{
+		FInventoryHangarDelivery& Delivery = Deliveries.AddDefaulted_GetRef();
+		FString ItemID;
+		int64 Quantity = 0;
+		Row.GetColumnValueByIndex(0, Delivery.ID);
+		Row.GetColumnValueByIndex(1, ItemID);
+		Row.GetColumnValueByIndex(2, Quantity);
+		Delivery.ItemID = FName(*ItemID);
+		Delivery.Quantity = static_cast<int32>(Quantity);
+		return ESQLitePreparedStatementExecuteRowResult::Continue;
+	});
+	SelectDeliveries.Reset();
+	SelectDeliveries.ClearBindings();
+
+	return Deliveries;
+}
+
+TArray<FInventoryHangarStack> FInventoryHangarDatabase::FindStacks(FName ItemID)
+{
+	TArray<FInventoryHangarStack> Stacks;
+	if (!IsOpen())
+	{
+		return Stacks;
+	}
+
+	SelectStacksByItem.SetBindingValueByIndex(1, ItemID.ToString());
+	SelectStacksByItem.Execute([&Stacks, ItemID](const FSQLitePreparedStatement& Row)
+	{
+		FString Key;
+		int64 SlotIndex = 0;
+		int64 Quantity = 0;
+		TArray<uint8> Metadata;
+		FString InstanceID;
+		Row.GetColumnValueByIndex(0, Key);
+		Row.GetColumnValueByIndex(1, SlotIndex);
+		Row.GetColumnValueByIndex(2, Quantity);
+		Row.GetColumnValueByIndex(3, Metadata);
+		Row.GetColumnValueByIndex(4, InstanceID);
+
+		FInventoryHangarStack& Stack = Stacks.AddDefaulted_GetRef();
+		Stack.PersistenceKey = FName(*Key);
+		Stack.Slot.SlotIndex = static_cast<int32>(SlotIndex);
+		Stack.Slot.ItemID = ItemID;
+		Stack.Slot.Quantity = static_cast<int32>(Quantity);
+		InventoryArchive::DecodeMetadata(Metadata, Stack.Slot.Metadata);
+		FGuid::Parse(InstanceID, Stack.Slot.InstanceID);
+		return ESQLitePreparedStatementExecuteRowResult::Continue;
+	});
+	SelectStacksByItem.Reset();
+	SelectStacksByItem.ClearBindings();
+
+	return Stacks;
+}
+
+bool FInventoryHangarDatabase::Execute(const TCHAR* Statement)
+{
+	if (!Database.Execute(Statement))
+	{
+		LogError(Statement);
+		return false;
+	}
+	return true;
+}
+
+bool FInventoryHangarDatabase::StepAndReset(FSQLitePreparedStatement& Statement)
+{
+	const bool bDone = Statement.Step() == ESQLitePreparedStatementStepResult::Done;
+	Statement.Reset();
+	Statement.ClearBindings();
+	return bDone;
+}
+
+void FInventoryHangarDatabase::LogError(const TCHAR* Context) const
+{
+	UE_LOG(LogOutercorp, Error, TEXT("Hangar database error (%s): %s"), Context, *Database.GetLastError());
+}
@@ -0,0 +1,97 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SQLiteDatabase.h"
+#include "InventoryArchive.h"
+
+/** A stored stack, as returned by cross-hangar queries */
+struct FInventoryHangarStack
+{
+	FName PersistenceKey;
+	FInventorySnapshotSlot Slot;
+};
+
+/** Item delivered to a hangar while it was not loaded */
+struct FInventoryHangarDelivery
+{
+	/** Row ID, increasing in delivery order */
+	int64 ID = 0;
+
+	FName ItemID;
+	int32 Quantity = 0;
+};
+
+/** Rows to write in one transaction */
+struct FInventoryHangarBatch
+{
+	struct FInventoryRows
+	{
+		FName PersistenceKey;
+
+		/** New capacity, INDEX_NONE when unchanged */
+		int32 MaxSlots = INDEX_NONE;
+
+		/** New slot contents, ItemID None deletes the row */
+		TArray<FInventorySnapshotSlot> Slots;
+
+		/** Deliveries up to this ID have been added to the slots above, INDEX_NONE if none */
+		int64 ClearDeliveriesThrough = INDEX_NONE;
+	};
+
+	TArray<FInventoryRows> Inventories;
+
+	bool IsEmpty() const { return Inventories.Num() == 0; }
+};
+
+/**
+ * SQLite store for hangar inventories
+ * One row per inventory and one per occupied slot, keyed by PersistenceKey, with an index
+ * on item ID so hangars can be searched without loading them. Not thread safe: the hangar
+ * subsystem runs every call on one task pipe.
+ */
+class OUTERCORP_API FInventoryHangarDatabase
+{
+public:
+	explicit FInventoryHangarDatabase(const FString& Filename);
+	~FInventoryHangarDatabase();
+
+	bool IsOpen() const { return Database.IsValid(); }
+
+	/** Write a batch in a single transaction, rolled back on failure */
+	bool WriteBatch(const FInventoryHangarBatch& Batch);
+
+	/** Read one inventory. False if it has never been stored */
+	bool ReadInventory(FName PersistenceKey, FInventorySnapshot& OutSnapshot);
+
+	/** Queue an item for a hangar that is not loaded */
+	bool AddDelivery(FName PersistenceKey, const FInventoryHangarDelivery& Delivery);
+
+	/** A hangar's queued deliveries. They stay queued until a batch clears them, so a crash before the items are written can't lose them */
+	TArray<FInventoryHangarDelivery> ReadDeliveries(FName PersistenceKey);
+
+	/** Every stored stack of an item type, across all hangars */
+	TArray<FInventoryHangarStack> FindStacks(FName ItemID);
+
+private:
+	bool Execute(const TCHAR* Statement);
+
+	/** Step a statement that returns no rows, then reset it for reuse */
+	bool StepAndReset(FSQLitePreparedStatement& Statement);
+
+	void LogError(const TCHAR* Context) const;
+
+	FSQLiteDatabase Database;
+
+	FSQLitePreparedStatement EnsureInventory;
+	FSQLitePreparedStatement UpsertInventory;
+	FSQLitePreparedStatement UpsertStack;
+	FSQLitePreparedStatement DeleteStack;
+	FSQLitePreparedStatement SelectInventory;
+	FSQLitePreparedStatement SelectStacks;
+	FSQLitePreparedStatement SelectStacksByItem;
+	FSQLitePreparedStatement InsertDelivery;
+	FSQLitePreparedStatement SelectDeliveries;
+	FSQLitePreparedStatement DeleteDeliveries;
+};
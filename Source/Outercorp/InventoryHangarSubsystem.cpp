@@ -0,0 +1,431 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryHangarSubsystem.h"
+#include "InventoryComponent.h"
+#include "InventoryItemCatalog.h"
+#include "Engine/GameInstance.h"
+#include "Misc/Paths.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory Hangar Write"), STAT_InventoryHangarWrite, STATGROUP_Inventory);
+DECLARE_CYCLE_STAT(TEXT("Inventory Hangar Read"), STAT_InventoryHangarRead, STATGROUP_Inventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Hangar Rows Written"), STAT_InventoryHangarRows, STATGROUP_Inventory);
+
+void UInventoryHangarSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UInventoryItemCatalogSubsystem>();
+
+	Database = MakeShared<FInventoryHangarDatabase>(FPaths::ProjectSavedDir() / DatabaseFilename);
+	if (!Database->IsOpen())
+	{
+		Database.Reset();
+	}
+
+	FlushTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &UInventoryHangarSubsystem::HandleFlushTicker), FMath::Max(FlushInterval, 0.0f));
+}
+
+void UInventoryHangarSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(FlushTickerHandle);
+
+	FlushAndWait();
+	Entries.Empty();
+	Database.Reset();
+
+	if (UInventoryItemCatalogSubsystem* Catalog = GetGameInstance()->GetSubsystem<UInventoryItemCatalogSubsystem>())
+	{
+		Catalog->OnCatalogLoaded.RemoveDynamic(this, &UInventoryHangarSubsystem::HandleCatalogLoaded);
+	}
+
+	Super::Deinitialize();
+}
+
+void UInventoryHangarSubsystem::RegisterInventory(UInventoryComponent* Inventory)
+{
+	if (!Inventory || Inventory->PersistenceKey.IsNone())
+	{
+		return;
+	}
+
+	FHangarEntry& Entry = Entries.FindOrAdd(Inventory->PersistenceKey);
+	if (Entry.Inventory.IsValid() && Entry.Inventory != Inventory)
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("Hangar %s is already registered by %s, ignoring %s"),
+			*Inventory->PersistenceKey.ToString(), *Entry.Inventory->GetPathName(), *Inventory->GetPathName());
+		return;
+	}
+
+	Entry.Inventory = Inventory;
+}
+
+void UInventoryHangarSubsystem::UnregisterInventory(UInventoryComponent* Inventory)
+{
+	if (!Inventory)
+	{
+		return;
+	}
+
+	const FHangarEntry* Entry = Entries.Find(Inventory->PersistenceKey);
+	if (Entry && Entry->Inventory == Inventory)
+	{
+		Flush();
+		Entries.Remove(Inventory->PersistenceKey);
+	}
+}
+
+void UInventoryHangarSubsystem::LoadInventory(UInventoryComponent* Inventory)
+{
+	if (!Inventory)
+	{
+		return;
+	}
+
+	const FName Key = Inventory->PersistenceKey;
+	FHangarEntry* Entry = Entries.Find(Key);
+	if (!Entry || Entry->Inventory != Inventory || Entry->bLoaded || Entry->bLoading)
+	{
+		return;
+	}
+
+	// Nothing stored to wait for, changes just won't be kept
+	if (!Database)
+	{
+		Entry->bLoaded = true;
+		return;
+	}
+
+	// Stored item IDs can only be resolved once the catalog is in
+	UInventoryItemCatalogSubsystem* Catalog = GetGameInstance()->GetSubsystem<UInventoryItemCatalogSubsystem>();
+	if (Catalog && !Catalog->IsCatalogLoaded())
+	{
+		Entry->bLoadRequested = true;
+		Catalog->OnCatalogLoaded.AddUniqueDynamic(this, &UInventoryHangarSubsystem::HandleCatalogLoaded);
+		return;
+	}
+
+	Entry->bLoadRequested = false;
+	Entry->bLoading = true;
+
+	LaunchOnPipe([WeakThis = TWeakObjectPtr<UInventoryHangarSubsystem>(this), Key](FInventoryHangarDatabase& Db)
+	{
+		FInventorySnapshot Snapshot;
+		TArray<FInventoryHangarDelivery> Deliveries;
+		bool bStored = false;
+		{
+			SCOPE_CYCLE_COUNTER(STAT_InventoryHangarRead);
+			bStored = Db.ReadInventory(Key, Snapshot);
+			Deliveries = Db.ReadDeliveries(Key);
+		}
+
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, Key, Snapshot = MoveTemp(Snapshot), bStored, Deliveries = MoveTemp(Deliveries)]() mutable
+		{
+			if (UInventoryHangarSubsystem* This = WeakThis.Get())
+			{
+				This->ApplyLoadedContents(Key, MoveTemp(Snapshot), bStored, MoveTemp(Deliveries));
+			}
+		}, UE::Tasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+	});
+}
+
+bool UInventoryHangarSubsystem::IsInventoryLoaded(const UInventoryComponent* Inventory) const
+{
+	const FHangarEntry* Entry = Inventory ? Entries.Find(Inventory->PersistenceKey) : nullptr;
+	return Entry && Entry->Inventory == Inventory && Entry->bLoaded;
+}
+
+void UInventoryHangarSubsystem::MarkSlotDirty(const UInventoryComponent& Inventory, int32 SlotIndex)
+{
+	FHangarEntry* Entry = Entries.Find(Inventory.PersistenceKey);
+	if (!Entry || Entry->bApplying)
+	{
+		return;
+	}
+
+	// The component refuses changes until loaded (CanModifyContents), only direct writes to its slots get here
+	if (!ensureMsgf(Entry->bLoaded, TEXT("Hangar %s changed before it was loaded, the change is not stored (use DeliverItems)"), *Inventory.PersistenceKey.ToString()))
+	{
+		return;
+	}
+
+	Entry->DirtySlots.Add(SlotIndex);
+}
+
+void UInventoryHangarSubsystem::MarkCapacityDirty(const UInventoryComponent& Inventory)
+{
+	FHangarEntry* Entry = Entries.Find(Inventory.PersistenceKey);
+	if (Entry && Entry->bLoaded && !Entry->bApplying)
+	{
+		Entry->bCapacityDirty = true;
+	}
+}
+
+bool UInventoryHangarSubsystem::DeliverItems(FName PersistenceKey, const TArray<FItemQuantity>& Items)
+{
+	// Nowhere to keep them, the caller holds on to the items
+	if (!Database)
+	{
+		return false;
+	}
+
+	TArray<FItemQuantity> Undelivered;
+
+	const FHangarEntry* Entry = Entries.Find(PersistenceKey);
+	UInventoryComponent* Inventory = Entry && Entry->bLoaded ? Entry->Inventory.Get() : nullptr;
+	if (Inventory)
+	{
+		Inventory->AddItems(Items, Undelivered);
+	}
+	else
+	{
+		Undelivered = Items;
+	}
+
+	TArray<FInventoryHangarDelivery> Deliveries;
+	for (const FItemQuantity& Item : Undelivered)
+	{
+		if (Item.ItemData && Item.Quantity > 0)
+		{
+			FInventoryHangarDelivery& Delivery = Deliveries.AddDefaulted_GetRef();
+			Delivery.ItemID = Item.ItemData->ItemID;
+			Delivery.Quantity = Item.Quantity;
+		}
+	}
+
+	if (Deliveries.Num() > 0)
+	{
+		LaunchOnPipe([PersistenceKey, Deliveries = MoveTemp(Deliveries)](FInventoryHangarDatabase& Db)
+		{
+			for (const FInventoryHangarDelivery& Delivery : Deliveries)
+			{
+				Db.AddDelivery(PersistenceKey, Delivery);
+			}
+		});
+	}
+	return true;
+}
+
+void UInventoryHangarSubsystem::FindStacks(FName ItemID, TFunction<void(TArray<FInventoryHangarStack>&&)> OnFound)
+{
+	LaunchOnPipe([ItemID, OnFound = MoveTemp(OnFound)](FInventoryHangarDatabase& Db) mutable
+	{
+		TArray<FInventoryHangarStack> Stacks;
+		{
+			SCOPE_CYCLE_COUNTER(STAT_InventoryHangarRead);
+			Stacks = Db.FindStacks(ItemID);
+		}
+
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [OnFound = MoveTemp(OnFound), Stacks = MoveTemp(Stacks)]() mutable
+		{
+			OnFound(MoveTemp(Stacks));
+		}, UE::Tasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+	});
+}
+
+void UInventoryHangarSubsystem::Flush()
+{
+	// Retried rows go first, so newer rows of the same hangar overwrite them in the transaction
+	FInventoryHangarBatch Batch = MoveTemp(RetryBatch);
+	RetryBatch.Inventories.Reset();
+	for (TPair<FName, FHangarEntry>& Pair : Entries)
+	{
+		CaptureDirtyRows(Pair.Key, Pair.Value, Batch);
+	}
+
+	if (Batch.IsEmpty())
+	{
+		return;
+	}
+
+	LaunchOnPipe([WeakThis = TWeakObjectPtr<UInventoryHangarSubsystem>(this), Batch = MoveTemp(Batch)](FInventoryHangarDatabase& Db) mutable
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InventoryHangarWrite);
+
+		if (Db.WriteBatch(Batch))
+		{
+			for (const FInventoryHangarBatch::FInventoryRows& Rows : Batch.Inventories)
+			{
+				INC_DWORD_STAT_BY(STAT_InventoryHangarRows, Rows.Slots.Num());
+			}
+			return;
+		}
+
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, Batch = MoveTemp(Batch)]() mutable
+		{
+			if (UInventoryHangarSubsystem* This = WeakThis.Get())
+			{
+				This->HandleBatchFailed(MoveTemp(Batch));
+			}
+		}, UE::Tasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+	});
+}
+
+void UInventoryHangarSubsystem::HandleBatchFailed(FInventoryHangarBatch&& Batch)
+{
+	int32 NumRetried = 0;
+	for (FInventoryHangarBatch::FInventoryRows& Rows : Batch.Inventories)
+	{
+		// A live hangar recaptures the slots from its current contents on the next flush
+		FHangarEntry* Entry = Entries.Find(Rows.PersistenceKey);
+		if (Entry && Entry->Inventory.IsValid())
+		{
+			for (const FInventorySnapshotSlot& Slot : Rows.Slots)
+			{
+				Entry->DirtySlots.Add(Slot.SlotIndex);
+			}
+			Entry->bCapacityDirty |= Rows.MaxSlots != INDEX_NONE;
+			Entry->ClearDeliveriesThrough = FMath::Max(Entry->ClearDeliveriesThrough, Rows.ClearDeliveriesThrough);
+		}
+		else
+		{
+			RetryBatch.Inventories.Add(MoveTemp(Rows));
+			++NumRetried;
+		}
+	}
+
+	UE_LOG(LogOutercorp, Warning, TEXT("Hangar write failed, retrying %d inventories on the next flush (%d no longer loaded)"), Batch.Inventories.Num(), NumRetried);
+}
+
+void UInventoryHangarSubsystem::FlushAndWait()
+{
+	Flush();
+	Pipe.WaitUntilEmpty();
+}
+
+void UInventoryHangarSubsystem::CaptureDirtyRows(FName PersistenceKey, FHangarEntry& Entry, FInventoryHangarBatch& Batch)
+{
+	const UInventoryComponent* Inventory = Entry.Inventory.Get();
+	if (!Inventory || (Entry.DirtySlots.Num() == 0 && !Entry.bCapacityDirty && Entry.ClearDeliveriesThrough == INDEX_NONE))
+	{
+		Entry.DirtySlots.Reset();
+		return;
+	}
+
+	// A page that can't be read leaves the slots empty, writing them would delete the rows. Kept dirty for a later flush
+	const TArray<FInventoryItem>& Items = Inventory->GetItems();
+	if (Inventory->IsPagedOut())
+	{
+		return;
+	}
+
+	FInventoryHangarBatch::FInventoryRows& Rows = Batch.Inventories.AddDefaulted_GetRef();
+	Rows.PersistenceKey = PersistenceKey;
+	Rows.MaxSlots = Entry.bCapacityDirty ? Inventory->MaxSlots : INDEX_NONE;
+	Rows.ClearDeliveriesThrough = Entry.ClearDeliveriesThrough;
+
+	// Slots beyond the current size were shrunk away and are deleted
+	Rows.Slots.Reserve(Entry.DirtySlots.Num());
+	for (int32 SlotIndex : Entry.DirtySlots)
+	{
+		if (Items.IsValidIndex(SlotIndex))
+		{
+			Rows.Slots.Add(Inventory->CaptureSlot(SlotIndex));
+		}
+		else
+		{
+			Rows.Slots.AddDefaulted_GetRef().SlotIndex = SlotIndex;
+		}
+	}
+
+	Entry.DirtySlots.Reset();
+	Entry.bCapacityDirty = false;
+	Entry.ClearDeliveriesThrough = INDEX_NONE;
+}
+
+void UInventoryHangarSubsystem::LaunchOnPipe(TUniqueFunction<void(FInventoryHangarDatabase&)>&& Work)
+{
+	if (!Database)
+	{
+		return;
+	}
+
+	Pipe.Launch(UE_SOURCE_LOCATION, [Database = Database, Work = MoveTemp(Work)]()
+	{
+		Work(*Database);
+	});
+}
+
+void UInventoryHangarSubsystem::ApplyLoadedContents(FName PersistenceKey, FInventorySnapshot&& Snapshot, bool bStored, TArray<FInventoryHangarDelivery>&& Deliveries)
+{
+	FHangarEntry* Entry = Entries.Find(PersistenceKey);
+	UInventoryComponent* Inventory = Entry ? Entry->Inventory.Get() : nullptr;
+	if (!Inventory)
+	{
+		// Gone before the read finished, deliveries stay queued
+		return;
+	}
+
+	const UInventoryItemCatalogSubsystem* Catalog = GetGameInstance()->GetSubsystem<UInventoryItemCatalogSubsystem>();
+
+	if (bStored)
+	{
+		TGuardValue<bool> ApplyingGuard(Entry->bApplying, true);
+		Inventory->ApplySnapshot(Snapshot, Catalog);
+	}
+
+	Entry->bLoading = false;
+	Entry->bLoaded = true;
+
+	if (Deliveries.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FItemQuantity> Items;
+	for (const FInventoryHangarDelivery& Delivery : Deliveries)
+	{
+		UInventoryItemData* ItemData = Catalog ? Catalog->FindItem(Delivery.ItemID) : nullptr;
+		if (ItemData)
+		{
+			Items.Emplace(ItemData, Delivery.Quantity);
+		}
+		else
+		{
+			UE_LOG(LogOutercorp, Warning, TEXT("Hangar %s: delivered item '%s' no longer exists, dropping %d"),
+				*PersistenceKey.ToString(), *Delivery.ItemID.ToString(), Delivery.Quantity);
+		}
+	}
+
+	TArray<FItemQuantity> Rejected;
+	Inventory->AddItems(Items, Rejected);
+
+	// The added slots and the delivery rows they came from go out in one transaction
+	Entry->ClearDeliveriesThrough = Deliveries.Last().ID;
+	Flush();
+
+	// Whatever didn't fit waits for the next load
+	if (Rejected.Num() > 0)
+	{
+		DeliverItems(PersistenceKey, Rejected);
+	}
+}
+
+void UInventoryHangarSubsystem::HandleCatalogLoaded()
+{
+	if (UInventoryItemCatalogSubsystem* Catalog = GetGameInstance()->GetSubsystem<UInventoryItemCatalogSubsystem>())
+	{
+		Catalog->OnCatalogLoaded.RemoveDynamic(this, &UInventoryHangarSubsystem::HandleCatalogLoaded);
+	}
+
+	TArray<UInventoryComponent*> ToLoad;
+	for (const TPair<FName, FHangarEntry>& Pair : Entries)
+	{
+		if (Pair.Value.bLoadRequested && Pair.Value.Inventory.IsValid())
+		{
+			ToLoad.Add(Pair.Value.Inventory.Get());
+		}
+	}
+
+	for (UInventoryComponent* Inventory : ToLoad)
+	{
+		LoadInventory(Inventory);
+	}
+}
+
+bool UInventoryHangarSubsystem::HandleFlushTicker(float DeltaTime)
+{
+	Flush();
+	return true;
+}
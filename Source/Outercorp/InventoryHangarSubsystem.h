@@ -0,0 +1,118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Tasks/Pipe.h"
+#include "InventoryHangarDatabase.h"
+#include "InventoryItemData.h"
+#include "InventoryHangarSubsystem.generated.h"
+
+class UInventoryComponent;
+
+/**
+ * Keeps hangar inventories (components with Storage = Hangar) in a local SQLite database
+ * A hangar's contents are only read when it is first opened. Changes mark slots dirty; every
+ * FlushInterval the dirty slots are copied and written as one transaction on a background
+ * task pipe, so repeated edits of a slot cost one row write. Until its contents are applied a
+ * hangar refuses changes (UInventoryComponent::CanModifyContents), since the load would
+ * overwrite them. Items delivered to hangars that aren't loaded go straight to the database
+ * and are added when the hangar loads.
+ */
+UCLASS(Config = Game)
+class OUTERCORP_API UInventoryHangarSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Database file, relative to the project Saved directory */
+	UPROPERTY(Config, BlueprintReadOnly, Category = "Inventory")
+	FString DatabaseFilename = TEXT("Inventories/Hangars.db");
+
+	/** How often dirty rows are written, in seconds */
+	UPROPERTY(Config, BlueprintReadOnly, Category = "Inventory")
+	float FlushInterval = 1.0f;
+
+	/** Track a hangar inventory (called from BeginPlay). Its contents are not read yet */
+	void RegisterInventory(UInventoryComponent* Inventory);
+
+	/** Write a hangar's pending changes and stop tracking it */
+	void UnregisterInventory(UInventoryComponent* Inventory);
+
+	/** Read a hangar's stored contents and deliveries if that hasn't happened yet */
+	void LoadInventory(UInventoryComponent* Inventory);
+
+	/** Whether a hangar's stored contents have been applied */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	bool IsInventoryLoaded(const UInventoryComponent* Inventory) const;
+
+	/** Record a changed slot for the next flush */
+	void MarkSlotDirty(const UInventoryComponent& Inventory, int32 SlotIndex);
+
+	/** Record a capacity change for the next flush */
+	void MarkCapacityDirty(const UInventoryComponent& Inventory);
+
+	/** Add items to a hangar, directly if it is loaded, otherwise on its next load. False (nothing delivered) without a database */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool DeliverItems(FName PersistenceKey, const TArray<FItemQuantity>& Items);
+
+	/** Find every stored stack of an item type across all hangars, without loading them. Calls back on the game thread */
+	void FindStacks(FName ItemID, TFunction<void(TArray<FInventoryHangarStack>&&)> OnFound);
+
+	/** Queue a write of everything dirty */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void Flush();
+
+	/** Flush and block until the database has it */
+	void FlushAndWait();
+
+private:
+	struct FHangarEntry
+	{
+		TWeakObjectPtr<UInventoryComponent> Inventory;
+		TSet<int32> DirtySlots;
+		bool bCapacityDirty = false;
+		bool bLoadRequested = false;
+		bool bLoading = false;
+		bool bLoaded = false;
+
+		/** Deliveries applied since the last flush, cleared from the database with the rows */
+		int64 ClearDeliveriesThrough = INDEX_NONE;
+
+		/** Set while stored contents are applied, those changes are already in the database */
+		bool bApplying = false;
+	};
+
+	/** Copy an entry's dirty rows into a batch */
+	void CaptureDirtyRows(FName PersistenceKey, FHangarEntry& Entry, FInventoryHangarBatch& Batch);
+
+	/** A batch was rolled back (game thread): mark its rows dirty again, or keep them for the next flush if their hangar is gone */
+	void HandleBatchFailed(FInventoryHangarBatch&& Batch);
+
+	/** Run on the pipe: the database is only touched from there */
+	void LaunchOnPipe(TUniqueFunction<void(FInventoryHangarDatabase&)>&& Work);
+
+	void ApplyLoadedContents(FName PersistenceKey, FInventorySnapshot&& Snapshot, bool bStored, TArray<FInventoryHangarDelivery>&& Deliveries);
+
+	UFUNCTION()
+	void HandleCatalogLoaded();
+
+	bool HandleFlushTicker(float DeltaTime);
+
+	TSharedPtr<FInventoryHangarDatabase> Database;
+
+	/** Serializes database access on background workers */
+	UE::Tasks::FPipe Pipe{UE_SOURCE_LOCATION};
+
+	TMap<FName, FHangarEntry> Entries;
+
+	/** Rows of failed batches whose hangar was unregistered, written ahead of the next flush's rows */
+	FInventoryHangarBatch RetryBatch;
+
+	FTSTicker::FDelegateHandle FlushTickerHandle;
+};
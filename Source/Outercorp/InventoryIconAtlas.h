@@ -0,0 +1,62 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "InventoryIconAtlas.generated.h"
+
+class UTexture2D;
+
+/**
+ * Location of one icon inside an atlas page
+ */
+USTRUCT()
+struct FInventoryIconAtlasEntry
+{
+	GENERATED_BODY()
+
+	/** Index into UInventoryIconAtlas::Pages */
+	UPROPERTY(VisibleAnywhere, Category = "Inventory")
+	int32 Page = INDEX_NONE;
+
+	/** Top-left corner of the icon in page UV space */
+	UPROPERTY(VisibleAnywhere, Category = "Inventory")
+	FVector2D UVMin = FVector2D::ZeroVector;
+
+	/** Bottom-right corner of the icon in page UV space */
+	UPROPERTY(VisibleAnywhere, Category = "Inventory")
+	FVector2D UVMax = FVector2D::ZeroVector;
+
+	/** Size of the source icon, used as the brush image size */
+	UPROPERTY(VisibleAnywhere, Category = "Inventory")
+	FVector2D ImageSize = FVector2D::ZeroVector;
+};
+
+/**
+ * Item icons packed into a few large textures
+ * Generated by UInventoryIconAtlasCommandlet. Icons drawn from the same page share a
+ * texture, so Slate can batch a whole inventory grid into a handful of draw elements.
+ * Icons missing from the atlas (added since it was packed) are drawn from their own texture.
+ */
+UCLASS(BlueprintType)
+class OUTERCORP_API UInventoryIconAtlas : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Atlas page textures */
+	UPROPERTY(VisibleAnywhere, Category = "Inventory")
+	TArray<TSoftObjectPtr<UTexture2D>> Pages;
+
+	/** Source icon texture to its place in the atlas */
+	UPROPERTY(VisibleAnywhere, Category = "Inventory")
+	TMap<FSoftObjectPath, FInventoryIconAtlasEntry> Entries;
+
+	/** Atlas cell for an icon texture (null if it was not packed) */
+	const FInventoryIconAtlasEntry* FindEntry(const FSoftObjectPath& IconPath) const
+	{
+		const FInventoryIconAtlasEntry* Entry = Entries.Find(IconPath);
+		return Entry && Pages.IsValidIndex(Entry->Page) ? Entry : nullptr;
+	}
+};
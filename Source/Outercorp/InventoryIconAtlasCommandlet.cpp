@@ -0,0 +1,194 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryIconAtlasCommandlet.h"
+#include "InventoryIconAtlas.h"
+#include "InventoryItemData.h"
+#include "Outercorp.h"
+
+#if WITH_EDITOR
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Texture2D.h"
+#include "ImageCore.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#endif
+
+UInventoryIconAtlasCommandlet::UInventoryIconAtlasCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UInventoryIconAtlasCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString OutputPath = TEXT("/Game/UI/Inventory/IconAtlas");
+	int32 PageSize = 2048;
+	int32 CellSize = 128;
+	int32 Padding = 2;
+
+	FParse::Value(*Params, TEXT("OutputPath="), OutputPath);
+	FParse::Value(*Params, TEXT("PageSize="), PageSize);
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+	FParse::Value(*Params, TEXT("Padding="), Padding);
+
+	const int32 Stride = CellSize + Padding * 2;
+	if (CellSize <= 0 || Padding < 0 || Stride > PageSize)
+	{
+		UE_LOG(LogOutercorp, Error, TEXT("Invalid atlas layout: PageSize=%d CellSize=%d Padding=%d"), PageSize, CellSize, Padding);
+		return 1;
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> ItemAssets;
+	AssetRegistry.GetAssetsByClass(UInventoryItemData::StaticClass()->GetClassPathName(), ItemAssets, true);
+
+	// Item types can share an icon, each texture is packed once
+	TArray<FSoftObjectPath> IconPaths;
+	for (const FAssetData& Asset : ItemAssets)
+	{
+		const UInventoryItemData* ItemData = Cast<UInventoryItemData>(Asset.GetAsset());
+		if (ItemData && !ItemData->ItemIcon.IsNull())
+		{
+			IconPaths.AddUnique(ItemData->ItemIcon.ToSoftObjectPath());
+		}
+	}
+
+	// Stable order keeps the output identical between runs with the same icons
+	IconPaths.Sort([](const FSoftObjectPath& A, const FSoftObjectPath& B)
+	{
+		return A.ToString() < B.ToString();
+	});
+
+	const FString AtlasName = TEXT("DA_InventoryIconAtlas");
+	UPackage* AtlasPackage = CreatePackage(*(OutputPath / AtlasName));
+	UInventoryIconAtlas* Atlas = NewObject<UInventoryIconAtlas>(AtlasPackage, *AtlasName, RF_Public | RF_Standalone);
+
+	const int32 CellsPerRow = PageSize / Stride;
+	const int32 CellsPerPage = CellsPerRow * CellsPerRow;
+
+	TArray<uint8> PagePixels;
+	int32 CellIndex = CellsPerPage;
+
+	for (const FSoftObjectPath& IconPath : IconPaths)
+	{
+		UTexture2D* Icon = Cast<UTexture2D>(IconPath.TryLoad());
+		FImage SourceImage;
+		if (!Icon || !Icon->Source.IsValid() || !Icon->Source.GetMipImage(SourceImage, 0, 0, 0))
+		{
+			UE_LOG(LogOutercorp, Warning, TEXT("Skipping icon '%s', no source data"), *IconPath.ToString());
+			continue;
+		}
+
+		// Letterboxed: the longer side fills the cell, the shorter keeps the icon's aspect ratio
+		const int32 SourceWidth = SourceImage.SizeX;
+		const int32 SourceHeight = SourceImage.SizeY;
+		const int32 ImageWidth = SourceWidth >= SourceHeight ? CellSize : FMath::Max(1, FMath::RoundToInt32(static_cast<float>(CellSize) * SourceWidth / SourceHeight));
+		const int32 ImageHeight = SourceHeight >= SourceWidth ? CellSize : FMath::Max(1, FMath::RoundToInt32(static_cast<float>(CellSize) * SourceHeight / SourceWidth));
+
+		FImage CellImage;
+		SourceImage.ResizeTo(CellImage, ImageWidth, ImageHeight, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+
+		if (CellIndex == CellsPerPage)
+		{
+			if (PagePixels.Num() > 0 && !SavePage(Atlas, OutputPath, PagePixels, PageSize))
+			{
+				return 1;
+			}
+
+			PagePixels.SetNumZeroed(PageSize * PageSize * 4);
+			CellIndex = 0;
+		}
+
+		// Centred in its cell, the rest of the cell stays transparent
+		const int32 CellX = (CellIndex % CellsPerRow) * Stride + Padding + (CellSize - ImageWidth) / 2;
+		const int32 CellY = (CellIndex / CellsPerRow) * Stride + Padding + (CellSize - ImageHeight) / 2;
+
+		// Copy the image, repeating edge pixels into the padding
+		const TArrayView64<FColor> CellColors = CellImage.AsBGRA8();
+		for (int32 Y = -Padding; Y < ImageHeight + Padding; ++Y)
+		{
+			const int32 SourceY = FMath::Clamp(Y, 0, ImageHeight - 1);
+			for (int32 X = -Padding; X < ImageWidth + Padding; ++X)
+			{
+				const int32 SourceX = FMath::Clamp(X, 0, ImageWidth - 1);
+				const FColor& Color = CellColors[SourceY * ImageWidth + SourceX];
+				uint8* Dest = &PagePixels[((CellY + Y) * PageSize + (CellX + X)) * 4];
+				Dest[0] = Color.B;
+				Dest[1] = Color.G;
+				Dest[2] = Color.R;
+				Dest[3] = Color.A;
+			}
+		}
+
+		FInventoryIconAtlasEntry& Entry = Atlas->Entries.Add(IconPath);
+		Entry.Page = Atlas->Pages.Num();
+		Entry.UVMin = FVector2D(CellX, CellY) / PageSize;
+		Entry.UVMax = FVector2D(CellX + ImageWidth, CellY + ImageHeight) / PageSize;
+		Entry.ImageSize = FVector2D(Icon->Source.GetSizeX(), Icon->Source.GetSizeY());
+
+		++CellIndex;
+	}
+
+	if (PagePixels.Num() > 0 && !SavePage(Atlas, OutputPath, PagePixels, PageSize))
+	{
+		return 1;
+	}
+
+	if (!SaveAssetPackage(Atlas))
+	{
+		UE_LOG(LogOutercorp, Error, TEXT("Failed to save '%s'"), *Atlas->GetPathName());
+		return 1;
+	}
+
+	UE_LOG(LogOutercorp, Display, TEXT("Packed %d icons from %d item types into %d atlas pages"), Atlas->Entries.Num(), ItemAssets.Num(), Atlas->Pages.Num());
+	return 0;
+#else
+	UE_LOG(LogOutercorp, Error, TEXT("The icon atlas can only be packed in the editor"));
+	return 1;
+#endif
+}
+
+#if WITH_EDITOR
+bool UInventoryIconAtlasCommandlet::SavePage(UInventoryIconAtlas* Atlas, const FString& OutputPath, const TArray<uint8>& Pixels, int32 PageSize)
+{
+	const FString PageName = FString::Printf(TEXT("T_InventoryIconAtlas_%d"), Atlas->Pages.Num());
+	UPackage* Package = CreatePackage(*(OutputPath / PageName));
+
+	UTexture2D* Page = NewObject<UTexture2D>(Package, *PageName, RF_Public | RF_Standalone);
+	Page->Source.Init(PageSize, PageSize, 1, 1, TSF_BGRA8, Pixels.GetData());
+	Page->SRGB = true;
+	Page->CompressionSettings = TC_EditorIcon;
+	Page->MipGenSettings = TMGS_NoMipmaps;
+	Page->LODGroup = TEXTUREGROUP_UI;
+	Page->NeverStream = true;
+	Page->PostEditChange();
+
+	if (!SaveAssetPackage(Page))
+	{
+		UE_LOG(LogOutercorp, Error, TEXT("Failed to save '%s'"), *Page->GetPathName());
+		return false;
+	}
+
+	Atlas->Pages.Add(Page);
+	return true;
+}
+
+bool UInventoryIconAtlasCommandlet::SaveAssetPackage(UObject* Asset)
+{
+	UPackage* Package = Asset->GetPackage();
+	Package->MarkPackageDirty();
+	FAssetRegistryModule::AssetCreated(Asset);
+
+	const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	return UPackage::SavePackage(Package, Asset, *Filename, SaveArgs);
+}
+#endif
@@ -0,0 +1,38 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "InventoryIconAtlasCommandlet.generated.h"
+
+class UInventoryIconAtlas;
+
+/**
+ * Packs every UInventoryItemData::ItemIcon into atlas pages and writes a UInventoryIconAtlas
+ * Run before cooking, after icons change:
+ *   UnrealEditor-Cmd Outercorp.uproject -run=InventoryIconAtlas [-OutputPath=/Game/UI/Inventory/IconAtlas] [-PageSize=2048] [-CellSize=128] [-Padding=2]
+ * Icons are resampled to fit CellSize, keeping their aspect ratio (non-square icons are
+ * letterboxed in their cell), and laid out on a uniform grid, with edge pixels repeated
+ * into the padding so filtering doesn't bleed between neighbours. Point the icon subsystem's
+ * IconAtlas setting at the generated asset to use it.
+ */
+UCLASS()
+class OUTERCORP_API UInventoryIconAtlasCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UInventoryIconAtlasCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+#if WITH_EDITOR
+private:
+	/** Write a finished page texture and add it to the atlas */
+	bool SavePage(UInventoryIconAtlas* Atlas, const FString& OutputPath, const TArray<uint8>& Pixels, int32 PageSize);
+
+	/** Save a newly created asset to disk */
+	static bool SaveAssetPackage(UObject* Asset);
+#endif
+};
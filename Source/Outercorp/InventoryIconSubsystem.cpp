@@ -0,0 +1,443 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryIconSubsystem.h"
+#include "InventoryItemData.h"
+#include "InventoryIconAtlas.h"
+#include "Engine/AssetManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/Texture2D.h"
+#include "TimerManager.h"
+#include "Outercorp.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inventory Icons Resident"), STAT_InventoryIconsResident, STATGROUP_Inventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Icon Requests"), STAT_InventoryIconRequests, STATGROUP_Inventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inventory Icons Atlased"), STAT_InventoryIconsAtlased, STATGROUP_Inventory);
+
+void UInventoryIconSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Only the cell table, pages are streamed like any other icon
+	if (IconAtlas.IsNull())
+	{
+		return;
+	}
+
+	LoadedAtlas = IconAtlas.Get();
+	if (!LoadedAtlas)
+	{
+		bAtlasPending = true;
+		AtlasHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(IconAtlas.ToSoftObjectPath(),
+			FStreamableDelegate::CreateUObject(this, &UInventoryIconSubsystem::HandleAtlasLoaded), FStreamableManager::AsyncLoadHighPriority);
+	}
+}
+
+void UInventoryIconSubsystem::Deinitialize()
+{
+	if (UGameInstance* GameInstance = GetGameInstance())
+	{
+		GameInstance->GetTimerManager().ClearTimer(FlushTimerHandle);
+		GameInstance->GetTimerManager().ClearTimer(RetryTimerHandle);
+	}
+
+	for (const TSharedPtr<FStreamableHandle>& Handle : ActiveHandles)
+	{
+		Handle->CancelHandle();
+	}
+	ActiveHandles.Empty();
+
+	if (AtlasHandle.IsValid())
+	{
+		AtlasHandle->CancelHandle();
+		AtlasHandle.Reset();
+	}
+	bAtlasPending = false;
+
+	Icons.Empty();
+	Textures.Empty();
+	LoadedAtlas = nullptr;
+	PendingItemTypes.Empty();
+	PendingTextures.Empty();
+
+	Super::Deinitialize();
+}
+
+void UInventoryIconSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UInventoryIconSubsystem* This = CastChecked<UInventoryIconSubsystem>(InThis);
+
+	// Brushes point at their textures, keep them alive while cached
+	for (TPair<TObjectKey<UInventoryItemData>, FIconEntry>& Pair : This->Icons)
+	{
+		Collector.AddReferencedObject(Pair.Value.Texture);
+	}
+
+	for (TPair<FSoftObjectPath, FIconEntry>& Pair : This->Textures)
+	{
+		Collector.AddReferencedObject(Pair.Value.Texture);
+	}
+
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+const FSlateBrush* UInventoryIconSubsystem::AcquireIcon(const UInventoryItemData* ItemData)
+{
+	if (!ItemData || ItemData->ItemIcon.IsNull())
+	{
+		return nullptr;
+	}
+
+	FIconEntry& Entry = Icons.FindOrAdd(ItemData);
+	++Entry.RefCount;
+
+	if (Entry.Texture)
+	{
+		return &Entry.Brush;
+	}
+
+	// Already in memory (e.g. another system loaded it), no request needed
+	if (TryResolveIcon(Entry, ItemData))
+	{
+		return &Entry.Brush;
+	}
+
+	// After a failed load the retry timer requests it once the wait is over
+	if (CanRequest(Entry))
+	{
+		Entry.bRequested = true;
+		PendingItemTypes.Add(ItemData);
+		ScheduleFlush();
+	}
+
+	return nullptr;
+}
+
+void UInventoryIconSubsystem::ReleaseIcon(const UInventoryItemData* ItemData)
+{
+	FIconEntry* Entry = Icons.Find(ItemData);
+	if (!Entry || !ensure(Entry->RefCount > 0))
+	{
+		return;
+	}
+
+	if (--Entry->RefCount == 0)
+	{
+		if (Entry->Texture)
+		{
+			DEC_DWORD_STAT(STAT_InventoryIconsResident);
+		}
+
+		if (Entry->bAtlased)
+		{
+			DEC_DWORD_STAT(STAT_InventoryIconsAtlased);
+		}
+
+		// An in-flight load for this type is simply ignored when it completes
+		Icons.Remove(ItemData);
+	}
+}
+
+const FSlateBrush* UInventoryIconSubsystem::FindIcon(const UInventoryItemData* ItemData) const
+{
+	const FIconEntry* Entry = Icons.Find(ItemData);
+	return Entry && Entry->Texture ? &Entry->Brush : nullptr;
+}
+
+const FSlateBrush* UInventoryIconSubsystem::FindOrLoadTextureBrush(const TSoftObjectPtr<UTexture2D>& Texture)
+{
+	if (Texture.IsNull())
+	{
+		return nullptr;
+	}
+
+	const FSoftObjectPath& Path = Texture.ToSoftObjectPath();
+	FIconEntry& Entry = Textures.FindOrAdd(Path);
+
+	if (Entry.Texture)
+	{
+		return &Entry.Brush;
+	}
+
+	if (UTexture2D* Loaded = Texture.Get())
+	{
+		SetEntryTexture(Entry, Loaded);
+		return &Entry.Brush;
+	}
+
+	if (CanRequest(Entry))
+	{
+		Entry.bRequested = true;
+		PendingTextures.Add(Path);
+		ScheduleFlush();
+	}
+
+	return nullptr;
+}
+
+void UInventoryIconSubsystem::FlushRequests()
+{
+	if (UGameInstance* GameInstance = GetGameInstance())
+	{
+		GameInstance->GetTimerManager().ClearTimer(FlushTimerHandle);
+	}
+	FlushTimerHandle.Invalidate();
+
+	// Kept queued until the atlas says which icons come from its pages
+	if (bAtlasPending || (PendingItemTypes.Num() == 0 && PendingTextures.Num() == 0))
+	{
+		return;
+	}
+
+	TArray<TObjectKey<UInventoryItemData>> ItemTypes;
+	TArray<FSoftObjectPath> Paths;
+	ItemTypes.Reserve(PendingItemTypes.Num());
+	Paths.Reserve(PendingItemTypes.Num() + PendingTextures.Num());
+
+	for (const TObjectKey<UInventoryItemData>& Key : PendingItemTypes)
+	{
+		// Skip types every slot released before the flush
+		const UInventoryItemData* ItemData = Key.ResolveObjectPtr();
+		const FIconEntry* Entry = Icons.Find(Key);
+		if (ItemData && Entry)
+		{
+			ItemTypes.Add(Key);
+			Paths.AddUnique(GetIconSourcePath(ItemData, *Entry));
+		}
+	}
+
+	for (const FSoftObjectPath& Path : PendingTextures)
+	{
+		Paths.AddUnique(Path);
+	}
+
+	TArray<FSoftObjectPath> TexturePaths = MoveTemp(PendingTextures);
+	PendingItemTypes.Reset();
+	PendingTextures.Reset();
+
+	if (Paths.Num() == 0)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_InventoryIconRequests, Paths.Num());
+
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		MoveTemp(Paths),
+		FStreamableDelegate::CreateUObject(this, &UInventoryIconSubsystem::HandleBatchLoaded, MoveTemp(ItemTypes), MoveTemp(TexturePaths)),
+		FStreamableManager::AsyncLoadHighPriority);
+
+	if (Handle.IsValid() && Handle->IsLoadingInProgress())
+	{
+		ActiveHandles.Add(Handle);
+	}
+}
+
+void UInventoryIconSubsystem::SetEntryTexture(FIconEntry& Entry, UTexture2D* Texture)
+{
+	Entry.Texture = Texture;
+	Entry.Brush.SetResourceObject(Texture);
+	Entry.Brush.SetUVRegion(FBox2f(ForceInit));
+	Entry.Brush.ImageSize = FVector2D(Texture->GetSizeX(), Texture->GetSizeY());
+	Entry.bRequested = false;
+	Entry.NumFailedLoads = 0;
+}
+
+const FInventoryIconAtlasEntry* UInventoryIconSubsystem::FindAtlasEntry(const UInventoryItemData* ItemData, const FIconEntry& Entry) const
+{
+	return Entry.bUseAtlas && LoadedAtlas ? LoadedAtlas->FindEntry(ItemData->ItemIcon.ToSoftObjectPath()) : nullptr;
+}
+
+FSoftObjectPath UInventoryIconSubsystem::GetIconSourcePath(const UInventoryItemData* ItemData, const FIconEntry& Entry) const
+{
+	if (const FInventoryIconAtlasEntry* AtlasEntry = FindAtlasEntry(ItemData, Entry))
+	{
+		return LoadedAtlas->Pages[AtlasEntry->Page].ToSoftObjectPath();
+	}
+
+	return ItemData->ItemIcon.ToSoftObjectPath();
+}
+
+bool UInventoryIconSubsystem::TryResolveIcon(FIconEntry& Entry, const UInventoryItemData* ItemData)
+{
+	if (const FInventoryIconAtlasEntry* AtlasEntry = FindAtlasEntry(ItemData, Entry))
+	{
+		UTexture2D* Page = LoadedAtlas->Pages[AtlasEntry->Page].Get();
+		if (!Page)
+		{
+			return false;
+		}
+
+		SetEntryTexture(Entry, Page);
+		Entry.Brush.SetUVRegion(FBox2f(FVector2f(AtlasEntry->UVMin), FVector2f(AtlasEntry->UVMax)));
+		Entry.Brush.ImageSize = AtlasEntry->ImageSize;
+		Entry.bAtlased = true;
+		INC_DWORD_STAT(STAT_InventoryIconsResident);
+		INC_DWORD_STAT(STAT_InventoryIconsAtlased);
+		return true;
+	}
+
+	UTexture2D* Texture = ItemData->ItemIcon.Get();
+	if (!Texture)
+	{
+		return false;
+	}
+
+	SetEntryTexture(Entry, Texture);
+	INC_DWORD_STAT(STAT_InventoryIconsResident);
+	return true;
+}
+
+void UInventoryIconSubsystem::ScheduleFlush()
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	if (!GameInstance || FlushTimerHandle.IsValid())
+	{
+		return;
+	}
+
+	FlushTimerHandle = GameInstance->GetTimerManager().SetTimerForNextTick(this, &UInventoryIconSubsystem::FlushRequests);
+}
+
+void UInventoryIconSubsystem::MarkLoadFailed(FIconEntry& Entry) const
+{
+	++Entry.NumFailedLoads;
+	const float Delay = FMath::Min(IconRetryDelay * FMath::Pow(2.0f, static_cast<float>(FMath::Min(Entry.NumFailedLoads - 1, 16))), MaxIconRetryDelay);
+	Entry.RetryTime = FPlatformTime::Seconds() + Delay;
+	Entry.bRequested = false;
+}
+
+bool UInventoryIconSubsystem::CanRequest(const FIconEntry& Entry)
+{
+	return !Entry.bRequested && (Entry.NumFailedLoads == 0 || FPlatformTime::Seconds() >= Entry.RetryTime);
+}
+
+void UInventoryIconSubsystem::ScheduleRetry()
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	if (!GameInstance)
+	{
+		return;
+	}
+
+	// Icons nobody shows anymore were dropped from the cache with their failures
+	double NextRetry = TNumericLimits<double>::Max();
+	for (const TPair<TObjectKey<UInventoryItemData>, FIconEntry>& Pair : Icons)
+	{
+		const FIconEntry& Entry = Pair.Value;
+		if (!Entry.Texture && !Entry.bRequested && Entry.NumFailedLoads > 0)
+		{
+			NextRetry = FMath::Min(NextRetry, Entry.RetryTime);
+		}
+	}
+
+	if (NextRetry == TNumericLimits<double>::Max())
+	{
+		GameInstance->GetTimerManager().ClearTimer(RetryTimerHandle);
+		return;
+	}
+
+	const float Delay = static_cast<float>(FMath::Max(NextRetry - FPlatformTime::Seconds(), 0.01));
+	GameInstance->GetTimerManager().SetTimer(RetryTimerHandle, this, &UInventoryIconSubsystem::RetryFailedIcons, Delay, false);
+}
+
+void UInventoryIconSubsystem::RetryFailedIcons()
+{
+	for (TPair<TObjectKey<UInventoryItemData>, FIconEntry>& Pair : Icons)
+	{
+		FIconEntry& Entry = Pair.Value;
+		if (!Entry.Texture && Entry.NumFailedLoads > 0 && CanRequest(Entry))
+		{
+			Entry.bRequested = true;
+			PendingItemTypes.Add(Pair.Key);
+		}
+	}
+
+	FlushRequests();
+	ScheduleRetry();
+}
+
+void UInventoryIconSubsystem::HandleBatchLoaded(TArray<TObjectKey<UInventoryItemData>> ItemTypes, TArray<FSoftObjectPath> TexturePaths)
+{
+	// The cache holds the textures now, the handles are no longer needed
+	ActiveHandles.RemoveAll([](const TSharedPtr<FStreamableHandle>& Handle)
+	{
+		return !Handle->IsLoadingInProgress();
+	});
+
+	bool bRequeued = false;
+	bool bRetry = false;
+	for (const TObjectKey<UInventoryItemData>& Key : ItemTypes)
+	{
+		FIconEntry* Entry = Icons.Find(Key);
+		const UInventoryItemData* ItemData = Key.ResolveObjectPtr();
+		if (!Entry || Entry->Texture || !ItemData)
+		{
+			continue;
+		}
+
+		if (TryResolveIcon(*Entry, ItemData))
+		{
+			continue;
+		}
+
+		if (FindAtlasEntry(ItemData, *Entry))
+		{
+			// Atlas page is missing, fall back to the icon's own texture
+			UE_LOG(LogOutercorp, Warning, TEXT("Icon atlas page for item '%s' failed to load, using its own icon"), *GetNameSafe(ItemData));
+			Entry->bUseAtlas = false;
+			PendingItemTypes.Add(Key);
+			bRequeued = true;
+		}
+		else
+		{
+			MarkLoadFailed(*Entry);
+			bRetry = true;
+			UE_LOG(LogOutercorp, Warning, TEXT("Failed to load icon for item '%s', retrying in %.0fs"), *GetNameSafe(ItemData), Entry->RetryTime - FPlatformTime::Seconds());
+		}
+	}
+
+	for (const FSoftObjectPath& Path : TexturePaths)
+	{
+		FIconEntry* Entry = Textures.Find(Path);
+		if (Entry && !Entry->Texture)
+		{
+			if (UTexture2D* Texture = Cast<UTexture2D>(Path.ResolveObject()))
+			{
+				SetEntryTexture(*Entry, Texture);
+			}
+			else
+			{
+				// Requested again by the next FindOrLoadTextureBrush after the wait
+				MarkLoadFailed(*Entry);
+				UE_LOG(LogOutercorp, Warning, TEXT("Failed to load texture '%s'"), *Path.ToString());
+			}
+		}
+	}
+
+	if (bRequeued)
+	{
+		ScheduleFlush();
+	}
+
+	if (bRetry)
+	{
+		ScheduleRetry();
+	}
+
+	OnIconsLoaded.Broadcast();
+}
+
+void UInventoryIconSubsystem::HandleAtlasLoaded()
+{
+	AtlasHandle.Reset();
+	bAtlasPending = false;
+
+	LoadedAtlas = IconAtlas.Get();
+	if (!LoadedAtlas)
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("Inventory icon atlas '%s' failed to load, icons use their own textures"), *IconAtlas.ToString());
+	}
+
+	FlushRequests();
+}
@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Styling/SlateBrush.h"
+#include "UObject/ObjectKey.h"
+#include "InventoryIconSubsystem.generated.h"
+
+class UInventoryItemData;
+class UInventoryIconAtlas;
+class UTexture2D;
+struct FInventoryIconAtlasEntry;
+struct FStreamableHandle;
+
+/**
+ * Shared icon cache for inventory UI
+ * Holds one FSlateBrush per item type, reference counted by the slot widgets (and drag
+ * visuals) showing it. Icons that are not resident are queued and requested from the
+ * streamable manager in one batch, either when a window flushes its refresh or on the
+ * next tick. Lives on the game instance so split-screen players share the cache.
+ * Icons packed into IconAtlas are drawn from their atlas page with a UV region, so
+ * slots showing different items share one texture; other icons use their own texture.
+ * The atlas cell table loads asynchronously at startup, and queued icons wait for it.
+ */
+UCLASS(Config = Game)
+class OUTERCORP_API UInventoryIconSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	/** Take a reference on an item type's icon. Returns the brush if it is already resident, null while loading */
+	const FSlateBrush* AcquireIcon(const UInventoryItemData* ItemData);
+
+	/** Drop a reference taken with AcquireIcon */
+	void ReleaseIcon(const UInventoryItemData* ItemData);
+
+	/** Resident brush for an item type (null if not loaded). Only valid until the cache next changes */
+	const FSlateBrush* FindIcon(const UInventoryItemData* ItemData) const;
+
+	/** Brush for a standalone texture such as empty slot art. Loaded once and kept, null while loading */
+	const FSlateBrush* FindOrLoadTextureBrush(const TSoftObjectPtr<UTexture2D>& Texture);
+
+	/** Send every queued icon to the streamable manager as one request */
+	void FlushRequests();
+
+	/** Called after a batch of icons finished loading */
+	FSimpleMulticastDelegate OnIconsLoaded;
+
+	/** Packed icon atlas (see UInventoryIconAtlasCommandlet), optional */
+	UPROPERTY(Config)
+	TSoftObjectPtr<UInventoryIconAtlas> IconAtlas;
+
+	/** Seconds before an icon that failed to load is requested again, doubling with each failure in a row */
+	UPROPERTY(Config)
+	float IconRetryDelay = 2.0f;
+
+	/** Longest wait between requests of an icon that keeps failing */
+	UPROPERTY(Config)
+	float MaxIconRetryDelay = 60.0f;
+
+protected:
+	struct FIconEntry
+	{
+		FSlateBrush Brush;
+		TObjectPtr<UTexture2D> Texture;
+		int32 RefCount = 0;
+		bool bRequested = false;
+
+		/** Look the icon up in the atlas (cleared if its page failed to load) */
+		bool bUseAtlas = true;
+
+		/** Brush points into an atlas page */
+		bool bAtlased = false;
+
+		/** Loads that failed in a row, and the earliest time the next request goes out */
+		int32 NumFailedLoads = 0;
+		double RetryTime = 0.0;
+	};
+
+	/** Point an entry's brush at a loaded texture */
+	static void SetEntryTexture(FIconEntry& Entry, UTexture2D* Texture);
+
+	/** Atlas cell for an item type's icon, if it should be drawn from the atlas */
+	const FInventoryIconAtlasEntry* FindAtlasEntry(const UInventoryItemData* ItemData, const FIconEntry& Entry) const;
+
+	/** Texture to load for an item type: its atlas page or the icon itself */
+	FSoftObjectPath GetIconSourcePath(const UInventoryItemData* ItemData, const FIconEntry& Entry) const;
+
+	/** Point an item type's brush at its texture if resident. Returns false if it still needs loading */
+	bool TryResolveIcon(FIconEntry& Entry, const UInventoryItemData* ItemData);
+
+	/** Schedule FlushRequests for the next tick if nobody flushes sooner */
+	void ScheduleFlush();
+
+	/** Clear an entry's request after a failed load and set when it may be requested again */
+	void MarkLoadFailed(FIconEntry& Entry) const;
+
+	/** Whether an entry may be requested now, false while it waits out a failed load */
+	static bool CanRequest(const FIconEntry& Entry);
+
+	/** Set the retry timer for the earliest failed icon still shown */
+	void ScheduleRetry();
+
+	/** Request again the failed icons whose wait is over */
+	void RetryFailedIcons();
+
+	void HandleBatchLoaded(TArray<TObjectKey<UInventoryItemData>> ItemTypes, TArray<FSoftObjectPath> TexturePaths);
+
+	/** Take the atlas once loaded and send the icons queued while waiting for it */
+	void HandleAtlasLoaded();
+
+private:
+	/** IconAtlas once loaded */
+	UPROPERTY()
+	TObjectPtr<UInventoryIconAtlas> LoadedAtlas;
+
+	/** IconAtlas request, icons aren't requested while it is in flight so they can come from its pages */
+	TSharedPtr<FStreamableHandle> AtlasHandle;
+	bool bAtlasPending = false;
+
+	TMap<TObjectKey<UInventoryItemData>, FIconEntry> Icons;
+	TMap<FSoftObjectPath, FIconEntry> Textures;
+
+	/** Waiting for the next flush */
+	TArray<TObjectKey<UInventoryItemData>> PendingItemTypes;
+	TArray<FSoftObjectPath> PendingTextures;
+
+	/** Requests in flight */
+	TArray<TSharedPtr<FStreamableHandle>> ActiveHandles;
+
+	FTimerHandle FlushTimerHandle;
+	FTimerHandle RetryTimerHandle;
+};
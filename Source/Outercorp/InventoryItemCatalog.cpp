@@ -0,0 +1,215 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryItemCatalog.h"
+#include "InventoryItemData.h"
+#include "Engine/AssetManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Outercorp.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Item Catalog Entries"), STAT_ItemCatalogEntries, STATGROUP_Inventory);
+
+const FName UInventoryItemCatalogSubsystem::IconBundle(TEXT("Icon"));
+const FName UInventoryItemCatalogSubsystem::MeshBundle(TEXT("Mesh"));
+
+void UInventoryItemCatalogSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	InitializeTime = FPlatformTime::Seconds();
+
+	// In the editor the asset registry may still be scanning, the index needs the full list
+	UAssetManager::CallOrRegister_OnCompletedInitialScan(FSimpleMulticastDelegate::FDelegate::CreateUObject(this, &UInventoryItemCatalogSubsystem::BuildIndex));
+}
+
+void UInventoryItemCatalogSubsystem::Deinitialize()
+{
+	if (CoreHandle.IsValid())
+	{
+		CoreHandle->CancelHandle();
+		CoreHandle.Reset();
+	}
+
+	ItemIndex.Empty();
+	NetItemIDs.Empty();
+	NetIndexByID.Empty();
+	LoadedItems.Empty();
+	bCatalogLoaded = false;
+
+	Super::Deinitialize();
+}
+
+UInventoryItemData* UInventoryItemCatalogSubsystem::FindItem(FName ItemID) const
+{
+	if (const TObjectPtr<UInventoryItemData>* Item = LoadedItems.Find(ItemID))
+	{
+		return *Item;
+	}
+
+	// Loaded by someone else before the catalog got to it
+	const FPrimaryAssetId* AssetId = ItemIndex.Find(ItemID);
+	return AssetId ? UAssetManager::Get().GetPrimaryAssetObject<UInventoryItemData>(*AssetId) : nullptr;
+}
+
+FPrimaryAssetId UInventoryItemCatalogSubsystem::GetItemAssetId(FName ItemID) const
+{
+	const FPrimaryAssetId* AssetId = ItemIndex.Find(ItemID);
+	return AssetId ? *AssetId : FPrimaryAssetId();
+}
+
+TArray<FName> UInventoryItemCatalogSubsystem::GetAllItemIDs() const
+{
+	TArray<FName> ItemIDs;
+	ItemIndex.GetKeys(ItemIDs);
+	return ItemIDs;
+}
+
+int32 UInventoryItemCatalogSubsystem::GetNetIndex(const UInventoryItemData* Item) const
+{
+	const int32* NetIndex = Item ? NetIndexByID.Find(Item->ItemID) : nullptr;
+	return NetIndex ? *NetIndex : INDEX_NONE;
+}
+
+UInventoryItemData* UInventoryItemCatalogSubsystem::FindItemByNetIndex(int32 NetIndex) const
+{
+	return NetItemIDs.IsValidIndex(NetIndex) ? FindItem(NetItemIDs[NetIndex]) : nullptr;
+}
+
+TSharedPtr<FStreamableHandle> UInventoryItemCatalogSubsystem::LoadItemBundles(const TArray<FName>& ItemIDs, const TArray<FName>& Bundles, FStreamableDelegate Callback)
+{
+	return UAssetManager::Get().ChangeBundleStateForPrimaryAssets(GetItemAssetIds(ItemIDs), Bundles, TArray<FName>(), false, MoveTemp(Callback));
+}
+
+void UInventoryItemCatalogSubsystem::UnloadItemBundles(const TArray<FName>& ItemIDs, const TArray<FName>& Bundles)
+{
+	UAssetManager::Get().ChangeBundleStateForPrimaryAssets(GetItemAssetIds(ItemIDs), TArray<FName>(), Bundles);
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+void UInventoryItemCatalogSubsystem::SetItemsForTests(const TArray<UInventoryItemData*>& Items, bool bLoaded)
+{
+	ItemIndex.Reset();
+	LoadedItems.Reset();
+	for (UInventoryItemData* Item : Items)
+	{
+		ItemIndex.Add(Item->ItemID, FPrimaryAssetId(UInventoryItemData::PrimaryAssetType, Item->ItemID));
+		if (bLoaded)
+		{
+			LoadedItems.Add(Item->ItemID, Item);
+		}
+	}
+
+	BuildNetIndex();
+	bCatalogLoaded = bLoaded;
+}
+#endif
+
+void UInventoryItemCatalogSubsystem::BuildIndex()
+{
+	UAssetManager& AssetManager = UAssetManager::Get();
+
+	TArray<FAssetData> AssetDataList;
+	AssetManager.GetPrimaryAssetDataList(UInventoryItemData::PrimaryAssetType, AssetDataList);
+
+	ItemIndex.Reserve(AssetDataList.Num());
+
+	int32 NumUntagged = 0;
+	for (const FAssetData& AssetData : AssetDataList)
+	{
+		FName ItemID;
+		if (!AssetData.GetTagValue(GET_MEMBER_NAME_CHECKED(UInventoryItemData, ItemID), ItemID) || ItemID.IsNone())
+		{
+			// Saved before ItemID was searchable, indexed once its definition loads
+			++NumUntagged;
+			continue;
+		}
+
+		const FPrimaryAssetId AssetId = AssetManager.GetPrimaryAssetIdForData(AssetData);
+		if (const FPrimaryAssetId* Existing = ItemIndex.Find(ItemID))
+		{
+			UE_LOG(LogOutercorp, Warning, TEXT("Item catalog: '%s' and '%s' share ItemID '%s'"), *Existing->ToString(), *AssetId.ToString(), *ItemID.ToString());
+			continue;
+		}
+
+		ItemIndex.Add(ItemID, AssetId);
+	}
+
+	UE_LOG(LogOutercorp, Log, TEXT("Item catalog: indexed %d of %d item definitions in %.1f ms (%d need resaving to be indexed before load and replicated by index)"),
+		ItemIndex.Num(), AssetDataList.Num(), (FPlatformTime::Seconds() - InitializeTime) * 1000.0, NumUntagged);
+
+	BuildNetIndex();
+
+	// Core data only, icon and mesh bundles are left for LoadItemBundles
+	CoreHandle = AssetManager.LoadPrimaryAssetsWithType(UInventoryItemData::PrimaryAssetType, TArray<FName>(),
+		FStreamableDelegate::CreateUObject(this, &UInventoryItemCatalogSubsystem::HandleCoreLoaded));
+
+	// Nothing to load (no items, or all resident already)
+	if (!CoreHandle.IsValid() || !CoreHandle->IsLoadingInProgress())
+	{
+		HandleCoreLoaded();
+	}
+}
+
+void UInventoryItemCatalogSubsystem::HandleCoreLoaded()
+{
+	if (bCatalogLoaded)
+	{
+		return;
+	}
+
+	TArray<UObject*> Loaded;
+	UAssetManager::Get().GetPrimaryAssetObjectList(UInventoryItemData::PrimaryAssetType, Loaded);
+
+	LoadedItems.Reserve(Loaded.Num());
+	for (UObject* Object : Loaded)
+	{
+		UInventoryItemData* Item = Cast<UInventoryItemData>(Object);
+		if (!Item || Item->ItemID.IsNone())
+		{
+			continue;
+		}
+
+		// Also picks up definitions whose ItemID tag was missing from the registry. They get no
+		// network index: clients may have been sent indices already, so those must not move
+		ItemIndex.FindOrAdd(Item->ItemID, Item->GetPrimaryAssetId());
+		LoadedItems.Add(Item->ItemID, Item);
+	}
+
+	bCatalogLoaded = true;
+	SET_DWORD_STAT(STAT_ItemCatalogEntries, LoadedItems.Num());
+
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	UE_LOG(LogOutercorp, Log, TEXT("Item catalog: %d definitions loaded %.1f ms after startup, peak used physical memory %.1f MB"),
+		LoadedItems.Num(), (FPlatformTime::Seconds() - InitializeTime) * 1000.0, MemoryStats.PeakUsedPhysical / (1024.0 * 1024.0));
+
+	OnCatalogLoaded.Broadcast();
+}
+
+TArray<FPrimaryAssetId> UInventoryItemCatalogSubsystem::GetItemAssetIds(const TArray<FName>& ItemIDs) const
+{
+	TArray<FPrimaryAssetId> AssetIds;
+	AssetIds.Reserve(ItemIDs.Num());
+	for (const FName& ItemID : ItemIDs)
+	{
+		if (const FPrimaryAssetId* AssetId = ItemIndex.Find(ItemID))
+		{
+			AssetIds.Add(*AssetId);
+		}
+	}
+	return AssetIds;
+}
+
+void UInventoryItemCatalogSubsystem::BuildNetIndex()
+{
+	NetItemIDs.Reset();
+	ItemIndex.GetKeys(NetItemIDs);
+
+	// Lexical, FName's default order depends on when each name was created
+	NetItemIDs.Sort(FNameLexicalLess());
+
+	NetIndexByID.Reset();
+	NetIndexByID.Reserve(NetItemIDs.Num());
+	for (int32 i = 0; i < NetItemIDs.Num(); ++i)
+	{
+		NetIndexByID.Add(NetItemIDs[i], i);
+	}
+}
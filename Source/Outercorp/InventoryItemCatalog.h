@@ -0,0 +1,119 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "InventoryItemCatalog.generated.h"
+
+class UInventoryItemData;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnItemCatalogLoaded);
+
+/**
+ * Central ItemID to item definition table
+ * At boot the ItemID index is built from asset registry tags, without loading anything,
+ * then every definition's core data is loaded asynchronously in one request. Icon and
+ * mesh bundles stay unloaded until asked for with LoadItemBundles. Definitions stay
+ * resident for the lifetime of the game instance, so level loads don't reload them.
+ * Item types found in the registry also get a small network index, assigned once from the
+ * sorted ItemIDs so it is identical on server and clients running the same content. Types
+ * only indexed once their definition loaded have none and replicate as object references.
+ */
+UCLASS(Config = Game)
+class OUTERCORP_API UInventoryItemCatalogSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Bundle holding UInventoryItemData::ItemIcon */
+	static const FName IconBundle;
+
+	/** Bundle holding UInventoryItemData::ItemMesh */
+	static const FName MeshBundle;
+
+	/** Definition for an ItemID, null if unknown or not loaded yet. Never loads synchronously */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	UInventoryItemData* FindItem(FName ItemID) const;
+
+	/** Primary asset for an ItemID, available before the definition has loaded */
+	FPrimaryAssetId GetItemAssetId(FName ItemID) const;
+
+	/** Every ItemID in the catalog */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	TArray<FName> GetAllItemIDs() const;
+
+	/** Number of item types in the catalog */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	int32 GetNumItems() const { return ItemIndex.Num(); }
+
+	/** Have the core definitions finished loading */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	bool IsCatalogLoaded() const { return bCatalogLoaded; }
+
+	/** Called once the core definitions have loaded */
+	UPROPERTY(BlueprintAssignable, Category = "Inventory")
+	FOnItemCatalogLoaded OnCatalogLoaded;
+
+	/** Metadata keys replicated as an index rather than a name, must be the same on server and clients */
+	UPROPERTY(Config, BlueprintReadOnly, Category = "Inventory")
+	TArray<FName> NetMetadataKeys;
+
+	/** Network index of an item type, INDEX_NONE if it has none */
+	int32 GetNetIndex(const UInventoryItemData* Item) const;
+
+	/** Definition for a network index, null if unknown or not loaded yet (retry after OnCatalogLoaded) */
+	UInventoryItemData* FindItemByNetIndex(int32 NetIndex) const;
+
+	/** Number of network item indices */
+	int32 GetNumNetIndices() const { return NetItemIDs.Num(); }
+
+	/** Load bundles (IconBundle, MeshBundle) for some items. Callback runs when they are resident */
+	TSharedPtr<FStreamableHandle> LoadItemBundles(const TArray<FName>& ItemIDs, const TArray<FName>& Bundles, FStreamableDelegate Callback = FStreamableDelegate());
+
+	/** Release bundles loaded with LoadItemBundles, the core definitions stay loaded */
+	void UnloadItemBundles(const TArray<FName>& ItemIDs, const TArray<FName>& Bundles);
+
+#if WITH_DEV_AUTOMATION_TESTS
+	/** Replace the catalog's contents with these definitions, as if indexed from the registry and, if bLoaded, loaded */
+	void SetItemsForTests(const TArray<UInventoryItemData*>& Items, bool bLoaded = true);
+#endif
+
+protected:
+	/** Index ItemIDs from asset registry tags and start loading the core definitions */
+	void BuildIndex();
+
+	void HandleCoreLoaded();
+
+	/** Primary asset ids for a list of ItemIDs, unknown ids are skipped */
+	TArray<FPrimaryAssetId> GetItemAssetIds(const TArray<FName>& ItemIDs) const;
+
+	/** Assign network indices in ItemID order, once: clients may already hold indices from the server */
+	void BuildNetIndex();
+
+private:
+	/** ItemID to primary asset */
+	TMap<FName, FPrimaryAssetId> ItemIndex;
+
+	/** ItemIDs by network index, lexically sorted */
+	TArray<FName> NetItemIDs;
+
+	/** ItemID to network index */
+	TMap<FName, int32> NetIndexByID;
+
+	/** ItemID to loaded definition */
+	UPROPERTY()
+	TMap<FName, TObjectPtr<UInventoryItemData>> LoadedItems;
+
+	/** Keeps the core definitions loaded */
+	TSharedPtr<FStreamableHandle> CoreHandle;
+
+	bool bCatalogLoaded = false;
+
+	/** For the startup report */
+	double InitializeTime = 0.0;
+};
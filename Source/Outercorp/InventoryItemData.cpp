@@ -2,6 +2,13 @@
 
 #include "InventoryItemData.h"
 
+const FPrimaryAssetType UInventoryItemData::PrimaryAssetType(TEXT("InventoryItem"));
+
+FPrimaryAssetId UInventoryItemData::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
 FLinearColor UInventoryItemData::GetRarityColor() const
 {
 	switch (Rarity)
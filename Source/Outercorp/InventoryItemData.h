@@ -34,8 +34,63 @@ enum class EItemCategory : uint8
 	Misc		UMETA(DisplayName = "Miscellaneous")
 };
 
+/**
+ * Fitting slot an item can be fitted into
+ */
+UENUM(BlueprintType)
+enum class EFittingSlotType : uint8
+{
+	None		UMETA(DisplayName = "None"),
+	High		UMETA(DisplayName = "High Slot"),
+	Mid			UMETA(DisplayName = "Mid Slot"),
+	Low			UMETA(DisplayName = "Low Slot"),
+	Rig			UMETA(DisplayName = "Rig Slot")
+};
+
+/**
+ * How a stat modifier combines with the stat it targets
+ */
+UENUM(BlueprintType)
+enum class EStatModifierOp : uint8
+{
+	/** Added to the base value */
+	Additive			UMETA(DisplayName = "Additive"),
+	/** Multiplies the value, e.g. 1.1 for +10% */
+	Multiplicative		UMETA(DisplayName = "Multiplicative"),
+	/** Percentage bonus with diminishing returns per stacked module, e.g. 0.1 for +10% */
+	StackingPenalized	UMETA(DisplayName = "Stacking Penalized")
+};
+
+/**
+ * Stat modifier applied while an item is fitted
+ */
+USTRUCT(BlueprintType)
+struct FItemStatModifier
+{
+	GENERATED_BODY()
+
+	/** Stat being modified */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Modifier")
+	FName Stat;
+
+	/** How the value combines */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Modifier")
+	EStatModifierOp Op = EStatModifierOp::Additive;
+
+	/** Modifier magnitude */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Modifier")
+	float Value = 0.0f;
+
+	/** Optional stat the value is scaled by (creates a dependency on that stat) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Modifier")
+	FName SourceStat;
+};
+
 /**
  * Data asset defining an item type
+ * Registered with the asset manager as the "InventoryItem" primary asset type (see
+ * UInventoryItemCatalogSubsystem). The definition itself is the core data; the icon and
+ * mesh are in the Icon and Mesh bundles and load separately.
  */
 UCLASS(BlueprintType)
 class OUTERCORP_API UInventoryItemData : public UPrimaryDataAsset
@@ -43,8 +98,13 @@ class OUTERCORP_API UInventoryItemData : public UPrimaryDataAsset
 	GENERATED_BODY()
 
 public:
-	/** Unique identifier for this item type */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item")
+	/** Primary asset type of every item definition */
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/** Unique identifier for this item type (searchable, so the catalog can index it without loading) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item", AssetRegistrySearchable)
 	FName ItemID;
 
 	/** Display name shown in UI */
@@ -56,11 +116,11 @@ public:
 	FText Description;
 
 	/** Icon for UI display */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item")
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item", meta = (AssetBundles = "Icon"))
 	TSoftObjectPtr<UTexture2D> ItemIcon;
 
 	/** 3D mesh for world representation */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item")
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item", meta = (AssetBundles = "Mesh"))
 	TSoftObjectPtr<UStaticMesh> ItemMesh;
 
 	/** Item category */
@@ -95,6 +155,26 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item")
 	bool bIsDroppable = true;
 
+	/** Seconds before the item can be used again (0 = no cooldown) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item|Timers", meta = (ClampMin = "0"))
+	float UseCooldown = 0.0f;
+
+	/** Seconds until a perishable item expires (0 = never expires) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item|Timers", meta = (ClampMin = "0"))
+	float ShelfLife = 0.0f;
+
+	/** Seconds for a module to recharge after activation (0 = instant) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item|Timers", meta = (ClampMin = "0"))
+	float RechargeTime = 0.0f;
+
+	/** Fitting slot this item can be fitted into (None = cannot be fitted) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item|Fitting")
+	EFittingSlotType FittingSlot = EFittingSlotType::None;
+
+	/** Stat modifiers applied while fitted */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item|Fitting")
+	TArray<FItemStatModifier> StatModifiers;
+
 	/** Item metadata (for custom properties) */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item")
 	TMap<FName, FString> Metadata;
@@ -166,3 +246,32 @@ struct FInventoryItem
 		return InstanceID == Other.InstanceID;
 	}
 };
+
+/**
+ * Item type and quantity pair, used for bulk inserts and generated loot
+ */
+USTRUCT(BlueprintType)
+struct FItemQuantity
+{
+	GENERATED_BODY()
+
+	/** Item type */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item")
+	TObjectPtr<UInventoryItemData> ItemData;
+
+	/** Number of items */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item")
+	int32 Quantity = 0;
+
+	FItemQuantity()
+		: ItemData(nullptr)
+		, Quantity(0)
+	{
+	}
+
+	FItemQuantity(UInventoryItemData* InItemData, int32 InQuantity)
+		: ItemData(InItemData)
+		, Quantity(InQuantity)
+	{
+	}
+};
@@ -0,0 +1,338 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryJournal.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory Journal Commit"), STAT_InventoryJournalCommit, STATGROUP_Inventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Journal Bytes Written"), STAT_InventoryJournalBytes, STATGROUP_Inventory);
+
+FInventoryJournal::FInventoryJournal(const FString& InDirectory, int32 InFirstSegment, float InGroupCommitSeconds)
+	: Directory(InDirectory)
+	, GroupCommitSeconds(FMath::Max(InGroupCommitSeconds, 0.001f))
+	, FirstSegment(InFirstSegment)
+	, CurrentSegment(InFirstSegment)
+{
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	CommitEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("InventoryJournal"), 0, TPri_BelowNormal);
+	if (!Thread)
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("Could not start the inventory journal thread, journal records are only written on Flush"));
+	}
+}
+
+FInventoryJournal::~FInventoryJournal()
+{
+	if (Thread)
+	{
+		// Run makes a final commit after Stop, so nothing buffered is lost
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+	else
+	{
+		Commit();
+		CloseSegment();
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	FPlatformProcess::ReturnSynchEventToPool(CommitEvent);
+}
+
+void FInventoryJournal::Append(const FInventoryJournalRecord& Record)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (Pending.Num() == 0 || Pending.Last().Segment != CurrentSegment)
+	{
+		Pending.AddDefaulted_GetRef().Segment = CurrentSegment;
+	}
+
+	FChunk& Chunk = Pending.Last();
+	InventoryArchive::EncodeJournalRecord(Record, Chunk.Bytes);
+	++Chunk.NumRecords;
+	++NumAppended;
+}
+
+int32 FInventoryJournal::StartNewSegment()
+{
+	FScopeLock ScopeLock(&Lock);
+	return ++CurrentSegment;
+}
+
+void FInventoryJournal::TruncateBefore(int32 Segment)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		TruncateSegment = FMath::Max(TruncateSegment, Segment);
+	}
+
+	if (Thread)
+	{
+		WorkEvent->Trigger();
+	}
+	else
+	{
+		Commit();
+	}
+}
+
+bool FInventoryJournal::Flush()
+{
+	uint64 Target = 0;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Target = NumAppended;
+	}
+
+	if (!Thread)
+	{
+		Commit();
+		return NumCommitted.load() >= Target;
+	}
+
+	// A commit running now may have taken its records before ours were appended, only the ones after it count
+	const uint64 FirstCommit = NumCommits.load() + 1;
+	while (NumCommitted.load() < Target)
+	{
+		if (NumCommits.load() > FirstCommit && bWriteFailed.load())
+		{
+			return false;
+		}
+
+		WorkEvent->Trigger();
+		CommitEvent->Wait(FTimespan::FromMilliseconds(10));
+	}
+
+	return true;
+}
+
+TArray<int32> FInventoryJournal::FindSegments(const FString& Directory)
+{
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *(Directory / TEXT("Journal_*.log")), true, false);
+
+	TArray<int32> Segments;
+	for (const FString& Filename : Filenames)
+	{
+		const FString Number = FPaths::GetBaseFilename(Filename).RightChop(8);
+		if (Number.IsNumeric())
+		{
+			Segments.Add(FCString::Atoi(*Number));
+		}
+	}
+
+	Segments.Sort();
+	return Segments;
+}
+
+FString FInventoryJournal::GetSegmentFilename(const FString& Directory, int32 Segment)
+{
+	return Directory / FString::Printf(TEXT("Journal_%08d.log"), Segment);
+}
+
+uint32 FInventoryJournal::Run()
+{
+	while (!bStopping.load())
+	{
+		WorkEvent->Wait(FTimespan::FromSeconds(GroupCommitSeconds));
+		Commit();
+	}
+
+	Commit();
+	CloseSegment();
+
+	if (bWriteFailed.load())
+	{
+		FScopeLock ScopeLock(&Lock);
+		UE_LOG(LogOutercorp, Error, TEXT("Inventory journal shut down with %llu records it could not write"), NumAppended - NumCommitted.load());
+	}
+	return 0;
+}
+
+void FInventoryJournal::Stop()
+{
+	bStopping = true;
+	WorkEvent->Trigger();
+}
+
+void FInventoryJournal::Commit()
+{
+	FScopeLock CommitScopeLock(&CommitLock);
+
+	TArray<FChunk> Chunks;
+	int32 Truncate = INDEX_NONE;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Chunks = MoveTemp(Pending);
+		Pending.Reset();
+		Truncate = TruncateSegment;
+		TruncateSegment = INDEX_NONE;
+	}
+
+	uint64 NumWritten = 0;
+
+	// Records kept from a failed commit may be bound for segments about to be deleted, the snapshots cover them
+	if (Truncate != INDEX_NONE)
+	{
+		Chunks.RemoveAll([Truncate, &NumWritten](const FChunk& Chunk)
+		{
+			if (Chunk.Segment < Truncate)
+			{
+				NumWritten += Chunk.NumRecords;
+				return true;
+			}
+			return false;
+		});
+	}
+
+	if (Chunks.Num() > 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InventoryJournalCommit);
+
+		int32 NumDone = 0;
+		uint64 NumDoneRecords = 0;
+		while (NumDone < Chunks.Num() && WriteChunk(Chunks[NumDone]))
+		{
+			NumDoneRecords += Chunks[NumDone].NumRecords;
+			INC_DWORD_STAT_BY(STAT_InventoryJournalBytes, Chunks[NumDone].Bytes.Num());
+			++NumDone;
+		}
+
+		// One sync for the whole group. If it fails nothing here is known to be on disk; records hold resulting states, so writing them again is harmless
+		if (SegmentHandle && !SegmentHandle->Flush(true))
+		{
+			UE_LOG(LogOutercorp, Error, TEXT("Failed to sync inventory journal segment %d"), OpenSegmentNumber);
+			CloseSegment();
+			NumDone = 0;
+			NumDoneRecords = 0;
+		}
+		NumWritten += NumDoneRecords;
+
+		if (NumDone < Chunks.Num())
+		{
+			UE_LOG(LogOutercorp, Error, TEXT("Failed to write inventory journal segment %d, keeping %d bytes for the next commit"), Chunks[NumDone].Segment, Chunks[NumDone].Bytes.Num());
+
+			// Back in front of anything appended since, so the records still reach the disk in order
+			Chunks.RemoveAt(0, NumDone);
+			FScopeLock ScopeLock(&Lock);
+			Pending.Insert(MoveTemp(Chunks), 0);
+			bWriteFailed = true;
+		}
+		else
+		{
+			bWriteFailed = false;
+		}
+	}
+	else
+	{
+		bWriteFailed = false;
+	}
+
+	if (Truncate != INDEX_NONE)
+	{
+		if (OpenSegmentNumber != INDEX_NONE && OpenSegmentNumber < Truncate)
+		{
+			CloseSegment();
+		}
+
+		for (int32 Segment : FindSegments(Directory))
+		{
+			if (Segment >= FirstSegment && Segment < Truncate)
+			{
+				IFileManager::Get().Delete(*GetSegmentFilename(Directory, Segment), false, false, true);
+			}
+		}
+	}
+
+	NumCommitted += NumWritten;
+	++NumCommits;
+	CommitEvent->Trigger();
+}
+
+bool FInventoryJournal::WriteChunk(const FChunk& Chunk)
+{
+	if (!OpenSegment(Chunk.Segment))
+	{
+		return false;
+	}
+
+	const int64 Start = SegmentHandle->Size();
+	bool bWritten = false;
+
+#if WITH_DEV_AUTOMATION_TESTS
+	if (NumWritesToFail.load() > 0)
+	{
+		--NumWritesToFail;
+		SegmentHandle->Write(Chunk.Bytes.GetData(), Chunk.Bytes.Num() / 2);
+	}
+	else
+#endif
+	{
+		bWritten = SegmentHandle->Write(Chunk.Bytes.GetData(), Chunk.Bytes.Num());
+	}
+
+	if (!bWritten)
+	{
+		// Recovery stops at the first torn record, anything written after one would never be replayed
+		if (!SegmentHandle->Truncate(Start))
+		{
+			UE_LOG(LogOutercorp, Error, TEXT("Could not cut inventory journal segment %d back to %lld bytes after a failed write"), Chunk.Segment, Start);
+		}
+		CloseSegment();
+	}
+
+	return bWritten;
+}
+
+bool FInventoryJournal::OpenSegment(int32 Segment)
+{
+	if (SegmentHandle && OpenSegmentNumber == Segment)
+	{
+		return true;
+	}
+
+	// Closing syncs the previous segment
+	CloseSegment();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString Filename = GetSegmentFilename(Directory, Segment);
+	PlatformFile.CreateDirectoryTree(*Directory);
+
+	SegmentHandle.Reset(PlatformFile.OpenWrite(*Filename, true));
+	if (!SegmentHandle)
+	{
+		return false;
+	}
+	OpenSegmentNumber = Segment;
+
+	if (SegmentHandle->Size() == 0)
+	{
+		TArray<uint8> Header;
+		InventoryArchive::EncodeJournalHeader(Header);
+		if (!SegmentHandle->Write(Header.GetData(), Header.Num()))
+		{
+			// Left empty, the next attempt writes the header again
+			SegmentHandle->Truncate(0);
+			CloseSegment();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FInventoryJournal::CloseSegment()
+{
+	if (SegmentHandle)
+	{
+		SegmentHandle->Flush(true);
+		SegmentHandle.Reset();
+	}
+	OpenSegmentNumber = INDEX_NONE;
+}
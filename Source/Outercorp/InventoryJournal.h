@@ -0,0 +1,112 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Runnable.h"
+#include "InventoryArchive.h"
+
+class FRunnableThread;
+class FEvent;
+
+/**
+ * Append-only inventory journal, written by its own thread
+ * Callers encode records into a memory buffer; the writer thread wakes every group commit
+ * interval (or on Flush), writes everything buffered in one go and syncs the file, so many
+ * changes share one disk sync. The journal is split into numbered segment files: compaction
+ * starts a new segment, snapshots every inventory, and once those snapshots are on disk
+ * the older segments are deleted with TruncateBefore. A chunk that fails to write is cut back
+ * out of its segment and kept, in order, for the next commit. Without a writer thread (it
+ * couldn't be created) commits run inline in Flush and TruncateBefore.
+ */
+class OUTERCORP_API FInventoryJournal : public FRunnable
+{
+public:
+	FInventoryJournal(const FString& InDirectory, int32 FirstSegment, float GroupCommitSeconds);
+	virtual ~FInventoryJournal();
+
+	/** Buffer a record for the next group commit. Thread safe */
+	void Append(const FInventoryJournalRecord& Record);
+
+	/** Send further records to a new segment and return its number */
+	int32 StartNewSegment();
+
+	/** Delete this journal's segments before Segment, once everything buffered for them is written. Segments from an earlier session are left to recovery */
+	void TruncateBefore(int32 Segment);
+
+	/** Block until everything appended so far is on disk. False if a commit since the call failed to write; the records stay buffered for the next one */
+	bool Flush();
+
+	/** Segment numbers present in Directory, ascending */
+	static TArray<int32> FindSegments(const FString& Directory);
+
+	static FString GetSegmentFilename(const FString& Directory, int32 Segment);
+
+	//~ FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/** Records bound for one segment */
+	struct FChunk
+	{
+		int32 Segment = 0;
+		TArray<uint8> Bytes;
+		uint64 NumRecords = 0;
+	};
+
+	/** Write and sync everything buffered, then apply a pending truncation */
+	void Commit();
+
+	/** Append a chunk to its segment. On failure the segment is cut back to where it was, so recovery isn't stopped by a torn record */
+	bool WriteChunk(const FChunk& Chunk);
+
+	/** Open Segment for appending, writing the header into a new file */
+	bool OpenSegment(int32 Segment);
+
+	void CloseSegment();
+
+	const FString Directory;
+	const float GroupCommitSeconds;
+
+	/** First segment this journal wrote */
+	const int32 FirstSegment;
+
+	/** Guards Pending, CurrentSegment, TruncateSegment and NumAppended */
+	FCriticalSection Lock;
+	TArray<FChunk> Pending;
+	int32 CurrentSegment = 0;
+	int32 TruncateSegment = INDEX_NONE;
+	uint64 NumAppended = 0;
+
+	/** Serializes commits, which run inline when there is no writer thread */
+	FCriticalSection CommitLock;
+
+	/** Records on disk (or dropped by a truncation), only written by Commit */
+	std::atomic<uint64> NumCommitted = 0;
+
+	/** Commits finished, and whether the last one left records behind */
+	std::atomic<uint64> NumCommits = 0;
+	std::atomic<bool> bWriteFailed = false;
+
+	std::atomic<bool> bStopping = false;
+
+	/** Wakes the writer early (Flush, shutdown) */
+	FEvent* WorkEvent = nullptr;
+
+	/** Signalled after every commit */
+	FEvent* CommitEvent = nullptr;
+
+	FRunnableThread* Thread = nullptr;
+
+	/** Writer thread only */
+	TUniquePtr<IFileHandle> SegmentHandle;
+	int32 OpenSegmentNumber = INDEX_NONE;
+
+#if WITH_DEV_AUTOMATION_TESTS
+public:
+	/** Tests only: the next this many chunk writes stop halfway and fail, as a full disk would */
+	std::atomic<int32> NumWritesToFail = 0;
+#endif
+};
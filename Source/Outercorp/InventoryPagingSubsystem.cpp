@@ -0,0 +1,368 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryPagingSubsystem.h"
+#include "InventoryArchive.h"
+#include "InventoryComponent.h"
+#include "InventoryItemCatalog.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory Paging Update"), STAT_InventoryPagingUpdate, STATGROUP_Inventory);
+DECLARE_CYCLE_STAT(TEXT("Inventory Fault In"), STAT_InventoryFaultIn, STATGROUP_Inventory);
+DECLARE_MEMORY_STAT(TEXT("Inventory Contents Resident"), STAT_InventoryPagingResident, STATGROUP_Inventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inventories Paged Out"), STAT_InventoriesPagedOut, STATGROUP_Inventory);
+
+bool UInventoryPagingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UInventoryPagingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Per process then per world, PIE instances and other servers share the Saved directory
+	const FString PagesRoot = FPaths::ProjectSavedDir() / TEXT("InventoryPages");
+	DeleteStalePageDirectories(PagesRoot);
+	PageDirectory = PagesRoot / LexToString(FPlatformProcess::GetCurrentProcessId()) / FGuid::NewGuid().ToString();
+}
+
+void UInventoryPagingSubsystem::Deinitialize()
+{
+	for (TPair<TObjectKey<UInventoryComponent>, FPage>& Pair : Pages)
+	{
+		Pair.Value.WriteTask.Wait();
+	}
+	Pages.Empty();
+	Inventories.Empty();
+
+	IFileManager::Get().DeleteDirectory(*PageDirectory, false, true);
+
+	Super::Deinitialize();
+}
+
+void UInventoryPagingSubsystem::DeleteStalePageDirectories(const FString& PagesRoot)
+{
+	TArray<FString> StaleDirectories;
+	IFileManager::Get().IterateDirectory(*PagesRoot, [&StaleDirectories](const TCHAR* Path, bool bIsDirectory)
+	{
+		// Anything not named after a process is from before directories were, and its process is gone too
+		const FString Name = FPaths::GetCleanFilename(Path);
+		uint32 ProcessId = 0;
+		const bool bProcessDirectory = Name.IsNumeric() && LexTryParseString(ProcessId, *Name);
+		if (bIsDirectory && (!bProcessDirectory || (ProcessId != FPlatformProcess::GetCurrentProcessId() && !FPlatformProcess::IsApplicationRunning(ProcessId))))
+		{
+			StaleDirectories.Add(Path);
+		}
+		return true;
+	});
+
+	for (const FString& Directory : StaleDirectories)
+	{
+		UE_LOG(LogOutercorp, Log, TEXT("Removing inventory pages left behind by a process no longer running: %s"), *Directory);
+		IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	}
+}
+
+void UInventoryPagingSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.0f)
+	{
+		return;
+	}
+
+	TimeUntilUpdate = UpdateInterval;
+	UpdatePaging();
+}
+
+ETickableTickType UInventoryPagingSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UInventoryPagingSubsystem::IsTickable() const
+{
+	return Inventories.Num() > 0;
+}
+
+TStatId UInventoryPagingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UInventoryPagingSubsystem, STATGROUP_Tickables);
+}
+
+void UInventoryPagingSubsystem::RegisterInventory(UInventoryComponent* Inventory)
+{
+	if (Inventory)
+	{
+		Inventories.AddUnique(Inventory);
+	}
+}
+
+void UInventoryPagingSubsystem::UnregisterInventory(UInventoryComponent* Inventory)
+{
+	Inventories.Remove(Inventory);
+
+	FPage Page;
+	if (Pages.RemoveAndCopyValue(Inventory, Page))
+	{
+		Page.WriteTask.Wait();
+		DeletePageFile(Page);
+	}
+}
+
+bool UInventoryPagingSubsystem::FaultIn(UInventoryComponent* Inventory)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryFaultIn);
+
+	FPage* Page = Pages.Find(Inventory);
+	if (!Inventory || !Page)
+	{
+		return true;
+	}
+
+	FInventorySnapshot Snapshot;
+	TArray<uint8> Bytes;
+	FString Error = TEXT("page could not be read");
+	if (!LoadPageBytes(*Page, Bytes) || !InventoryArchive::Decode(Bytes, Snapshot, Error))
+	{
+		// Paging in nothing would have the empty inventory saved over the real one
+		if (Page->bFaultInFailed)
+		{
+			UE_LOG(LogOutercorp, Verbose, TEXT("Failed to fault in %s again (%s)"), *Inventory->GetPathName(), *Error);
+		}
+		else
+		{
+			UE_LOG(LogOutercorp, Error, TEXT("Failed to fault in %s (%s), it stays paged out and refuses changes"), *Inventory->GetPathName(), *Error);
+			Page->bFaultInFailed = true;
+		}
+
+		// Waiters stay until it does come back, a later RequestResident tries again
+		Page->bFaultInQueued = false;
+		return false;
+	}
+
+	FinishFaultIn(Inventory, Snapshot);
+	return true;
+}
+
+void UInventoryPagingSubsystem::RequestResident(UInventoryComponent* Inventory, FSimpleDelegate OnResident)
+{
+	FPage* Page = Inventory ? Pages.Find(Inventory) : nullptr;
+	if (!Page)
+	{
+		OnResident.ExecuteIfBound();
+		return;
+	}
+
+	Page->Waiters.Add(MoveTemp(OnResident));
+	if (Page->bFaultInQueued)
+	{
+		return;
+	}
+	Page->bFaultInQueued = true;
+
+	// Decoded off the game thread, applied by the continuation below
+	struct FDecodedPage
+	{
+		FInventorySnapshot Snapshot;
+		bool bDecoded = false;
+	};
+	TSharedRef<FDecodedPage, ESPMode::ThreadSafe> Decoded = MakeShared<FDecodedPage, ESPMode::ThreadSafe>();
+
+	UE::Tasks::FTask DecodeTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Decoded, Blob = Page->Blob, Filename = Page->Filename]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InventoryFaultIn);
+
+		TArray<uint8> FileBytes;
+		if (!Blob && !FFileHelper::LoadFileToArray(FileBytes, *Filename))
+		{
+			return;
+		}
+
+		FString Error;
+		Decoded->bDecoded = InventoryArchive::Decode(Blob ? TConstArrayView<uint8>(*Blob) : TConstArrayView<uint8>(FileBytes), Decoded->Snapshot, Error);
+	}, Page->WriteTask);
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis = TWeakObjectPtr<UInventoryPagingSubsystem>(this), WeakInventory = TWeakObjectPtr<UInventoryComponent>(Inventory), Serial = Page->Serial, Decoded]()
+	{
+		UInventoryPagingSubsystem* This = WeakThis.Get();
+		UInventoryComponent* Inventory = WeakInventory.Get();
+		const FPage* Page = This && Inventory ? This->Pages.Find(Inventory) : nullptr;
+
+		// Already faulted in synchronously, or paged out again since
+		if (!Page || Page->Serial != Serial)
+		{
+			return;
+		}
+
+		if (Decoded->bDecoded)
+		{
+			This->FinishFaultIn(Inventory, Decoded->Snapshot);
+		}
+		else
+		{
+			// The synchronous path logs why
+			This->FaultIn(Inventory);
+		}
+	}, DecodeTask, UE::Tasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+}
+
+bool UInventoryPagingSubsystem::GetPagedSnapshot(const UInventoryComponent* Inventory, FInventorySnapshot& OutSnapshot) const
+{
+	const FPage* Page = Pages.Find(Inventory);
+	if (!Page)
+	{
+		return false;
+	}
+
+	TArray<uint8> Bytes;
+	FString Error;
+	return LoadPageBytes(*Page, Bytes) && InventoryArchive::Decode(Bytes, OutSnapshot, Error);
+}
+
+void UInventoryPagingSubsystem::UpdatePaging()
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryPagingUpdate);
+
+	Inventories.RemoveAll([](const TWeakObjectPtr<UInventoryComponent>& Inventory)
+	{
+		return !Inventory.IsValid();
+	});
+
+	// Disk pages that finished writing no longer need their blob
+	int64 PageBytes = 0;
+	for (TPair<TObjectKey<UInventoryComponent>, FPage>& Pair : Pages)
+	{
+		FPage& Page = Pair.Value;
+		if (Page.Blob && !Page.Filename.IsEmpty() && Page.WriteTask.IsCompleted())
+		{
+			if (Page.WriteTask.GetResult())
+			{
+				Page.Blob.Reset();
+			}
+			else
+			{
+				// Stays in memory
+				Page.Filename.Reset();
+			}
+		}
+
+		if (Page.Blob)
+		{
+			PageBytes += Page.Blob->GetAllocatedSize();
+		}
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	TArray<TPair<double, UInventoryComponent*>> Candidates;
+	int64 ContentBytes = 0;
+	for (const TWeakObjectPtr<UInventoryComponent>& WeakInventory : Inventories)
+	{
+		UInventoryComponent* Inventory = WeakInventory.Get();
+		ContentBytes += Inventory->GetResidentSize();
+		if (Inventory->IsPagedOut())
+		{
+			continue;
+		}
+
+		if (Now - Inventory->GetLastAccessTime() >= MinIdleSeconds)
+		{
+			Candidates.Emplace(Inventory->GetLastAccessTime(), Inventory);
+		}
+	}
+
+	ResidentBytes = ContentBytes + PageBytes;
+
+	const int64 BudgetBytes = static_cast<int64>(MemoryBudgetMB * 1024.0f * 1024.0f);
+	if (ResidentBytes > BudgetBytes && Candidates.Num() > 0)
+	{
+		Candidates.Sort([](const TPair<double, UInventoryComponent*>& A, const TPair<double, UInventoryComponent*>& B)
+		{
+			return A.Key < B.Key;
+		});
+
+		for (int32 i = 0; i < Candidates.Num() && i < MaxPageOutsPerUpdate && ResidentBytes > BudgetBytes; ++i)
+		{
+			UInventoryComponent* Inventory = Candidates[i].Value;
+			const int64 SizeBefore = Inventory->GetResidentSize();
+			PageOut(Inventory);
+
+			// The replicated copy is still counted, only the slots and search index go
+			const FPage& Page = Pages.FindChecked(Inventory);
+			ResidentBytes -= SizeBefore - Inventory->GetResidentSize() - (Page.Filename.IsEmpty() ? Page.Blob->GetAllocatedSize() : 0);
+		}
+	}
+
+	SET_MEMORY_STAT(STAT_InventoryPagingResident, ResidentBytes);
+	SET_DWORD_STAT(STAT_InventoriesPagedOut, Pages.Num());
+}
+
+void UInventoryPagingSubsystem::PageOut(UInventoryComponent* Inventory)
+{
+	TArray<uint8> Bytes;
+	Inventory->PageOut(Bytes);
+	Bytes.Shrink();
+
+	FPage& Page = Pages.Add(Inventory);
+	Page.Blob = MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>(MoveTemp(Bytes));
+	Page.Serial = ++NextPageSerial;
+
+	if (bPageToDisk)
+	{
+		Page.Filename = PageDirectory / FString::Printf(TEXT("%u.page"), Page.Serial);
+		Page.WriteTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Blob = Page.Blob, Filename = Page.Filename]()
+		{
+			return FFileHelper::SaveArrayToFile(*Blob, *Filename);
+		});
+	}
+}
+
+bool UInventoryPagingSubsystem::LoadPageBytes(const FPage& Page, TArray<uint8>& OutBytes)
+{
+	if (Page.Blob)
+	{
+		OutBytes = *Page.Blob;
+		return true;
+	}
+
+	Page.WriteTask.Wait();
+	return FFileHelper::LoadFileToArray(OutBytes, *Page.Filename);
+}
+
+void UInventoryPagingSubsystem::FinishFaultIn(UInventoryComponent* Inventory, const FInventorySnapshot& Snapshot)
+{
+	FPage Page;
+	if (!Pages.RemoveAndCopyValue(Inventory, Page))
+	{
+		return;
+	}
+
+	const UInventoryItemCatalogSubsystem* Catalog = nullptr;
+	if (const UGameInstance* GameInstance = GetWorld()->GetGameInstance())
+	{
+		Catalog = GameInstance->GetSubsystem<UInventoryItemCatalogSubsystem>();
+	}
+
+	Inventory->PageIn(Snapshot, Catalog);
+
+	Page.WriteTask.Wait();
+	DeletePageFile(Page);
+
+	for (FSimpleDelegate& Waiter : Page.Waiters)
+	{
+		Waiter.ExecuteIfBound();
+	}
+}
+
+void UInventoryPagingSubsystem::DeletePageFile(const FPage& Page) const
+{
+	if (!Page.Filename.IsEmpty())
+	{
+		IFileManager::Get().Delete(*Page.Filename, false, false, true);
+	}
+}
@@ -0,0 +1,130 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "UObject/ObjectKey.h"
+#include "InventoryPagingSubsystem.generated.h"
+
+class UInventoryComponent;
+struct FInventorySnapshot;
+
+/**
+ * Server-side paging of cold inventories
+ * Every authority inventory registers here. When the slot arrays of all registered inventories
+ * exceed the memory budget, the ones untouched the longest (and idle for at least
+ * MinIdleSeconds) are encoded to a compressed blob and their slots freed. The blob is kept in
+ * memory or, with bPageToDisk, written to a page file in the background and dropped. Any
+ * access through the inventory's public API faults it back in synchronously; RequestResident
+ * decodes off the game thread first and calls back when the contents are back. A page that
+ * can't be read or decoded is kept and the inventory stays paged out, refusing changes, until
+ * a later fault-in succeeds.
+ */
+UCLASS(Config = Game)
+class OUTERCORP_API UInventoryPagingSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	/** Memory resident inventory contents may use, in megabytes (in-memory pages and the replicated copies of paged-out contents count too) */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float MemoryBudgetMB = 256.0f;
+
+	/** Inventories accessed more recently than this are never paged out, in seconds */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float MinIdleSeconds = 60.0f;
+
+	/** Seconds between budget checks */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float UpdateInterval = 1.0f;
+
+	/** Most inventories paged out per check, bounds the encoding cost of one frame */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	int32 MaxPageOutsPerUpdate = 32;
+
+	/** Write pages to disk and free their memory, so residency stays flat however many inventories are seen */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	bool bPageToDisk = true;
+
+	/** Track an inventory (called from UInventoryComponent::BeginPlay on the authority) */
+	void RegisterInventory(UInventoryComponent* Inventory);
+
+	/** Stop tracking an inventory and drop its page */
+	void UnregisterInventory(UInventoryComponent* Inventory);
+
+	/** Bring a paged-out inventory back now. False if its page can't be read, it stays paged out */
+	bool FaultIn(UInventoryComponent* Inventory);
+
+	/** Bring a paged-out inventory back, decoding on a worker. OnResident runs on the game thread once it is resident (immediately if it already is) */
+	void RequestResident(UInventoryComponent* Inventory, FSimpleDelegate OnResident);
+
+	/** Decode a paged-out inventory's contents without bringing them back (saving). False if it isn't paged out */
+	bool GetPagedSnapshot(const UInventoryComponent* Inventory, FInventorySnapshot& OutSnapshot) const;
+
+	/** Bytes held by resident contents and in-memory pages at the last check */
+	int64 GetResidentBytes() const { return ResidentBytes; }
+
+protected:
+	/** Measure residency and page out the coldest inventories while over budget */
+	void UpdatePaging();
+
+	void PageOut(UInventoryComponent* Inventory);
+
+private:
+	struct FPage
+	{
+		/** Encoded contents, released once a disk page has been written */
+		TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Blob;
+
+		/** Page file, empty for in-memory pages */
+		FString Filename;
+
+		/** Writes the page file, true on success */
+		UE::Tasks::TTask<bool> WriteTask;
+
+		/** Distinguishes this page from later ones of the same inventory */
+		uint32 Serial = 0;
+
+		bool bFaultInQueued = false;
+
+		/** A fault-in failed already, later failures only log verbosely */
+		bool bFaultInFailed = false;
+
+		/** RequestResident callers waiting for this page */
+		TArray<FSimpleDelegate> Waiters;
+	};
+
+	/** Read a page's encoded contents, from memory or its file */
+	static bool LoadPageBytes(const FPage& Page, TArray<uint8>& OutBytes);
+
+	/** Apply decoded contents and drop the page */
+	void FinishFaultIn(UInventoryComponent* Inventory, const FInventorySnapshot& Snapshot);
+
+	void DeletePageFile(const FPage& Page) const;
+
+	/** Remove the page directories of processes that are no longer running, left behind by a crash */
+	static void DeleteStalePageDirectories(const FString& PagesRoot);
+
+	TArray<TWeakObjectPtr<UInventoryComponent>> Inventories;
+
+	TMap<TObjectKey<UInventoryComponent>, FPage> Pages;
+
+	/** This world's page files, under a directory named after the process; removed on shutdown */
+	FString PageDirectory;
+
+	uint32 NextPageSerial = 0;
+
+	int64 ResidentBytes = 0;
+
+	float TimeUntilUpdate = 0.0f;
+};
@@ -0,0 +1,396 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryPredictionComponent.h"
+#include "InventoryComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "TimerManager.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory Prediction Reconcile"), STAT_InventoryPredictionReconcile, STATGROUP_Inventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inventory Predictions Pending"), STAT_InventoryPredictionsPending, STATGROUP_Inventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Predictions Rolled Back"), STAT_InventoryPredictionsRolledBack, STATGROUP_Inventory);
+
+namespace
+{
+	/** Stacks remembered per player, well past the operations a client has in flight before their results arrive */
+	constexpr int32 MaxProducedStacks = 64;
+}
+
+bool FInventoryPredictedOperation::Execute() const
+{
+	if (!SourceInventory || !TargetInventory)
+	{
+		return false;
+	}
+
+	// Same calls an inventory window makes on a drop (TransferItem moves within an inventory when both are the same)
+	if (bSplit && SourceInventory == TargetInventory)
+	{
+		return SourceInventory->SplitStack(SourceSlot, TargetSlot, Quantity);
+	}
+	return SourceInventory->TransferItem(SourceSlot, TargetInventory, TargetSlot, Quantity);
+}
+
+UInventoryPredictionComponent::UInventoryPredictionComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UInventoryPredictionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(ExpireTimerHandle);
+	}
+
+	Pending.Reset();
+	UpdatePredictedInventories();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+UInventoryPredictionComponent* UInventoryPredictionComponent::Get(const APlayerController* Player)
+{
+	return Player ? Player->FindComponentByClass<UInventoryPredictionComponent>() : nullptr;
+}
+
+bool UInventoryPredictionComponent::RequestTransfer(UInventoryComponent* SourceInventory, int32 SourceSlot, UInventoryComponent* TargetInventory, int32 TargetSlot, int32 Quantity, bool bSplit)
+{
+	if (!SourceInventory || !TargetInventory)
+	{
+		return false;
+	}
+
+	FInventoryPendingOperation NewOperation;
+	FInventoryPredictedOperation& Operation = NewOperation.Operation;
+	Operation.SourceInventory = SourceInventory;
+	Operation.SourceSlot = SourceSlot;
+	Operation.TargetInventory = TargetInventory;
+	Operation.TargetSlot = TargetSlot;
+	Operation.Quantity = Quantity;
+	Operation.bSplit = bSplit;
+
+	// Listen servers and standalone games have nothing to predict
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return Operation.Execute();
+	}
+
+	const TArray<FInventoryItem>& SourceItems = SourceInventory->GetItems();
+	const TArray<FInventoryItem>& TargetItems = TargetInventory->GetItems();
+	if (!SourceItems.IsValidIndex(SourceSlot) || !TargetItems.IsValidIndex(TargetSlot))
+	{
+		return false;
+	}
+
+	const FInventoryItem& Source = SourceItems[SourceSlot];
+	const FInventoryItem& Target = TargetItems[TargetSlot];
+	NewOperation.SourceInstanceID = Source.InstanceID;
+	NewOperation.SourceQuantity = Source.IsValid() ? Source.Quantity : 0;
+	NewOperation.TargetInstanceID = Target.InstanceID;
+	NewOperation.TargetQuantity = Target.IsValid() ? Target.Quantity : 0;
+	NewOperation.RequestTime = FPlatformTime::Seconds();
+
+	// What an operation still in flight left in the slot has no ID the server would know, it goes by the slot alone
+	const bool bPredictedStack = Pending.ContainsByPredicate([SourceInventory, SourceSlot](const FInventoryPendingOperation& Candidate)
+	{
+		const FInventoryPredictedOperation& Other = Candidate.Operation;
+		return (Other.TargetInventory == SourceInventory && Other.TargetSlot == SourceSlot)
+			|| (Other.SourceInventory == SourceInventory && Other.SourceSlot == SourceSlot);
+	});
+	Operation.SourceNetInstanceID = bPredictedStack ? 0 : SourceInventory->GetNetInstanceID(SourceSlot);
+
+	// Broadcasts as usual, this is what makes the drop feel instant. What fails here would be rejected anyway
+	if (!Operation.Execute())
+	{
+		return false;
+	}
+
+	Operation.PredictionKey = ++LastPredictionKey;
+	Pending.Add(NewOperation);
+	UpdatePredictedInventories();
+
+	SendOperation(Operation);
+
+	UWorld* World = GetWorld();
+	if (World && !World->GetTimerManager().IsTimerActive(ExpireTimerHandle))
+	{
+		World->GetTimerManager().SetTimer(ExpireTimerHandle, this, &UInventoryPredictionComponent::ExpireOperations, FMath::Max(PredictionTimeout * 0.25f, 0.1f), true);
+	}
+
+	return true;
+}
+
+void UInventoryPredictionComponent::Reconcile()
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryPredictionReconcile);
+
+	// Accepted operations whose result has arrived are part of the replicated contents now
+	Pending.RemoveAll([](const FInventoryPendingOperation& Candidate)
+	{
+		return !IsValid(Candidate.Operation.SourceInventory) || !IsValid(Candidate.Operation.TargetInventory)
+			|| (Candidate.bAccepted && HasCaughtUp(Candidate));
+	});
+
+	// Every inventory predicted so far, those without operations left go back to their replicated contents
+	TArray<UInventoryComponent*, TInlineAllocator<4>> Inventories;
+	for (const TWeakObjectPtr<UInventoryComponent>& Inventory : PredictedInventories)
+	{
+		if (Inventory.IsValid())
+		{
+			Inventories.Add(Inventory.Get());
+		}
+	}
+
+	for (UInventoryComponent* Inventory : Inventories)
+	{
+		Inventory->BeginPredictionReplay();
+	}
+
+	for (const FInventoryPendingOperation& Candidate : Pending)
+	{
+		const FInventoryPredictedOperation& Operation = Candidate.Operation;
+
+		// Skipped when the replicated contents already have its result, or moved on so it no longer applies
+		if (IsSlotAsPredicted(Operation.SourceInventory, Operation.SourceSlot, Candidate.SourceInstanceID, Candidate.SourceQuantity)
+			&& IsSlotAsPredicted(Operation.TargetInventory, Operation.TargetSlot, Candidate.TargetInstanceID, Candidate.TargetQuantity))
+		{
+			Operation.Execute();
+		}
+	}
+
+	for (UInventoryComponent* Inventory : Inventories)
+	{
+		Inventory->EndPredictionReplay();
+	}
+
+	UpdatePredictedInventories();
+
+	if (Pending.Num() == 0)
+	{
+		if (UWorld* World = GetWorld())
+		{
+			World->GetTimerManager().ClearTimer(ExpireTimerHandle);
+		}
+	}
+}
+
+void UInventoryPredictionComponent::ServerExecuteOperation_Implementation(const FInventoryPredictedOperation& Operation)
+{
+	ExecuteOperation(Operation);
+}
+
+void UInventoryPredictionComponent::ClientOperationResult_Implementation(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial)
+{
+	HandleOperationResult(PredictionKey, bAccepted, SourceChangeSerial, TargetChangeSerial);
+}
+
+void UInventoryPredictionComponent::SendOperation(const FInventoryPredictedOperation& Operation)
+{
+	ServerExecuteOperation(Operation);
+}
+
+void UInventoryPredictionComponent::SendResult(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial)
+{
+	ClientOperationResult(PredictionKey, bAccepted, SourceChangeSerial, TargetChangeSerial);
+}
+
+void UInventoryPredictionComponent::ExecuteOperation(const FInventoryPredictedOperation& Operation)
+{
+	const APlayerController* Player = Cast<APlayerController>(GetOwner());
+	UInventoryComponent* SourceInventory = Operation.SourceInventory;
+	UInventoryComponent* TargetInventory = Operation.TargetInventory;
+
+	// Only inventories the player sees and can still reach (they may have walked off since opening
+	// the window), and only the stack they dragged: by its ID, or without one only a stack one of
+	// their own earlier operations left in the slot
+	bool bAccepted = false;
+	if (SourceInventory && TargetInventory && SourceInventory->IsObservedBy(Player) && TargetInventory->IsObservedBy(Player)
+		&& SourceInventory->CanBeOpenedBy(Player) && TargetInventory->CanBeOpenedBy(Player))
+	{
+		const bool bSameStack = Operation.SourceNetInstanceID != 0
+			? Operation.SourceNetInstanceID == SourceInventory->GetNetInstanceID(Operation.SourceSlot)
+			: IsProducedStack(SourceInventory, Operation.SourceSlot);
+		bAccepted = bSameStack && Operation.Execute();
+	}
+
+	if (bAccepted)
+	{
+		AddProducedStack(SourceInventory, Operation.SourceSlot);
+		AddProducedStack(TargetInventory, Operation.TargetSlot);
+	}
+
+	SendResult(Operation.PredictionKey, bAccepted,
+		SourceInventory ? SourceInventory->GetChangeSerial() : 0,
+		TargetInventory ? TargetInventory->GetChangeSerial() : 0);
+}
+
+void UInventoryPredictionComponent::HandleOperationResult(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial)
+{
+	const int32 Index = Pending.IndexOfByPredicate([PredictionKey](const FInventoryPendingOperation& Candidate)
+	{
+		return Candidate.Operation.PredictionKey == PredictionKey;
+	});
+
+	// Already rolled back by the timeout
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (bAccepted)
+	{
+		FInventoryPendingOperation& Accepted = Pending[Index];
+		Accepted.bAccepted = true;
+		Accepted.SourceChangeSerial = SourceChangeSerial;
+		Accepted.TargetChangeSerial = TargetChangeSerial;
+	}
+	else
+	{
+		UE_LOG(LogOutercorp, Verbose, TEXT("%s: server rejected inventory operation %d, rolling back"), *GetNameSafe(GetOwner()), PredictionKey);
+		INC_DWORD_STAT(STAT_InventoryPredictionsRolledBack);
+		Pending.RemoveAt(Index);
+	}
+
+	Reconcile();
+}
+
+void UInventoryPredictionComponent::AddProducedStack(UInventoryComponent* Inventory, int32 SlotIndex)
+{
+	const uint32 NetInstanceID = Inventory->GetNetInstanceID(SlotIndex);
+	if (NetInstanceID == 0)
+	{
+		return;
+	}
+
+	if (ProducedStacks.Num() == MaxProducedStacks)
+	{
+		ProducedStacks.RemoveAt(0, 1, EAllowShrinking::No);
+	}
+	ProducedStacks.Add({ Inventory, SlotIndex, NetInstanceID });
+}
+
+bool UInventoryPredictionComponent::IsProducedStack(const UInventoryComponent* Inventory, int32 SlotIndex) const
+{
+	// Someone else changing the slot since gives it a new ID
+	const uint32 NetInstanceID = Inventory->GetNetInstanceID(SlotIndex);
+	return NetInstanceID != 0 && ProducedStacks.ContainsByPredicate([Inventory, SlotIndex, NetInstanceID](const FProducedStack& Stack)
+	{
+		return Stack.Inventory.Get() == Inventory && Stack.SlotIndex == SlotIndex && Stack.NetInstanceID == NetInstanceID;
+	});
+}
+
+bool UInventoryPredictionComponent::HasReached(const UInventoryComponent* Inventory, uint32 ChangeSerial)
+{
+	// Serials wrap, compare by distance
+	return static_cast<int32>(Inventory->GetChangeSerial() - ChangeSerial) >= 0;
+}
+
+bool UInventoryPredictionComponent::HasCaughtUp(const FInventoryPendingOperation& Operation)
+{
+	return HasReached(Operation.Operation.SourceInventory, Operation.SourceChangeSerial)
+		&& HasReached(Operation.Operation.TargetInventory, Operation.TargetChangeSerial);
+}
+
+bool UInventoryPredictionComponent::IsSlotAsPredicted(const UInventoryComponent* Inventory, int32 SlotIndex, const FGuid& InstanceID, int32 Quantity)
+{
+	const TArray<FInventoryItem>& Items = Inventory->GetItems();
+	if (!Items.IsValidIndex(SlotIndex))
+	{
+		return false;
+	}
+
+	const FInventoryItem& Item = Items[SlotIndex];
+	if (Quantity == 0)
+	{
+		return !Item.IsValid();
+	}
+
+	// Stacks made by an earlier prediction get a new ID on every replay, leave those to the operation to validate
+	if (Inventory->ReplicatedContents->Slots.ParseClientInstanceID(InstanceID) == 0)
+	{
+		return true;
+	}
+
+	return Item.IsValid() && Item.InstanceID == InstanceID && Item.Quantity == Quantity;
+}
+
+void UInventoryPredictionComponent::ExpireOperations()
+{
+	const double Deadline = FPlatformTime::Seconds() - PredictionTimeout;
+	const APlayerController* Player = Cast<APlayerController>(GetOwner());
+
+	// The server ran an accepted operation; its result stops arriving once the player closes an inventory it touched
+	const auto IsResultWithheld = [Player](const UInventoryComponent* Inventory, uint32 ChangeSerial)
+	{
+		return !Inventory || (!HasReached(Inventory, ChangeSerial) && !Inventory->IsReceivingContents(Player));
+	};
+
+	int32 NumExpired = 0;
+	int32 NumWithheld = 0;
+	Pending.RemoveAll([Deadline, &IsResultWithheld, &NumExpired, &NumWithheld](const FInventoryPendingOperation& Candidate)
+	{
+		if (Candidate.RequestTime >= Deadline)
+		{
+			return false;
+		}
+
+		if (Candidate.bAccepted && (IsResultWithheld(Candidate.Operation.SourceInventory, Candidate.SourceChangeSerial)
+			|| IsResultWithheld(Candidate.Operation.TargetInventory, Candidate.TargetChangeSerial)))
+		{
+			++NumWithheld;
+		}
+		else
+		{
+			++NumExpired;
+		}
+		return true;
+	});
+
+	if (NumExpired > 0)
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("%s: %d inventory operations got no result within %.1fs, rolling back"), *GetNameSafe(GetOwner()), NumExpired, PredictionTimeout);
+		INC_DWORD_STAT_BY(STAT_InventoryPredictionsRolledBack, NumExpired);
+	}
+
+	if (NumWithheld > 0)
+	{
+		UE_LOG(LogOutercorp, Verbose, TEXT("%s: dropped %d accepted inventory operations on inventories no longer observed"), *GetNameSafe(GetOwner()), NumWithheld);
+	}
+
+	if (NumExpired + NumWithheld > 0)
+	{
+		Reconcile();
+	}
+}
+
+void UInventoryPredictionComponent::UpdatePredictedInventories()
+{
+	TArray<TWeakObjectPtr<UInventoryComponent>> StillPredicted;
+	for (const FInventoryPendingOperation& Candidate : Pending)
+	{
+		StillPredicted.AddUnique(Candidate.Operation.SourceInventory.Get());
+		StillPredicted.AddUnique(Candidate.Operation.TargetInventory.Get());
+	}
+
+	for (const TWeakObjectPtr<UInventoryComponent>& Inventory : PredictedInventories)
+	{
+		if (Inventory.IsValid() && !StillPredicted.Contains(Inventory) && Inventory->Predictor == this)
+		{
+			Inventory->Predictor.Reset();
+		}
+	}
+
+	for (const TWeakObjectPtr<UInventoryComponent>& Inventory : StillPredicted)
+	{
+		if (Inventory.IsValid())
+		{
+			Inventory->Predictor = this;
+		}
+	}
+
+	PredictedInventories = MoveTemp(StillPredicted);
+	SET_DWORD_STAT(STAT_InventoryPredictionsPending, Pending.Num());
+}
@@ -0,0 +1,180 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "InventoryPredictionComponent.generated.h"
+
+class UInventoryComponent;
+class APlayerController;
+
+/** A drag-drop move, merge or split, as sent to the server */
+USTRUCT()
+struct FInventoryPredictedOperation
+{
+	GENERATED_BODY()
+
+	/** Names the operation in the server's answer, increasing per player */
+	UPROPERTY()
+	int32 PredictionKey = 0;
+
+	UPROPERTY()
+	TObjectPtr<UInventoryComponent> SourceInventory;
+
+	UPROPERTY()
+	int32 SourceSlot = INDEX_NONE;
+
+	UPROPERTY()
+	TObjectPtr<UInventoryComponent> TargetInventory;
+
+	UPROPERTY()
+	int32 TargetSlot = INDEX_NONE;
+
+	/** Quantity to move, -1 for the whole stack */
+	UPROPERTY()
+	int32 Quantity = -1;
+
+	/** Split into an empty slot rather than move, within one inventory */
+	UPROPERTY()
+	bool bSplit = false;
+
+	/** Network instance ID of the stack the client saw in the source slot, 0 if an operation of this player still in flight left it there */
+	UPROPERTY()
+	uint32 SourceNetInstanceID = 0;
+
+	/** Run the operation on the local slot arrays */
+	bool Execute() const;
+};
+
+/** An operation a client predicted, waiting for the server */
+USTRUCT()
+struct FInventoryPendingOperation
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FInventoryPredictedOperation Operation;
+
+	/** Source and target slots as they were when the operation was predicted, a quantity of 0 meaning empty */
+	FGuid SourceInstanceID;
+	int32 SourceQuantity = 0;
+	FGuid TargetInstanceID;
+	int32 TargetQuantity = 0;
+
+	/** FPlatformTime::Seconds() when it was sent */
+	double RequestTime = 0.0;
+
+	/** Accepted by the server, with the change serials its result went out under */
+	bool bAccepted = false;
+	uint32 SourceChangeSerial = 0;
+	uint32 TargetChangeSerial = 0;
+};
+
+/**
+ * Client-side prediction of inventory drag-drop operations
+ * Lives on the player controller. On a client, moves, merges and splits are applied to the local
+ * slot arrays straight away and sent to the server under a prediction key; the server runs them
+ * for real and answers with the key. While operations are in flight, replicated updates of the
+ * inventories they touch are not written into the slot arrays directly: every update and every
+ * answer rebuilds those inventories from the replicated contents and replays the outstanding
+ * operations on top, and only slots that came out different are broadcast. A rejected operation
+ * is dropped, which rolls it back. An accepted one stays until the replicated contents have
+ * caught up with the change serials in the answer, so the slot doesn't flicker back in between.
+ * Operations on stacks that an earlier operation still in flight left behind name the stack by
+ * slot only; the server accepts those only for slots its own earlier operations filled.
+ */
+UCLASS(ClassGroup=(Custom), Config = Game)
+class OUTERCORP_API UInventoryPredictionComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UInventoryPredictionComponent();
+
+	/** Operations the server hasn't answered, or whose result hasn't arrived, after this many seconds are rolled back */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Inventory")
+	float PredictionTimeout = 5.0f;
+
+	/** Prediction component of a player, null if it has none */
+	static UInventoryPredictionComponent* Get(const APlayerController* Player);
+
+	/**
+	 * Move, merge or split a stack, as dropped in an inventory window (a Quantity of -1 moves the whole stack).
+	 * Predicted on clients, run directly on the authority. False if it can't be done with the contents as known here
+	 */
+	bool RequestTransfer(UInventoryComponent* SourceInventory, int32 SourceSlot, UInventoryComponent* TargetInventory, int32 TargetSlot, int32 Quantity = -1, bool bSplit = false);
+
+	/** Rebuild the predicted inventories from their replicated contents plus the operations still outstanding */
+	void Reconcile();
+
+	/** Number of operations waiting for the server */
+	int32 GetNumPendingOperations() const { return Pending.Num(); }
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Run a client's operation and answer it */
+	UFUNCTION(Server, Reliable)
+	void ServerExecuteOperation(const FInventoryPredictedOperation& Operation);
+
+	/** Answer to ServerExecuteOperation, with the inventories' change serials right after the operation */
+	UFUNCTION(Client, Reliable)
+	void ClientOperationResult(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial);
+
+	/** Send an operation to the server, through ServerExecuteOperation unless overridden (tests) */
+	virtual void SendOperation(const FInventoryPredictedOperation& Operation);
+
+	/** Send an answer to the client, through ClientOperationResult unless overridden (tests) */
+	virtual void SendResult(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial);
+
+	/** Check and run an operation of this player, then answer it (server) */
+	void ExecuteOperation(const FInventoryPredictedOperation& Operation);
+
+	/** Confirm or roll back an operation on the server's answer (client) */
+	void HandleOperationResult(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial);
+
+private:
+	/** A stack an accepted operation of this player left in a slot, which the player's next operations may name without an ID (server) */
+	struct FProducedStack
+	{
+		TWeakObjectPtr<UInventoryComponent> Inventory;
+		int32 SlotIndex = INDEX_NONE;
+		uint32 NetInstanceID = 0;
+	};
+
+	/** Remember what an accepted operation left in a slot (server) */
+	void AddProducedStack(UInventoryComponent* Inventory, int32 SlotIndex);
+
+	/** Whether a slot still holds a stack an accepted operation of this player left there (server) */
+	bool IsProducedStack(const UInventoryComponent* Inventory, int32 SlotIndex) const;
+
+	/** Whether an inventory's replicated contents include a given change serial */
+	static bool HasReached(const UInventoryComponent* Inventory, uint32 ChangeSerial);
+
+	/** Whether the replicated contents of both inventories include an accepted operation */
+	static bool HasCaughtUp(const FInventoryPendingOperation& Operation);
+
+	/** Whether a slot still holds what the operation was predicted against, so replaying it won't apply it twice */
+	static bool IsSlotAsPredicted(const UInventoryComponent* Inventory, int32 SlotIndex, const FGuid& InstanceID, int32 Quantity);
+
+	/** Roll back operations past PredictionTimeout */
+	void ExpireOperations();
+
+	/** Point the inventories of the pending operations at this component, and the others away from it */
+	void UpdatePredictedInventories();
+
+	/** Operations in flight, in key order */
+	UPROPERTY()
+	TArray<FInventoryPendingOperation> Pending;
+
+	/** Inventories whose slot arrays include predictions */
+	TArray<TWeakObjectPtr<UInventoryComponent>> PredictedInventories;
+
+	/** Most recent stacks left by this player's accepted operations, oldest first (server) */
+	TArray<FProducedStack> ProducedStacks;
+
+	int32 LastPredictionKey = 0;
+
+	FTimerHandle ExpireTimerHandle;
+};
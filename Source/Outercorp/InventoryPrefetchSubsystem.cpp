@@ -0,0 +1,321 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryPrefetchSubsystem.h"
+#include "InventoryComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory Prefetch Update"), STAT_InventoryPrefetchUpdate, STATGROUP_Inventory);
+DECLARE_MEMORY_STAT(TEXT("Inventory Prefetch Resident"), STAT_InventoryPrefetchResident, STATGROUP_Inventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inventory Prefetch Entries"), STAT_InventoryPrefetchEntries, STATGROUP_Inventory);
+
+bool UInventoryPrefetchSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Nobody looks at containers on a dedicated server
+	return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UInventoryPrefetchSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UInventoryPrefetchSubsystem::Deinitialize()
+{
+	TArray<FSoftObjectPath> Paths;
+	Entries.GetKeys(Paths);
+	for (const FSoftObjectPath& Path : Paths)
+	{
+		ReleaseEntry(Path);
+	}
+
+	Containers.Empty();
+
+	Super::Deinitialize();
+}
+
+void UInventoryPrefetchSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.0f)
+	{
+		return;
+	}
+
+	TimeUntilUpdate = UpdateInterval;
+	UpdatePrefetch();
+}
+
+ETickableTickType UInventoryPrefetchSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UInventoryPrefetchSubsystem::IsTickable() const
+{
+	return Containers.Num() > 0;
+}
+
+TStatId UInventoryPrefetchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UInventoryPrefetchSubsystem, STATGROUP_Tickables);
+}
+
+void UInventoryPrefetchSubsystem::RegisterContainer(UInventoryComponent* Container)
+{
+	if (Container)
+	{
+		Containers.AddUnique(Container);
+	}
+}
+
+void UInventoryPrefetchSubsystem::UnregisterContainer(UInventoryComponent* Container)
+{
+	Containers.Remove(Container);
+}
+
+void UInventoryPrefetchSubsystem::UpdatePrefetch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryPrefetchUpdate);
+
+	++UpdateNumber;
+
+	Containers.RemoveAll([](const TWeakObjectPtr<UInventoryComponent>& Container)
+	{
+		return !Container.IsValid();
+	});
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (!PlayerController || !PlayerController->IsLocalController() || !PlayerController->PlayerCameraManager)
+	{
+		return;
+	}
+
+	const FVector ViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	const FVector ViewDirection = PlayerController->PlayerCameraManager->GetCameraRotation().Vector();
+
+	const APawn* Pawn = PlayerController->GetPawn();
+	const FVector Velocity = Pawn ? Pawn->GetVelocity() : FVector::ZeroVector;
+	const float MaxSpeed = Pawn && Pawn->GetMovementComponent() ? Pawn->GetMovementComponent()->GetMaxSpeed() : 0.0f;
+
+	TArray<TPair<float, const UInventoryComponent*>, TInlineAllocator<16>> Ranked;
+	for (const TWeakObjectPtr<UInventoryComponent>& WeakContainer : Containers)
+	{
+		const UInventoryComponent* Container = WeakContainer.Get();
+
+		// The player's own inventory is loaded by its window
+		if (Pawn && Container->GetOwner() == Pawn)
+		{
+			continue;
+		}
+
+		const float Score = ScoreContainer(Container, ViewLocation, ViewDirection, Velocity, MaxSpeed);
+		if (Score > 0.0f)
+		{
+			Ranked.Emplace(Score, Container);
+		}
+	}
+
+	Ranked.Sort([](const TPair<float, const UInventoryComponent*>& A, const TPair<float, const UInventoryComponent*>& B)
+	{
+		return A.Key > B.Key;
+	});
+
+	// Assets in rank order, so the budget goes to the most likely container first
+	TArray<FSoftObjectPath> Wanted;
+	TSet<const UInventoryItemData*> SeenTypes;
+	const int32 NumContainers = FMath::Min(Ranked.Num(), MaxContainers);
+	for (int32 i = 0; i < NumContainers; ++i)
+	{
+		// The summary reaches every client, the contents only observers (and may be paged out on a listen server)
+		for (const UInventoryItemData* ItemData : Ranked[i].Value->Summary.ItemTypes)
+		{
+			if (!ItemData)
+			{
+				continue;
+			}
+
+			bool bAlreadySeen = false;
+			SeenTypes.Add(ItemData, &bAlreadySeen);
+			if (bAlreadySeen)
+			{
+				continue;
+			}
+
+			if (!ItemData->ItemIcon.IsNull())
+			{
+				Wanted.Add(ItemData->ItemIcon.ToSoftObjectPath());
+			}
+
+			if (!ItemData->ItemMesh.IsNull())
+			{
+				Wanted.Add(ItemData->ItemMesh.ToSoftObjectPath());
+			}
+		}
+	}
+
+	// Stamp everything still wanted first, so eviction for the new requests only takes stale entries
+	for (const FSoftObjectPath& Path : Wanted)
+	{
+		if (FPrefetchEntry* Entry = Entries.Find(Path))
+		{
+			Entry->LastWantedUpdate = UpdateNumber;
+		}
+	}
+
+	for (const FSoftObjectPath& Path : Wanted)
+	{
+		if (!Entries.Contains(Path) && !RequestAsset(Path))
+		{
+			// Budget is full of assets wanted right now
+			break;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_InventoryPrefetchEntries, Entries.Num());
+}
+
+float UInventoryPrefetchSubsystem::ScoreContainer(const UInventoryComponent* Container, const FVector& ViewLocation, const FVector& ViewDirection, const FVector& Velocity, float MaxSpeed) const
+{
+	const AActor* Owner = Container->GetOwner();
+	if (!Owner || PrefetchRadius <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	const FVector ToContainer = Owner->GetActorLocation() - ViewLocation;
+	const float Distance = ToContainer.Size();
+	if (Distance > PrefetchRadius)
+	{
+		return 0.0f;
+	}
+
+	const FVector Direction = ToContainer / FMath::Max(Distance, 1.0f);
+	const float Proximity = 1.0f - Distance / PrefetchRadius;
+	const float Facing = FMath::Max(0.0f, FVector::DotProduct(Direction, ViewDirection));
+	const float Approach = MaxSpeed > 0.0f ? FMath::Clamp(FVector::DotProduct(Direction, Velocity / MaxSpeed), 0.0f, 1.0f) : 0.0f;
+
+	return Proximity * (1.0f + FacingWeight * Facing + ApproachWeight * Approach);
+}
+
+bool UInventoryPrefetchSubsystem::RequestAsset(const FSoftObjectPath& Path)
+{
+	// The size isn't known until it has loaded, reserve an estimate so a burst of requests can't overshoot the budget
+	const int64 EstimatedBytes = FMath::Max<int64>(static_cast<int64>(EstimatedAssetKB * 1024.0), 1);
+	if (!EvictFor(EstimatedBytes))
+	{
+		return false;
+	}
+
+	FPrefetchEntry& NewEntry = Entries.Add(Path);
+	NewEntry.LastWantedUpdate = UpdateNumber;
+	NewEntry.SizeBytes = EstimatedBytes;
+	ResidentBytes += EstimatedBytes;
+	INC_MEMORY_STAT_BY(STAT_InventoryPrefetchResident, EstimatedBytes);
+
+	// Below anything gameplay asks for, prefetch should never delay a real request
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		Path,
+		FStreamableDelegate::CreateUObject(this, &UInventoryPrefetchSubsystem::HandleAssetLoaded, Path),
+		FStreamableManager::DefaultAsyncLoadPriority - 1);
+
+	// Already loaded assets complete inside RequestAsyncLoad, the entry may have changed or gone
+	FPrefetchEntry* Entry = Entries.Find(Path);
+	if (!Handle.IsValid())
+	{
+		ReleaseEntry(Path);
+	}
+	else if (Entry)
+	{
+		Entry->Handle = Handle;
+	}
+
+	return true;
+}
+
+bool UInventoryPrefetchSubsystem::EvictFor(int64 NeededBytes)
+{
+	const int64 BudgetBytes = static_cast<int64>(MemoryBudgetMB * 1024.0 * 1024.0);
+
+	while (ResidentBytes + NeededBytes > BudgetBytes)
+	{
+		const FSoftObjectPath* Oldest = nullptr;
+		uint32 OldestUpdate = UpdateNumber;
+		for (const TPair<FSoftObjectPath, FPrefetchEntry>& Pair : Entries)
+		{
+			if (Pair.Value.LastWantedUpdate < OldestUpdate)
+			{
+				Oldest = &Pair.Key;
+				OldestUpdate = Pair.Value.LastWantedUpdate;
+			}
+		}
+
+		if (!Oldest)
+		{
+			return false;
+		}
+
+		ReleaseEntry(FSoftObjectPath(*Oldest));
+	}
+
+	return true;
+}
+
+void UInventoryPrefetchSubsystem::HandleAssetLoaded(FSoftObjectPath Path)
+{
+	FPrefetchEntry* Entry = Entries.Find(Path);
+	if (!Entry || Entry->bLoaded)
+	{
+		return;
+	}
+
+	UObject* Object = Path.ResolveObject();
+	if (!Object)
+	{
+		UE_LOG(LogOutercorp, Verbose, TEXT("Prefetch of '%s' failed"), *Path.ToString());
+		ReleaseEntry(Path);
+		return;
+	}
+
+	// Swap the estimate for the real size
+	const int64 SizeBytes = FMath::Max<int64>(Object->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal), 1);
+	ResidentBytes += SizeBytes - Entry->SizeBytes;
+	DEC_MEMORY_STAT_BY(STAT_InventoryPrefetchResident, Entry->SizeBytes);
+	INC_MEMORY_STAT_BY(STAT_InventoryPrefetchResident, SizeBytes);
+	Entry->SizeBytes = SizeBytes;
+	Entry->bLoaded = true;
+
+	// Only makes room from assets nobody wants right now; if everything is wanted, the next update stops requesting
+	EvictFor(0);
+}
+
+void UInventoryPrefetchSubsystem::ReleaseEntry(const FSoftObjectPath& Path)
+{
+	FPrefetchEntry Entry;
+	if (!Entries.RemoveAndCopyValue(Path, Entry))
+	{
+		return;
+	}
+
+	ResidentBytes -= Entry.SizeBytes;
+	DEC_MEMORY_STAT_BY(STAT_InventoryPrefetchResident, Entry.SizeBytes);
+
+	// Releasing lets the asset be collected unless something else (e.g. an open window) holds it
+	if (Entry.Handle.IsValid())
+	{
+		if (Entry.Handle->IsLoadingInProgress())
+		{
+			Entry.Handle->CancelHandle();
+		}
+		else
+		{
+			Entry.Handle->ReleaseHandle();
+		}
+	}
+}
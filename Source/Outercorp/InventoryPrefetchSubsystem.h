@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryPrefetchSubsystem.generated.h"
+
+class UInventoryComponent;
+struct FStreamableHandle;
+
+/**
+ * Predictive prefetch of item assets for world containers
+ * A few times a second the local player's view (from the player camera manager) and
+ * movement are used to rank nearby containers by how likely they are to be opened: close,
+ * in front of the camera and being walked towards scores highest. Icons and meshes of the
+ * item types listed in the best ranked containers' summaries are requested at low priority,
+ * so they are usually resident by the time a container is opened. Contents are never read,
+ * they may be paged out or not replicated to this client. Prefetched assets are kept within a
+ * memory budget, loads in flight counted at an estimate; when it is exceeded the least
+ * recently wanted ones are released first.
+ */
+UCLASS(Config = Game)
+class OUTERCORP_API UInventoryPrefetchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	/** Containers further than this from the camera are ignored */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float PrefetchRadius = 1500.0f;
+
+	/** Prefetch for at most this many of the best ranked containers */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	int32 MaxContainers = 4;
+
+	/** Seconds between re-ranking */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float UpdateInterval = 0.25f;
+
+	/** Memory prefetched assets may hold, in megabytes */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float MemoryBudgetMB = 64.0f;
+
+	/** Memory reserved for an asset while it loads, in kilobytes, until its real size is known */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float EstimatedAssetKB = 256.0f;
+
+	/** Score bonus for a container straight ahead of the camera */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float FacingWeight = 1.0f;
+
+	/** Score bonus for a container the player is moving towards at full speed */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float ApproachWeight = 1.0f;
+
+	/** Consider a container for prefetch (called from UInventoryComponent::BeginPlay) */
+	void RegisterContainer(UInventoryComponent* Container);
+
+	/** Stop considering a container */
+	void UnregisterContainer(UInventoryComponent* Container);
+
+	/** Bytes held by prefetched assets, those still loading counted at EstimatedAssetKB */
+	int64 GetResidentBytes() const { return ResidentBytes; }
+
+protected:
+	/** Rank containers and request or release assets */
+	void UpdatePrefetch();
+
+	/** Likelihood-of-opening score, 0 if out of range */
+	float ScoreContainer(const UInventoryComponent* Container, const FVector& ViewLocation, const FVector& ViewDirection, const FVector& Velocity, float MaxSpeed) const;
+
+	/** Start a low-priority load for an asset. False if it doesn't fit the budget */
+	bool RequestAsset(const FSoftObjectPath& Path);
+
+	/** Release least recently wanted assets not wanted by this update until NeededBytes fit. False if that's not possible */
+	bool EvictFor(int64 NeededBytes);
+
+	void HandleAssetLoaded(FSoftObjectPath Path);
+
+private:
+	struct FPrefetchEntry
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+
+		/** Update that last wanted this asset */
+		uint32 LastWantedUpdate = 0;
+
+		/** Size counted against the budget: the estimate while loading, then the loaded size */
+		int64 SizeBytes = 0;
+
+		bool bLoaded = false;
+	};
+
+	void ReleaseEntry(const FSoftObjectPath& Path);
+
+	TArray<TWeakObjectPtr<UInventoryComponent>> Containers;
+
+	TMap<FSoftObjectPath, FPrefetchEntry> Entries;
+
+	int64 ResidentBytes = 0;
+
+	/** Incremented by every update */
+	uint32 UpdateNumber = 0;
+
+	float TimeUntilUpdate = 0.0f;
+};
@@ -0,0 +1,394 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryQuery.h"
+#include "InventoryItemData.h"
+
+namespace InventoryQuery
+{
+	static bool Compare(EInventoryQueryOp Op, float A, float B)
+	{
+		switch (Op)
+		{
+		case EInventoryQueryOp::Less:			return A < B;
+		case EInventoryQueryOp::LessEqual:		return A <= B;
+		case EInventoryQueryOp::Greater:		return A > B;
+		case EInventoryQueryOp::GreaterEqual:	return A >= B;
+		case EInventoryQueryOp::Equal:
+		default:								return A == B;
+		}
+	}
+
+	/** Short or alternative names players type for an enum value */
+	struct FEnumAlias
+	{
+		const TCHAR* Alias;
+		int32 Value;
+	};
+
+	static const FEnumAlias CategoryAliases[] =
+	{
+		{ TEXT("ammo"), static_cast<int32>(EItemCategory::Ammunition) },
+		{ TEXT("armour"), static_cast<int32>(EItemCategory::Armor) },
+		{ TEXT("other"), static_cast<int32>(EItemCategory::Misc) }
+	};
+
+	/** Bits of the enum values whose name, display name or alias starts with Prefix */
+	static uint32 MatchEnumPrefix(const UEnum* Enum, int32 NumValues, const FString& Prefix, TConstArrayView<FEnumAlias> Aliases = {})
+	{
+		uint32 Mask = 0;
+		for (int32 i = 0; i < NumValues; ++i)
+		{
+			if (Enum->GetNameStringByIndex(i).StartsWith(Prefix, ESearchCase::IgnoreCase)
+				|| Enum->GetDisplayNameTextByIndex(i).ToString().StartsWith(Prefix, ESearchCase::IgnoreCase))
+			{
+				Mask |= 1u << i;
+			}
+		}
+
+		for (const FEnumAlias& Alias : Aliases)
+		{
+			if (FCString::Strnicmp(Alias.Alias, *Prefix, Prefix.Len()) == 0)
+			{
+				Mask |= 1u << Alias.Value;
+			}
+		}
+
+		// Plurals, e.g. cat:weapons
+		if (Mask == 0 && Prefix.Len() > 1 && Prefix.EndsWith(TEXT("s"), ESearchCase::IgnoreCase))
+		{
+			return MatchEnumPrefix(Enum, NumValues, Prefix.LeftChop(1), Aliases);
+		}
+		return Mask;
+	}
+
+	/** Bits of the ordinals satisfying "ordinal Op Value" */
+	static uint32 MakeOrdinalMask(EInventoryQueryOp Op, int32 Value, int32 NumValues)
+	{
+		uint32 Mask = 0;
+		for (int32 i = 0; i < NumValues; ++i)
+		{
+			if (Compare(Op, static_cast<float>(i), static_cast<float>(Value)))
+			{
+				Mask |= 1u << i;
+			}
+		}
+		return Mask;
+	}
+
+	/** Clear the bits of OutWords whose column value fails the comparison, 32 slots at a time */
+	template <typename CompareType>
+	static void FilterColumn(TConstArrayView<float> Column, uint32* OutWords, int32 NumSlots, CompareType CompareValue)
+	{
+		const int32 NumWords = FMath::DivideAndRoundUp(NumSlots, NumBitsPerDWORD);
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			// Whole word already filtered out by an earlier term
+			if (OutWords[Word] == 0)
+			{
+				continue;
+			}
+
+			const int32 Base = Word * NumBitsPerDWORD;
+			const int32 Count = FMath::Min(NumBitsPerDWORD, NumSlots - Base);
+			const float* Values = Column.GetData() + Base;
+
+			uint32 Mask = 0;
+			for (int32 Bit = 0; Bit < Count; ++Bit)
+			{
+				Mask |= static_cast<uint32>(CompareValue(Values[Bit])) << Bit;
+			}
+
+			OutWords[Word] &= Mask;
+		}
+	}
+
+	/** Parse a key/operator/value term. Returns false if the token is not a term (it is then name text) */
+	static bool ParseTerm(const FString& Token, FInventoryQueryPlan& Plan)
+	{
+		int32 OpStart = INDEX_NONE;
+		for (int32 i = 0; i < Token.Len(); ++i)
+		{
+			const TCHAR Char = Token[i];
+			if (Char == TEXT(':') || Char == TEXT('<') || Char == TEXT('>') || Char == TEXT('='))
+			{
+				OpStart = i;
+				break;
+			}
+		}
+
+		if (OpStart <= 0)
+		{
+			return false;
+		}
+
+		const FString Key = Token.Left(OpStart).ToLower();
+
+		EInventoryQueryOp Op = EInventoryQueryOp::Equal;
+		int32 OpLength = 1;
+		const TCHAR OpChar = Token[OpStart];
+		const bool bHasEquals = OpStart + 1 < Token.Len() && Token[OpStart + 1] == TEXT('=');
+
+		if (OpChar == TEXT('<'))
+		{
+			Op = bHasEquals ? EInventoryQueryOp::LessEqual : EInventoryQueryOp::Less;
+			OpLength = bHasEquals ? 2 : 1;
+		}
+		else if (OpChar == TEXT('>'))
+		{
+			Op = bHasEquals ? EInventoryQueryOp::GreaterEqual : EInventoryQueryOp::Greater;
+			OpLength = bHasEquals ? 2 : 1;
+		}
+
+		const FString Value = Token.Mid(OpStart + OpLength);
+
+		if (Key == TEXT("cat") || Key == TEXT("category"))
+		{
+			// Incomplete terms are ignored while the user is still typing
+			if (!Value.IsEmpty() && Op == EInventoryQueryOp::Equal)
+			{
+				const uint32 Named = MatchEnumPrefix(StaticEnum<EItemCategory>(), FInventorySearchIndex::NumCategories, Value, CategoryAliases);
+				if (Named == 0)
+				{
+					Plan.Errors.Add(FString::Printf(TEXT("Unknown category '%s'"), *Value));
+					return true;
+				}
+
+				FInventoryQueryFacetTerm& Term = Plan.FacetTerms.AddDefaulted_GetRef();
+				Term.Facet = EInventoryFacet::Category;
+				Term.ValueMask = Named;
+			}
+			return true;
+		}
+
+		if (Key == TEXT("rarity"))
+		{
+			if (!Value.IsEmpty())
+			{
+				const uint32 Named = MatchEnumPrefix(StaticEnum<EItemRarity>(), FInventorySearchIndex::NumRarities, Value);
+				if (Named == 0)
+				{
+					Plan.Errors.Add(FString::Printf(TEXT("Unknown rarity '%s'"), *Value));
+					return true;
+				}
+
+				FInventoryQueryFacetTerm& Term = Plan.FacetTerms.AddDefaulted_GetRef();
+				Term.Facet = EInventoryFacet::Rarity;
+				Term.ValueMask = Op == EInventoryQueryOp::Equal
+					? Named
+					: MakeOrdinalMask(Op, static_cast<int32>(FMath::CountTrailingZeros(Named)), FInventorySearchIndex::NumRarities);
+			}
+			return true;
+		}
+
+		if (Key == TEXT("tradeable") || Key == TEXT("sellable"))
+		{
+			if (!Value.IsEmpty() && Op == EInventoryQueryOp::Equal)
+			{
+				FInventoryQueryFacetTerm& Term = Plan.FacetTerms.AddDefaulted_GetRef();
+				Term.Facet = Key == TEXT("tradeable") ? EInventoryFacet::Tradeable : EInventoryFacet::Sellable;
+
+				// yes/true/on/1 (or y) match flagged items, anything else matches unflagged ones
+				const bool bFlag = FCString::ToBool(*Value) || Value.Equals(TEXT("y"), ESearchCase::IgnoreCase);
+				Term.ValueMask = 1;
+				Term.bInvert = !bFlag;
+			}
+			return true;
+		}
+
+		EInventoryQueryColumn Column = EInventoryQueryColumn::Weight;
+		if (Key == TEXT("weight"))
+		{
+			Column = EInventoryQueryColumn::Weight;
+		}
+		else if (Key == TEXT("value"))
+		{
+			Column = EInventoryQueryColumn::Value;
+		}
+		else if (Key == TEXT("qty") || Key == TEXT("quantity"))
+		{
+			Column = EInventoryQueryColumn::Quantity;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (Value.IsNumeric())
+		{
+			FInventoryQueryRangeTerm& Term = Plan.RangeTerms.AddDefaulted_GetRef();
+			Term.Column = Column;
+			Term.Op = Op;
+			Term.Value = FCString::Atof(*Value);
+		}
+		return true;
+	}
+}
+
+FInventoryQueryPlan FInventoryQueryPlan::Compile(const FString& Query)
+{
+	FInventoryQueryPlan Plan;
+
+	TArray<FString> Tokens;
+	Query.ParseIntoArrayWS(Tokens);
+
+	TArray<FString> NameWords;
+	for (const FString& Token : Tokens)
+	{
+		if (!InventoryQuery::ParseTerm(Token, Plan))
+		{
+			NameWords.Add(Token);
+		}
+	}
+
+	Plan.NameText = FString::Join(NameWords, TEXT(" "));
+	return Plan;
+}
+
+void FInventoryQueryPlan::Evaluate(const FInventorySearchIndex& Index, FInventorySearchResult& NameResult, TBitArray<>& OutMatches) const
+{
+	OutMatches = Index.GetOccupiedBits();
+
+	const int32 NumSlots = OutMatches.Num();
+	const int32 NumWords = FMath::DivideAndRoundUp(NumSlots, NumBitsPerDWORD);
+	uint32* OutWords = OutMatches.GetData();
+
+	// Equality facets: OR the bitsets of the allowed values, AND into the result
+	for (const FInventoryQueryFacetTerm& Term : FacetTerms)
+	{
+		TArray<const uint32*, TInlineAllocator<8>> Sources;
+		for (uint32 Mask = Term.ValueMask; Mask != 0; Mask &= Mask - 1)
+		{
+			Sources.Add(Index.GetFacetBits(Term.Facet, static_cast<int32>(FMath::CountTrailingZeros(Mask))).GetData());
+		}
+
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			uint32 Allowed = 0;
+			for (const uint32* Source : Sources)
+			{
+				Allowed |= Source[Word];
+			}
+
+			OutWords[Word] &= Term.bInvert ? ~Allowed : Allowed;
+		}
+	}
+
+	// Range predicates over the packed columns
+	for (const FInventoryQueryRangeTerm& Term : RangeTerms)
+	{
+		const TConstArrayView<float> Column = Index.GetColumn(Term.Column);
+		const float Value = Term.Value;
+
+		switch (Term.Op)
+		{
+		case EInventoryQueryOp::Less:
+			InventoryQuery::FilterColumn(Column, OutWords, NumSlots, [Value](float X) { return X < Value; });
+			break;
+		case EInventoryQueryOp::LessEqual:
+			InventoryQuery::FilterColumn(Column, OutWords, NumSlots, [Value](float X) { return X <= Value; });
+			break;
+		case EInventoryQueryOp::Greater:
+			InventoryQuery::FilterColumn(Column, OutWords, NumSlots, [Value](float X) { return X > Value; });
+			break;
+		case EInventoryQueryOp::GreaterEqual:
+			InventoryQuery::FilterColumn(Column, OutWords, NumSlots, [Value](float X) { return X >= Value; });
+			break;
+		case EInventoryQueryOp::Equal:
+		default:
+			InventoryQuery::FilterColumn(Column, OutWords, NumSlots, [Value](float X) { return X == Value; });
+			break;
+		}
+	}
+
+	// Name text last, it only has to look at the slots that survived the cheaper terms
+	Index.Search(NameText, NameResult);
+	if (NameText.IsEmpty())
+	{
+		return;
+	}
+
+	for (int32 Word = 0; Word < NumWords; ++Word)
+	{
+		uint32 Remaining = OutWords[Word];
+		uint32 Keep = Remaining;
+
+		while (Remaining != 0)
+		{
+			const uint32 Bit = FMath::CountTrailingZeros(Remaining);
+			Remaining &= Remaining - 1;
+
+			if (!NameResult.IsTypeMatching(Index.GetSlotType(Word * NumBitsPerDWORD + Bit)))
+			{
+				Keep &= ~(1u << Bit);
+			}
+		}
+
+		OutWords[Word] = Keep;
+	}
+}
+
+bool FInventoryQueryPlan::EvaluateSlot(const FInventorySearchIndex& Index, const FInventorySearchResult& NameResult, int32 SlotIndex) const
+{
+	const TBitArray<>& Occupied = Index.GetOccupiedBits();
+	if (!Occupied.IsValidIndex(SlotIndex) || !Occupied[SlotIndex])
+	{
+		return false;
+	}
+
+	for (const FInventoryQueryFacetTerm& Term : FacetTerms)
+	{
+		bool bHasValue = false;
+		for (uint32 Mask = Term.ValueMask; Mask != 0 && !bHasValue; Mask &= Mask - 1)
+		{
+			bHasValue = Index.GetFacetBits(Term.Facet, static_cast<int32>(FMath::CountTrailingZeros(Mask)))[SlotIndex];
+		}
+
+		if (bHasValue == Term.bInvert)
+		{
+			return false;
+		}
+	}
+
+	for (const FInventoryQueryRangeTerm& Term : RangeTerms)
+	{
+		if (!InventoryQuery::Compare(Term.Op, Index.GetColumn(Term.Column)[SlotIndex], Term.Value))
+		{
+			return false;
+		}
+	}
+
+	return NameText.IsEmpty() || NameResult.IsTypeMatching(Index.GetSlotType(SlotIndex));
+}
+
+void FInventoryFacetCounts::Compute(const FInventorySearchIndex& Index, const TBitArray<>& Matches)
+{
+	const int32 NumWords = FMath::DivideAndRoundUp(FMath::Min(Matches.Num(), Index.GetNumSlots()), NumBitsPerDWORD);
+	const uint32* MatchWords = Matches.GetData();
+
+	auto CountAnd = [NumWords, MatchWords](const TBitArray<>& Bits)
+	{
+		const uint32* Words = Bits.GetData();
+		int32 Count = 0;
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			Count += FMath::CountBits(MatchWords[Word] & Words[Word]);
+		}
+		return Count;
+	};
+
+	Total = 0;
+	for (int32 Word = 0; Word < NumWords; ++Word)
+	{
+		Total += FMath::CountBits(MatchWords[Word]);
+	}
+
+	for (int32 i = 0; i < FInventorySearchIndex::NumCategories; ++i)
+	{
+		Categories[i] = CountAnd(Index.GetFacetBits(EInventoryFacet::Category, i));
+	}
+
+	for (int32 i = 0; i < FInventorySearchIndex::NumRarities; ++i)
+	{
+		Rarities[i] = CountAnd(Index.GetFacetBits(EInventoryFacet::Rarity, i));
+	}
+}
@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventorySearchIndex.h"
+
+/** Comparison used by a range predicate */
+enum class EInventoryQueryOp : uint8
+{
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual,
+	Equal
+};
+
+/** Equality facet predicate: the slot's facet value must be one of ValueMask's bits */
+struct FInventoryQueryFacetTerm
+{
+	EInventoryFacet Facet = EInventoryFacet::Category;
+
+	/** One bit per enum value; flag facets use bit 0 */
+	uint32 ValueMask = 0;
+
+	/** Match slots without the value instead (flag facets, e.g. tradeable:no) */
+	bool bInvert = false;
+};
+
+/** Numeric predicate evaluated over a packed column */
+struct FInventoryQueryRangeTerm
+{
+	EInventoryQueryColumn Column = EInventoryQueryColumn::Weight;
+	EInventoryQueryOp Op = EInventoryQueryOp::Less;
+	float Value = 0.0f;
+};
+
+/**
+ * Compiled inventory filter, e.g. "cat:ammo rarity>=rare weight<5 lead"
+ * Supported terms:
+ *   cat:<name>, rarity:<name>          category / rarity (prefix match on the enum name or an alias, e.g. ammo)
+ *   rarity<op><name>                   rarity range, op is one of < <= > >= =
+ *   tradeable:yes|no, sellable:yes|no  flags
+ *   weight<op>N, value<op>N, qty<op>N  unit weight, unit value, stack quantity
+ * Anything else is name text; all terms must match. A category or rarity that names no value
+ * is reported in Errors and left out of the plan.
+ */
+struct OUTERCORP_API FInventoryQueryPlan
+{
+	/** Free text matched against item names through the trigram index */
+	FString NameText;
+
+	TArray<FInventoryQueryFacetTerm> FacetTerms;
+	TArray<FInventoryQueryRangeTerm> RangeTerms;
+
+	/** Terms that could not be compiled, e.g. "Unknown category 'foo'" */
+	TArray<FString> Errors;
+
+	/** Parse a query string */
+	static FInventoryQueryPlan Compile(const FString& Query);
+
+	/** No terms at all (everything matches) */
+	bool IsEmpty() const
+	{
+		return NameText.IsEmpty() && FacetTerms.Num() == 0 && RangeTerms.Num() == 0;
+	}
+
+	/** Evaluate against every slot. NameResult is updated (and narrowed when the name text grows) */
+	void Evaluate(const FInventorySearchIndex& Index, FInventorySearchResult& NameResult, TBitArray<>& OutMatches) const;
+
+	/** Evaluate one slot, e.g. after it changed. NameResult must be current for the index */
+	bool EvaluateSlot(const FInventorySearchIndex& Index, const FInventorySearchResult& NameResult, int32 SlotIndex) const;
+};
+
+/**
+ * Per-facet counts of matching slots, for filter tabs
+ * Computed from the facet bitsets with popcounts, no item data is touched.
+ */
+struct OUTERCORP_API FInventoryFacetCounts
+{
+	int32 Categories[FInventorySearchIndex::NumCategories] = {};
+	int32 Rarities[FInventorySearchIndex::NumRarities] = {};
+	int32 Total = 0;
+
+	void Compute(const FInventorySearchIndex& Index, const TBitArray<>& Matches);
+};
@@ -0,0 +1,562 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryReplication.h"
+#include "InventoryComponent.h"
+#include "InventoryItemCatalog.h"
+#include "Engine/GameInstance.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/PackageMapClient.h"
+#include "Engine/World.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/Core/Trace/NetTrace.h"
+#include "Net/UnrealNetwork.h"
+#include "UObject/CoreNet.h"
+#include "Outercorp.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Slot Bits Sent"), STAT_InventorySlotBitsSent, STATGROUP_Inventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Metadata Bits Sent"), STAT_InventoryMetadataBitsSent, STATGROUP_Inventory);
+
+namespace
+{
+	enum ESlotFields : uint8
+	{
+		Field_Quantity = 1 << 0,
+		Field_Metadata = 1 << 1,
+		Field_ItemReference = 1 << 2,
+
+		NumSlotFieldBits = 3
+	};
+
+	enum EMetadataValueType : uint8
+	{
+		Value_String,
+		Value_Int,
+		Value_False,
+		Value_True,
+
+		NumValueTypeBits = 2
+	};
+
+	/** Metadata pairs past this are treated as corrupt */
+	constexpr uint32 MaxMetadataPairs = 256;
+
+	/** Slot indices past this are treated as corrupt */
+	constexpr uint32 MaxSlotIndex = 1 << 20;
+
+	/** First word of client-side instance IDs ("OCNI"), together with a zero second word random GUIDs practically never match */
+	constexpr uint32 ClientInstanceIDTag = 0x4F434E49;
+
+	double GetStackWeight(const FInventoryReplicatedSlot& Entry)
+	{
+		return Entry.ItemData ? static_cast<double>(Entry.ItemData->Weight) * Entry.Quantity : 0.0;
+	}
+
+	UNetConnection* GetConnection(UPackageMap* Map)
+	{
+		UPackageMapClient* PackageMap = Cast<UPackageMapClient>(Map);
+		return PackageMap ? PackageMap->GetConnection() : nullptr;
+	}
+
+	const UInventoryItemCatalogSubsystem* GetCatalog(const UNetConnection* Connection)
+	{
+		const UWorld* World = Connection && Connection->Driver ? Connection->Driver->GetWorld() : nullptr;
+		const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		return GameInstance ? GameInstance->GetSubsystem<UInventoryItemCatalogSubsystem>() : nullptr;
+	}
+
+	/** Integers written the way LexToString would, so the value survives being sent as a number */
+	bool ParseCanonicalInt(const FString& Value, int64& OutValue)
+	{
+		const TCHAR* Digits = *Value;
+		const bool bNegative = *Digits == TEXT('-');
+		if (bNegative)
+		{
+			++Digits;
+		}
+
+		const int32 NumDigits = FCString::Strlen(Digits);
+		if (NumDigits == 0 || NumDigits > 18 || (Digits[0] == TEXT('0') && (NumDigits > 1 || bNegative)))
+		{
+			return false;
+		}
+
+		int64 Result = 0;
+		for (const TCHAR* Digit = Digits; *Digit; ++Digit)
+		{
+			if (*Digit < TEXT('0') || *Digit > TEXT('9'))
+			{
+				return false;
+			}
+			Result = Result * 10 + (*Digit - TEXT('0'));
+		}
+
+		OutValue = bNegative ? -Result : Result;
+		return true;
+	}
+
+	void SerializeMetadataValue(FArchive& Ar, FString& Value)
+	{
+		uint8 Type = Value_String;
+		int64 IntValue = 0;
+		if (Ar.IsSaving())
+		{
+			if (Value.Equals(TEXT("true"), ESearchCase::CaseSensitive))
+			{
+				Type = Value_True;
+			}
+			else if (Value.Equals(TEXT("false"), ESearchCase::CaseSensitive))
+			{
+				Type = Value_False;
+			}
+			else if (ParseCanonicalInt(Value, IntValue))
+			{
+				Type = Value_Int;
+			}
+		}
+
+		Ar.SerializeBits(&Type, NumValueTypeBits);
+
+		switch (Type)
+		{
+		case Value_Int:
+		{
+			// Zigzag, so small negative numbers stay small
+			uint64 Packed = (static_cast<uint64>(IntValue) << 1) ^ static_cast<uint64>(IntValue >> 63);
+			Ar.SerializeIntPacked64(Packed);
+			if (Ar.IsLoading())
+			{
+				Value = LexToString(static_cast<int64>(Packed >> 1) ^ -static_cast<int64>(Packed & 1));
+			}
+			break;
+		}
+		case Value_True:
+		case Value_False:
+			if (Ar.IsLoading())
+			{
+				Value = Type == Value_True ? TEXT("true") : TEXT("false");
+			}
+			break;
+		default:
+			Ar << Value;
+			break;
+		}
+	}
+}
+
+bool FInventoryReplicatedSlot::CopyFrom(const FInventoryItem& Item)
+{
+	bool bMetadataChanged = Metadata.Num() != Item.InstanceMetadata.Num();
+	if (!bMetadataChanged)
+	{
+		int32 i = 0;
+		for (const TPair<FName, FString>& Pair : Item.InstanceMetadata)
+		{
+			const FInventoryReplicatedMetadata& Entry = Metadata[i++];
+			if (Entry.Key != Pair.Key || !Entry.Value.Equals(Pair.Value, ESearchCase::CaseSensitive))
+			{
+				bMetadataChanged = true;
+				break;
+			}
+		}
+	}
+
+	if (!bMetadataChanged && ItemData == Item.ItemData && Quantity == Item.Quantity && InstanceID == Item.InstanceID)
+	{
+		return false;
+	}
+
+	ItemData = Item.ItemData;
+	Quantity = Item.Quantity;
+	InstanceID = Item.InstanceID;
+
+	if (bMetadataChanged)
+	{
+		Metadata.Reset(Item.InstanceMetadata.Num());
+		for (const TPair<FName, FString>& Pair : Item.InstanceMetadata)
+		{
+			Metadata.Add({ Pair.Key, Pair.Value });
+		}
+	}
+
+	return true;
+}
+
+void FInventoryReplicatedSlot::CopyTo(FInventoryItem& Item) const
+{
+	Item.ItemData = ItemData;
+	Item.Quantity = Quantity;
+	Item.InstanceID = InstanceID;
+
+	Item.InstanceMetadata.Reset();
+	for (const FInventoryReplicatedMetadata& Entry : Metadata)
+	{
+		Item.InstanceMetadata.Add(Entry.Key, Entry.Value);
+	}
+}
+
+bool FInventoryReplicatedSlot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	const UInventoryItemCatalogSubsystem* Catalog = GetCatalog(GetConnection(Map));
+
+	// Slot sizes show up in the network profiler; only net archives are bit streams it can trace
+	if (Ar.IsNetArchive() && Ar.IsSaving())
+	{
+		FNetBitWriter& Writer = static_cast<FNetBitWriter&>(Ar);
+		UE_NET_TRACE_SCOPE(InventorySlot, Writer, GetTraceCollector(Writer), ENetTraceVerbosity::Trace);
+		return SerializeWithCatalog(Ar, Map, Catalog, bOutSuccess);
+	}
+
+	if (Ar.IsNetArchive() && Ar.IsLoading())
+	{
+		FNetBitReader& Reader = static_cast<FNetBitReader&>(Ar);
+		UE_NET_TRACE_SCOPE(InventorySlot, Reader, GetTraceCollector(Reader), ENetTraceVerbosity::Trace);
+		return SerializeWithCatalog(Ar, Map, Catalog, bOutSuccess);
+	}
+
+	return SerializeWithCatalog(Ar, Map, Catalog, bOutSuccess);
+}
+
+bool FInventoryReplicatedSlot::SerializeWithCatalog(FArchive& Ar, UPackageMap* Map, const UInventoryItemCatalogSubsystem* Catalog, bool& bOutSuccess)
+{
+	// Replays, fallback serializers and generic struct serialization can pass any FArchive, only net archives are bit writers
+	FNetBitWriter* Writer = Ar.IsSaving() && Ar.IsNetArchive() ? static_cast<FNetBitWriter*>(&Ar) : nullptr;
+	const int64 StartBits = Writer ? Writer->GetNumBits() : 0;
+
+	int32 NetIndex = INDEX_NONE;
+	uint8 Fields = 0;
+	if (Ar.IsSaving())
+	{
+		NetIndex = Catalog ? Catalog->GetNetIndex(ItemData) : INDEX_NONE;
+		Fields |= Quantity != 1 ? Field_Quantity : 0;
+		Fields |= Metadata.Num() > 0 ? Field_Metadata : 0;
+		Fields |= NetIndex == INDEX_NONE ? Field_ItemReference : 0;
+	}
+
+	Ar.SerializeBits(&Fields, NumSlotFieldBits);
+
+	uint32 PackedSlot = static_cast<uint32>(SlotIndex);
+	Ar.SerializeIntPacked(PackedSlot);
+	Ar.SerializeIntPacked(NetInstanceID);
+
+	bOutSuccess = PackedSlot < MaxSlotIndex;
+	SlotIndex = static_cast<int32>(PackedSlot);
+
+	if (Fields & Field_ItemReference)
+	{
+		// No network index, fall back to an object reference
+		UObject* Object = ItemData;
+		bOutSuccess &= Map && Map->SerializeObject(Ar, UInventoryItemData::StaticClass(), Object);
+		ItemData = Cast<UInventoryItemData>(Object);
+		PendingNetIndex = INDEX_NONE;
+	}
+	else
+	{
+		uint32 PackedIndex = static_cast<uint32>(NetIndex);
+		Ar.SerializeIntPacked(PackedIndex);
+		if (Ar.IsLoading())
+		{
+			// Null while the catalog is still loading, the entry is then resolved again once it has loaded
+			ItemData = Catalog ? Catalog->FindItemByNetIndex(static_cast<int32>(PackedIndex)) : nullptr;
+			PendingNetIndex = ItemData ? INDEX_NONE : static_cast<int32>(FMath::Min<uint32>(PackedIndex, MAX_int32));
+			if (!ItemData && Catalog && Catalog->IsCatalogLoaded())
+			{
+				UE_LOG(LogOutercorp, Warning, TEXT("Replicated inventory slot %d has item type %u, which this client's catalog doesn't know"), SlotIndex, PackedIndex);
+			}
+		}
+	}
+
+	if (Fields & Field_Quantity)
+	{
+		uint32 PackedQuantity = static_cast<uint32>(FMath::Max(Quantity, 0));
+		Ar.SerializeIntPacked(PackedQuantity);
+		Quantity = static_cast<int32>(FMath::Min<uint32>(PackedQuantity, MAX_int32));
+	}
+	else
+	{
+		Quantity = 1;
+	}
+
+	if (Fields & Field_Metadata)
+	{
+		const int64 MetadataStartBits = Writer ? Writer->GetNumBits() : 0;
+
+		uint32 NumPairs = static_cast<uint32>(Metadata.Num());
+		Ar.SerializeIntPacked(NumPairs);
+		if (NumPairs > MaxMetadataPairs)
+		{
+			bOutSuccess = false;
+			return true;
+		}
+
+		Metadata.SetNum(NumPairs);
+		const TArray<FName>* Keys = Catalog ? &Catalog->NetMetadataKeys : nullptr;
+		for (FInventoryReplicatedMetadata& Pair : Metadata)
+		{
+			int32 KeyIndex = Keys && Ar.IsSaving() ? Keys->IndexOfByKey(Pair.Key) : INDEX_NONE;
+			uint8 bKnownKey = KeyIndex != INDEX_NONE;
+			Ar.SerializeBits(&bKnownKey, 1);
+
+			if (bKnownKey)
+			{
+				uint32 PackedKey = static_cast<uint32>(KeyIndex);
+				Ar.SerializeIntPacked(PackedKey);
+				if (Ar.IsLoading())
+				{
+					Pair.Key = Keys && Keys->IsValidIndex(static_cast<int32>(PackedKey)) ? (*Keys)[PackedKey] : NAME_None;
+				}
+			}
+			else
+			{
+				Ar << Pair.Key;
+			}
+
+			SerializeMetadataValue(Ar, Pair.Value);
+		}
+
+		if (Writer)
+		{
+			INC_DWORD_STAT_BY(STAT_InventoryMetadataBitsSent, static_cast<uint32>(Writer->GetNumBits() - MetadataStartBits));
+		}
+	}
+	else
+	{
+		Metadata.Reset();
+	}
+
+	if (Writer)
+	{
+		INC_DWORD_STAT_BY(STAT_InventorySlotBitsSent, static_cast<uint32>(Writer->GetNumBits() - StartBits));
+	}
+
+	bOutSuccess &= !Ar.IsError();
+	return true;
+}
+
+void FInventoryReplicatedSlot::PreReplicatedRemove(const FInventoryReplicatedSlots& InArraySerializer)
+{
+	if (UInventoryComponent* Inventory = InArraySerializer.Owner)
+	{
+		Inventory->ApplyReplicatedSlot(*this, true);
+	}
+}
+
+void FInventoryReplicatedSlot::PostReplicatedAdd(const FInventoryReplicatedSlots& InArraySerializer)
+{
+	InstanceID = InArraySerializer.MakeClientInstanceID(NetInstanceID);
+
+	if (UInventoryComponent* Inventory = InArraySerializer.Owner)
+	{
+		Inventory->ApplyReplicatedSlot(*this, false);
+		if (PendingNetIndex != INDEX_NONE)
+		{
+			Inventory->WaitForCatalog();
+		}
+	}
+}
+
+void FInventoryReplicatedSlot::PostReplicatedChange(const FInventoryReplicatedSlots& InArraySerializer)
+{
+	InstanceID = InArraySerializer.MakeClientInstanceID(NetInstanceID);
+
+	if (UInventoryComponent* Inventory = InArraySerializer.Owner)
+	{
+		Inventory->ApplyReplicatedSlot(*this, false);
+		if (PendingNetIndex != INDEX_NONE)
+		{
+			Inventory->WaitForCatalog();
+		}
+	}
+}
+
+bool FInventoryReplicatedSlots::SetSlot(int32 SlotIndex, const FInventoryItem& Item)
+{
+	if (SlotIndex < 0)
+	{
+		return false;
+	}
+
+	if (SlotIndex >= EntryBySlot.Num())
+	{
+		EntryBySlot.Init(INDEX_NONE, SlotIndex + 1);
+		for (int32 i = 0; i < Slots.Num(); ++i)
+		{
+			EntryBySlot[Slots[i].SlotIndex] = i;
+		}
+	}
+
+	const int32 EntryIndex = EntryBySlot[SlotIndex];
+	if (!Item.IsValid())
+	{
+		if (EntryIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		RemoveEntry(EntryIndex);
+		return true;
+	}
+
+	if (EntryIndex != INDEX_NONE)
+	{
+		FInventoryReplicatedSlot& Entry = Slots[EntryIndex];
+		if (Entry.InstanceID != Item.InstanceID)
+		{
+			Entry.NetInstanceID = AllocateNetInstanceID();
+		}
+
+		const double PreviousWeight = GetStackWeight(Entry);
+		if (!Entry.CopyFrom(Item))
+		{
+			return false;
+		}
+
+		TotalWeight += GetStackWeight(Entry) - PreviousWeight;
+		MarkItemDirty(Entry);
+		return true;
+	}
+
+	FInventoryReplicatedSlot& Entry = Slots.AddDefaulted_GetRef();
+	Entry.SlotIndex = SlotIndex;
+	Entry.NetInstanceID = AllocateNetInstanceID();
+	Entry.CopyFrom(Item);
+	EntryBySlot[SlotIndex] = Slots.Num() - 1;
+	TotalWeight += GetStackWeight(Entry);
+	MarkItemDirty(Entry);
+	return true;
+}
+
+bool FInventoryReplicatedSlots::Trim(int32 NumSlots)
+{
+	bool bRemovedAny = false;
+	for (int32 i = Slots.Num() - 1; i >= 0; --i)
+	{
+		if (Slots[i].SlotIndex >= NumSlots)
+		{
+			RemoveEntry(i);
+			bRemovedAny = true;
+		}
+	}
+
+	if (EntryBySlot.Num() > NumSlots)
+	{
+		EntryBySlot.SetNum(FMath::Max(NumSlots, 0));
+	}
+
+	return bRemovedAny;
+}
+
+SIZE_T FInventoryReplicatedSlots::GetAllocatedSize() const
+{
+	SIZE_T Size = Slots.GetAllocatedSize() + EntryBySlot.GetAllocatedSize() + ItemMap.GetAllocatedSize();
+	for (const FInventoryReplicatedSlot& Entry : Slots)
+	{
+		Size += Entry.Metadata.GetAllocatedSize();
+	}
+	return Size;
+}
+
+FGuid FInventoryReplicatedSlots::MakeClientInstanceID(uint32 NetInstanceID) const
+{
+	// Components have distinct unique IDs, so stacks in different inventories never collide
+	return FGuid(ClientInstanceIDTag, 0, Owner ? Owner->GetUniqueID() : 0, NetInstanceID);
+}
+
+uint32 FInventoryReplicatedSlots::ParseClientInstanceID(const FGuid& InstanceID) const
+{
+	const bool bMadeHere = InstanceID.A == ClientInstanceIDTag && InstanceID.B == 0 && InstanceID.C == (Owner ? Owner->GetUniqueID() : 0);
+	return bMadeHere ? InstanceID.D : 0;
+}
+
+uint32 FInventoryReplicatedSlots::FindNetInstanceID(int32 SlotIndex) const
+{
+	const int32 EntryIndex = EntryBySlot.IsValidIndex(SlotIndex) ? EntryBySlot[SlotIndex] : INDEX_NONE;
+	return EntryIndex != INDEX_NONE ? Slots[EntryIndex].NetInstanceID : 0;
+}
+
+int32 FInventoryReplicatedSlots::ResolvePendingItems(const UInventoryItemCatalogSubsystem* Catalog)
+{
+	int32 NumResolved = 0;
+	for (FInventoryReplicatedSlot& Entry : Slots)
+	{
+		if (Entry.PendingNetIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		Entry.ItemData = Catalog ? Catalog->FindItemByNetIndex(Entry.PendingNetIndex) : nullptr;
+		if (!Entry.ItemData)
+		{
+			if (Catalog && Catalog->IsCatalogLoaded())
+			{
+				UE_LOG(LogOutercorp, Warning, TEXT("Replicated inventory slot %d has item type %d, which this client's catalog doesn't know"), Entry.SlotIndex, Entry.PendingNetIndex);
+			}
+			continue;
+		}
+
+		Entry.PendingNetIndex = INDEX_NONE;
+		++NumResolved;
+
+		if (Owner)
+		{
+			Owner->ApplyReplicatedSlot(Entry, false);
+		}
+	}
+	return NumResolved;
+}
+
+uint32 FInventoryReplicatedSlots::AllocateNetInstanceID()
+{
+	// Zero is never used, it reads as "none" on clients
+	if (++LastNetInstanceID == 0)
+	{
+		++LastNetInstanceID;
+	}
+	return LastNetInstanceID;
+}
+
+void FInventoryReplicatedSlots::RemoveEntry(int32 EntryIndex)
+{
+	EntryBySlot[Slots[EntryIndex].SlotIndex] = INDEX_NONE;
+	TotalWeight -= GetStackWeight(Slots[EntryIndex]);
+
+	// Order doesn't matter to the fast array, entries are matched by replication ID
+	Slots.RemoveAtSwap(EntryIndex, 1, EAllowShrinking::No);
+	if (Slots.IsValidIndex(EntryIndex))
+	{
+		EntryBySlot[Slots[EntryIndex].SlotIndex] = EntryIndex;
+	}
+
+	// No drift left behind once empty
+	if (Slots.Num() == 0)
+	{
+		TotalWeight = 0.0;
+	}
+
+	MarkArrayDirty();
+}
+
+void UInventoryReplicatedContents::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryReplicatedContents, Slots, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryReplicatedContents, ChangeSerial, Params);
+}
+
+void UInventoryReplicatedContents::MarkSlotsDirty()
+{
+	++ChangeSerial;
+	MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryReplicatedContents, Slots, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryReplicatedContents, ChangeSerial, this);
+}
+
+void UInventoryReplicatedContents::OnRep_ChangeSerial()
+{
+	if (UInventoryComponent* Inventory = Slots.Owner)
+	{
+		Inventory->HandleReplicatedContents();
+	}
+}
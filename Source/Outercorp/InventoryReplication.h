@@ -0,0 +1,212 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "InventoryReplication.generated.h"
+
+class UInventoryComponent;
+class UInventoryItemCatalogSubsystem;
+class UInventoryItemData;
+struct FInventoryItem;
+struct FInventoryReplicatedSlots;
+
+/** One FInventoryItem::InstanceMetadata pair (maps don't replicate) */
+USTRUCT()
+struct FInventoryReplicatedMetadata
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Key;
+
+	UPROPERTY()
+	FString Value;
+};
+
+/**
+ * Replicated copy of one occupied slot
+ * Serialized by hand: slot index, network instance ID and item type as a catalog network
+ * index go as packed ints; quantity (when not 1), metadata and an item reference for types
+ * outside the catalog are gated by a bitmask. Metadata keys listed in the catalog's
+ * NetMetadataKeys go as an index, and integer and boolean values as such. A type that arrives
+ * while the client's catalog is still loading is resolved again once it has loaded.
+ */
+USTRUCT()
+struct FInventoryReplicatedSlot : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 SlotIndex = INDEX_NONE;
+
+	/** Stands in for InstanceID on the wire, assigned by the server whenever the slot's stack changes identity */
+	UPROPERTY()
+	uint32 NetInstanceID = 0;
+
+	UPROPERTY()
+	TObjectPtr<UInventoryItemData> ItemData;
+
+	UPROPERTY()
+	int32 Quantity = 0;
+
+	/** The stack's real ID on the server; on clients it is derived from NetInstanceID */
+	UPROPERTY()
+	FGuid InstanceID;
+
+	UPROPERTY()
+	TArray<FInventoryReplicatedMetadata> Metadata;
+
+	/** Network index of an item type the client's catalog couldn't resolve yet, ItemData is null until it does (client) */
+	int32 PendingNetIndex = INDEX_NONE;
+
+	/** Copy an item's replicated state, false if nothing differed. The caller assigns NetInstanceID */
+	bool CopyFrom(const FInventoryItem& Item);
+
+	/** Write the replicated state into a slot */
+	void CopyTo(FInventoryItem& Item) const;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	/** NetSerialize against a given catalog rather than the connection's game instance's */
+	bool SerializeWithCatalog(FArchive& Ar, UPackageMap* Map, const UInventoryItemCatalogSubsystem* Catalog, bool& bOutSuccess);
+
+	void PreReplicatedRemove(const FInventoryReplicatedSlots& InArraySerializer);
+	void PostReplicatedAdd(const FInventoryReplicatedSlots& InArraySerializer);
+	void PostReplicatedChange(const FInventoryReplicatedSlots& InArraySerializer);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryReplicatedSlot> : public TStructOpsTypeTraitsBase2<FInventoryReplicatedSlot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * Delta-replicated contents of an inventory
+ * The server keeps one entry per occupied slot, mirroring UInventoryComponent::Items, and only
+ * entries marked dirty since a connection's last update are sent. Clients apply the adds,
+ * changes and removes to their own slot array, which broadcasts OnInventoryUpdated.
+ */
+USTRUCT()
+struct FInventoryReplicatedSlots : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FInventoryReplicatedSlot> Slots;
+
+	/** Component the entries belong to, set in its PostInitProperties */
+	UInventoryComponent* Owner = nullptr;
+
+	/** Update the entry of a slot, adding or removing it as the slot fills or empties (server). False if nothing changed */
+	bool SetSlot(int32 SlotIndex, const FInventoryItem& Item);
+
+	/** Remove the entries of slots at or beyond NumSlots, after the inventory shrank (server). False if nothing changed */
+	bool Trim(int32 NumSlots);
+
+	/** Total weight of the entries, kept up to date by SetSlot (server) */
+	float GetTotalWeight() const { return static_cast<float>(TotalWeight); }
+
+	/** Heap memory held by the entries */
+	SIZE_T GetAllocatedSize() const;
+
+	/** Client-side InstanceID for a network instance ID, unique within the client */
+	FGuid MakeClientInstanceID(uint32 NetInstanceID) const;
+
+	/** Network instance ID a client-side InstanceID was made from, 0 for IDs MakeClientInstanceID didn't make */
+	uint32 ParseClientInstanceID(const FGuid& InstanceID) const;
+
+	/** Network instance ID of the stack in a slot, 0 when empty (server) */
+	uint32 FindNetInstanceID(int32 SlotIndex) const;
+
+	/** Resolve the item types of entries that arrived before the catalog could, applying them to Owner. Returns the number resolved (client) */
+	int32 ResolvePendingItems(const UInventoryItemCatalogSubsystem* Catalog);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInventoryReplicatedSlot, FInventoryReplicatedSlots>(Slots, DeltaParms, *this);
+	}
+
+private:
+	void RemoveEntry(int32 EntryIndex);
+
+	uint32 AllocateNetInstanceID();
+
+	/** Entry index of each slot, INDEX_NONE when empty (server only) */
+	TArray<int32> EntryBySlot;
+
+	/** Last network instance ID handed out (server only) */
+	uint32 LastNetInstanceID = 0;
+
+	/** Sum of the entries' stack weights (server only) */
+	double TotalWeight = 0.0;
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryReplicatedSlots> : public TStructOpsTypeTraitsBase2<FInventoryReplicatedSlots>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Holder of an inventory's replicated contents
+ * A subobject of UInventoryComponent so the contents can replicate to a different set of
+ * connections than the component itself: only to those observing the inventory (its owner,
+ * and anyone with its window open), through a per-inventory net condition group.
+ */
+UCLASS()
+class OUTERCORP_API UInventoryReplicatedContents : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool IsSupportedForNetworking() const override { return true; }
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	UPROPERTY(Replicated)
+	FInventoryReplicatedSlots Slots;
+
+	/** Bumped with every change to Slots, so a client can tell when it has caught up with a given server state */
+	UPROPERTY(ReplicatedUsing = OnRep_ChangeSerial)
+	uint32 ChangeSerial = 0;
+
+	/** Push-model dirty mark, call after changing Slots. Advances ChangeSerial */
+	void MarkSlotsDirty();
+
+protected:
+	/** Arrives after the slot changes of the same update were applied */
+	UFUNCTION()
+	void OnRep_ChangeSerial();
+};
+
+/** What connections not observing an inventory get to know about it */
+USTRUCT(BlueprintType)
+struct FInventorySummary
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory")
+	int32 OccupiedSlots = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory")
+	float Weight = 0.0f;
+
+	/** Distinct item types held, at most MaxItemTypes of them, so clients can prefetch their assets */
+	UPROPERTY()
+	TArray<TObjectPtr<UInventoryItemData>> ItemTypes;
+
+	static constexpr int32 MaxItemTypes = 8;
+
+	bool operator==(const FInventorySummary& Other) const
+	{
+		return OccupiedSlots == Other.OccupiedSlots && Weight == Other.Weight && ItemTypes == Other.ItemTypes;
+	}
+};
@@ -0,0 +1,507 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventorySaveSubsystem.h"
+#include "InventoryComponent.h"
+#include "InventoryItemCatalog.h"
+#include "InventoryJournal.h"
+#include "Engine/GameInstance.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory Save Capture"), STAT_InventorySaveCapture, STATGROUP_Inventory);
+DECLARE_CYCLE_STAT(TEXT("Inventory Save Write"), STAT_InventorySaveWrite, STATGROUP_Inventory);
+DECLARE_CYCLE_STAT(TEXT("Inventory Load Read"), STAT_InventoryLoadRead, STATGROUP_Inventory);
+DECLARE_CYCLE_STAT(TEXT("Inventory Journal Recovery"), STAT_InventoryJournalRecovery, STATGROUP_Inventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Journal Records"), STAT_InventoryJournalRecords, STATGROUP_Inventory);
+
+namespace
+{
+	bool WriteSnapshot(const FString& Directory, const FInventorySnapshot& Snapshot)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InventorySaveWrite);
+
+		TArray<uint8> Bytes;
+		InventoryArchive::Encode(Snapshot, Bytes);
+
+		// Written beside the real file then moved over it, so a crash mid-write keeps the previous save
+		const FString Filename = UInventorySaveSubsystem::GetSaveFilename(Snapshot.PersistenceKey, Directory);
+		const FString TempFilename = Filename + TEXT(".tmp");
+		if (!FFileHelper::SaveArrayToFile(Bytes, *TempFilename) || !IFileManager::Get().Move(*Filename, *TempFilename, true, true))
+		{
+			UE_LOG(LogOutercorp, Error, TEXT("Failed to write inventory save %s"), *Filename);
+			return false;
+		}
+		return true;
+	}
+
+	/** Read a save file. False if there is none or it could not be decoded */
+	bool ReadSnapshot(const FString& Directory, FName PersistenceKey, FInventorySnapshot& OutSnapshot)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InventoryLoadRead);
+
+		const FString Filename = UInventorySaveSubsystem::GetSaveFilename(PersistenceKey, Directory);
+
+		TArray<uint8> Bytes;
+		if (!FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent))
+		{
+			// Never saved
+			return false;
+		}
+
+		FString Error;
+		if (!InventoryArchive::Decode(Bytes, OutSnapshot, Error))
+		{
+			UE_LOG(LogOutercorp, Error, TEXT("Failed to read inventory save %s: %s"), *Filename, *Error);
+			return false;
+		}
+		return true;
+	}
+}
+
+void UInventorySaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UInventoryItemCatalogSubsystem>();
+
+	const FString Directory = GetSaveDirectory();
+	const TArray<int32> Segments = FInventoryJournal::FindSegments(Directory);
+	if (Segments.Num() > 0)
+	{
+		RecoveryTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Directory, Segments]()
+		{
+			return RecoverJournal(Directory, Segments);
+		});
+	}
+
+	// New records go after the recovered segments, which recovery deletes once replayed
+	Journal = MakeShared<FInventoryJournal>(Directory, Segments.Num() > 0 ? Segments.Last() + 1 : 0, GroupCommitInterval);
+
+	if (SnapshotInterval > 0.0f)
+	{
+		SnapshotTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateUObject(this, &UInventorySaveSubsystem::HandleSnapshotTicker), SnapshotInterval);
+	}
+}
+
+void UInventorySaveSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(SnapshotTickerHandle);
+
+	// A clean shutdown leaves saves and no journal
+	CompactJournal();
+	FlushPendingSaves();
+	Journal.Reset();
+	RegisteredInventories.Empty();
+
+	if (UInventoryItemCatalogSubsystem* Catalog = GetGameInstance()->GetSubsystem<UInventoryItemCatalogSubsystem>())
+	{
+		Catalog->OnCatalogLoaded.RemoveDynamic(this, &UInventorySaveSubsystem::HandleCatalogLoaded);
+	}
+	LoadsAwaitingCatalog.Empty();
+
+	Super::Deinitialize();
+}
+
+void UInventorySaveSubsystem::RegisterInventory(UInventoryComponent* Inventory)
+{
+	if (Inventory && !Inventory->PersistenceKey.IsNone())
+	{
+		RegisteredInventories.AddUnique(Inventory);
+	}
+}
+
+void UInventorySaveSubsystem::UnregisterInventory(UInventoryComponent* Inventory)
+{
+	if (RegisteredInventories.Remove(Inventory) > 0)
+	{
+		// Its journal records are only dropped by a compaction once this save is on disk
+		SaveInventory(Inventory);
+	}
+}
+
+void UInventorySaveSubsystem::JournalSlot(const UInventoryComponent& Inventory, int32 SlotIndex)
+{
+	if (!Journal)
+	{
+		return;
+	}
+
+	FInventoryJournalRecord Record;
+	Record.Type = FInventoryJournalRecord::EType::SetSlot;
+	Record.PersistenceKey = Inventory.PersistenceKey;
+	Record.Slot = Inventory.CaptureSlot(SlotIndex);
+	Journal->Append(Record);
+
+	INC_DWORD_STAT(STAT_InventoryJournalRecords);
+}
+
+void UInventorySaveSubsystem::JournalCapacity(const UInventoryComponent& Inventory)
+{
+	if (!Journal)
+	{
+		return;
+	}
+
+	FInventoryJournalRecord Record;
+	Record.Type = FInventoryJournalRecord::EType::SetCapacity;
+	Record.PersistenceKey = Inventory.PersistenceKey;
+	Record.MaxSlots = Inventory.MaxSlots;
+	Journal->Append(Record);
+
+	INC_DWORD_STAT(STAT_InventoryJournalRecords);
+}
+
+void UInventorySaveSubsystem::CompactJournal()
+{
+	if (!Journal)
+	{
+		return;
+	}
+
+	// Everything journaled so far is in the old segments and in the snapshots taken right after
+	const int32 Segment = Journal->StartNewSegment();
+
+	RegisteredInventories.RemoveAll([](const TWeakObjectPtr<UInventoryComponent>& Inventory)
+	{
+		return !Inventory.IsValid();
+	});
+
+	for (const TWeakObjectPtr<UInventoryComponent>& Inventory : RegisteredInventories)
+	{
+		SaveInventory(Inventory.Get());
+	}
+
+	if (UnsavedInventories.Num() > 0)
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("%d inventories could not be saved, keeping the inventory journal"), UnsavedInventories.Num());
+		return;
+	}
+
+	// This compaction's writes, and any earlier one still pending or failed
+	TArray<UE::Tasks::TTask<bool>> Writes;
+	Writes.Reserve(PendingWrites.Num());
+	for (const TPair<FName, FPendingWrite>& Pair : PendingWrites)
+	{
+		Writes.Add(Pair.Value.Task);
+	}
+
+	TArray<UE::Tasks::TTask<bool>> Prerequisites = Writes;
+	if (RecoveryTask.IsValid())
+	{
+		Prerequisites.Add(RecoveryTask);
+	}
+
+	CompactionTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Journal = Journal, Segment, Writes = MoveTemp(Writes)]() mutable
+	{
+		for (UE::Tasks::TTask<bool>& Write : Writes)
+		{
+			if (!Write.GetResult())
+			{
+				UE_LOG(LogOutercorp, Warning, TEXT("An inventory save failed, keeping the inventory journal"));
+				return;
+			}
+		}
+		Journal->TruncateBefore(Segment);
+	}, Prerequisites);
+}
+
+bool UInventorySaveSubsystem::SaveInventory(UInventoryComponent* Inventory)
+{
+	if (!Inventory || Inventory->PersistenceKey.IsNone())
+	{
+		return false;
+	}
+
+	FInventorySnapshot Snapshot;
+	bool bCaptured = false;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InventorySaveCapture);
+		bCaptured = Inventory->CaptureSnapshot(Snapshot);
+	}
+
+	// Writing what's in memory would replace the save with an empty inventory
+	if (!bCaptured)
+	{
+		UE_LOG(LogOutercorp, Error, TEXT("%s: contents could not be read, not saving over %s"), *Inventory->GetPathName(), *Inventory->PersistenceKey.ToString());
+		UnsavedInventories.Add(Inventory->PersistenceKey);
+		return false;
+	}
+
+	UnsavedInventories.Remove(Inventory->PersistenceKey);
+	QueueWrite(MoveTemp(Snapshot));
+	return true;
+}
+
+int32 UInventorySaveSubsystem::SaveInventories(const TArray<UInventoryComponent*>& Inventories)
+{
+	int32 NumQueued = 0;
+	for (UInventoryComponent* Inventory : Inventories)
+	{
+		if (SaveInventory(Inventory))
+		{
+			++NumQueued;
+		}
+	}
+	return NumQueued;
+}
+
+bool UInventorySaveSubsystem::DeliverItems(UInventoryComponent* Inventory, const TArray<FItemQuantity>& Items, TArray<FItemQuantity>& OutRejected)
+{
+	OutRejected.Reset();
+	if (!Inventory || Inventory->PersistenceKey.IsNone())
+	{
+		return false;
+	}
+
+	Inventory->AddItems(Items, OutRejected);
+	SaveInventory(Inventory);
+	return true;
+}
+
+void UInventorySaveSubsystem::LoadInventories(const TArray<UInventoryComponent*>& Inventories, FOnInventoriesLoaded OnLoaded)
+{
+	TSharedRef<FPendingLoad> Load = MakeShared<FPendingLoad>();
+	Load->OnLoaded = MoveTemp(OnLoaded);
+
+	for (UInventoryComponent* Inventory : Inventories)
+	{
+		if (Inventory && !Inventory->PersistenceKey.IsNone())
+		{
+			Load->Inventories.Add(Inventory);
+		}
+	}
+
+	// Sized up front, the read tasks write into their own element
+	Load->Snapshots.SetNum(Load->Inventories.Num());
+
+	TArray<UE::Tasks::FTask> ReadTasks;
+	ReadTasks.Reserve(Load->Inventories.Num());
+	for (int32 i = 0; i < Load->Inventories.Num(); ++i)
+	{
+		const FName Key = Load->Inventories[i]->PersistenceKey;
+
+		// A read never overtakes recovery or a write of the same inventory
+		TArray<UE::Tasks::TTask<bool>, TInlineAllocator<2>> Prerequisites;
+		if (RecoveryTask.IsValid())
+		{
+			Prerequisites.Add(RecoveryTask);
+		}
+		if (const FPendingWrite* Write = PendingWrites.Find(Key))
+		{
+			Prerequisites.Add(Write->Task);
+		}
+
+		ReadTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [Load, i, Key, Directory = GetSaveDirectory()]()
+		{
+			FInventorySnapshot Snapshot;
+			if (ReadSnapshot(Directory, Key, Snapshot))
+			{
+				Load->Snapshots[i] = MoveTemp(Snapshot);
+			}
+		}, Prerequisites));
+	}
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis = TWeakObjectPtr<UInventorySaveSubsystem>(this), Load]()
+	{
+		if (UInventorySaveSubsystem* This = WeakThis.Get())
+		{
+			This->ApplyLoad(Load);
+		}
+	}, ReadTasks, UE::Tasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+}
+
+void UInventorySaveSubsystem::FlushPendingSaves()
+{
+	RecoveryTask.Wait();
+
+	// Failures are recorded here, the game thread tasks HandleWriteFailed runs in may come too late
+	for (TPair<FName, FPendingWrite>& Pair : PendingWrites)
+	{
+		if (!Pair.Value.Task.GetResult())
+		{
+			UnsavedInventories.Add(Pair.Key);
+		}
+	}
+	PendingWrites.Reset();
+
+	CompactionTask.Wait();
+
+	if (Journal && !Journal->Flush())
+	{
+		UE_LOG(LogOutercorp, Error, TEXT("Inventory journal could not be written, recent inventory changes are only in memory"));
+	}
+}
+
+FString UInventorySaveSubsystem::GetSaveFilename(FName PersistenceKey, const FString& Directory)
+{
+	return Directory / PersistenceKey.ToString() + TEXT(".inv");
+}
+
+FString UInventorySaveSubsystem::GetSaveDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Inventories");
+}
+
+void UInventorySaveSubsystem::QueueWrite(FInventorySnapshot&& Snapshot)
+{
+	// Failed writes stay, so the next compaction sees them and keeps the journal
+	for (auto It = PendingWrites.CreateIterator(); It; ++It)
+	{
+		if (It->Value.Task.IsCompleted() && It->Value.Task.GetResult())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const FName Key = Snapshot.PersistenceKey;
+	const uint32 Serial = ++NextWriteSerial;
+
+	TArray<UE::Tasks::TTask<bool>, TInlineAllocator<2>> Prerequisites;
+	if (RecoveryTask.IsValid())
+	{
+		Prerequisites.Add(RecoveryTask);
+	}
+	if (const FPendingWrite* Previous = PendingWrites.Find(Key))
+	{
+		Prerequisites.Add(Previous->Task);
+	}
+
+	FPendingWrite& Write = PendingWrites.Add(Key);
+	Write.Serial = Serial;
+	Write.Task = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[WeakThis = TWeakObjectPtr<UInventorySaveSubsystem>(this), Snapshot = MoveTemp(Snapshot), Key, Serial, Directory = GetSaveDirectory()]()
+	{
+		if (WriteSnapshot(Directory, Snapshot))
+		{
+			return true;
+		}
+
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, Key, Serial]()
+		{
+			if (UInventorySaveSubsystem* This = WeakThis.Get())
+			{
+				This->HandleWriteFailed(Key, Serial);
+			}
+		}, UE::Tasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+		return false;
+	}, Prerequisites);
+}
+
+void UInventorySaveSubsystem::HandleWriteFailed(FName PersistenceKey, uint32 Serial)
+{
+	const FPendingWrite* Latest = PendingWrites.Find(PersistenceKey);
+	if (Latest && Latest->Serial == Serial)
+	{
+		UnsavedInventories.Add(PersistenceKey);
+	}
+}
+
+bool UInventorySaveSubsystem::RecoverJournal(const FString& Directory, const TArray<int32>& Segments)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryJournalRecovery);
+
+	TMap<FName, FInventorySnapshot> Recovered;
+	int32 NumRecords = 0;
+
+	for (int32 Segment : Segments)
+	{
+		const FString Filename = FInventoryJournal::GetSegmentFilename(Directory, Segment);
+
+		TArray<uint8> Bytes;
+		if (!FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent))
+		{
+			continue;
+		}
+
+		TArray<FInventoryJournalRecord> Records;
+		if (!InventoryArchive::DecodeJournal(Bytes, Records))
+		{
+			// Expected after a crash: the last group commit was cut short
+			UE_LOG(LogOutercorp, Warning, TEXT("Inventory journal %s ends in a torn record, replaying the %d records before it"), *Filename, Records.Num());
+		}
+
+		for (const FInventoryJournalRecord& Record : Records)
+		{
+			FInventorySnapshot* Snapshot = Recovered.Find(Record.PersistenceKey);
+			if (!Snapshot)
+			{
+				// Never saved: rebuilt with MaxSlots 0 (unknown) unless the journal resized it, the inventory keeps its own
+				Snapshot = &Recovered.Add(Record.PersistenceKey);
+				if (!ReadSnapshot(Directory, Record.PersistenceKey, *Snapshot))
+				{
+					*Snapshot = FInventorySnapshot();
+				}
+				Snapshot->PersistenceKey = Record.PersistenceKey;
+			}
+
+			InventoryArchive::ApplyJournalRecord(*Snapshot, Record);
+		}
+		NumRecords += Records.Num();
+	}
+
+	bool bWroteAll = true;
+	for (const TPair<FName, FInventorySnapshot>& Pair : Recovered)
+	{
+		bWroteAll &= WriteSnapshot(Directory, Pair.Value);
+	}
+
+	// Kept on failure, the next start tries again
+	if (bWroteAll)
+	{
+		for (int32 Segment : Segments)
+		{
+			IFileManager::Get().Delete(*FInventoryJournal::GetSegmentFilename(Directory, Segment), false, false, true);
+		}
+	}
+
+	UE_LOG(LogOutercorp, Log, TEXT("Recovered %d journaled inventory changes across %d inventories"), NumRecords, Recovered.Num());
+	return bWroteAll;
+}
+
+void UInventorySaveSubsystem::ApplyLoad(const TSharedRef<FPendingLoad>& Load)
+{
+	UInventoryItemCatalogSubsystem* Catalog = GetGameInstance()->GetSubsystem<UInventoryItemCatalogSubsystem>();
+	if (Catalog && !Catalog->IsCatalogLoaded())
+	{
+		LoadsAwaitingCatalog.Add(Load);
+		Catalog->OnCatalogLoaded.AddUniqueDynamic(this, &UInventorySaveSubsystem::HandleCatalogLoaded);
+		return;
+	}
+
+	int32 NumLoaded = 0;
+	for (int32 i = 0; i < Load->Inventories.Num(); ++i)
+	{
+		UInventoryComponent* Inventory = Load->Inventories[i].Get();
+		if (Inventory && Load->Snapshots[i].IsSet())
+		{
+			Inventory->ApplySnapshot(Load->Snapshots[i].GetValue(), Catalog);
+			++NumLoaded;
+		}
+	}
+
+	Load->OnLoaded.ExecuteIfBound(NumLoaded);
+}
+
+void UInventorySaveSubsystem::HandleCatalogLoaded()
+{
+	if (UInventoryItemCatalogSubsystem* Catalog = GetGameInstance()->GetSubsystem<UInventoryItemCatalogSubsystem>())
+	{
+		Catalog->OnCatalogLoaded.RemoveDynamic(this, &UInventorySaveSubsystem::HandleCatalogLoaded);
+	}
+
+	TArray<TSharedRef<FPendingLoad>> Loads = MoveTemp(LoadsAwaitingCatalog);
+	LoadsAwaitingCatalog.Reset();
+	for (const TSharedRef<FPendingLoad>& Load : Loads)
+	{
+		ApplyLoad(Load);
+	}
+}
+
+bool UInventorySaveSubsystem::HandleSnapshotTicker(float DeltaTime)
+{
+	CompactJournal();
+	return true;
+}
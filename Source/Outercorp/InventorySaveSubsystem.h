@@ -0,0 +1,155 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tasks/Task.h"
+#include "Containers/Ticker.h"
+#include "InventoryArchive.h"
+#include "InventoryItemData.h"
+#include "InventorySaveSubsystem.generated.h"
+
+class UInventoryComponent;
+class FInventoryJournal;
+
+DECLARE_DELEGATE_OneParam(FOnInventoriesLoaded, int32 /*NumLoaded*/);
+
+/**
+ * Saves and loads inventories in the InventoryArchive format
+ * Saving only copies the occupied slots on the game thread; encoding, compression and the
+ * file write run as background tasks, and writes of the same inventory stay in order.
+ * Loads read and decode every file in parallel, then apply the results on the game thread
+ * once the item catalog is ready. Files live in Saved/Inventories/<PersistenceKey>.inv.
+ *
+ * Between saves, every committed change to a registered inventory is appended to a journal
+ * (see FInventoryJournal), so a crash loses at most one group commit interval. Every
+ * SnapshotInterval all registered inventories are saved and the journal is truncated. At
+ * startup any journal left behind is replayed onto the saved files before loads may read them.
+ */
+UCLASS(Config = Game)
+class OUTERCORP_API UInventorySaveSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** How often journaled changes are written to disk together, in seconds */
+	UPROPERTY(Config, BlueprintReadOnly, Category = "Inventory")
+	float GroupCommitInterval = 0.05f;
+
+	/** How often registered inventories are saved and the journal truncated, in seconds (0 = never) */
+	UPROPERTY(Config, BlueprintReadOnly, Category = "Inventory")
+	float SnapshotInterval = 300.0f;
+
+	/** Start journaling an inventory's changes (called from BeginPlay when it has a PersistenceKey) */
+	void RegisterInventory(UInventoryComponent* Inventory);
+
+	/** Stop journaling an inventory and save it */
+	void UnregisterInventory(UInventoryComponent* Inventory);
+
+	/** Journal the new contents of a slot */
+	void JournalSlot(const UInventoryComponent& Inventory, int32 SlotIndex);
+
+	/** Journal a capacity change */
+	void JournalCapacity(const UInventoryComponent& Inventory);
+
+	/** Save every registered inventory and drop the journal written before them once they are on disk */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void CompactJournal();
+
+	/** Snapshot an inventory now and write it in the background. Fails if it has no PersistenceKey or its contents can't be read */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool SaveInventory(UInventoryComponent* Inventory);
+
+	/** Snapshot several inventories in the same frame (e.g. autosave) and write them in the background. Returns the number queued */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	int32 SaveInventories(const TArray<UInventoryComponent*>& Inventories);
+
+	/**
+	 * Add items to an inventory and save it right away, for inventories whose actor has ended play:
+	 * they no longer journal their changes. What doesn't fit is returned in OutRejected. False (nothing
+	 * added) without a PersistenceKey
+	 */
+	bool DeliverItems(UInventoryComponent* Inventory, const TArray<FItemQuantity>& Items, TArray<FItemQuantity>& OutRejected);
+
+	/** Read saved contents for these inventories in parallel and apply them on the game thread. Inventories without a save are left alone */
+	void LoadInventories(const TArray<UInventoryComponent*>& Inventories, FOnInventoriesLoaded OnLoaded = FOnInventoriesLoaded());
+
+	/** Block until every queued write and journaled change has reached disk */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void FlushPendingSaves();
+
+	/** File an inventory is saved to */
+	static FString GetSaveFilename(FName PersistenceKey, const FString& Directory = GetSaveDirectory());
+
+	/** Directory holding saves and the journal */
+	static FString GetSaveDirectory();
+
+	/**
+	 * Replay journal segments left by a previous session onto the save files in Directory, then delete them
+	 * Returns false if a save could not be written; the segments are then kept for the next start.
+	 */
+	static bool RecoverJournal(const FString& Directory, const TArray<int32>& Segments);
+
+private:
+	/** One LoadInventories call, filled in by the read tasks */
+	struct FPendingLoad
+	{
+		TArray<TWeakObjectPtr<UInventoryComponent>> Inventories;
+
+		/** Parallel to Inventories, unset when there was no save or it failed to decode */
+		TArray<TOptional<FInventorySnapshot>> Snapshots;
+
+		FOnInventoriesLoaded OnLoaded;
+	};
+
+	/** A queued write; its task returns whether the save reached disk */
+	struct FPendingWrite
+	{
+		UE::Tasks::TTask<bool> Task;
+
+		/** Tells a failed write apart from a later write of the same inventory */
+		uint32 Serial = 0;
+	};
+
+	/** Encode and write a snapshot after any earlier write of the same inventory */
+	void QueueWrite(FInventorySnapshot&& Snapshot);
+
+	/** A write failed (game thread); unless a newer write of the inventory was queued, keep the journal for it */
+	void HandleWriteFailed(FName PersistenceKey, uint32 Serial);
+
+	/** Apply decoded snapshots, or hold them until the catalog has loaded */
+	void ApplyLoad(const TSharedRef<FPendingLoad>& Load);
+
+	UFUNCTION()
+	void HandleCatalogLoaded();
+
+	bool HandleSnapshotTicker(float DeltaTime);
+
+	/** Most recent write per PersistenceKey; failed ones stay until a newer write replaces them */
+	TMap<FName, FPendingWrite> PendingWrites;
+
+	uint32 NextWriteSerial = 0;
+
+	/** Replays the journal left by the previous session, reads and writes wait for it */
+	UE::Tasks::TTask<bool> RecoveryTask;
+
+	TSharedPtr<FInventoryJournal> Journal;
+
+	/** Truncates the journal once the last compaction's snapshots are on disk, if they all were written */
+	UE::Tasks::FTask CompactionTask;
+
+	/** Inventories whose changes are journaled */
+	TArray<TWeakObjectPtr<UInventoryComponent>> RegisteredInventories;
+
+	/** Inventories whose last save failed; their changes are only in the journal, so it isn't truncated */
+	TSet<FName> UnsavedInventories;
+
+	FTSTicker::FDelegateHandle SnapshotTickerHandle;
+
+	/** Loads that finished reading before the item catalog */
+	TArray<TSharedRef<FPendingLoad>> LoadsAwaitingCatalog;
+};
@@ -0,0 +1,345 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventorySearchIndex.h"
+
+void FInventorySearchIndex::Build(const TArray<FInventoryItem>& Items)
+{
+	Reset();
+
+	bBuilt = true;
+
+	EnsureSlotCapacity(Items.Num());
+
+	for (int32 i = 0; i < Items.Num(); ++i)
+	{
+		if (Items[i].IsValid())
+		{
+			UpdateSlot(i, Items[i]);
+		}
+	}
+}
+
+void FInventorySearchIndex::Reset()
+{
+	Types.Reset();
+	TypeLookup.Reset();
+	TrigramPostings.Reset();
+	SlotTypes.Reset();
+	SlotPositions.Reset();
+	OccupiedBits.Empty();
+	for (TBitArray<>& Bits : CategoryBits)
+	{
+		Bits.Empty();
+	}
+	for (TBitArray<>& Bits : RarityBits)
+	{
+		Bits.Empty();
+	}
+	TradeableBits.Empty();
+	SellableBits.Empty();
+	for (TArray<float>& Column : Columns)
+	{
+		Column.Reset();
+	}
+	++Revision;
+	bBuilt = false;
+}
+
+void FInventorySearchIndex::Release()
+{
+	Reset();
+
+	Types.Empty();
+	TypeLookup.Empty();
+	TrigramPostings.Empty();
+	SlotTypes.Empty();
+	SlotPositions.Empty();
+	for (TArray<float>& Column : Columns)
+	{
+		Column.Empty();
+	}
+}
+
+SIZE_T FInventorySearchIndex::GetAllocatedSize() const
+{
+	SIZE_T Size = Types.GetAllocatedSize() + TypeLookup.GetAllocatedSize() + TrigramPostings.GetAllocatedSize()
+		+ SlotTypes.GetAllocatedSize() + SlotPositions.GetAllocatedSize()
+		+ OccupiedBits.GetAllocatedSize() + TradeableBits.GetAllocatedSize() + SellableBits.GetAllocatedSize();
+
+	for (const FTypeEntry& Entry : Types)
+	{
+		Size += Entry.Slots.GetAllocatedSize() + Entry.FoldedName.GetAllocatedSize();
+	}
+	for (const TPair<uint64, TArray<int32>>& Posting : TrigramPostings)
+	{
+		Size += Posting.Value.GetAllocatedSize();
+	}
+	for (const TBitArray<>& Bits : CategoryBits)
+	{
+		Size += Bits.GetAllocatedSize();
+	}
+	for (const TBitArray<>& Bits : RarityBits)
+	{
+		Size += Bits.GetAllocatedSize();
+	}
+	for (const TArray<float>& Column : Columns)
+	{
+		Size += Column.GetAllocatedSize();
+	}
+	return Size;
+}
+
+void FInventorySearchIndex::UpdateSlot(int32 SlotIndex, const FInventoryItem& Item)
+{
+	if (!bBuilt || SlotIndex < 0)
+	{
+		return;
+	}
+
+	EnsureSlotCapacity(SlotIndex + 1);
+
+	const bool bOccupied = Item.IsValid();
+	Columns[static_cast<int32>(EInventoryQueryColumn::Quantity)][SlotIndex] = bOccupied ? static_cast<float>(Item.Quantity) : 0.0f;
+
+	const int32 NewType = bOccupied ? FindOrAddType(Item.ItemData) : INDEX_NONE;
+	const int32 OldType = SlotTypes[SlotIndex];
+	if (OldType == NewType)
+	{
+		return;
+	}
+
+	if (OldType != INDEX_NONE)
+	{
+		SetSlotFacets(SlotIndex, OldType, false);
+		RemoveSlotFromType(SlotIndex);
+	}
+
+	if (NewType != INDEX_NONE)
+	{
+		SlotTypes[SlotIndex] = NewType;
+		SlotPositions[SlotIndex] = Types[NewType].Slots.Add(SlotIndex);
+		SetSlotFacets(SlotIndex, NewType, true);
+	}
+}
+
+const TBitArray<>& FInventorySearchIndex::GetFacetBits(EInventoryFacet Facet, int32 Value) const
+{
+	switch (Facet)
+	{
+	case EInventoryFacet::Category:
+		return CategoryBits[FMath::Clamp(Value, 0, NumCategories - 1)];
+	case EInventoryFacet::Rarity:
+		return RarityBits[FMath::Clamp(Value, 0, NumRarities - 1)];
+	case EInventoryFacet::Tradeable:
+		return TradeableBits;
+	case EInventoryFacet::Sellable:
+	default:
+		return SellableBits;
+	}
+}
+
+void FInventorySearchIndex::Search(const FString& Query, FInventorySearchResult& InOutResult, TArray<int32>* OutChangedTypes) const
+{
+	const FString Folded = FoldName(Query.TrimStartAndEnd());
+	const int32 NumTypes = Types.Num();
+
+	TBitArray<> NewMatches(Folded.IsEmpty(), NumTypes);
+
+	if (!Folded.IsEmpty())
+	{
+		auto Matches = [this, &Folded](int32 TypeIndex)
+		{
+			return Types[TypeIndex].FoldedName.Contains(Folded, ESearchCase::CaseSensitive);
+		};
+
+		// A query containing the previous one can only match a subset of its results
+		const bool bNarrow = InOutResult.bValid
+			&& InOutResult.Revision == Revision
+			&& !InOutResult.FoldedQuery.IsEmpty()
+			&& Folded.Contains(InOutResult.FoldedQuery, ESearchCase::CaseSensitive);
+
+		if (bNarrow)
+		{
+			for (TConstSetBitIterator<> It(InOutResult.MatchingTypes); It; ++It)
+			{
+				if (It.GetIndex() < NumTypes && Matches(It.GetIndex()))
+				{
+					NewMatches[It.GetIndex()] = true;
+				}
+			}
+		}
+		else if (Folded.Len() >= 3)
+		{
+			// Candidates come from the rarest trigram of the query, then are verified
+			const TArray<int32>* Candidates = nullptr;
+			for (int32 i = 0; i + 3 <= Folded.Len(); ++i)
+			{
+				const TArray<int32>* Posting = TrigramPostings.Find(MakeTrigram(*Folded + i));
+				if (!Posting)
+				{
+					Candidates = nullptr;
+					break;
+				}
+
+				if (!Candidates || Posting->Num() < Candidates->Num())
+				{
+					Candidates = Posting;
+				}
+			}
+
+			if (Candidates)
+			{
+				for (int32 TypeIndex : *Candidates)
+				{
+					if (Matches(TypeIndex))
+					{
+						NewMatches[TypeIndex] = true;
+					}
+				}
+			}
+		}
+		else
+		{
+			for (int32 TypeIndex = 0; TypeIndex < NumTypes; ++TypeIndex)
+			{
+				if (Matches(TypeIndex))
+				{
+					NewMatches[TypeIndex] = true;
+				}
+			}
+		}
+	}
+
+	if (OutChangedTypes)
+	{
+		for (int32 TypeIndex = 0; TypeIndex < NumTypes; ++TypeIndex)
+		{
+			if (NewMatches[TypeIndex] != InOutResult.IsTypeMatching(TypeIndex))
+			{
+				OutChangedTypes->Add(TypeIndex);
+			}
+		}
+	}
+
+	InOutResult.MatchingTypes = MoveTemp(NewMatches);
+	InOutResult.FoldedQuery = Folded;
+	InOutResult.Revision = Revision;
+	InOutResult.bValid = true;
+}
+
+FString FInventorySearchIndex::FoldName(const FString& Name)
+{
+	return Name.ToLower();
+}
+
+int32 FInventorySearchIndex::FindOrAddType(const UInventoryItemData* ItemData)
+{
+	if (const int32* Existing = TypeLookup.Find(ItemData))
+	{
+		return *Existing;
+	}
+
+	const int32 TypeIndex = Types.AddDefaulted();
+	FTypeEntry& Entry = Types[TypeIndex];
+	Entry.ItemData = ItemData;
+	Entry.FoldedName = FoldName(ItemData->ItemName.ToString());
+	Entry.Category = FMath::Clamp(static_cast<int32>(ItemData->Category), 0, NumCategories - 1);
+	Entry.Rarity = FMath::Clamp(static_cast<int32>(ItemData->Rarity), 0, NumRarities - 1);
+	Entry.bTradeable = ItemData->bIsTradeable;
+	Entry.bSellable = ItemData->bIsSellable;
+	Entry.UnitWeight = ItemData->Weight;
+	Entry.UnitValue = static_cast<float>(ItemData->BaseValue);
+	TypeLookup.Add(ItemData, TypeIndex);
+
+	TSet<uint64, DefaultKeyFuncs<uint64>, TInlineSetAllocator<32>> Trigrams;
+	for (int32 i = 0; i + 3 <= Entry.FoldedName.Len(); ++i)
+	{
+		Trigrams.Add(MakeTrigram(*Entry.FoldedName + i));
+	}
+
+	for (uint64 Trigram : Trigrams)
+	{
+		TrigramPostings.FindOrAdd(Trigram).Add(TypeIndex);
+	}
+
+	++Revision;
+	return TypeIndex;
+}
+
+void FInventorySearchIndex::RemoveSlotFromType(int32 SlotIndex)
+{
+	const int32 TypeIndex = SlotTypes[SlotIndex];
+	if (TypeIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	TArray<int32>& Slots = Types[TypeIndex].Slots;
+	const int32 Position = SlotPositions[SlotIndex];
+
+	Slots.RemoveAtSwap(Position, 1, EAllowShrinking::No);
+	if (Position < Slots.Num())
+	{
+		SlotPositions[Slots[Position]] = Position;
+	}
+
+	SlotTypes[SlotIndex] = INDEX_NONE;
+	SlotPositions[SlotIndex] = INDEX_NONE;
+}
+
+void FInventorySearchIndex::EnsureSlotCapacity(int32 NumSlots)
+{
+	const int32 OldNum = SlotTypes.Num();
+	if (NumSlots <= OldNum)
+	{
+		return;
+	}
+
+	const int32 Added = NumSlots - OldNum;
+
+	SlotTypes.Reserve(NumSlots);
+	SlotPositions.Reserve(NumSlots);
+	for (int32 i = 0; i < Added; ++i)
+	{
+		SlotTypes.Add(INDEX_NONE);
+		SlotPositions.Add(INDEX_NONE);
+	}
+
+	OccupiedBits.Add(false, Added);
+	for (TBitArray<>& Bits : CategoryBits)
+	{
+		Bits.Add(false, Added);
+	}
+	for (TBitArray<>& Bits : RarityBits)
+	{
+		Bits.Add(false, Added);
+	}
+	TradeableBits.Add(false, Added);
+	SellableBits.Add(false, Added);
+
+	for (TArray<float>& Column : Columns)
+	{
+		Column.AddZeroed(Added);
+	}
+}
+
+void FInventorySearchIndex::SetSlotFacets(int32 SlotIndex, int32 TypeIndex, bool bValue)
+{
+	const FTypeEntry& Entry = Types[TypeIndex];
+
+	OccupiedBits[SlotIndex] = bValue;
+	CategoryBits[Entry.Category][SlotIndex] = bValue;
+	RarityBits[Entry.Rarity][SlotIndex] = bValue;
+	TradeableBits[SlotIndex] = bValue && Entry.bTradeable;
+	SellableBits[SlotIndex] = bValue && Entry.bSellable;
+
+	Columns[static_cast<int32>(EInventoryQueryColumn::Weight)][SlotIndex] = bValue ? Entry.UnitWeight : 0.0f;
+	Columns[static_cast<int32>(EInventoryQueryColumn::Value)][SlotIndex] = bValue ? Entry.UnitValue : 0.0f;
+}
+
+uint64 FInventorySearchIndex::MakeTrigram(const TCHAR* Chars)
+{
+	return static_cast<uint64>(static_cast<uint32>(Chars[0]))
+		| (static_cast<uint64>(static_cast<uint32>(Chars[1])) << 21)
+		| (static_cast<uint64>(static_cast<uint32>(Chars[2])) << 42);
+}
@@ -0,0 +1,173 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "InventoryItemData.h"
+
+/** Equality facets indexed as per-slot bitsets */
+enum class EInventoryFacet : uint8
+{
+	Category,
+	Rarity,
+	Tradeable,
+	Sellable
+};
+
+/** Numeric per-slot columns for range predicates */
+enum class EInventoryQueryColumn : uint8
+{
+	/** Unit weight */
+	Weight,
+	/** Unit base value */
+	Value,
+	/** Stack quantity */
+	Quantity,
+
+	MAX
+};
+
+/**
+ * Result of a search, owned by whoever issued it (e.g. an inventory window)
+ * Kept between queries so a query that extends the previous one only re-checks
+ * the previous matches.
+ */
+struct OUTERCORP_API FInventorySearchResult
+{
+	/** Case-folded query the result was computed for */
+	FString FoldedQuery;
+
+	/** One bit per item type in the index, set when the type matches */
+	TBitArray<> MatchingTypes;
+
+	/** Index type revision the result was computed against */
+	uint32 Revision = 0;
+
+	/** Result has been computed at least once */
+	bool bValid = false;
+
+	/** Does an item type match. An empty (or never run) query matches everything; other types added after the search do not match until it is re-run */
+	bool IsTypeMatching(int32 TypeIndex) const
+	{
+		return FoldedQuery.IsEmpty() || (MatchingTypes.IsValidIndex(TypeIndex) && MatchingTypes[TypeIndex]);
+	}
+};
+
+/**
+ * Search index over the slots of one inventory
+ * Names are stored case-folded once per item type, with trigram postings for
+ * candidate lookup; slots map to their item type, so a name query costs O(types)
+ * rather than O(slots). Equality facets are kept as one bitset per value over the
+ * slots, and numeric fields as packed float columns, for FInventoryQueryPlan.
+ * Maintained incrementally as slots change.
+ */
+class OUTERCORP_API FInventorySearchIndex
+{
+public:
+	/** Index every slot */
+	void Build(const TArray<FInventoryItem>& Items);
+
+	/** Drop everything, IsBuilt() returns false afterwards */
+	void Reset();
+
+	/** Reset and free the memory too */
+	void Release();
+
+	bool IsBuilt() const { return bBuilt; }
+
+	/** Heap memory held by the index */
+	SIZE_T GetAllocatedSize() const;
+
+	/** Slot contents changed */
+	void UpdateSlot(int32 SlotIndex, const FInventoryItem& Item);
+
+	/** Run a query, updating InOutResult. Item types whose match state flipped are added to OutChangedTypes */
+	void Search(const FString& Query, FInventorySearchResult& InOutResult, TArray<int32>* OutChangedTypes = nullptr) const;
+
+	/** Item type shown in a slot (INDEX_NONE if empty) */
+	int32 GetSlotType(int32 SlotIndex) const
+	{
+		return SlotTypes.IsValidIndex(SlotIndex) ? SlotTypes[SlotIndex] : INDEX_NONE;
+	}
+
+	/** Slots currently holding an item type, in no particular order */
+	TConstArrayView<int32> GetSlotsOfType(int32 TypeIndex) const
+	{
+		return Types.IsValidIndex(TypeIndex) ? TConstArrayView<int32>(Types[TypeIndex].Slots) : TConstArrayView<int32>();
+	}
+
+	/** Bumped whenever an item type is added */
+	uint32 GetRevision() const { return Revision; }
+
+	/** Number of slots covered by the bitsets and columns */
+	int32 GetNumSlots() const { return SlotTypes.Num(); }
+
+	/** Slots holding an item */
+	const TBitArray<>& GetOccupiedBits() const { return OccupiedBits; }
+
+	/** Slots whose item has the given facet value (Value is ignored for flag facets) */
+	const TBitArray<>& GetFacetBits(EInventoryFacet Facet, int32 Value = 0) const;
+
+	/** Packed per-slot values for range predicates (zero for empty slots) */
+	TConstArrayView<float> GetColumn(EInventoryQueryColumn Column) const
+	{
+		return Columns[static_cast<int32>(Column)];
+	}
+
+	static constexpr int32 NumCategories = static_cast<int32>(EItemCategory::Misc) + 1;
+	static constexpr int32 NumRarities = static_cast<int32>(EItemRarity::Legendary) + 1;
+
+	/** Lower-case a string for matching */
+	static FString FoldName(const FString& Name);
+
+private:
+	struct FTypeEntry
+	{
+		TObjectKey<UInventoryItemData> ItemData;
+		FString FoldedName;
+		TArray<int32> Slots;
+
+		/** Facet values copied from the item data */
+		int32 Category = 0;
+		int32 Rarity = 0;
+		bool bTradeable = false;
+		bool bSellable = false;
+		float UnitWeight = 0.0f;
+		float UnitValue = 0.0f;
+	};
+
+	int32 FindOrAddType(const UInventoryItemData* ItemData);
+	void RemoveSlotFromType(int32 SlotIndex);
+
+	/** Grow every per-slot array to cover NumSlots */
+	void EnsureSlotCapacity(int32 NumSlots);
+
+	/** Set or clear a slot's facet bits and type-derived columns */
+	void SetSlotFacets(int32 SlotIndex, int32 TypeIndex, bool bValue);
+
+	static uint64 MakeTrigram(const TCHAR* Chars);
+
+	TArray<FTypeEntry> Types;
+	TMap<TObjectKey<UInventoryItemData>, int32> TypeLookup;
+
+	/** Trigram to item types whose name contains it */
+	TMap<uint64, TArray<int32>> TrigramPostings;
+
+	/** Per slot: item type and position in that type's Slots list */
+	TArray<int32> SlotTypes;
+	TArray<int32> SlotPositions;
+
+	/** Facet bitsets over the slots */
+	TBitArray<> OccupiedBits;
+	TBitArray<> CategoryBits[NumCategories];
+	TBitArray<> RarityBits[NumRarities];
+	TBitArray<> TradeableBits;
+	TBitArray<> SellableBits;
+
+	/** Packed numeric columns over the slots */
+	TArray<float> Columns[static_cast<int32>(EInventoryQueryColumn::MAX)];
+
+	uint32 Revision = 0;
+	bool bBuilt = false;
+};
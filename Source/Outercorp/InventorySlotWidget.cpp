@@ -2,14 +2,250 @@
 
 #include "InventorySlotWidget.h"
 #include "InventoryComponent.h"
+#include "InventoryIconSubsystem.h"
+#include "InventoryPredictionComponent.h"
+#include "InventoryViewSubsystem.h"
+#include "InventoryWidget.h"
 #include "Components/Image.h"
 #include "Components/TextBlock.h"
 #include "Components/Border.h"
 #include "Components/Button.h"
 #include "Blueprint/WidgetBlueprintLibrary.h"
+#include "Engine/GameInstance.h"
 #include "Engine/Texture2D.h"
+#include "Engine/World.h"
 #include "Input/Reply.h"
 
+void UInventoryDragDropOperation::BuildDropTargets(const TArray<UInventoryComponent*>& TargetInventories)
+{
+	EndDrag();
+
+	TArray<UInventoryComponent*> Inventories;
+	Inventories.Add(InventoryComponent);
+	for (UInventoryComponent* Inventory : TargetInventories)
+	{
+		Inventories.AddUnique(Inventory);
+	}
+
+	for (UInventoryComponent* Inventory : Inventories)
+	{
+		if (!Inventory)
+		{
+			continue;
+		}
+
+		FDropTarget& Target = DropTargets.AddDefaulted_GetRef();
+		Target.Inventory = Inventory;
+		BuildTarget(Target);
+
+		Inventory->OnInventoryUpdated.AddDynamic(this, &UInventoryDragDropOperation::HandleInventoryUpdated);
+		Inventory->OnInventoryCapacityChanged.AddDynamic(this, &UInventoryDragDropOperation::HandleCapacityChanged);
+	}
+}
+
+EInventoryDropResult UInventoryDragDropOperation::GetDropResult(const UInventoryComponent* TargetInventory, int32 TargetSlot) const
+{
+	for (const FDropTarget& Target : DropTargets)
+	{
+		if (Target.Inventory.Get() == TargetInventory)
+		{
+			if (!Target.Results.IsValidIndex(TargetSlot))
+			{
+				return EInventoryDropResult::Invalid;
+			}
+
+			return Target.ValidBits[TargetSlot] && Target.bOverWeight ? EInventoryDropResult::RejectedWeight : Target.Results[TargetSlot];
+		}
+	}
+
+	return EInventoryDropResult::None;
+}
+
+bool UInventoryDragDropOperation::IsDropValid(const UInventoryComponent* TargetInventory, int32 TargetSlot) const
+{
+	for (const FDropTarget& Target : DropTargets)
+	{
+		if (Target.Inventory.Get() == TargetInventory)
+		{
+			return Target.ValidBits.IsValidIndex(TargetSlot) && Target.ValidBits[TargetSlot] && !Target.bOverWeight;
+		}
+	}
+
+	return false;
+}
+
+int32 UInventoryDragDropOperation::GetDropQuantity() const
+{
+	return bIsSplitOperation ? DraggedItem.Quantity / 2 : DraggedItem.Quantity;
+}
+
+void UInventoryDragDropOperation::Drop_Implementation(const FPointerEvent& PointerEvent)
+{
+	EndDrag();
+	Super::Drop_Implementation(PointerEvent);
+}
+
+void UInventoryDragDropOperation::DragCancelled_Implementation(const FPointerEvent& PointerEvent)
+{
+	EndDrag();
+	Super::DragCancelled_Implementation(PointerEvent);
+}
+
+void UInventoryDragDropOperation::HandleInventoryUpdated(int32 SlotIndex, const FInventoryItem& Item)
+{
+	// The dragged stack itself changed (used, split off, moved by something else): everything depends on it
+	if (InventoryComponent && InventoryComponent->GetItems().IsValidIndex(SourceSlotIndex))
+	{
+		const FInventoryItem& Source = InventoryComponent->GetItems()[SourceSlotIndex];
+		if (Source.ItemData != DraggedItem.ItemData || Source.Quantity != DraggedItem.Quantity || Source.InstanceID != DraggedItem.InstanceID)
+		{
+			DraggedItem = Source;
+			for (FDropTarget& Target : DropTargets)
+			{
+				BuildTarget(Target);
+				OnDropTargetsChanged.Broadcast(Target.Inventory.Get(), INDEX_NONE);
+			}
+			return;
+		}
+	}
+
+	// The event doesn't say which inventory sent it, re-check the slot in each (one lookup per target)
+	for (FDropTarget& Target : DropTargets)
+	{
+		const UInventoryComponent* Inventory = Target.Inventory.Get();
+		if (!Inventory || !Target.Results.IsValidIndex(SlotIndex) || !Inventory->GetItems().IsValidIndex(SlotIndex))
+		{
+			continue;
+		}
+
+		const float SlotWeight = Inventory->GetItems()[SlotIndex].GetTotalWeight();
+		Target.CurrentWeight += SlotWeight - Target.SlotWeights[SlotIndex];
+		Target.SlotWeights[SlotIndex] = SlotWeight;
+
+		if (UpdateOverWeight(Target))
+		{
+			OnDropTargetsChanged.Broadcast(Inventory, INDEX_NONE);
+		}
+
+		const EInventoryDropResult Result = EvaluateSlot(Inventory, SlotIndex);
+		if (Result != Target.Results[SlotIndex])
+		{
+			Target.Results[SlotIndex] = Result;
+			Target.ValidBits[SlotIndex] = IsValidDropResult(Result);
+			OnDropTargetsChanged.Broadcast(Inventory, SlotIndex);
+		}
+	}
+}
+
+void UInventoryDragDropOperation::HandleCapacityChanged(int32 NewCapacity)
+{
+	for (FDropTarget& Target : DropTargets)
+	{
+		const UInventoryComponent* Inventory = Target.Inventory.Get();
+		if (Inventory && Inventory->GetItems().Num() != Target.Results.Num())
+		{
+			BuildTarget(Target);
+			OnDropTargetsChanged.Broadcast(Inventory, INDEX_NONE);
+		}
+	}
+}
+
+void UInventoryDragDropOperation::BuildTarget(FDropTarget& Target)
+{
+	const UInventoryComponent* Inventory = Target.Inventory.Get();
+	const int32 NumSlots = Inventory ? Inventory->GetItems().Num() : 0;
+
+	Target.ValidBits.Init(false, NumSlots);
+	Target.Results.SetNumUninitialized(NumSlots);
+	Target.SlotWeights.SetNumUninitialized(NumSlots);
+	Target.CurrentWeight = 0.0f;
+
+	for (int32 i = 0; i < NumSlots; ++i)
+	{
+		const EInventoryDropResult Result = EvaluateSlot(Inventory, i);
+		Target.Results[i] = Result;
+		Target.ValidBits[i] = IsValidDropResult(Result);
+
+		Target.SlotWeights[i] = Inventory->GetItems()[i].GetTotalWeight();
+		Target.CurrentWeight += Target.SlotWeights[i];
+	}
+
+	Target.bOverWeight = false;
+	UpdateOverWeight(Target);
+}
+
+EInventoryDropResult UInventoryDragDropOperation::EvaluateSlot(const UInventoryComponent* TargetInventory, int32 TargetSlot) const
+{
+	// Mirrors what NativeOnDrop ends up calling: SplitStack, MoveItem or TransferItem
+	const bool bSameInventory = TargetInventory == InventoryComponent;
+	if (!DraggedItem.IsValid() || (bSameInventory && TargetSlot == SourceSlotIndex) || !TargetInventory->CanPlaceItemInSlot(DraggedItem.ItemData, TargetSlot))
+	{
+		return EInventoryDropResult::Invalid;
+	}
+
+	const FInventoryItem& TargetItem = TargetInventory->GetItems()[TargetSlot];
+	if (!TargetItem.IsValid())
+	{
+		return bIsSplitOperation ? EInventoryDropResult::Split : EInventoryDropResult::Move;
+	}
+
+	// Splits need an empty slot
+	if (bIsSplitOperation)
+	{
+		return EInventoryDropResult::Invalid;
+	}
+
+	if (TargetInventory->CanStack(DraggedItem, TargetItem))
+	{
+		return TargetItem.Quantity < TargetInventory->GetMaxStackSize(TargetItem.ItemData) ? EInventoryDropResult::Merge : EInventoryDropResult::Invalid;
+	}
+
+	// TransferItem doesn't swap across inventories
+	if (bSameInventory && TargetInventory->CanPlaceItemInSlot(TargetItem.ItemData, SourceSlotIndex))
+	{
+		return EInventoryDropResult::Swap;
+	}
+
+	return EInventoryDropResult::Invalid;
+}
+
+bool UInventoryDragDropOperation::UpdateOverWeight(FDropTarget& Target) const
+{
+	const UInventoryComponent* Inventory = Target.Inventory.Get();
+
+	// Moves within an inventory don't change its weight
+	bool bOverWeight = false;
+	if (Inventory && Inventory != InventoryComponent && Inventory->MaxWeight > 0.0f && DraggedItem.IsValid())
+	{
+		const float IncomingWeight = DraggedItem.ItemData->Weight * GetDropQuantity();
+		bOverWeight = Target.CurrentWeight + IncomingWeight > Inventory->MaxWeight;
+	}
+
+	const bool bChanged = bOverWeight != Target.bOverWeight;
+	Target.bOverWeight = bOverWeight;
+	return bChanged;
+}
+
+void UInventoryDragDropOperation::EndDrag()
+{
+	for (const FDropTarget& Target : DropTargets)
+	{
+		if (UInventoryComponent* Inventory = Target.Inventory.Get())
+		{
+			Inventory->OnInventoryUpdated.RemoveAll(this);
+			Inventory->OnInventoryCapacityChanged.RemoveAll(this);
+		}
+	}
+
+	const bool bWasTracking = DropTargets.Num() > 0;
+	DropTargets.Empty();
+
+	if (bWasTracking)
+	{
+		OnDragEnded.Broadcast();
+	}
+}
+
 void UInventorySlotWidget::NativeConstruct()
 {
 	Super::NativeConstruct();
@@ -20,10 +256,26 @@ void UInventorySlotWidget::NativeConstruct()
 		SlotButton->OnClicked.AddDynamic(this, &UInventorySlotWidget::OnSlotClicked);
 	}
 
+	// Re-take the icon reference dropped in NativeDestruct if we are added back
+	SetIconItemType(CurrentItem.IsValid() ? CurrentItem.ItemData.Get() : nullptr);
+
 	// Initialize appearance
 	UpdateAppearance();
 }
 
+void UInventorySlotWidget::NativeDestruct()
+{
+	SetIconItemType(nullptr);
+
+	if (UInventoryIconSubsystem* IconSubsystem = GetIconSubsystem())
+	{
+		IconSubsystem->OnIconsLoaded.Remove(IconsLoadedHandle);
+	}
+	IconsLoadedHandle.Reset();
+
+	Super::NativeDestruct();
+}
+
 FReply UInventorySlotWidget::NativeOnMouseButtonDown(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent)
 {
 	// Start drag detection
@@ -63,6 +315,22 @@ void UInventorySlotWidget::NativeOnDragDetected(const FGeometry& InGeometry, con
 		DragDropOp->Pivot = EDragPivot::MouseDown;
 	}
 
+	// Work out once where the item could go, every open window then only looks its slots up
+	UInventoryViewSubsystem* ViewSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UInventoryViewSubsystem>() : nullptr;
+	const TArray<UInventoryWidget*> OpenViews = ViewSubsystem ? ViewSubsystem->GetOpenViews() : TArray<UInventoryWidget*>();
+
+	TArray<UInventoryComponent*> TargetInventories;
+	for (UInventoryWidget* View : OpenViews)
+	{
+		TargetInventories.AddUnique(View->GetInventoryComponent());
+	}
+	DragDropOp->BuildDropTargets(TargetInventories);
+
+	for (UInventoryWidget* View : OpenViews)
+	{
+		View->ShowDropHints(DragDropOp);
+	}
+
 	OutOperation = DragDropOp;
 }
 
@@ -82,25 +350,52 @@ bool UInventorySlotWidget::NativeOnDrop(const FGeometry& InGeometry, const FDrag
 		BackgroundBorder->SetBrushColor(NormalColor);
 	}
 
+	UInventoryComponent* SourceInventory = DragDropOp->InventoryComponent;
+	const EInventoryDropResult Result = DragDropOp->GetDropResult(InventoryComponent, SlotIndex);
+
+	// Rejections were worked out when the drag started; untracked targets are left to the inventory to validate
+	if (!SourceInventory || (Result != EInventoryDropResult::None && !DragDropOp->IsDropValid(InventoryComponent, SlotIndex)))
+	{
+		return false;
+	}
+
 	// Don't drop on same slot
-	if (DragDropOp->SourceSlotIndex == SlotIndex)
+	if (SourceInventory == InventoryComponent && DragDropOp->SourceSlotIndex == SlotIndex)
 	{
 		return false;
 	}
 
+	// Applied at once and reconciled with the server's answer on clients
+	if (UInventoryPredictionComponent* Prediction = UInventoryPredictionComponent::Get(GetOwningPlayer()))
+	{
+		const int32 Quantity = DragDropOp->bIsSplitOperation ? DragDropOp->GetDropQuantity() : -1;
+		if (!DragDropOp->bIsSplitOperation || Quantity > 0)
+		{
+			Prediction->RequestTransfer(SourceInventory, DragDropOp->SourceSlotIndex, InventoryComponent, SlotIndex, Quantity, DragDropOp->bIsSplitOperation);
+		}
+		return true;
+	}
+
 	// Handle split operation
 	if (DragDropOp->bIsSplitOperation)
 	{
-		int32 SplitAmount = DragDropOp->DraggedItem.Quantity / 2;
+		const int32 SplitAmount = DragDropOp->GetDropQuantity();
 		if (SplitAmount > 0)
 		{
-			InventoryComponent->SplitStack(DragDropOp->SourceSlotIndex, SlotIndex, SplitAmount);
+			if (SourceInventory == InventoryComponent)
+			{
+				InventoryComponent->SplitStack(DragDropOp->SourceSlotIndex, SlotIndex, SplitAmount);
+			}
+			else
+			{
+				SourceInventory->TransferItem(DragDropOp->SourceSlotIndex, InventoryComponent, SlotIndex, SplitAmount);
+			}
 		}
 		return true;
 	}
 
-	// Handle normal move/swap
-	InventoryComponent->MoveItem(DragDropOp->SourceSlotIndex, SlotIndex);
+	// Handle normal move/swap (TransferItem moves within an inventory when both are the same)
+	SourceInventory->TransferItem(DragDropOp->SourceSlotIndex, InventoryComponent, SlotIndex);
 
 	return true;
 }
@@ -109,10 +404,11 @@ void UInventorySlotWidget::NativeOnDragEnter(const FGeometry& InGeometry, const
 {
 	Super::NativeOnDragEnter(InGeometry, InDragDropEvent, InOperation);
 
-	// Highlight slot when dragging over
+	// Highlight slot when dragging over, unless the drop is known to be rejected
 	if (BackgroundBorder)
 	{
-		BackgroundBorder->SetBrushColor(HoverColor);
+		const bool bRejected = DropHint != EInventoryDropResult::None && !UInventoryDragDropOperation::IsValidDropResult(DropHint);
+		BackgroundBorder->SetBrushColor(bRejected ? InvalidDropColor : HoverColor);
 	}
 }
 
@@ -120,16 +416,26 @@ void UInventorySlotWidget::NativeOnDragLeave(const FDragDropEvent& InDragDropEve
 {
 	Super::NativeOnDragLeave(InDragDropEvent, InOperation);
 
-	// Reset background color
+	// Back to the drop hint
 	if (BackgroundBorder)
 	{
-		BackgroundBorder->SetBrushColor(NormalColor);
+		BackgroundBorder->SetBrushColor(GetBackgroundColor());
 	}
 }
 
 void UInventorySlotWidget::SetItem(const FInventoryItem& Item)
 {
 	CurrentItem = Item;
+	SetIconItemType(Item.IsValid() ? Item.ItemData.Get() : nullptr);
+
+	// Nothing visible changed (e.g. a neighbouring slot was updated in the same flush)
+	const UInventoryItemData* NewItemData = Item.IsValid() ? Item.ItemData.Get() : nullptr;
+	const int32 NewQuantity = Item.IsValid() ? Item.Quantity : 0;
+	if (bHasAppearance && DrawnItemData == NewItemData && DrawnQuantity == NewQuantity)
+	{
+		return;
+	}
+
 	UpdateAppearance();
 }
 
@@ -145,25 +451,14 @@ void UInventorySlotWidget::OnSlotClicked()
 
 void UInventorySlotWidget::UpdateAppearance()
 {
+	bHasAppearance = true;
+	DrawnItemData = CurrentItem.IsValid() ? CurrentItem.ItemData.Get() : nullptr;
+	DrawnQuantity = CurrentItem.IsValid() ? CurrentItem.Quantity : 0;
+
+	UpdateIcon();
+
 	if (CurrentItem.IsValid() && CurrentItem.ItemData)
 	{
-		// Set item icon
-		if (ItemIcon)
-		{
-			if (CurrentItem.ItemData->ItemIcon.IsNull())
-			{
-				ItemIcon->SetOpacity(0.3f);
-				ItemIcon->SetBrushFromTexture(nullptr);
-			}
-			else
-			{
-				ItemIcon->SetOpacity(1.0f);
-				// Load icon asynchronously
-				UTexture2D* IconTexture = CurrentItem.ItemData->ItemIcon.LoadSynchronous();
-				ItemIcon->SetBrushFromTexture(IconTexture);
-			}
-		}
-
 		// Set quantity text
 		if (QuantityText)
 		{
@@ -188,21 +483,6 @@ void UInventorySlotWidget::UpdateAppearance()
 	else
 	{
 		// Empty slot
-		if (ItemIcon)
-		{
-			if (EmptySlotIcon.IsNull())
-			{
-				ItemIcon->SetOpacity(0.1f);
-				ItemIcon->SetBrushFromTexture(nullptr);
-			}
-			else
-			{
-				ItemIcon->SetOpacity(0.3f);
-				UTexture2D* EmptyTexture = EmptySlotIcon.LoadSynchronous();
-				ItemIcon->SetBrushFromTexture(EmptyTexture);
-			}
-		}
-
 		if (QuantityText)
 		{
 			QuantityText->SetVisibility(ESlateVisibility::Hidden);
@@ -217,6 +497,130 @@ void UInventorySlotWidget::UpdateAppearance()
 	// Set background color
 	if (BackgroundBorder)
 	{
-		BackgroundBorder->SetBrushColor(NormalColor);
+		BackgroundBorder->SetBrushColor(GetBackgroundColor());
+	}
+}
+
+void UInventorySlotWidget::SetDropHint(EInventoryDropResult InDropHint)
+{
+	if (DropHint == InDropHint)
+	{
+		return;
+	}
+
+	DropHint = InDropHint;
+	if (BackgroundBorder)
+	{
+		BackgroundBorder->SetBrushColor(GetBackgroundColor());
+	}
+}
+
+FLinearColor UInventorySlotWidget::GetBackgroundColor() const
+{
+	if (DropHint == EInventoryDropResult::None)
+	{
+		return NormalColor;
+	}
+
+	return UInventoryDragDropOperation::IsValidDropResult(DropHint) ? ValidDropColor : InvalidDropColor;
+}
+
+void UInventorySlotWidget::UpdateIcon()
+{
+	if (!ItemIcon)
+	{
+		return;
+	}
+
+	UInventoryIconSubsystem* IconSubsystem = GetIconSubsystem();
+	const FSlateBrush* Brush = nullptr;
+	bool bWaiting = false;
+	float Opacity = 1.0f;
+
+	if (CurrentItem.IsValid() && CurrentItem.ItemData)
+	{
+		if (CurrentItem.ItemData->ItemIcon.IsNull())
+		{
+			Opacity = 0.3f;
+		}
+		else
+		{
+			Brush = IconSubsystem ? IconSubsystem->FindIcon(CurrentItem.ItemData) : nullptr;
+			bWaiting = Brush == nullptr;
+
+			// Dimmed placeholder until the icon streams in
+			Opacity = bWaiting ? 0.3f : 1.0f;
+		}
+	}
+	else if (EmptySlotIcon.IsNull())
+	{
+		Opacity = 0.1f;
+	}
+	else
+	{
+		Brush = IconSubsystem ? IconSubsystem->FindOrLoadTextureBrush(EmptySlotIcon) : nullptr;
+		bWaiting = Brush == nullptr;
+		Opacity = bWaiting ? 0.1f : 0.3f;
+	}
+
+	ItemIcon->SetOpacity(Opacity);
+	if (Brush)
+	{
+		ItemIcon->SetBrush(*Brush);
+	}
+	else
+	{
+		ItemIcon->SetBrushFromTexture(nullptr);
 	}
+
+	// Only slots showing a placeholder listen for loads
+	if (IconSubsystem)
+	{
+		if (bWaiting && !IconsLoadedHandle.IsValid())
+		{
+			IconsLoadedHandle = IconSubsystem->OnIconsLoaded.AddUObject(this, &UInventorySlotWidget::HandleIconsLoaded);
+		}
+		else if (!bWaiting && IconsLoadedHandle.IsValid())
+		{
+			IconSubsystem->OnIconsLoaded.Remove(IconsLoadedHandle);
+			IconsLoadedHandle.Reset();
+		}
+	}
+}
+
+void UInventorySlotWidget::SetIconItemType(const UInventoryItemData* ItemData)
+{
+	if (IconItemType.Get() == ItemData)
+	{
+		return;
+	}
+
+	UInventoryIconSubsystem* IconSubsystem = GetIconSubsystem();
+	if (!IconSubsystem)
+	{
+		return;
+	}
+
+	if (const UInventoryItemData* Previous = IconItemType.Get())
+	{
+		IconSubsystem->ReleaseIcon(Previous);
+	}
+
+	IconItemType = ItemData;
+
+	if (ItemData)
+	{
+		IconSubsystem->AcquireIcon(ItemData);
+	}
+}
+
+void UInventorySlotWidget::HandleIconsLoaded()
+{
+	UpdateIcon();
+}
+
+UInventoryIconSubsystem* UInventorySlotWidget::GetIconSubsystem() const
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<UInventoryIconSubsystem>() : nullptr;
 }
@@ -13,10 +13,35 @@ class UImage;
 class UTextBlock;
 class UBorder;
 class UButton;
+class UInventoryIconSubsystem;
+
+/**
+ * What dropping the dragged item onto a slot would do
+ */
+UENUM(BlueprintType)
+enum class EInventoryDropResult : uint8
+{
+	/** No drag in progress, or the slot's inventory is not a drop target */
+	None			UMETA(DisplayName = "None"),
+	/** Into an empty slot */
+	Move			UMETA(DisplayName = "Move"),
+	/** Onto a stack of the same item with room left */
+	Merge			UMETA(DisplayName = "Merge"),
+	/** Exchange with the item in the slot */
+	Swap			UMETA(DisplayName = "Swap"),
+	/** Half the stack into an empty slot */
+	Split			UMETA(DisplayName = "Split"),
+	/** Not allowed */
+	Invalid			UMETA(DisplayName = "Invalid"),
+	/** Allowed, but the target inventory cannot carry the weight */
+	RejectedWeight	UMETA(DisplayName = "Rejected (Weight)")
+};
 
 /**
  * Drag-drop operation for inventory items
  * Must be declared before UInventorySlotWidget
+ * The drop result for every slot of every target inventory is computed once when the drag
+ * starts, then kept current from the inventories' update events, so slots only do a lookup.
  */
 UCLASS()
 class OUTERCORP_API UInventoryDragDropOperation : public UDragDropOperation
@@ -43,18 +68,93 @@ public:
 	/** Is this a split operation (shift-drag) */
 	UPROPERTY(BlueprintReadWrite, Category = "Inventory")
 	bool bIsSplitOperation = false;
+
+	/** Compute drop results for the source inventory and TargetInventories, and start tracking their changes */
+	void BuildDropTargets(const TArray<UInventoryComponent*>& TargetInventories);
+
+	/** What dropping onto a slot would do (None if the inventory is not a tracked target) */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	EInventoryDropResult GetDropResult(const UInventoryComponent* TargetInventory, int32 TargetSlot) const;
+
+	/** Would dropping onto a slot do anything */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	bool IsDropValid(const UInventoryComponent* TargetInventory, int32 TargetSlot) const;
+
+	/** Quantity a drop moves */
+	int32 GetDropQuantity() const;
+
+	/** Move, Merge, Swap or Split */
+	static bool IsValidDropResult(EInventoryDropResult Result)
+	{
+		return Result == EInventoryDropResult::Move || Result == EInventoryDropResult::Merge
+			|| Result == EInventoryDropResult::Swap || Result == EInventoryDropResult::Split;
+	}
+
+	/** Results changed for one slot of a target inventory (INDEX_NONE for all of its slots) */
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnDropTargetsChanged, const UInventoryComponent*, int32);
+	FOnDropTargetsChanged OnDropTargetsChanged;
+
+	/** Drag was dropped or cancelled */
+	FSimpleMulticastDelegate OnDragEnded;
+
+protected:
+	virtual void Drop_Implementation(const FPointerEvent& PointerEvent) override;
+	virtual void DragCancelled_Implementation(const FPointerEvent& PointerEvent) override;
+
+	/** A tracked inventory changed a slot */
+	UFUNCTION()
+	void HandleInventoryUpdated(int32 SlotIndex, const FInventoryItem& Item);
+
+	/** A tracked inventory changed size */
+	UFUNCTION()
+	void HandleCapacityChanged(int32 NewCapacity);
+
+private:
+	struct FDropTarget
+	{
+		TWeakObjectPtr<UInventoryComponent> Inventory;
+
+		/** Drop would do something (weight aside), one bit per slot */
+		TBitArray<> ValidBits;
+
+		/** What the drop would do, one byte per slot */
+		TArray<EInventoryDropResult> Results;
+
+		/** Weight per slot and in total, updated from slot events rather than re-summed */
+		TArray<float> SlotWeights;
+		float CurrentWeight = 0.0f;
+
+		/** The dragged quantity would exceed the inventory's weight limit */
+		bool bOverWeight = false;
+	};
+
+	/** Evaluate every slot of a target */
+	void BuildTarget(FDropTarget& Target);
+
+	/** Evaluate one slot, ignoring weight */
+	EInventoryDropResult EvaluateSlot(const UInventoryComponent* TargetInventory, int32 TargetSlot) const;
+
+	/** Recompute a target's weight verdict, true if it flipped */
+	bool UpdateOverWeight(FDropTarget& Target) const;
+
+	/** Stop listening to the inventories and tell the windows */
+	void EndDrag();
+
+	TArray<FDropTarget> DropTargets;
 };
 
 /**
  * Widget representing a single inventory slot
+ * Does not tick, all updates come through SetItem and the icon cache.
  */
-UCLASS()
+UCLASS(meta = (DisableNativeTick))
 class OUTERCORP_API UInventorySlotWidget : public UUserWidget
 {
 	GENERATED_BODY()
 
 protected:
 	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
 	virtual FReply NativeOnMouseButtonDown(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
 	virtual void NativeOnDragDetected(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent, UDragDropOperation*& OutOperation) override;
 	virtual bool NativeOnDrop(const FGeometry& InGeometry, const FDragDropEvent& InDragDropEvent, UDragDropOperation* InOperation) override;
@@ -105,6 +205,18 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
 	FLinearColor NormalColor = FLinearColor(0.05f, 0.05f, 0.05f, 0.9f);
 
+	/** Background while a drag could be dropped here */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
+	FLinearColor ValidDropColor = FLinearColor(0.05f, 0.2f, 0.05f, 0.9f);
+
+	/** Background while a drag could not be dropped here */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
+	FLinearColor InvalidDropColor = FLinearColor(0.25f, 0.04f, 0.04f, 0.9f);
+
+	/** Drop hint shown during a drag */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory")
+	EInventoryDropResult DropHint = EInventoryDropResult::None;
+
 public:
 	/** Set the item for this slot */
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
@@ -126,6 +238,10 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
 	int32 GetSlotIndex() const { return SlotIndex; }
 
+	/** Show what a drop onto this slot would do (None to clear) */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void SetDropHint(EInventoryDropResult InDropHint);
+
 protected:
 	/** Called when slot is clicked */
 	UFUNCTION()
@@ -133,4 +249,33 @@ protected:
 
 	/** Update visual appearance based on item */
 	void UpdateAppearance();
+
+	/** Background for the current drop hint */
+	FLinearColor GetBackgroundColor() const;
+
+	/** Apply the cached icon brush, or the placeholder while it streams in */
+	void UpdateIcon();
+
+	/** Hold a reference on the icon for the item type shown (null to release) */
+	void SetIconItemType(const UInventoryItemData* ItemData);
+
+	/** Icon batch finished loading */
+	void HandleIconsLoaded();
+
+	/** Shared icon cache */
+	UInventoryIconSubsystem* GetIconSubsystem() const;
+
+private:
+	/** Item type and quantity currently drawn (null and 0 when empty), SetItem skips Slate updates while they are unchanged */
+	TWeakObjectPtr<const UInventoryItemData> DrawnItemData;
+	int32 DrawnQuantity = 0;
+
+	/** UpdateAppearance has run at least once */
+	bool bHasAppearance = false;
+
+	/** Item type we hold an icon reference on */
+	TWeakObjectPtr<const UInventoryItemData> IconItemType;
+
+	/** Bound while a placeholder is shown */
+	FDelegateHandle IconsLoadedHandle;
 };
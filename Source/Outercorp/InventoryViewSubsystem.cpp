@@ -0,0 +1,124 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryViewSubsystem.h"
+#include "InventoryWidget.h"
+#include "Algo/StableSort.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory View Scheduler"), STAT_InventoryViewScheduler, STATGROUP_Inventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inventory Views Pending"), STAT_InventoryViewsPending, STATGROUP_Inventory);
+
+void UInventoryViewSubsystem::Deinitialize()
+{
+	Views.Empty();
+	PendingViews.Empty();
+
+	Super::Deinitialize();
+}
+
+void UInventoryViewSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryViewScheduler);
+
+	const double Deadline = FPlatformTime::Seconds() + FMath::Max(FrameBudgetMs, 0.0f) / 1000.0;
+
+	// Work on a local copy, flushing may request further refreshes
+	TArray<TWeakObjectPtr<UInventoryWidget>> Queue = MoveTemp(PendingViews);
+	PendingViews.Reset();
+
+	Queue.RemoveAll([](const TWeakObjectPtr<UInventoryWidget>& View)
+	{
+		return !View.IsValid();
+	});
+
+	Algo::StableSortBy(Queue, [](const TWeakObjectPtr<UInventoryWidget>& View)
+	{
+		return GetViewPriority(View.Get());
+	});
+
+	bool bFlushedAny = false;
+	for (const TWeakObjectPtr<UInventoryWidget>& WeakView : Queue)
+	{
+		UInventoryWidget* View = WeakView.Get();
+		if (!View->IsOpen())
+		{
+			// Keeps its dirty state, OpenInventory applies it
+			continue;
+		}
+
+		// The first window always makes progress, so a small budget can't starve everything
+		if (bFlushedAny && FPlatformTime::Seconds() >= Deadline)
+		{
+			PendingViews.AddUnique(WeakView);
+			continue;
+		}
+
+		bFlushedAny = true;
+		if (!View->FlushPendingRefresh(Deadline))
+		{
+			PendingViews.AddUnique(WeakView);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_InventoryViewsPending, PendingViews.Num());
+}
+
+ETickableTickType UInventoryViewSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UInventoryViewSubsystem::IsTickable() const
+{
+	return PendingViews.Num() > 0;
+}
+
+TStatId UInventoryViewSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UInventoryViewSubsystem, STATGROUP_Tickables);
+}
+
+void UInventoryViewSubsystem::RegisterView(UInventoryWidget* View)
+{
+	if (View)
+	{
+		Views.AddUnique(View);
+	}
+}
+
+void UInventoryViewSubsystem::UnregisterView(UInventoryWidget* View)
+{
+	Views.Remove(View);
+	PendingViews.Remove(View);
+}
+
+void UInventoryViewSubsystem::RequestRefresh(UInventoryWidget* View)
+{
+	if (View)
+	{
+		PendingViews.AddUnique(View);
+	}
+}
+
+TArray<UInventoryWidget*> UInventoryViewSubsystem::GetOpenViews() const
+{
+	TArray<UInventoryWidget*> OpenViews;
+	for (const TWeakObjectPtr<UInventoryWidget>& View : Views)
+	{
+		if (View.IsValid() && View->IsOpen())
+		{
+			OpenViews.Add(View.Get());
+		}
+	}
+	return OpenViews;
+}
+
+int32 UInventoryViewSubsystem::GetViewPriority(const UInventoryWidget* View)
+{
+	if (View->HasKeyboardFocus() || View->HasFocusedDescendants())
+	{
+		return 0;
+	}
+
+	return View->IsOpen() ? 1 : 2;
+}
@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryViewSubsystem.generated.h"
+
+class UInventoryWidget;
+
+/**
+ * Refresh scheduler shared by every inventory window in the world
+ * Windows record slot changes and ask for a refresh; once per frame the pending
+ * windows are flushed in priority order (focused, then visible) until the frame
+ * budget runs out, and whatever is left carries over to the next frame. Hidden
+ * windows are dropped from the queue and catch up when opened. Nothing ticks
+ * while no window has pending work.
+ */
+UCLASS(Config = Game)
+class OUTERCORP_API UInventoryViewSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	/** Time inventory window refreshes may use per frame, in milliseconds. At least one window is always refreshed */
+	UPROPERTY(Config, BlueprintReadWrite, Category = "Inventory")
+	float FrameBudgetMs = 1.0f;
+
+	/** Track a window (called when it is constructed) */
+	void RegisterView(UInventoryWidget* View);
+
+	/** Stop tracking a window and drop its pending refresh */
+	void UnregisterView(UInventoryWidget* View);
+
+	/** Queue a window's pending changes for the next tick */
+	void RequestRefresh(UInventoryWidget* View);
+
+	/** Windows currently open */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	TArray<UInventoryWidget*> GetOpenViews() const;
+
+private:
+	/** Flush order: lower runs first */
+	static int32 GetViewPriority(const UInventoryWidget* View);
+
+	/** Every constructed window */
+	TArray<TWeakObjectPtr<UInventoryWidget>> Views;
+
+	/** Windows with a refresh requested, in request order */
+	TArray<TWeakObjectPtr<UInventoryWidget>> PendingViews;
+};
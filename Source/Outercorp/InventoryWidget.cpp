@@ -2,20 +2,33 @@
 
 #include "InventoryWidget.h"
 #include "InventorySlotWidget.h"
+#include "InventoryIconSubsystem.h"
+#include "InventoryViewSubsystem.h"
 #include "Components/UniformGridPanel.h"
 #include "Components/TextBlock.h"
 #include "Components/ProgressBar.h"
 #include "Components/Button.h"
 #include "Components/EditableText.h"
+#include "Components/ScrollBox.h"
+#include "Components/CanvasPanel.h"
+#include "Components/CanvasPanelSlot.h"
+#include "Components/Spacer.h"
+#include "Components/InvalidationBox.h"
+#include "Blueprint/WidgetTree.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
 #include "Input/Reply.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory Window Open"), STAT_InventoryWindowOpen, STATGROUP_Inventory);
+DECLARE_CYCLE_STAT(TEXT("Inventory Window Flush"), STAT_InventoryWindowFlush, STATGROUP_Inventory);
+DECLARE_CYCLE_STAT(TEXT("Inventory Search"), STAT_InventorySearch, STATGROUP_Inventory);
 
 void UInventoryWidget::NativeConstruct()
 {
 	Super::NativeConstruct();
 
-	// Enable keyboard focus for this widget
-	SetKeyboardFocus();
-
 	// Bind button events
 	if (CloseButton)
 	{
@@ -36,43 +49,113 @@ void UInventoryWidget::NativeConstruct()
 	{
 		SearchText->OnTextChanged.AddDynamic(this, &UInventoryWidget::OnSearchTextChanged);
 	}
-}
 
-void UInventoryWidget::NativeDestruct()
-{
-	// Delegates are automatically cleaned up when the widget is destroyed
-	// No need to manually unbind
+	if (VirtualScrollBox)
+	{
+		VirtualScrollBox->OnUserScrolled.AddDynamic(this, &UInventoryWidget::OnVirtualScrolled);
+	}
 
-	Super::NativeDestruct();
+	if (SlotsInvalidationBox)
+	{
+		SlotsInvalidationBox->SetCanCache(true);
+	}
+
+	if (UWorld* World = GetWorld())
+	{
+		if (UInventoryViewSubsystem* ViewSubsystem = World->GetSubsystem<UInventoryViewSubsystem>())
+		{
+			ViewSubsystem->RegisterView(this);
+		}
+	}
+
+	// Re-added after NativeDestruct dropped our bindings; the component and slot widgets were kept
+	if (InventoryComponent)
+	{
+		BindInventoryComponent();
+		if (IsOpen())
+		{
+			InventoryComponent->RequestContents(GetOwningPlayer());
+		}
+		RefreshInventory();
+	}
 }
 
-void UInventoryWidget::NativeTick(const FGeometry& MyGeometry, float InDeltaTime)
+void UInventoryWidget::NativeDestruct()
 {
-	Super::NativeTick(MyGeometry, InDeltaTime);
+	// The component outlives the window, leaving our bindings behind would keep firing into a dead widget
+	UnbindInventoryComponent();
+	HideDropHints();
 
-	// Only reclaim focus if we've been without it for a short time
-	// This prevents interfering with button clicks
-	if (!HasKeyboardFocus())
+	if (UWorld* World = GetWorld())
 	{
-		FocusReclaimTimer += InDeltaTime;
+		World->GetTimerManager().ClearTimer(FocusReclaimTimerHandle);
 
-		// Wait 0.1 seconds before reclaiming focus
-		// This gives buttons time to process their clicks
-		if (FocusReclaimTimer > 0.1f)
+		if (UInventoryViewSubsystem* ViewSubsystem = World->GetSubsystem<UInventoryViewSubsystem>())
 		{
-			SetKeyboardFocus();
-			FocusReclaimTimer = 0.0f;
+			ViewSubsystem->UnregisterView(this);
 		}
 	}
-	else
+
+	if (CloseButton)
+	{
+		CloseButton->OnClicked.RemoveAll(this);
+	}
+
+	if (SortByNameButton)
+	{
+		SortByNameButton->OnClicked.RemoveAll(this);
+	}
+
+	if (SortByRarityButton)
 	{
-		FocusReclaimTimer = 0.0f;
+		SortByRarityButton->OnClicked.RemoveAll(this);
 	}
+
+	if (SearchText)
+	{
+		SearchText->OnTextChanged.RemoveAll(this);
+	}
+
+	if (VirtualScrollBox)
+	{
+		VirtualScrollBox->OnUserScrolled.RemoveAll(this);
+	}
+
+	Super::NativeDestruct();
 }
 
-FReply UInventoryWidget::NativeOnFocusReceived(const FGeometry& InGeometry, const FFocusEvent& InFocusEvent)
+void UInventoryWidget::NativeOnRemovedFromFocusPath(const FFocusEvent& InFocusEvent)
 {
-	return Super::NativeOnFocusReceived(InGeometry, InFocusEvent);
+	Super::NativeOnRemovedFromFocusPath(InFocusEvent);
+
+	// Focus left the window entirely (focus moving to our own buttons or search box keeps us on the path)
+	UWorld* World = GetWorld();
+	if (World && IsOpen())
+	{
+		World->GetTimerManager().SetTimer(FocusReclaimTimerHandle, this, &UInventoryWidget::ReclaimFocus, FMath::Max(FocusReclaimDelay, KINDA_SMALL_NUMBER), false);
+	}
+}
+
+void UInventoryWidget::ReclaimFocus()
+{
+	if (!IsOpen() || HasKeyboardFocus() || HasFocusedDescendants())
+	{
+		return;
+	}
+
+	// With several windows open, focus moving between them is intended
+	if (UInventoryViewSubsystem* ViewSubsystem = GetWorld()->GetSubsystem<UInventoryViewSubsystem>())
+	{
+		for (UInventoryWidget* View : ViewSubsystem->GetOpenViews())
+		{
+			if (View != this && (View->HasKeyboardFocus() || View->HasFocusedDescendants()))
+			{
+				return;
+			}
+		}
+	}
+
+	SetKeyboardFocus();
 }
 
 FReply UInventoryWidget::NativeOnKeyDown(const FGeometry& InGeometry, const FKeyEvent& InKeyEvent)
@@ -94,11 +177,26 @@ void UInventoryWidget::InitializeInventory(UInventoryComponent* InInventoryCompo
 		return;
 	}
 
+	// Already showing this component, the existing slot widgets are reused
+	if (InventoryComponent == InInventoryComponent && SlotWidgets.Num() > 0)
+	{
+		RefreshInventory();
+		return;
+	}
+
+	UnbindInventoryComponent();
+
 	InventoryComponent = InInventoryComponent;
+	SearchResult = FInventorySearchResult();
+	QueryMatches.Empty();
 
-	// Bind to inventory events
-	InventoryComponent->OnInventoryUpdated.AddDynamic(this, &UInventoryWidget::OnInventoryUpdated);
-	InventoryComponent->OnInventoryCapacityChanged.AddDynamic(this, &UInventoryWidget::OnCapacityChanged);
+	BindInventoryComponent();
+
+	// Rebound while open, the new inventory's contents are needed right away
+	if (IsOpen())
+	{
+		InventoryComponent->RequestContents(GetOwningPlayer());
+	}
 
 	// Create slot widgets
 	CreateSlotWidgets();
@@ -114,19 +212,75 @@ void UInventoryWidget::RefreshInventory()
 		return;
 	}
 
-	// Refresh all slots
-	for (int32 i = 0; i < SlotWidgets.Num(); ++i)
+	// Everything is refreshed below, pending per-slot work is redundant
+	ClearDirtySlots();
+	bCapacityDirty = false;
+	EvaluateQuery();
+
+	if (bVirtualized)
 	{
-		RefreshSlot(i);
+		// Filter may have changed, rebuild the display list and rebind visible widgets
+		RebuildDisplayedSlots();
+		UpdateVirtualRows(true);
+	}
+	else
+	{
+		// Refresh all slots
+		for (int32 i = 0; i < SlotWidgets.Num(); ++i)
+		{
+			RefreshSlot(i);
+		}
 	}
 
 	// Update capacity display
 	UpdateCapacityDisplay();
 }
 
+UInventorySlotWidget* UInventoryWidget::GetSlotWidget(int32 SlotIndex) const
+{
+	if (bVirtualized)
+	{
+		const int32* PoolIndex = SlotToPoolIndex.Find(SlotIndex);
+		return PoolIndex ? SlotWidgets[*PoolIndex].Get() : nullptr;
+	}
+
+	return SlotWidgets.IsValidIndex(SlotIndex) ? SlotWidgets[SlotIndex].Get() : nullptr;
+}
+
 void UInventoryWidget::RefreshSlot(int32 SlotIndex)
 {
-	if (!InventoryComponent || !SlotWidgets.IsValidIndex(SlotIndex))
+	if (!InventoryComponent)
+	{
+		return;
+	}
+
+	RefreshQueryMatch(SlotIndex);
+
+	if (bVirtualized)
+	{
+		if (!DisplayPositions.IsValidIndex(SlotIndex))
+		{
+			return;
+		}
+
+		const FInventoryItem& Item = InventoryComponent->GetItemAtSlot(SlotIndex);
+		const bool bShouldShow = !Item.IsValid() || PassesFilter(SlotIndex);
+		const bool bIsShown = DisplayPositions[SlotIndex] != INDEX_NONE;
+
+		if (bShouldShow != bIsShown)
+		{
+			// Slot entered or left the filter, positions after it shift
+			RebuildDisplayedSlots();
+			UpdateVirtualRows(true);
+		}
+		else if (UInventorySlotWidget* SlotWidget = GetSlotWidget(SlotIndex))
+		{
+			SlotWidget->SetItem(Item);
+		}
+		return;
+	}
+
+	if (!SlotWidgets.IsValidIndex(SlotIndex))
 	{
 		return;
 	}
@@ -136,10 +290,15 @@ void UInventoryWidget::RefreshSlot(int32 SlotIndex)
 	if (SlotWidgets[SlotIndex])
 	{
 		// Check if item passes filter
-		bool bShouldShow = !Item.IsValid() || PassesFilter(Item);
+		bool bShouldShow = !Item.IsValid() || PassesFilter(SlotIndex);
 
 		SlotWidgets[SlotIndex]->SetItem(Item);
-		SlotWidgets[SlotIndex]->SetVisibility(bShouldShow ? ESlateVisibility::Visible : ESlateVisibility::Collapsed);
+
+		const ESlateVisibility NewVisibility = bShouldShow ? ESlateVisibility::Visible : ESlateVisibility::Collapsed;
+		if (SlotWidgets[SlotIndex]->GetVisibility() != NewVisibility)
+		{
+			SlotWidgets[SlotIndex]->SetVisibility(NewVisibility);
+		}
 	}
 }
 
@@ -185,22 +344,79 @@ void UInventoryWidget::UpdateCapacityDisplay()
 	}
 }
 
+void UInventoryWidget::OpenInventory()
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryWindowOpen);
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (!IsInViewport())
+	{
+		AddToViewport(1);
+	}
+
+	// Hangars read their stored contents on first open, slots fill in as they arrive
+	if (InventoryComponent)
+	{
+		InventoryComponent->RequestContents(GetOwningPlayer());
+	}
+
+	// Apply what changed while hidden before the first frame is drawn
+	if (DirtySlots.Num() > 0 || bCapacityDirty)
+	{
+		FlushPendingRefresh();
+	}
+
+	// Icons for everything just bound go out as one request
+	FlushIconRequests();
+
+	SetVisibility(ESlateVisibility::Visible);
+	SetKeyboardFocus();
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(FocusReclaimTimerHandle);
+	}
+
+	UE_LOG(LogOutercorp, Verbose, TEXT("Inventory window visible in %.2f ms (%d slot widgets)"), (FPlatformTime::Seconds() - StartTime) * 1000.0, SlotWidgets.Num());
+}
+
 void UInventoryWidget::CloseInventory()
 {
+	// Remote containers stop replicating their contents to us
+	if (InventoryComponent && IsOpen())
+	{
+		InventoryComponent->ReleaseContents(GetOwningPlayer());
+	}
+
+	// Hide rather than remove, the window and its slot widgets are reused on the next open
+	SetVisibility(ESlateVisibility::Collapsed);
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(FocusReclaimTimerHandle);
+	}
 	OnInventoryClosed.Broadcast();
-	RemoveFromParent();
+}
+
+bool UInventoryWidget::IsOpen() const
+{
+	return IsInViewport() && IsVisible();
 }
 
 void UInventoryWidget::OnInventoryUpdated(int32 SlotIndex, const FInventoryItem& Item)
 {
-	RefreshSlot(SlotIndex);
-	UpdateCapacityDisplay();
+	MarkSlotDirty(SlotIndex);
+	bCapacityDirty = true;
+
+	// A hidden window only records what changed, OpenInventory applies it
+	if (IsOpen())
+	{
+		RequestRefresh();
+	}
 }
 
 void UInventoryWidget::OnCapacityChanged(int32 NewCapacity)
 {
-	// Recreate slot widgets if capacity changed
-	CreateSlotWidgets();
+	// Only place the slot widget pool changes size
+	ResizeSlotWidgets();
 	RefreshInventory();
 }
 
@@ -228,7 +444,13 @@ void UInventoryWidget::OnSortByRarityClicked()
 void UInventoryWidget::OnSearchTextChanged(const FText& Text)
 {
 	CurrentFilter = Text.ToString();
-	RefreshInventory();
+	ApplySearchFilter();
+}
+
+void UInventoryWidget::OnVirtualScrolled(float CurrentOffset)
+{
+	UpdateVirtualRows();
+	FlushIconRequests();
 }
 
 void UInventoryWidget::CreateSlotWidgets()
@@ -240,36 +462,631 @@ void UInventoryWidget::CreateSlotWidgets()
 
 	// Clear existing widgets
 	ItemGrid->ClearChildren();
+	if (VirtualCanvas)
+	{
+		VirtualCanvas->ClearChildren();
+	}
 	SlotWidgets.Empty();
+	SlotToPoolIndex.Reset();
+	FreePoolIndices.Reset();
+	VirtualExtentSpacer = nullptr;
+	FirstMaterializedRow = INDEX_NONE;
+	LastMaterializedRow = INDEX_NONE;
 
-	// Create new slot widgets
 	int32 NumSlots = InventoryComponent->MaxSlots;
 
+	// Large containers only materialize the visible rows
+	bVirtualized = VirtualScrollBox && VirtualCanvas && NumSlots > VirtualizationThreshold;
+
+	ItemGrid->SetVisibility(bVirtualized ? ESlateVisibility::Collapsed : ESlateVisibility::Visible);
+	if (VirtualScrollBox)
+	{
+		VirtualScrollBox->SetVisibility(bVirtualized ? ESlateVisibility::Visible : ESlateVisibility::Collapsed);
+	}
+
+	if (bVirtualized)
+	{
+		// Spacer at the bottom of the canvas so the scroll box sees the full content height
+		VirtualExtentSpacer = WidgetTree->ConstructWidget<USpacer>(USpacer::StaticClass());
+		if (UCanvasPanelSlot* SpacerSlot = VirtualCanvas->AddChildToCanvas(VirtualExtentSpacer))
+		{
+			SpacerSlot->SetSize(FVector2D(1.0f, 1.0f));
+		}
+
+		RebuildDisplayedSlots();
+		UpdateVirtualRows(true);
+		return;
+	}
+
+	// Create new slot widgets
 	for (int32 i = 0; i < NumSlots; ++i)
 	{
-		UInventorySlotWidget* SlotWidget = CreateWidget<UInventorySlotWidget>(this, SlotWidgetClass);
-		if (SlotWidget)
+		AddGridSlotWidget(i);
+	}
+}
+
+void UInventoryWidget::ResizeSlotWidgets()
+{
+	if (!InventoryComponent)
+	{
+		return;
+	}
+
+	const int32 NumSlots = InventoryComponent->MaxSlots;
+	const bool bWantVirtualized = VirtualScrollBox && VirtualCanvas && NumSlots > VirtualizationThreshold;
+
+	// Switching between grid and virtualized mode needs a full rebuild
+	if (SlotWidgets.Num() == 0 || bWantVirtualized != bVirtualized)
+	{
+		CreateSlotWidgets();
+		return;
+	}
+
+	if (bVirtualized)
+	{
+		// The pool is sized by the visible rows, not by capacity
+		RebuildDisplayedSlots();
+		UpdateVirtualRows(true);
+		return;
+	}
+
+	while (SlotWidgets.Num() > NumSlots)
+	{
+		if (UInventorySlotWidget* SlotWidget = SlotWidgets.Pop())
+		{
+			SlotWidget->RemoveFromParent();
+		}
+	}
+
+	for (int32 i = SlotWidgets.Num(); i < NumSlots; ++i)
+	{
+		AddGridSlotWidget(i);
+	}
+}
+
+void UInventoryWidget::AddGridSlotWidget(int32 SlotIndex)
+{
+	UInventorySlotWidget* SlotWidget = CreateWidget<UInventorySlotWidget>(this, SlotWidgetClass);
+	if (SlotWidget)
+	{
+		SlotWidget->SetSlotIndex(SlotIndex);
+		SlotWidget->SetInventoryComponent(InventoryComponent);
+
+		int32 Row = SlotIndex / GridColumns;
+		int32 Column = SlotIndex % GridColumns;
+
+		ItemGrid->AddChildToUniformGrid(SlotWidget, Row, Column);
+	}
+
+	// Keep indices aligned with slots even if creation failed
+	SlotWidgets.Add(SlotWidget);
+}
+
+void UInventoryWidget::BindInventoryComponent()
+{
+	if (InventoryComponent)
+	{
+		InventoryComponent->OnInventoryUpdated.AddUniqueDynamic(this, &UInventoryWidget::OnInventoryUpdated);
+		InventoryComponent->OnInventoryCapacityChanged.AddUniqueDynamic(this, &UInventoryWidget::OnCapacityChanged);
+	}
+}
+
+void UInventoryWidget::UnbindInventoryComponent()
+{
+	if (InventoryComponent)
+	{
+		if (IsOpen())
+		{
+			InventoryComponent->ReleaseContents(GetOwningPlayer());
+		}
+
+		InventoryComponent->OnInventoryUpdated.RemoveDynamic(this, &UInventoryWidget::OnInventoryUpdated);
+		InventoryComponent->OnInventoryCapacityChanged.RemoveDynamic(this, &UInventoryWidget::OnCapacityChanged);
+	}
+}
+
+void UInventoryWidget::RebuildDisplayedSlots()
+{
+	if (!InventoryComponent)
+	{
+		return;
+	}
+
+	const TArray<FInventoryItem>& Items = InventoryComponent->GetItems();
+	const int32 NumSlots = InventoryComponent->MaxSlots;
+
+	DisplayedSlots.Reset(NumSlots);
+	DisplayPositions.SetNumUninitialized(NumSlots);
+
+	for (int32 i = 0; i < NumSlots; ++i)
+	{
+		const bool bShow = !Items.IsValidIndex(i) || !Items[i].IsValid() || PassesFilter(i);
+		DisplayPositions[i] = bShow ? DisplayedSlots.Add(i) : INDEX_NONE;
+	}
+
+	// Resize the scrollable area
+	const int32 NumRows = FMath::DivideAndRoundUp(DisplayedSlots.Num(), FMath::Max(1, GridColumns));
+	if (VirtualExtentSpacer)
+	{
+		if (UCanvasPanelSlot* SpacerSlot = Cast<UCanvasPanelSlot>(VirtualExtentSpacer->Slot))
+		{
+			SpacerSlot->SetPosition(FVector2D(0.0f, FMath::Max(0.0f, NumRows * VirtualSlotSize.Y - 1.0f)));
+		}
+	}
+}
+
+void UInventoryWidget::UpdateVirtualRows(bool bForce)
+{
+	if (!bVirtualized || !InventoryComponent || !VirtualScrollBox)
+	{
+		return;
+	}
+
+	const int32 Columns = FMath::Max(1, GridColumns);
+	const float RowHeight = FMath::Max(1.0f, VirtualSlotSize.Y);
+	const int32 NumRows = FMath::DivideAndRoundUp(DisplayedSlots.Num(), Columns);
+
+	// Before the first layout pass there is no geometry, assume a default window height
+	float ViewHeight = VirtualScrollBox->GetCachedGeometry().GetLocalSize().Y;
+	if (ViewHeight <= 0.0f)
+	{
+		ViewHeight = DefaultVisibleRows * RowHeight;
+	}
+
+	const float ScrollOffset = VirtualScrollBox->GetScrollOffset();
+	const int32 FirstRow = FMath::Max(0, FMath::FloorToInt(ScrollOffset / RowHeight) - OverscanRows);
+	const int32 LastRow = FMath::Min(NumRows - 1, FMath::FloorToInt((ScrollOffset + ViewHeight) / RowHeight) + OverscanRows);
+
+	if (!bForce && FirstRow == FirstMaterializedRow && LastRow == LastMaterializedRow)
+	{
+		return;
+	}
+
+	FirstMaterializedRow = FirstRow;
+	LastMaterializedRow = LastRow;
+
+	const int32 FirstPosition = FirstRow * Columns;
+	const int32 EndPosition = FMath::Min((LastRow + 1) * Columns, DisplayedSlots.Num());
+
+	// Release widgets whose slot scrolled out of range, keep the rest bound
+	for (auto It = SlotToPoolIndex.CreateIterator(); It; ++It)
+	{
+		const int32 Position = DisplayPositions.IsValidIndex(It.Key()) ? DisplayPositions[It.Key()] : INDEX_NONE;
+		if (Position < FirstPosition || Position >= EndPosition)
+		{
+			FreePoolIndices.Add(It.Value());
+			It.RemoveCurrent();
+		}
+	}
+
+	// Bind widgets for newly visible slots
+	for (int32 Position = FirstPosition; Position < EndPosition; ++Position)
+	{
+		const int32 SlotIndex = DisplayedSlots[Position];
+		const int32* BoundPoolIndex = SlotToPoolIndex.Find(SlotIndex);
+		if (BoundPoolIndex && !bForce)
+		{
+			continue;
+		}
+
+		// Forced updates rebind in place, the slot may have moved after a filter change
+		const int32 PoolIndex = BoundPoolIndex ? *BoundPoolIndex : AcquirePooledWidget();
+		if (PoolIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		UInventorySlotWidget* SlotWidget = SlotWidgets[PoolIndex];
+		SlotWidget->SetSlotIndex(SlotIndex);
+		SlotWidget->SetItem(InventoryComponent->GetItemAtSlot(SlotIndex));
+		SlotWidget->SetVisibility(ESlateVisibility::Visible);
+		ApplyDropHint(SlotWidget);
+
+		if (UCanvasPanelSlot* CanvasSlot = Cast<UCanvasPanelSlot>(SlotWidget->Slot))
+		{
+			const int32 Row = Position / Columns;
+			const int32 Column = Position % Columns;
+			CanvasSlot->SetPosition(FVector2D(Column * VirtualSlotSize.X, Row * RowHeight));
+		}
+
+		if (!BoundPoolIndex)
+		{
+			SlotToPoolIndex.Add(SlotIndex, PoolIndex);
+		}
+	}
+
+	// Hide whatever is left in the pool
+	for (int32 PoolIndex : FreePoolIndices)
+	{
+		SlotWidgets[PoolIndex]->SetVisibility(ESlateVisibility::Collapsed);
+	}
+}
+
+int32 UInventoryWidget::AcquirePooledWidget()
+{
+	if (FreePoolIndices.Num() > 0)
+	{
+		return FreePoolIndices.Pop(EAllowShrinking::No);
+	}
+
+	UInventorySlotWidget* SlotWidget = CreateWidget<UInventorySlotWidget>(this, SlotWidgetClass);
+	if (!SlotWidget)
+	{
+		return INDEX_NONE;
+	}
+
+	SlotWidget->SetInventoryComponent(InventoryComponent);
+
+	if (UCanvasPanelSlot* CanvasSlot = VirtualCanvas->AddChildToCanvas(SlotWidget))
+	{
+		CanvasSlot->SetSize(VirtualSlotSize);
+	}
+
+	return SlotWidgets.Add(SlotWidget);
+}
+
+void UInventoryWidget::MarkSlotDirty(int32 SlotIndex)
+{
+	if (SlotIndex < 0)
+	{
+		return;
+	}
+
+	if (SlotIndex >= DirtySlotBits.Num())
+	{
+		DirtySlotBits.Add(false, SlotIndex + 1 - DirtySlotBits.Num());
+	}
+
+	if (!DirtySlotBits[SlotIndex])
+	{
+		DirtySlotBits[SlotIndex] = true;
+		DirtySlots.Add(SlotIndex);
+	}
+}
+
+void UInventoryWidget::RequestRefresh()
+{
+	UWorld* World = GetWorld();
+	UInventoryViewSubsystem* ViewSubsystem = World ? World->GetSubsystem<UInventoryViewSubsystem>() : nullptr;
+	if (ViewSubsystem)
+	{
+		ViewSubsystem->RequestRefresh(this);
+	}
+	else
+	{
+		FlushPendingRefresh();
+	}
+}
+
+bool UInventoryWidget::FlushPendingRefresh(double Deadline)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventoryWindowFlush);
+
+	if (!InventoryComponent)
+	{
+		ClearDirtySlots();
+		bCapacityDirty = false;
+		return true;
+	}
+
+	if (bVirtualized)
+	{
+		// Only materialized rows have widgets to update, so this is bounded by the pool and done in one go
+		for (int32 SlotIndex : DirtySlots)
 		{
-			SlotWidget->SetSlotIndex(i);
-			SlotWidget->SetInventoryComponent(InventoryComponent);
+			RefreshQueryMatch(SlotIndex);
+		}
+
+		const TArray<FInventoryItem>& Items = InventoryComponent->GetItems();
+
+		// Rebuild the display list at most once, and only if a slot entered or left the filter
+		bool bDisplayListChanged = false;
+		for (int32 SlotIndex : DirtySlots)
+		{
+			if (Items.IsValidIndex(SlotIndex) && DisplayPositions.IsValidIndex(SlotIndex))
+			{
+				const bool bShouldShow = !Items[SlotIndex].IsValid() || PassesFilter(SlotIndex);
+				if (bShouldShow != (DisplayPositions[SlotIndex] != INDEX_NONE))
+				{
+					bDisplayListChanged = true;
+					break;
+				}
+			}
+		}
+
+		if (bDisplayListChanged)
+		{
+			RebuildDisplayedSlots();
+			UpdateVirtualRows(true);
+		}
+		else
+		{
+			for (int32 SlotIndex : DirtySlots)
+			{
+				UInventorySlotWidget* SlotWidget = GetSlotWidget(SlotIndex);
+				if (SlotWidget && Items.IsValidIndex(SlotIndex))
+				{
+					SlotWidget->SetItem(Items[SlotIndex]);
+				}
+			}
+		}
+
+		ClearDirtySlots();
+	}
+	else
+	{
+		// Every slot has a widget here, so apply them in batches and check the clock between batches
+		constexpr int32 BatchSize = 32;
 
-			int32 Row = i / GridColumns;
-			int32 Column = i % GridColumns;
+		int32 NumApplied = 0;
+		while (NumApplied < DirtySlots.Num())
+		{
+			const int32 BatchEnd = FMath::Min(NumApplied + BatchSize, DirtySlots.Num());
+			for (; NumApplied < BatchEnd; ++NumApplied)
+			{
+				const int32 SlotIndex = DirtySlots[NumApplied];
+				DirtySlotBits[SlotIndex] = false;
+				RefreshSlot(SlotIndex);
+			}
 
-			ItemGrid->AddChildToUniformGrid(SlotWidget, Row, Column);
-			SlotWidgets.Add(SlotWidget);
+			if (FPlatformTime::Seconds() >= Deadline)
+			{
+				break;
+			}
 		}
+
+		DirtySlots.RemoveAt(0, NumApplied, EAllowShrinking::No);
 	}
+
+	FlushIconRequests();
+
+	if (DirtySlots.Num() > 0)
+	{
+		return false;
+	}
+
+	// Weight and occupancy are summed once the window has caught up, not once per slot event
+	if (bCapacityDirty)
+	{
+		bCapacityDirty = false;
+		UpdateCapacityDisplay();
+	}
+
+	return true;
+}
+
+void UInventoryWidget::ClearDirtySlots()
+{
+	for (int32 SlotIndex : DirtySlots)
+	{
+		DirtySlotBits[SlotIndex] = false;
+	}
+	DirtySlots.Reset();
 }
 
-bool UInventoryWidget::PassesFilter(const FInventoryItem& Item) const
+void UInventoryWidget::FlushIconRequests()
 {
-	if (CurrentFilter.IsEmpty() || !Item.IsValid())
+	UGameInstance* GameInstance = GetGameInstance();
+	if (UInventoryIconSubsystem* IconSubsystem = GameInstance ? GameInstance->GetSubsystem<UInventoryIconSubsystem>() : nullptr)
+	{
+		IconSubsystem->FlushRequests();
+	}
+}
+
+bool UInventoryWidget::PassesFilter(int32 SlotIndex) const
+{
+	if (QueryPlan.IsEmpty())
 	{
 		return true;
 	}
 
-	// Check if item name contains filter text
-	FString ItemName = Item.ItemData->ItemName.ToString();
-	return ItemName.Contains(CurrentFilter, ESearchCase::IgnoreCase);
+	// Kept current per slot by RefreshQueryMatch, so this is a bit lookup
+	return QueryMatches.IsValidIndex(SlotIndex) && QueryMatches[SlotIndex];
+}
+
+void UInventoryWidget::ApplySearchFilter()
+{
+	SCOPE_CYCLE_COUNTER(STAT_InventorySearch);
+
+	if (!InventoryComponent)
+	{
+		return;
+	}
+
+	const FInventorySearchIndex& Index = InventoryComponent->GetSearchIndex();
+
+	// Unfiltered, every occupied slot is shown
+	TBitArray<> OldMatches;
+	if (QueryPlan.IsEmpty())
+	{
+		OldMatches = Index.GetOccupiedBits();
+	}
+	else
+	{
+		OldMatches = MoveTemp(QueryMatches);
+	}
+
+	QueryPlan = FInventoryQueryPlan::Compile(CurrentFilter);
+	QueryPlan.Evaluate(Index, SearchResult, QueryMatches);
+	bFacetCountsDirty = true;
+
+	if (SearchErrorText)
+	{
+		SearchErrorText->SetText(FText::FromString(FString::Join(QueryPlan.Errors, TEXT(", "))));
+		SearchErrorText->SetVisibility(QueryPlan.Errors.Num() > 0 ? ESlateVisibility::HitTestInvisible : ESlateVisibility::Collapsed);
+	}
+
+	// Diff a word at a time, only flipped slots are touched
+	TArray<int32> ChangedSlots;
+	const int32 NumBits = FMath::Max(OldMatches.Num(), QueryMatches.Num());
+	OldMatches.SetNum(NumBits, false);
+	const int32 NumWords = FMath::DivideAndRoundUp(NumBits, NumBitsPerDWORD);
+	const uint32* OldWords = OldMatches.GetData();
+
+	TBitArray<> NewMatches = QueryMatches;
+	NewMatches.SetNum(NumBits, false);
+	const uint32* NewWords = NewMatches.GetData();
+
+	for (int32 Word = 0; Word < NumWords; ++Word)
+	{
+		for (uint32 Changed = OldWords[Word] ^ NewWords[Word]; Changed != 0; Changed &= Changed - 1)
+		{
+			ChangedSlots.Add(Word * NumBitsPerDWORD + FMath::CountTrailingZeros(Changed));
+		}
+	}
+
+	if (ChangedSlots.Num() == 0)
+	{
+		return;
+	}
+
+	if (bVirtualized)
+	{
+		RebuildDisplayedSlots();
+		UpdateVirtualRows(true);
+		FlushIconRequests();
+		return;
+	}
+
+	const TArray<FInventoryItem>& Items = InventoryComponent->GetItems();
+	for (int32 SlotIndex : ChangedSlots)
+	{
+		if (SlotWidgets.IsValidIndex(SlotIndex) && SlotWidgets[SlotIndex])
+		{
+			const bool bShouldShow = !Items.IsValidIndex(SlotIndex) || !Items[SlotIndex].IsValid() || PassesFilter(SlotIndex);
+			SlotWidgets[SlotIndex]->SetVisibility(bShouldShow ? ESlateVisibility::Visible : ESlateVisibility::Collapsed);
+		}
+	}
+}
+
+void UInventoryWidget::EvaluateQuery()
+{
+	bFacetCountsDirty = true;
+
+	if (!InventoryComponent || QueryPlan.IsEmpty())
+	{
+		QueryMatches.Empty();
+		return;
+	}
+
+	QueryPlan.Evaluate(InventoryComponent->GetSearchIndex(), SearchResult, QueryMatches);
+}
+
+void UInventoryWidget::RefreshQueryMatch(int32 SlotIndex)
+{
+	bFacetCountsDirty = true;
+
+	if (!InventoryComponent || QueryPlan.IsEmpty() || SlotIndex < 0)
+	{
+		return;
+	}
+
+	const FInventorySearchIndex& Index = InventoryComponent->GetSearchIndex();
+
+	// New item types were indexed since the name text was matched
+	if (SearchResult.Revision != Index.GetRevision())
+	{
+		Index.Search(QueryPlan.NameText, SearchResult);
+	}
+
+	if (SlotIndex >= QueryMatches.Num())
+	{
+		QueryMatches.Add(false, SlotIndex + 1 - QueryMatches.Num());
+	}
+
+	QueryMatches[SlotIndex] = QueryPlan.EvaluateSlot(Index, SearchResult, SlotIndex);
+}
+
+const FInventoryFacetCounts& UInventoryWidget::GetFacetCounts()
+{
+	if (bFacetCountsDirty && InventoryComponent)
+	{
+		const FInventorySearchIndex& Index = InventoryComponent->GetSearchIndex();
+		FacetCounts.Compute(Index, QueryPlan.IsEmpty() ? Index.GetOccupiedBits() : QueryMatches);
+		bFacetCountsDirty = false;
+	}
+	return FacetCounts;
+}
+
+int32 UInventoryWidget::GetCategoryMatchCount(EItemCategory Category)
+{
+	const int32 Index = static_cast<int32>(Category);
+	return Index < FInventorySearchIndex::NumCategories ? GetFacetCounts().Categories[Index] : 0;
+}
+
+int32 UInventoryWidget::GetRarityMatchCount(EItemRarity Rarity)
+{
+	const int32 Index = static_cast<int32>(Rarity);
+	return Index < FInventorySearchIndex::NumRarities ? GetFacetCounts().Rarities[Index] : 0;
+}
+
+void UInventoryWidget::ShowDropHints(UInventoryDragDropOperation* Operation)
+{
+	HideDropHints();
+
+	if (!Operation)
+	{
+		return;
+	}
+
+	DropHintOperation = Operation;
+	Operation->OnDropTargetsChanged.AddUObject(this, &UInventoryWidget::HandleDropTargetsChanged);
+	Operation->OnDragEnded.AddUObject(this, &UInventoryWidget::HideDropHints);
+
+	for (UInventorySlotWidget* SlotWidget : SlotWidgets)
+	{
+		ApplyDropHint(SlotWidget);
+	}
+}
+
+void UInventoryWidget::HideDropHints()
+{
+	UInventoryDragDropOperation* Operation = DropHintOperation.Get();
+	if (!Operation)
+	{
+		return;
+	}
+
+	Operation->OnDropTargetsChanged.RemoveAll(this);
+	Operation->OnDragEnded.RemoveAll(this);
+	DropHintOperation.Reset();
+
+	for (UInventorySlotWidget* SlotWidget : SlotWidgets)
+	{
+		if (SlotWidget)
+		{
+			SlotWidget->SetDropHint(EInventoryDropResult::None);
+		}
+	}
+}
+
+void UInventoryWidget::HandleDropTargetsChanged(const UInventoryComponent* Inventory, int32 SlotIndex)
+{
+	if (Inventory != InventoryComponent)
+	{
+		return;
+	}
+
+	if (SlotIndex == INDEX_NONE)
+	{
+		for (UInventorySlotWidget* SlotWidget : SlotWidgets)
+		{
+			ApplyDropHint(SlotWidget);
+		}
+	}
+	else
+	{
+		ApplyDropHint(GetSlotWidget(SlotIndex));
+	}
+}
+
+void UInventoryWidget::ApplyDropHint(UInventorySlotWidget* SlotWidget) const
+{
+	if (!SlotWidget)
+	{
+		return;
+	}
+
+	const UInventoryDragDropOperation* Operation = DropHintOperation.Get();
+	SlotWidget->SetDropHint(Operation ? Operation->GetDropResult(InventoryComponent, SlotWidget->GetSlotIndex()) : EInventoryDropResult::None);
 }
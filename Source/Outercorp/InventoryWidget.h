@@ -5,19 +5,28 @@
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
 #include "InventoryComponent.h"
+#include "InventoryQuery.h"
 #include "InventoryWidget.generated.h"
 
 class UInventorySlotWidget;
+class UInventoryDragDropOperation;
 class UUniformGridPanel;
 class UTextBlock;
 class UProgressBar;
 class UButton;
 class UEditableText;
+class UScrollBox;
+class UCanvasPanel;
+class USpacer;
+class UInvalidationBox;
 
 /**
  * Main inventory window widget (Eve Online style)
+ * Does not tick: refreshes are driven by UInventoryViewSubsystem and focus by focus events.
+ * The slot area can be wrapped in SlotsInvalidationBox so that the search box caret and
+ * the weight display don't repaint the grid.
  */
-UCLASS()
+UCLASS(meta = (DisableNativeTick))
 class OUTERCORP_API UInventoryWidget : public UUserWidget
 {
 	GENERATED_BODY()
@@ -25,9 +34,8 @@ class OUTERCORP_API UInventoryWidget : public UUserWidget
 protected:
 	virtual void NativeConstruct() override;
 	virtual void NativeDestruct() override;
-	virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
 	virtual FReply NativeOnKeyDown(const FGeometry& InGeometry, const FKeyEvent& InKeyEvent) override;
-	virtual FReply NativeOnFocusReceived(const FGeometry& InGeometry, const FFocusEvent& InFocusEvent) override;
+	virtual void NativeOnRemovedFromFocusPath(const FFocusEvent& InFocusEvent) override;
 	virtual bool NativeSupportsKeyboardFocus() const override { return true; }
 
 	/** Reference to the inventory component */
@@ -70,6 +78,22 @@ protected:
 	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
 	TObjectPtr<UEditableText> SearchText;
 
+	/** Why part of the search was left out, e.g. an unknown category */
+	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
+	TObjectPtr<UTextBlock> SearchErrorText;
+
+	/** Scroll box hosting the virtualized grid (optional, used for large containers) */
+	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
+	TObjectPtr<UScrollBox> VirtualScrollBox;
+
+	/** Canvas inside VirtualScrollBox that virtualized slot widgets are positioned on */
+	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
+	TObjectPtr<UCanvasPanel> VirtualCanvas;
+
+	/** Cached container around the slot grid (ItemGrid or VirtualScrollBox), repainted only when a slot changes */
+	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
+	TObjectPtr<UInvalidationBox> SlotsInvalidationBox;
+
 	/** Class for inventory slot widgets */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
 	TSubclassOf<UInventorySlotWidget> SlotWidgetClass;
@@ -78,10 +102,34 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
 	int32 GridColumns = 6;
 
-	/** Array of slot widgets */
+	/** Seconds to wait after focus leaves the window before taking it back (gives buttons time to process their clicks) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
+	float FocusReclaimDelay = 0.1f;
+
+	/** Containers with more slots than this use the virtualized grid (if bound) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory|Virtualization")
+	int32 VirtualizationThreshold = 200;
+
+	/** Size of a slot in the virtualized grid */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory|Virtualization")
+	FVector2D VirtualSlotSize = FVector2D(64.0f, 64.0f);
+
+	/** Extra rows materialized above and below the visible area */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory|Virtualization")
+	int32 OverscanRows = 2;
+
+	/** Rows assumed visible before the scroll box has been laid out */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory|Virtualization")
+	int32 DefaultVisibleRows = 10;
+
+	/** Array of slot widgets (one per slot, or the recycled pool when virtualized) */
 	UPROPERTY()
 	TArray<TObjectPtr<UInventorySlotWidget>> SlotWidgets;
 
+	/** Spacer that gives the virtual canvas its full scrollable height */
+	UPROPERTY()
+	TObjectPtr<USpacer> VirtualExtentSpacer;
+
 	/** Current search filter */
 	UPROPERTY()
 	FString CurrentFilter;
@@ -95,6 +143,32 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	void RefreshInventory();
 
+	/** Get the widget currently showing a slot (null if not materialized) */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	UInventorySlotWidget* GetSlotWidget(int32 SlotIndex) const;
+
+	/** Items matching the current filter in a category (for filter tabs) */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	int32 GetCategoryMatchCount(EItemCategory Category);
+
+	/** Items matching the current filter with a rarity (for filter tabs) */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	int32 GetRarityMatchCount(EItemRarity Rarity);
+
+	/** Inventory shown by this window */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	UInventoryComponent* GetInventoryComponent() const { return InventoryComponent; }
+
+	/** Show on each slot what dropping Operation's item there would do, until the drag ends */
+	void ShowDropHints(UInventoryDragDropOperation* Operation);
+
+	/** Clear drop hints from every slot */
+	void HideDropHints();
+
+	/** Is the virtualized grid in use */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	bool IsVirtualized() const { return bVirtualized; }
+
 	/** Refresh specific slot */
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	void RefreshSlot(int32 SlotIndex);
@@ -103,16 +177,30 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	void UpdateCapacityDisplay();
 
+	/** Show the window (it is kept alive while closed) */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void OpenInventory();
+
 	/** Close inventory */
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	void CloseInventory();
 
+	/** Is the window in the viewport and visible */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory")
+	bool IsOpen() const;
+
 	/** Delegate called when inventory is closed */
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnInventoryClosed);
 
 	UPROPERTY(BlueprintAssignable, Category = "Inventory")
 	FOnInventoryClosed OnInventoryClosed;
 
+	/**
+	 * Apply changes recorded since the last flush, stopping once FPlatformTime::Seconds() passes Deadline
+	 * At least one batch of slots is applied per call. Returns true when nothing is left pending.
+	 */
+	bool FlushPendingRefresh(double Deadline = DBL_MAX);
+
 protected:
 	/** Called when inventory is updated */
 	UFUNCTION()
@@ -138,13 +226,113 @@ protected:
 	UFUNCTION()
 	void OnSearchTextChanged(const FText& Text);
 
+	/** Virtual grid scrolled */
+	UFUNCTION()
+	void OnVirtualScrolled(float CurrentOffset);
+
 	/** Create slot widgets */
 	void CreateSlotWidgets();
 
-	/** Check if item passes filter */
-	bool PassesFilter(const FInventoryItem& Item) const;
+	/** Grow or shrink the slot widget pool to the current capacity, keeping existing widgets */
+	void ResizeSlotWidgets();
+
+	/** Create the grid widget for a slot (non-virtualized mode) */
+	void AddGridSlotWidget(int32 SlotIndex);
+
+	/** Take keyboard focus back unless the window was closed or another inventory window has it */
+	void ReclaimFocus();
+
+	/** Bind to the inventory component's change events */
+	void BindInventoryComponent();
+
+	/** Remove our bindings from the inventory component */
+	void UnbindInventoryComponent();
+
+	/** Record a slot for the next flush */
+	void MarkSlotDirty(int32 SlotIndex);
+
+	/** Queue this window with the view scheduler, which flushes it within the frame budget */
+	void RequestRefresh();
+
+	/** Forget recorded changes */
+	void ClearDirtySlots();
+
+	/** Send icons queued by slot updates as one streaming request */
+	void FlushIconRequests();
+
+	/** Rebuild the list of slots shown by the virtualized grid (empty slots and filter matches) */
+	void RebuildDisplayedSlots();
+
+	/** Materialize widgets for the visible rows plus overscan, recycling the rest */
+	void UpdateVirtualRows(bool bForce = false);
+
+	/** Take a widget from the virtual pool, creating one if needed */
+	int32 AcquirePooledWidget();
+
+	/** Check if the item in a slot passes the filter (callers show empty slots regardless) */
+	bool PassesFilter(int32 SlotIndex) const;
+
+	/** Compile the filter text, evaluate it against the search index and update only the slots whose match state flipped */
+	void ApplySearchFilter();
+
+	/** Re-evaluate the compiled filter over every slot */
+	void EvaluateQuery();
+
+	/** Re-evaluate the compiled filter for one changed slot */
+	void RefreshQueryMatch(int32 SlotIndex);
+
+	/** Drag operation's results changed for a slot of some inventory (INDEX_NONE for all its slots) */
+	void HandleDropTargetsChanged(const UInventoryComponent* Inventory, int32 SlotIndex);
+
+	/** Look up and apply the drop hint for a slot widget */
+	void ApplyDropHint(UInventorySlotWidget* SlotWidget) const;
 
 private:
-	/** Timer to delay focus reclaim to avoid interfering with button clicks */
-	float FocusReclaimTimer = 0.0f;
+	/** Drag whose hints are shown */
+	TWeakObjectPtr<UInventoryDragDropOperation> DropHintOperation;
+
+	/** Pending focus reclaim after focus left the window */
+	FTimerHandle FocusReclaimTimerHandle;
+
+	/** Using the virtualized grid */
+	bool bVirtualized = false;
+
+	/** Slot indices in display order for the virtualized grid */
+	TArray<int32> DisplayedSlots;
+
+	/** Display position of each slot (INDEX_NONE if filtered out) */
+	TArray<int32> DisplayPositions;
+
+	/** Slot index to pooled widget index for materialized slots */
+	TMap<int32, int32> SlotToPoolIndex;
+
+	/** Pooled widgets not showing any slot */
+	TArray<int32> FreePoolIndices;
+
+	/** Currently materialized row range */
+	int32 FirstMaterializedRow = INDEX_NONE;
+	int32 LastMaterializedRow = INDEX_NONE;
+
+	/** Slots changed since the last flush (bits for dedup, list for iteration) */
+	TBitArray<> DirtySlotBits;
+	TArray<int32> DirtySlots;
+
+	/** Weight and capacity text need updating */
+	bool bCapacityDirty = false;
+
+	/** Compiled form of CurrentFilter */
+	FInventoryQueryPlan QueryPlan;
+
+	/** Name part of the current filter, kept so longer queries narrow it */
+	FInventorySearchResult SearchResult;
+
+	/** Slots matching QueryPlan */
+	TBitArray<> QueryMatches;
+
+	/** Per-facet counts of QueryMatches, computed on demand */
+	FInventoryFacetCounts FacetCounts;
+	bool bFacetCountsDirty = true;
+
+	/** Recompute FacetCounts if needed */
+	const FInventoryFacetCounts& GetFacetCounts();
 };
@@ -0,0 +1,210 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ItemTimerSubsystem.h"
+#include "Engine/World.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Item Timers Advance"), STAT_ItemTimersAdvance, STATGROUP_Inventory);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Item Timers Active"), STAT_ItemTimersActive, STATGROUP_Inventory);
+
+bool UItemTimerSubsystem::FInstanceTimers::HasAny() const
+{
+	for (const FTimingWheelHandle& Handle : Handles)
+	{
+		if (Handle.IsValid())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UItemTimerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Wheel.Reset(GetWorldTick());
+}
+
+void UItemTimerSubsystem::Deinitialize()
+{
+	InstanceTimers.Empty();
+	FiredEntries.Empty();
+	FiredEvents.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemTimerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ItemTimersAdvance);
+
+	FiredEntries.Reset();
+	Wheel.Advance(GetWorldTick(), FiredEntries);
+
+	SET_DWORD_STAT(STAT_ItemTimersActive, Wheel.Num());
+
+	if (FiredEntries.Num() == 0)
+	{
+		return;
+	}
+
+	FiredEvents.Reset(FiredEntries.Num());
+	for (const FTimingWheelEntry& Entry : FiredEntries)
+	{
+		// Drop the per-instance bookkeeping for the timer that just fired
+		if (FInstanceTimers* Timers = InstanceTimers.Find(Entry.Key))
+		{
+			Timers->Handles[Entry.Tag].Invalidate();
+			if (!Timers->HasAny())
+			{
+				InstanceTimers.Remove(Entry.Key);
+			}
+		}
+
+		FItemTimerEvent& Event = FiredEvents.AddDefaulted_GetRef();
+		Event.InstanceID = Entry.Key;
+		Event.TimerType = static_cast<EItemTimerType>(Entry.Tag);
+	}
+
+	OnTimersFired.Broadcast(FiredEvents);
+}
+
+ETickableTickType UItemTimerSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UItemTimerSubsystem::IsTickable() const
+{
+	// No per-frame cost while no timers are running
+	return !Wheel.IsEmpty();
+}
+
+TStatId UItemTimerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UItemTimerSubsystem, STATGROUP_Tickables);
+}
+
+void UItemTimerSubsystem::StartTimer(FGuid InstanceID, EItemTimerType TimerType, float Duration)
+{
+	if (!InstanceID.IsValid() || TimerType == EItemTimerType::MAX || Duration <= 0.0f)
+	{
+		return;
+	}
+
+	const uint64 NowTick = GetWorldTick();
+
+	// The wheel stops advancing while idle, so catch it up before scheduling
+	if (Wheel.IsEmpty())
+	{
+		Wheel.Reset(NowTick);
+	}
+
+	const uint64 DelayTicks = FMath::Max<uint64>(1, FMath::CeilToInt64(Duration / TickInterval));
+
+	FInstanceTimers& Timers = InstanceTimers.FindOrAdd(InstanceID);
+	FTimingWheelHandle& Handle = Timers.Handles[static_cast<int32>(TimerType)];
+	Wheel.Cancel(Handle);
+	Handle = Wheel.Schedule(InstanceID, static_cast<int32>(TimerType), NowTick + DelayTicks);
+}
+
+bool UItemTimerSubsystem::StartItemTimer(const FInventoryItem& Item, EItemTimerType TimerType)
+{
+	if (!Item.IsValid())
+	{
+		return false;
+	}
+
+	float Duration = 0.0f;
+	switch (TimerType)
+	{
+		case EItemTimerType::Cooldown:
+			Duration = Item.ItemData->UseCooldown;
+			break;
+		case EItemTimerType::Expiry:
+			Duration = Item.ItemData->ShelfLife;
+			break;
+		case EItemTimerType::Recharge:
+			Duration = Item.ItemData->RechargeTime;
+			break;
+		default:
+			break;
+	}
+
+	if (Duration <= 0.0f)
+	{
+		return false;
+	}
+
+	StartTimer(Item.InstanceID, TimerType, Duration);
+	return true;
+}
+
+bool UItemTimerSubsystem::CancelTimer(FGuid InstanceID, EItemTimerType TimerType)
+{
+	if (TimerType == EItemTimerType::MAX)
+	{
+		return false;
+	}
+
+	FInstanceTimers* Timers = InstanceTimers.Find(InstanceID);
+	if (!Timers)
+	{
+		return false;
+	}
+
+	const bool bCancelled = Wheel.Cancel(Timers->Handles[static_cast<int32>(TimerType)]);
+	if (!Timers->HasAny())
+	{
+		InstanceTimers.Remove(InstanceID);
+	}
+	return bCancelled;
+}
+
+void UItemTimerSubsystem::CancelAllTimers(FGuid InstanceID)
+{
+	FInstanceTimers Timers;
+	if (InstanceTimers.RemoveAndCopyValue(InstanceID, Timers))
+	{
+		for (FTimingWheelHandle& Handle : Timers.Handles)
+		{
+			Wheel.Cancel(Handle);
+		}
+	}
+}
+
+bool UItemTimerSubsystem::IsTimerActive(FGuid InstanceID, EItemTimerType TimerType) const
+{
+	return GetRemainingTime(InstanceID, TimerType) > 0.0f;
+}
+
+float UItemTimerSubsystem::GetRemainingTime(FGuid InstanceID, EItemTimerType TimerType) const
+{
+	if (TimerType == EItemTimerType::MAX)
+	{
+		return 0.0f;
+	}
+
+	const FInstanceTimers* Timers = InstanceTimers.Find(InstanceID);
+	if (!Timers)
+	{
+		return 0.0f;
+	}
+
+	const uint64 ExpiryTick = Wheel.GetExpiryTick(Timers->Handles[static_cast<int32>(TimerType)]);
+	const uint64 NowTick = GetWorldTick();
+	if (ExpiryTick <= NowTick)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(ExpiryTick - NowTick) * TickInterval;
+}
+
+uint64 UItemTimerSubsystem::GetWorldTick() const
+{
+	const UWorld* World = GetWorld();
+	const double WorldTime = World ? World->GetTimeSeconds() : 0.0;
+	return static_cast<uint64>(WorldTime / TickInterval);
+}
@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HierarchicalTimingWheel.h"
+#include "InventoryItemData.h"
+#include "ItemTimerSubsystem.generated.h"
+
+/**
+ * Kind of per-instance item timer
+ */
+UENUM(BlueprintType)
+enum class EItemTimerType : uint8
+{
+	Cooldown	UMETA(DisplayName = "Cooldown"),
+	Expiry		UMETA(DisplayName = "Expiry"),
+	Recharge	UMETA(DisplayName = "Recharge"),
+
+	MAX			UMETA(Hidden)
+};
+
+/**
+ * Item timer that completed this frame
+ */
+USTRUCT(BlueprintType)
+struct FItemTimerEvent
+{
+	GENERATED_BODY()
+
+	/** Item instance the timer belonged to */
+	UPROPERTY(BlueprintReadOnly, Category = "Item Timers")
+	FGuid InstanceID;
+
+	/** Kind of timer */
+	UPROPERTY(BlueprintReadOnly, Category = "Item Timers")
+	EItemTimerType TimerType = EItemTimerType::Cooldown;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnItemTimersFired, const TArray<FItemTimerEvent>&, FiredTimers);
+
+/**
+ * Shared timer service for item cooldowns, expiry and recharge
+ * Timers are keyed on item instance ID rather than slot or owner, so they follow
+ * the item through MoveItem, SortInventory and TransferItem. All timers live in one
+ * hierarchical timing wheel; completed timers are reported in a single batch per frame.
+ */
+UCLASS()
+class OUTERCORP_API UItemTimerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	/** Called once per frame with every timer that completed */
+	UPROPERTY(BlueprintAssignable, Category = "Item Timers")
+	FOnItemTimersFired OnTimersFired;
+
+	/** Start (or restart) a timer for an item instance */
+	UFUNCTION(BlueprintCallable, Category = "Item Timers")
+	void StartTimer(FGuid InstanceID, EItemTimerType TimerType, float Duration);
+
+	/** Start a timer using the duration configured on the item's data asset */
+	UFUNCTION(BlueprintCallable, Category = "Item Timers")
+	bool StartItemTimer(const FInventoryItem& Item, EItemTimerType TimerType);
+
+	/** Cancel a running timer */
+	UFUNCTION(BlueprintCallable, Category = "Item Timers")
+	bool CancelTimer(FGuid InstanceID, EItemTimerType TimerType);
+
+	/** Cancel every timer for an item instance (e.g. when it is destroyed) */
+	UFUNCTION(BlueprintCallable, Category = "Item Timers")
+	void CancelAllTimers(FGuid InstanceID);
+
+	/** Check if a timer is running */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Item Timers")
+	bool IsTimerActive(FGuid InstanceID, EItemTimerType TimerType) const;
+
+	/** Seconds left on a timer (0 if not running) */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Item Timers")
+	float GetRemainingTime(FGuid InstanceID, EItemTimerType TimerType) const;
+
+	/** Number of running timers */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Item Timers")
+	int32 GetNumActiveTimers() const { return Wheel.Num(); }
+
+	/** Wheel resolution in seconds */
+	static constexpr float TickInterval = 0.05f;
+
+private:
+	/** Wheel tick corresponding to the current world time */
+	uint64 GetWorldTick() const;
+
+	/** Per-instance handles, one per timer type */
+	struct FInstanceTimers
+	{
+		FTimingWheelHandle Handles[static_cast<int32>(EItemTimerType::MAX)];
+
+		bool HasAny() const;
+	};
+
+	FHierarchicalTimingWheel Wheel;
+	TMap<FGuid, FInstanceTimers> InstanceTimers;
+
+	/** Scratch buffers reused every frame */
+	TArray<FTimingWheelEntry> FiredEntries;
+	TArray<FItemTimerEvent> FiredEvents;
+};
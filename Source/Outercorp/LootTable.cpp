@@ -0,0 +1,225 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LootTable.h"
+#include "InventoryComponent.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Loot Generate"), STAT_LootGenerate, STATGROUP_Inventory);
+
+void FLootAliasTable::Build(TConstArrayView<float> Weights)
+{
+	Probability.Reset();
+	Alias.Reset();
+	EntryIndex.Reset();
+
+	double TotalWeight = 0.0;
+	for (int32 i = 0; i < Weights.Num(); ++i)
+	{
+		if (Weights[i] > 0.0f)
+		{
+			EntryIndex.Add(i);
+			TotalWeight += Weights[i];
+		}
+	}
+
+	const int32 NumColumns = EntryIndex.Num();
+	if (NumColumns == 0)
+	{
+		return;
+	}
+
+	Probability.SetNumUninitialized(NumColumns);
+	Alias.SetNumUninitialized(NumColumns);
+
+	// Vose's method: scale weights so the average column is 1, then pair small with large
+	TArray<double> Scaled;
+	Scaled.SetNumUninitialized(NumColumns);
+
+	TArray<int32> Small;
+	TArray<int32> Large;
+
+	for (int32 Column = 0; Column < NumColumns; ++Column)
+	{
+		Scaled[Column] = Weights[EntryIndex[Column]] * NumColumns / TotalWeight;
+		Alias[Column] = Column;
+		(Scaled[Column] < 1.0 ? Small : Large).Add(Column);
+	}
+
+	while (Small.Num() > 0 && Large.Num() > 0)
+	{
+		const int32 Less = Small.Pop(EAllowShrinking::No);
+		const int32 More = Large.Pop(EAllowShrinking::No);
+
+		Probability[Less] = static_cast<float>(Scaled[Less]);
+		Alias[Less] = More;
+
+		Scaled[More] = (Scaled[More] + Scaled[Less]) - 1.0;
+		(Scaled[More] < 1.0 ? Small : Large).Add(More);
+	}
+
+	// Leftovers are full columns (numerical error may leave some in Small)
+	for (int32 Column : Large)
+	{
+		Probability[Column] = 1.0f;
+	}
+	for (int32 Column : Small)
+	{
+		Probability[Column] = 1.0f;
+	}
+}
+
+int32 FLootAliasTable::Sample(const FRandomStream& Stream) const
+{
+	const int32 Column = Stream.RandHelper(EntryIndex.Num());
+	const int32 Picked = Stream.GetFraction() < Probability[Column] ? Column : Alias[Column];
+	return EntryIndex[Picked];
+}
+
+void ULootTable::RollLoot(FRandomStream& Stream, TArray<FItemQuantity>& OutLoot) const
+{
+	RollLootInternal(Stream, OutLoot, 0);
+}
+
+int32 ULootTable::GenerateLoot(UInventoryComponent* TargetInventory, int32 Seed) const
+{
+	if (!TargetInventory)
+	{
+		return 0;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LootGenerate);
+
+	FRandomStream Stream(Seed);
+	TArray<FItemQuantity> Loot;
+	RollLoot(Stream, Loot);
+
+	TArray<FItemQuantity> Rejected;
+	TargetInventory->AddItems(Loot, Rejected);
+	return Rejected.Num();
+}
+
+void ULootTable::GenerateLootBatch(const TArray<UInventoryComponent*>& TargetInventories, int32 BaseSeed) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LootGenerate);
+
+	// Compile once up front rather than on the first container
+	GetCompiledTable();
+
+	FRandomStream Stream;
+	TArray<FItemQuantity> Loot;
+	TArray<FItemQuantity> Rejected;
+
+	for (int32 i = 0; i < TargetInventories.Num(); ++i)
+	{
+		UInventoryComponent* TargetInventory = TargetInventories[i];
+		if (!TargetInventory)
+		{
+			continue;
+		}
+
+		Stream.Initialize(static_cast<int32>(HashCombine(GetTypeHash(BaseSeed), GetTypeHash(i))));
+
+		Loot.Reset();
+		RollLootInternal(Stream, Loot, 0);
+		TargetInventory->AddItems(Loot, Rejected);
+	}
+}
+
+void ULootTable::InvalidateCompiledTable()
+{
+	bCompiled = false;
+	CompiledTable = FLootAliasTable();
+}
+
+#if WITH_EDITOR
+void ULootTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	InvalidateCompiledTable();
+}
+#endif
+
+void ULootTable::RollLootInternal(FRandomStream& Stream, TArray<FItemQuantity>& OutLoot, int32 Depth) const
+{
+	if (Depth >= MaxNestingDepth)
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("Loot table '%s' exceeded max nesting depth"), *GetNameSafe(this));
+		return;
+	}
+
+	const FLootAliasTable& Table = GetCompiledTable();
+	if (Table.IsEmpty())
+	{
+		return;
+	}
+
+	const int32 NumRolls = Stream.RandRange(MinRolls, FMath::Max(MinRolls, MaxRolls));
+	for (int32 Roll = 0; Roll < NumRolls; ++Roll)
+	{
+		const FLootTableEntry& Entry = Entries[Table.Sample(Stream)];
+		const int32 Quantity = Stream.RandRange(Entry.MinQuantity, FMath::Max(Entry.MinQuantity, Entry.MaxQuantity));
+
+		if (Entry.SubTable)
+		{
+			for (int32 SubRoll = 0; SubRoll < Quantity; ++SubRoll)
+			{
+				Entry.SubTable->RollLootInternal(Stream, OutLoot, Depth + 1);
+			}
+			continue;
+		}
+
+		FItemQuantity* Existing = OutLoot.FindByPredicate([&Entry](const FItemQuantity& Other)
+		{
+			return Other.ItemData == Entry.Item;
+		});
+
+		if (Existing)
+		{
+			Existing->Quantity += Quantity;
+		}
+		else
+		{
+			OutLoot.Emplace(Entry.Item, Quantity);
+		}
+	}
+}
+
+const FLootAliasTable& ULootTable::GetCompiledTable() const
+{
+	if (!bCompiled)
+	{
+		TArray<float, TInlineAllocator<32>> Weights;
+		Weights.Reserve(Entries.Num());
+		for (const FLootTableEntry& Entry : Entries)
+		{
+			Weights.Add(GetEffectiveWeight(Entry));
+		}
+
+		CompiledTable.Build(Weights);
+		bCompiled = true;
+	}
+
+	return CompiledTable;
+}
+
+float ULootTable::GetEffectiveWeight(const FLootTableEntry& Entry) const
+{
+	if (Entry.SubTable)
+	{
+		return Entry.Weight;
+	}
+
+	if (!Entry.Item)
+	{
+		return 0.0f;
+	}
+
+	if (AllowedCategories.Num() > 0 && !AllowedCategories.Contains(Entry.Item->Category))
+	{
+		return 0.0f;
+	}
+
+	const float* Scale = RarityWeightScale.Find(Entry.Item->Rarity);
+	return Entry.Weight * (Scale ? *Scale : 1.0f);
+}
@@ -0,0 +1,131 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Math/RandomStream.h"
+#include "InventoryItemData.h"
+#include "LootTable.generated.h"
+
+class UInventoryComponent;
+class ULootTable;
+
+/**
+ * Single weighted entry of a loot table, either an item or a nested table
+ */
+USTRUCT(BlueprintType)
+struct FLootTableEntry
+{
+	GENERATED_BODY()
+
+	/** Item dropped by this entry */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	TObjectPtr<UInventoryItemData> Item;
+
+	/** Nested table rolled instead of an item (takes priority over Item) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	TObjectPtr<ULootTable> SubTable;
+
+	/** Relative chance of this entry being picked */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = "0"))
+	float Weight = 1.0f;
+
+	/** Minimum quantity (or number of sub table rolls) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = "1"))
+	int32 MinQuantity = 1;
+
+	/** Maximum quantity (or number of sub table rolls) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = "1"))
+	int32 MaxQuantity = 1;
+};
+
+/**
+ * Walker alias table compiled from loot table weights for O(1) sampling
+ */
+struct FLootAliasTable
+{
+	/** Probability of keeping the column instead of taking its alias */
+	TArray<float> Probability;
+
+	/** Alias column for each column */
+	TArray<int32> Alias;
+
+	/** Loot table entry index for each column */
+	TArray<int32> EntryIndex;
+
+	bool IsEmpty() const { return EntryIndex.Num() == 0; }
+
+	/** Build from raw weights, zero-weight entries are dropped */
+	void Build(TConstArrayView<float> Weights);
+
+	/** Pick an entry index */
+	int32 Sample(const FRandomStream& Stream) const;
+};
+
+/**
+ * Data asset describing weighted loot for crates, wrecks and NPC drops
+ * Entry weights (scaled per rarity and filtered by category) are compiled into an alias
+ * table on first use. Rolls use a seeded FRandomStream so loot is deterministic per seed,
+ * and results are written into the target inventory with a single AddItems call.
+ */
+UCLASS(BlueprintType)
+class OUTERCORP_API ULootTable : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Weighted entries */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	TArray<FLootTableEntry> Entries;
+
+	/** Minimum number of picks per roll */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = "0"))
+	int32 MinRolls = 1;
+
+	/** Maximum number of picks per roll */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = "0"))
+	int32 MaxRolls = 1;
+
+	/** Weight multiplier per item rarity (missing rarities use 1) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	TMap<EItemRarity, float> RarityWeightScale;
+
+	/** Item categories allowed to drop (empty = all) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	TArray<EItemCategory> AllowedCategories;
+
+	/** Roll this table and append the results (duplicates are merged) */
+	void RollLoot(FRandomStream& Stream, TArray<FItemQuantity>& OutLoot) const;
+
+	/** Roll this table with a seed and insert the results into an inventory, returns number of stacks rejected */
+	UFUNCTION(BlueprintCallable, Category = "Loot")
+	int32 GenerateLoot(UInventoryComponent* TargetInventory, int32 Seed) const;
+
+	/** Generate loot for many containers, each seeded from BaseSeed and its index */
+	UFUNCTION(BlueprintCallable, Category = "Loot")
+	void GenerateLootBatch(const TArray<UInventoryComponent*>& TargetInventories, int32 BaseSeed) const;
+
+	/** Drop the compiled alias table so it is rebuilt on next use */
+	void InvalidateCompiledTable();
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+protected:
+	/** Maximum nesting of sub tables */
+	static constexpr int32 MaxNestingDepth = 8;
+
+	void RollLootInternal(FRandomStream& Stream, TArray<FItemQuantity>& OutLoot, int32 Depth) const;
+
+	/** Compile weights into the alias table if needed */
+	const FLootAliasTable& GetCompiledTable() const;
+
+	/** Effective weight of an entry after rarity scaling and category filtering */
+	float GetEffectiveWeight(const FLootTableEntry& Entry) const;
+
+private:
+	mutable FLootAliasTable CompiledTable;
+	mutable bool bCompiled = false;
+};
@@ -0,0 +1,305 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MarketOrderBook.h"
+
+FMarketOrderId FMarketOrderBook::SubmitOrder(EMarketSide Side, int32 Trader, int64 Price, int32 Quantity, TArray<FMarketFill>& OutFills)
+{
+	if (Quantity <= 0 || Price <= 0)
+	{
+		return 0;
+	}
+
+	// Allocate first so no order references are invalidated while matching
+	const int32 OrderIndex = AllocateOrder();
+	const FMarketOrderId OrderId = MakeOrderId(OrderIndex, Orders[OrderIndex].Generation);
+
+	const EMarketSide OppositeSide = Side == EMarketSide::Buy ? EMarketSide::Sell : EMarketSide::Buy;
+	TArray<FPriceLevel>& OppositeLevels = GetLevels(OppositeSide);
+
+	int32 Remaining = Quantity;
+	while (Remaining > 0 && OppositeLevels.Num() > 0)
+	{
+		FPriceLevel& Best = OppositeLevels.Last();
+		const bool bCrosses = Side == EMarketSide::Buy ? Best.Price <= Price : Best.Price >= Price;
+		if (!bCrosses)
+		{
+			break;
+		}
+
+		// Oldest order at the best price fills first
+		while (Remaining > 0 && Best.Head != INDEX_NONE)
+		{
+			const int32 MakerIndex = Best.Head;
+			FOrder& Maker = Orders[MakerIndex];
+			const int32 FillQuantity = FMath::Min(Remaining, Maker.Remaining);
+
+			FMarketFill& Fill = OutFills.AddDefaulted_GetRef();
+			Fill.MakerOrder = MakeOrderId(MakerIndex, Maker.Generation);
+			Fill.TakerOrder = OrderId;
+			Fill.MakerTrader = Maker.Trader;
+			Fill.TakerTrader = Trader;
+			Fill.TakerSide = Side;
+			Fill.Price = Best.Price;
+			Fill.BuyerLimitPrice = Side == EMarketSide::Buy ? Price : Best.Price;
+			Fill.Quantity = FillQuantity;
+
+			Maker.Remaining -= FillQuantity;
+			Best.TotalQuantity -= FillQuantity;
+			Remaining -= FillQuantity;
+
+			if (Maker.Remaining == 0)
+			{
+				Best.Head = Maker.Next;
+				if (Best.Head != INDEX_NONE)
+				{
+					Orders[Best.Head].Prev = INDEX_NONE;
+				}
+				else
+				{
+					Best.Tail = INDEX_NONE;
+				}
+
+				ReleaseOrder(MakerIndex);
+				--NumResting;
+			}
+		}
+
+		if (Best.Head == INDEX_NONE)
+		{
+			OppositeLevels.Pop(EAllowShrinking::No);
+		}
+	}
+
+	if (Remaining > 0)
+	{
+		FOrder& Order = Orders[OrderIndex];
+		Order.Side = Side;
+		Order.Trader = Trader;
+		Order.Price = Price;
+		Order.Remaining = Remaining;
+		LinkOrder(OrderIndex);
+		++NumResting;
+	}
+	else
+	{
+		ReleaseOrder(OrderIndex);
+	}
+
+	return OrderId;
+}
+
+bool FMarketOrderBook::CancelOrder(FMarketOrderId OrderId, FMarketOrderInfo& OutCancelled)
+{
+	const int32 OrderIndex = ResolveOrderId(OrderId);
+	if (OrderIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FOrder& Order = Orders[OrderIndex];
+
+	bool bFound = false;
+	const int32 LevelIndex = FindLevel(Order.Side, Order.Price, bFound);
+	if (!ensure(bFound))
+	{
+		return false;
+	}
+
+	OutCancelled.Side = Order.Side;
+	OutCancelled.Trader = Order.Trader;
+	OutCancelled.Price = Order.Price;
+	OutCancelled.RemainingQuantity = Order.Remaining;
+
+	UnlinkOrder(OrderIndex, LevelIndex);
+	ReleaseOrder(OrderIndex);
+	--NumResting;
+	return true;
+}
+
+void FMarketOrderBook::CancelAllOrders(TArray<FMarketOrderInfo>& OutCancelled)
+{
+	for (TArray<FPriceLevel>* Levels : { &Bids, &Asks })
+	{
+		for (const FPriceLevel& Level : *Levels)
+		{
+			int32 OrderIndex = Level.Head;
+			while (OrderIndex != INDEX_NONE)
+			{
+				const FOrder& Order = Orders[OrderIndex];
+				FMarketOrderInfo& Cancelled = OutCancelled.AddDefaulted_GetRef();
+				Cancelled.Side = Order.Side;
+				Cancelled.Trader = Order.Trader;
+				Cancelled.Price = Order.Price;
+				Cancelled.RemainingQuantity = Order.Remaining;
+
+				const int32 NextIndex = Order.Next;
+				ReleaseOrder(OrderIndex);
+				OrderIndex = NextIndex;
+			}
+		}
+		Levels->Reset();
+	}
+	NumResting = 0;
+}
+
+bool FMarketOrderBook::GetOrder(FMarketOrderId OrderId, FMarketOrderInfo& OutInfo) const
+{
+	const int32 OrderIndex = ResolveOrderId(OrderId);
+	if (OrderIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FOrder& Order = Orders[OrderIndex];
+	OutInfo.Side = Order.Side;
+	OutInfo.Trader = Order.Trader;
+	OutInfo.Price = Order.Price;
+	OutInfo.RemainingQuantity = Order.Remaining;
+	return true;
+}
+
+bool FMarketOrderBook::GetBestPrice(EMarketSide Side, int64& OutPrice, int32& OutQuantity) const
+{
+	const TArray<FPriceLevel>& Levels = GetLevels(Side);
+	if (Levels.Num() == 0)
+	{
+		return false;
+	}
+
+	OutPrice = Levels.Last().Price;
+	OutQuantity = Levels.Last().TotalQuantity;
+	return true;
+}
+
+FMarketOrderId FMarketOrderBook::MakeOrderId(int32 Index, uint32 Generation)
+{
+	return (static_cast<uint64>(Generation) << 32) | static_cast<uint32>(Index);
+}
+
+int32 FMarketOrderBook::ResolveOrderId(FMarketOrderId OrderId) const
+{
+	const int32 Index = static_cast<int32>(OrderId & 0xFFFFFFFF);
+	const uint32 Generation = static_cast<uint32>(OrderId >> 32);
+
+	if (!Orders.IsValidIndex(Index) || Orders[Index].Generation != Generation || !Orders[Index].bResting)
+	{
+		return INDEX_NONE;
+	}
+	return Index;
+}
+
+int32 FMarketOrderBook::AllocateOrder()
+{
+	if (FreeHead != INDEX_NONE)
+	{
+		const int32 Index = FreeHead;
+		FreeHead = Orders[Index].Next;
+		Orders[Index].Next = INDEX_NONE;
+		return Index;
+	}
+
+	return Orders.AddDefaulted();
+}
+
+void FMarketOrderBook::ReleaseOrder(int32 OrderIndex)
+{
+	FOrder& Order = Orders[OrderIndex];
+	++Order.Generation;
+	Order.bResting = false;
+	Order.Remaining = 0;
+	Order.Prev = INDEX_NONE;
+	Order.Next = FreeHead;
+	FreeHead = OrderIndex;
+}
+
+int32 FMarketOrderBook::FindLevel(EMarketSide Side, int64 Price, bool& bOutFound) const
+{
+	const TArray<FPriceLevel>& Levels = GetLevels(Side);
+	const bool bAscending = Side == EMarketSide::Buy;
+
+	// Lower bound: first level not ordered before Price
+	int32 Low = 0;
+	int32 High = Levels.Num();
+	while (Low < High)
+	{
+		const int32 Mid = Low + (High - Low) / 2;
+		const bool bBefore = bAscending ? Levels[Mid].Price < Price : Levels[Mid].Price > Price;
+		if (bBefore)
+		{
+			Low = Mid + 1;
+		}
+		else
+		{
+			High = Mid;
+		}
+	}
+
+	bOutFound = Levels.IsValidIndex(Low) && Levels[Low].Price == Price;
+	return Low;
+}
+
+void FMarketOrderBook::LinkOrder(int32 OrderIndex)
+{
+	FOrder& Order = Orders[OrderIndex];
+	TArray<FPriceLevel>& Levels = GetLevels(Order.Side);
+
+	bool bFound = false;
+	const int32 LevelIndex = FindLevel(Order.Side, Order.Price, bFound);
+	if (!bFound)
+	{
+		FPriceLevel NewLevel;
+		NewLevel.Price = Order.Price;
+		Levels.Insert(NewLevel, LevelIndex);
+	}
+
+	FPriceLevel& Level = Levels[LevelIndex];
+	Order.Prev = Level.Tail;
+	Order.Next = INDEX_NONE;
+	Order.bResting = true;
+
+	if (Level.Tail != INDEX_NONE)
+	{
+		Orders[Level.Tail].Next = OrderIndex;
+	}
+	else
+	{
+		Level.Head = OrderIndex;
+	}
+
+	Level.Tail = OrderIndex;
+	Level.TotalQuantity += Order.Remaining;
+}
+
+void FMarketOrderBook::UnlinkOrder(int32 OrderIndex, int32 LevelIndex)
+{
+	FOrder& Order = Orders[OrderIndex];
+	TArray<FPriceLevel>& Levels = GetLevels(Order.Side);
+	FPriceLevel& Level = Levels[LevelIndex];
+
+	if (Order.Prev != INDEX_NONE)
+	{
+		Orders[Order.Prev].Next = Order.Next;
+	}
+	else
+	{
+		Level.Head = Order.Next;
+	}
+
+	if (Order.Next != INDEX_NONE)
+	{
+		Orders[Order.Next].Prev = Order.Prev;
+	}
+	else
+	{
+		Level.Tail = Order.Prev;
+	}
+
+	Level.TotalQuantity -= Order.Remaining;
+	Order.Prev = INDEX_NONE;
+	Order.Next = INDEX_NONE;
+
+	if (Level.Head == INDEX_NONE)
+	{
+		Levels.RemoveAt(LevelIndex, 1, EAllowShrinking::No);
+	}
+}
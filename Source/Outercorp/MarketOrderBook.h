@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Order identifier, encodes pool slot and generation (0 is never a valid id) */
+typedef uint64 FMarketOrderId;
+
+/**
+ * Side of a market order
+ */
+enum class EMarketSide : uint8
+{
+	Buy,
+	Sell
+};
+
+/**
+ * Match between an incoming (taker) order and a resting (maker) order
+ */
+struct FMarketFill
+{
+	FMarketOrderId MakerOrder = 0;
+	FMarketOrderId TakerOrder = 0;
+	int32 MakerTrader = INDEX_NONE;
+	int32 TakerTrader = INDEX_NONE;
+	EMarketSide TakerSide = EMarketSide::Buy;
+
+	/** Execution price (the maker's price) */
+	int64 Price = 0;
+
+	/** Price the buyer escrowed at, used to refund price improvement */
+	int64 BuyerLimitPrice = 0;
+
+	int32 Quantity = 0;
+
+	int32 GetBuyer() const { return TakerSide == EMarketSide::Buy ? TakerTrader : MakerTrader; }
+	int32 GetSeller() const { return TakerSide == EMarketSide::Sell ? TakerTrader : MakerTrader; }
+};
+
+/**
+ * Resting order state returned on cancel
+ */
+struct FMarketOrderInfo
+{
+	EMarketSide Side = EMarketSide::Buy;
+	int32 Trader = INDEX_NONE;
+	int64 Price = 0;
+	int32 RemainingQuantity = 0;
+};
+
+/**
+ * Limit order book for a single item type with price-time priority
+ * Orders live in a pooled array and are linked FIFO per price level, so insert, cancel
+ * and fill do not allocate once warm. Price levels are kept sorted with the best price
+ * at the end of each side's array, making best-price access and level removal O(1).
+ */
+class OUTERCORP_API FMarketOrderBook
+{
+public:
+	/** Match an order against the opposite side and rest any remainder, returns its id */
+	FMarketOrderId SubmitOrder(EMarketSide Side, int32 Trader, int64 Price, int32 Quantity, TArray<FMarketFill>& OutFills);
+
+	/** Remove a resting order */
+	bool CancelOrder(FMarketOrderId OrderId, FMarketOrderInfo& OutCancelled);
+
+	/** Remove every resting order, appending what each had left */
+	void CancelAllOrders(TArray<FMarketOrderInfo>& OutCancelled);
+
+	/** Look up a resting order */
+	bool GetOrder(FMarketOrderId OrderId, FMarketOrderInfo& OutInfo) const;
+
+	/** Best price and quantity available on a side */
+	bool GetBestPrice(EMarketSide Side, int64& OutPrice, int32& OutQuantity) const;
+
+	/** Number of resting orders */
+	int32 NumOrders() const { return NumResting; }
+
+private:
+	struct FOrder
+	{
+		int64 Price = 0;
+		int32 Trader = INDEX_NONE;
+		int32 Remaining = 0;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		uint32 Generation = 1;
+		EMarketSide Side = EMarketSide::Buy;
+		bool bResting = false;
+	};
+
+	struct FPriceLevel
+	{
+		int64 Price = 0;
+		int32 Head = INDEX_NONE;
+		int32 Tail = INDEX_NONE;
+		int32 TotalQuantity = 0;
+	};
+
+	static FMarketOrderId MakeOrderId(int32 Index, uint32 Generation);
+	int32 ResolveOrderId(FMarketOrderId OrderId) const;
+
+	int32 AllocateOrder();
+	void ReleaseOrder(int32 OrderIndex);
+
+	TArray<FPriceLevel>& GetLevels(EMarketSide Side) { return Side == EMarketSide::Buy ? Bids : Asks; }
+	const TArray<FPriceLevel>& GetLevels(EMarketSide Side) const { return Side == EMarketSide::Buy ? Bids : Asks; }
+
+	/** Binary search for a price level, returns insertion point if not found */
+	int32 FindLevel(EMarketSide Side, int64 Price, bool& bOutFound) const;
+
+	/** Append a resting order to the back of its price level */
+	void LinkOrder(int32 OrderIndex);
+
+	/** Remove a resting order from its price level, dropping the level if empty */
+	void UnlinkOrder(int32 OrderIndex, int32 LevelIndex);
+
+	TArray<FOrder> Orders;
+	int32 FreeHead = INDEX_NONE;
+	int32 NumResting = 0;
+
+	/** Bids sorted ascending, asks sorted descending, best price last */
+	TArray<FPriceLevel> Bids;
+	TArray<FPriceLevel> Asks;
+};
@@ -0,0 +1,384 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MarketSubsystem.h"
+#include "InventoryComponent.h"
+#include "InventoryHangarSubsystem.h"
+#include "InventorySaveSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Outercorp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Market Submit Order"), STAT_MarketSubmitOrder, STATGROUP_Inventory);
+DECLARE_CYCLE_STAT(TEXT("Market Settle"), STAT_MarketSettle, STATGROUP_Inventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Market Fills Settled"), STAT_MarketFillsSettled, STATGROUP_Inventory);
+
+void UMarketSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UMarketSubsystem::HandlePostActorTick);
+	TearDownHandle = FWorldDelegates::OnWorldBeginTearDown.AddUObject(this, &UMarketSubsystem::HandleWorldBeginTearDown);
+}
+
+void UMarketSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	FWorldDelegates::OnWorldBeginTearDown.Remove(TearDownHandle);
+
+	// Normally done at teardown; the traders' actors have ended play now, so what is left goes through their stores
+	bInventoriesEnded = true;
+	CancelRestingOrders();
+
+	for (const int32 TraderIndex : TradersWithDeliveries)
+	{
+		const FTraderAccount& Account = Traders[TraderIndex];
+		const FString TraderName = Account.PersistenceKey.IsNone() ? GetNameSafe(Account.Inventory.Get()) : Account.PersistenceKey.ToString();
+		UE_LOG(LogOutercorp, Warning, TEXT("Market shut down with %d undelivered stacks for '%s'"), Account.PendingDeliveries.Num(), *TraderName);
+	}
+
+	OrderBooks.Empty();
+	Traders.Empty();
+	TraderLookup.Empty();
+	TraderByKey.Empty();
+	TradersWithDeliveries.Empty();
+
+	Super::Deinitialize();
+}
+
+int64 UMarketSubsystem::PlaceBuyOrder(UInventoryComponent* Trader, UInventoryItemData* ItemData, int32 Quantity, int64 Price)
+{
+	// The escrow, and so every fill and refund of the order, must fit in int64
+	if (!Trader || !ItemData || !ItemData->bIsTradeable || Quantity <= 0 || Price <= 0 || Price > MAX_int64 / Quantity)
+	{
+		return 0;
+	}
+
+	const int32 TraderIndex = FindOrAddTrader(Trader);
+	FTraderAccount& Account = Traders[TraderIndex];
+
+	// Escrow the full limit value up front, price improvement is refunded on settlement
+	const int64 EscrowAmount = Price * Quantity;
+	if (Account.Balance < EscrowAmount)
+	{
+		return 0;
+	}
+	Account.Balance -= EscrowAmount;
+
+	return static_cast<int64>(SubmitOrder(ItemData, EMarketSide::Buy, TraderIndex, Price, Quantity));
+}
+
+int64 UMarketSubsystem::PlaceSellOrder(UInventoryComponent* Trader, UInventoryItemData* ItemData, int32 Quantity, int64 Price)
+{
+	if (!Trader || !ItemData || !ItemData->bIsSellable || !ItemData->bIsTradeable || Quantity <= 0 || Price <= 0 || Price > MAX_int64 / Quantity)
+	{
+		return 0;
+	}
+
+	// Escrow the items out of the seller's inventory
+	if (!Trader->RemoveItems(ItemData, Quantity))
+	{
+		return 0;
+	}
+
+	const int32 TraderIndex = FindOrAddTrader(Trader);
+	return static_cast<int64>(SubmitOrder(ItemData, EMarketSide::Sell, TraderIndex, Price, Quantity));
+}
+
+bool UMarketSubsystem::CancelOrder(UInventoryComponent* Trader, UInventoryItemData* ItemData, int64 OrderId)
+{
+	TUniquePtr<FMarketOrderBook>* Book = OrderBooks.Find(ItemData);
+	const int32 TraderIndex = Trader ? FindTrader(Trader) : INDEX_NONE;
+	if (!Book || TraderIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Only whoever placed the order may cancel it
+	FMarketOrderInfo Order;
+	if (!(*Book)->GetOrder(static_cast<FMarketOrderId>(OrderId), Order) || Order.Trader != TraderIndex)
+	{
+		return false;
+	}
+
+	FMarketOrderInfo Cancelled;
+	if (!(*Book)->CancelOrder(static_cast<FMarketOrderId>(OrderId), Cancelled))
+	{
+		return false;
+	}
+
+	// Returned items go to the component asking, not an earlier one of the same inventory
+	FindOrAddTrader(Trader);
+	RefundOrder(ItemData, Cancelled);
+	return true;
+}
+
+bool UMarketSubsystem::GetBestPrice(UInventoryItemData* ItemData, bool bBuySide, int64& OutPrice, int32& OutQuantity) const
+{
+	OutPrice = 0;
+	OutQuantity = 0;
+
+	const TUniquePtr<FMarketOrderBook>* Book = OrderBooks.Find(ItemData);
+	return Book && (*Book)->GetBestPrice(bBuySide ? EMarketSide::Buy : EMarketSide::Sell, OutPrice, OutQuantity);
+}
+
+void UMarketSubsystem::Deposit(UInventoryComponent* Trader, int64 Amount)
+{
+	if (Trader && Amount > 0)
+	{
+		Traders[FindOrAddTrader(Trader)].Balance += Amount;
+	}
+}
+
+int64 UMarketSubsystem::GetBalance(UInventoryComponent* Trader) const
+{
+	const int32 TraderIndex = FindTrader(Trader);
+	return TraderIndex != INDEX_NONE ? Traders[TraderIndex].Balance : 0;
+}
+
+void UMarketSubsystem::SettlePendingTrades()
+{
+	if (PendingFills.Num() == 0 && TradersWithDeliveries.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_MarketSettle);
+	INC_DWORD_STAT_BY(STAT_MarketFillsSettled, PendingFills.Num());
+
+	TArray<FMarketTrade> Trades;
+	Trades.Reserve(PendingFills.Num());
+
+	for (const FPendingFill& Pending : PendingFills)
+	{
+		const FMarketFill& Fill = Pending.Fill;
+		const int32 Buyer = Fill.GetBuyer();
+		const int32 Seller = Fill.GetSeller();
+
+		// Both within the buyer's escrow, which PlaceBuyOrder checked fits in int64
+		Traders[Seller].Balance += Fill.Price * Fill.Quantity;
+		Traders[Buyer].Balance += (Fill.BuyerLimitPrice - Fill.Price) * Fill.Quantity;
+		QueueDelivery(Buyer, Pending.ItemData, Fill.Quantity);
+
+		FMarketTrade& Trade = Trades.AddDefaulted_GetRef();
+		Trade.ItemData = Pending.ItemData;
+		Trade.Buyer = Traders[Buyer].Inventory;
+		Trade.Seller = Traders[Seller].Inventory;
+		Trade.Price = Fill.Price;
+		Trade.Quantity = Fill.Quantity;
+	}
+	PendingFills.Reset();
+
+	// One bulk insert per receiving inventory
+	TArray<FItemQuantity> Rejected;
+	TArray<int32> StillPending;
+
+	for (int32 TraderIndex : TradersWithDeliveries)
+	{
+		FTraderAccount& Account = Traders[TraderIndex];
+		UInventoryComponent* Inventory = Account.Inventory.Get();
+		if (!Inventory || bInventoriesEnded)
+		{
+			// Paid for, so never dropped
+			if (!DeliverToStoredInventory(Account))
+			{
+				StillPending.Add(TraderIndex);
+			}
+			continue;
+		}
+
+		Inventory->AddItems(Account.PendingDeliveries, Rejected);
+
+		// Keep what did not fit and retry on the next settlement
+		Account.PendingDeliveries = Rejected;
+		if (Rejected.Num() > 0)
+		{
+			UE_LOG(LogOutercorp, Verbose, TEXT("Market delivery to '%s' deferred, %d stacks did not fit"), *GetNameSafe(Inventory), Rejected.Num());
+			StillPending.Add(TraderIndex);
+		}
+	}
+	TradersWithDeliveries = MoveTemp(StillPending);
+
+	if (Trades.Num() > 0)
+	{
+		OnTradesSettled.Broadcast(Trades);
+	}
+}
+
+int32 UMarketSubsystem::FindTrader(const UInventoryComponent* Inventory) const
+{
+	if (!Inventory)
+	{
+		return INDEX_NONE;
+	}
+
+	if (const int32* Existing = TraderLookup.Find(Inventory))
+	{
+		return *Existing;
+	}
+
+	const int32* ByKey = Inventory->PersistenceKey.IsNone() ? nullptr : TraderByKey.Find(Inventory->PersistenceKey);
+	return ByKey ? *ByKey : INDEX_NONE;
+}
+
+int32 UMarketSubsystem::FindOrAddTrader(UInventoryComponent* Inventory)
+{
+	int32 TraderIndex = FindTrader(Inventory);
+	if (TraderIndex == INDEX_NONE)
+	{
+		TraderIndex = Traders.AddDefaulted();
+		Traders[TraderIndex].PersistenceKey = Inventory->PersistenceKey;
+		if (!Inventory->PersistenceKey.IsNone())
+		{
+			TraderByKey.Add(Inventory->PersistenceKey, TraderIndex);
+		}
+	}
+
+	// A new component of the same saved inventory takes the account over, pending deliveries included
+	FTraderAccount& Account = Traders[TraderIndex];
+	if (Account.Inventory.Get() != Inventory)
+	{
+		Account.Inventory = Inventory;
+		Account.bHangar = Inventory->Storage == EInventoryStorage::Hangar;
+		TraderLookup.Add(Inventory, TraderIndex);
+	}
+
+	return TraderIndex;
+}
+
+FMarketOrderBook& UMarketSubsystem::FindOrAddBook(UInventoryItemData* ItemData)
+{
+	TUniquePtr<FMarketOrderBook>& Book = OrderBooks.FindOrAdd(ItemData);
+	if (!Book)
+	{
+		Book = MakeUnique<FMarketOrderBook>();
+		TradedItemTypes.Add(ItemData);
+	}
+	return *Book;
+}
+
+FMarketOrderId UMarketSubsystem::SubmitOrder(UInventoryItemData* ItemData, EMarketSide Side, int32 Trader, int64 Price, int32 Quantity)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MarketSubmitOrder);
+
+	FillScratch.Reset();
+	const FMarketOrderId OrderId = FindOrAddBook(ItemData).SubmitOrder(Side, Trader, Price, Quantity, FillScratch);
+
+	for (const FMarketFill& Fill : FillScratch)
+	{
+		FPendingFill& Pending = PendingFills.AddDefaulted_GetRef();
+		Pending.Fill = Fill;
+		Pending.ItemData = ItemData;
+	}
+
+	return OrderId;
+}
+
+void UMarketSubsystem::RefundOrder(UInventoryItemData* ItemData, const FMarketOrderInfo& Cancelled)
+{
+	if (Cancelled.Side == EMarketSide::Buy)
+	{
+		// At most the escrow taken when the order was placed
+		Traders[Cancelled.Trader].Balance += Cancelled.Price * Cancelled.RemainingQuantity;
+	}
+	else
+	{
+		QueueDelivery(Cancelled.Trader, ItemData, Cancelled.RemainingQuantity);
+	}
+}
+
+void UMarketSubsystem::QueueDelivery(int32 Trader, UInventoryItemData* ItemData, int32 Quantity)
+{
+	FTraderAccount& Account = Traders[Trader];
+	if (Account.PendingDeliveries.Num() == 0)
+	{
+		TradersWithDeliveries.Add(Trader);
+	}
+
+	FItemQuantity* Existing = Account.PendingDeliveries.FindByPredicate([ItemData](const FItemQuantity& Delivery)
+	{
+		return Delivery.ItemData == ItemData;
+	});
+
+	if (Existing)
+	{
+		Existing->Quantity += Quantity;
+	}
+	else
+	{
+		Account.PendingDeliveries.Emplace(ItemData, Quantity);
+	}
+}
+
+bool UMarketSubsystem::DeliverToStoredInventory(FTraderAccount& Account)
+{
+	const UGameInstance* GameInstance = GetWorld()->GetGameInstance();
+	if (!GameInstance || Account.PersistenceKey.IsNone())
+	{
+		return false;
+	}
+
+	// A saved inventory that ended play no longer journals changes, it is saved with the items instead
+	UInventoryComponent* Inventory = Account.Inventory.Get();
+	if (!Account.bHangar)
+	{
+		UInventorySaveSubsystem* Saves = GameInstance->GetSubsystem<UInventorySaveSubsystem>();
+		TArray<FItemQuantity> Rejected;
+		if (!Inventory || !Saves || !Saves->DeliverItems(Inventory, Account.PendingDeliveries, Rejected))
+		{
+			return false;
+		}
+
+		Account.PendingDeliveries = MoveTemp(Rejected);
+		return Account.PendingDeliveries.Num() == 0;
+	}
+
+	UInventoryHangarSubsystem* Hangars = GameInstance->GetSubsystem<UInventoryHangarSubsystem>();
+	if (!Hangars)
+	{
+		return false;
+	}
+
+	// Without a database the deliveries stay pending
+	if (!Hangars->DeliverItems(Account.PersistenceKey, Account.PendingDeliveries))
+	{
+		return false;
+	}
+
+	Account.PendingDeliveries.Reset();
+	return true;
+}
+
+void UMarketSubsystem::CancelRestingOrders()
+{
+	SettlePendingTrades();
+
+	// Escrow went out of inventories and wallets when the orders were placed, hand it back
+	TArray<FMarketOrderInfo> Cancelled;
+	for (UInventoryItemData* ItemData : TradedItemTypes)
+	{
+		Cancelled.Reset();
+		OrderBooks.FindChecked(ItemData)->CancelAllOrders(Cancelled);
+		for (const FMarketOrderInfo& Order : Cancelled)
+		{
+			RefundOrder(ItemData, Order);
+		}
+	}
+	SettlePendingTrades();
+}
+
+void UMarketSubsystem::HandlePostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		SettlePendingTrades();
+	}
+}
+
+void UMarketSubsystem::HandleWorldBeginTearDown(UWorld* World)
+{
+	// Actors have not ended play yet, so inventories still journal and save what they are given
+	if (World == GetWorld())
+	{
+		CancelRestingOrders();
+	}
+}
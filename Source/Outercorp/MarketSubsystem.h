@@ -0,0 +1,170 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "MarketOrderBook.h"
+#include "InventoryItemData.h"
+#include "MarketSubsystem.generated.h"
+
+class UInventoryComponent;
+
+/**
+ * Trade settled by the market
+ */
+USTRUCT(BlueprintType)
+struct FMarketTrade
+{
+	GENERATED_BODY()
+
+	/** Item type traded */
+	UPROPERTY(BlueprintReadOnly, Category = "Market")
+	TObjectPtr<UInventoryItemData> ItemData;
+
+	/** Buyer's inventory */
+	UPROPERTY(BlueprintReadOnly, Category = "Market")
+	TWeakObjectPtr<UInventoryComponent> Buyer;
+
+	/** Seller's inventory */
+	UPROPERTY(BlueprintReadOnly, Category = "Market")
+	TWeakObjectPtr<UInventoryComponent> Seller;
+
+	/** Price per unit */
+	UPROPERTY(BlueprintReadOnly, Category = "Market")
+	int64 Price = 0;
+
+	/** Units traded */
+	UPROPERTY(BlueprintReadOnly, Category = "Market")
+	int32 Quantity = 0;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnMarketTradesSettled, const TArray<FMarketTrade>&, Trades);
+
+/**
+ * Regional market with one price-time priority order book per item type
+ * Sell orders escrow items out of the seller's inventory and buy orders escrow currency
+ * from the buyer's wallet when placed. Matching happens immediately, settlement is batched
+ * at the end of the frame: each buyer inventory receives its items through one AddItems call.
+ * Traders are identified by their (hangar) inventory's PersistenceKey, or by the component when
+ * it has none: a new component for the same saved inventory, as after a relog, keeps the balance,
+ * resting orders and deliveries. Resting orders are cancelled and refunded when the world begins
+ * tearing down, while the traders' inventories still journal and save what they are given.
+ */
+UCLASS()
+class OUTERCORP_API UMarketSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Called after each end-of-frame settlement with every trade settled */
+	UPROPERTY(BlueprintAssignable, Category = "Market")
+	FOnMarketTradesSettled OnTradesSettled;
+
+	/** Place a buy order, escrowing Price * Quantity from the trader's wallet. Returns order id (0 on failure, including when the escrow would overflow) */
+	UFUNCTION(BlueprintCallable, Category = "Market")
+	int64 PlaceBuyOrder(UInventoryComponent* Trader, UInventoryItemData* ItemData, int32 Quantity, int64 Price);
+
+	/** Place a sell order, escrowing the items from the trader's inventory. Returns order id (0 on failure) */
+	UFUNCTION(BlueprintCallable, Category = "Market")
+	int64 PlaceSellOrder(UInventoryComponent* Trader, UInventoryItemData* ItemData, int32 Quantity, int64 Price);
+
+	/** Cancel a resting order of the trader's and return its escrow. Fails for orders placed by someone else */
+	UFUNCTION(BlueprintCallable, Category = "Market")
+	bool CancelOrder(UInventoryComponent* Trader, UInventoryItemData* ItemData, int64 OrderId);
+
+	/** Best bid/ask for an item type */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Market")
+	bool GetBestPrice(UInventoryItemData* ItemData, bool bBuySide, int64& OutPrice, int32& OutQuantity) const;
+
+	/** Add currency to a trader's wallet */
+	UFUNCTION(BlueprintCallable, Category = "Market")
+	void Deposit(UInventoryComponent* Trader, int64 Amount);
+
+	/** Currency available (not in escrow) */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Market")
+	int64 GetBalance(UInventoryComponent* Trader) const;
+
+	/** Settle all pending fills now (normally done at the end of each frame) */
+	void SettlePendingTrades();
+
+protected:
+	struct FTraderAccount
+	{
+		TWeakObjectPtr<UInventoryComponent> Inventory;
+		int64 Balance = 0;
+
+		/** Inventory's PersistenceKey: the account moves to the next component with it, and deliveries can still reach it while there is none */
+		FName PersistenceKey;
+
+		/** Inventory is kept in the hangar database */
+		bool bHangar = false;
+
+		/** Items waiting to be delivered (bought, or returned from cancelled sell orders) */
+		TArray<FItemQuantity> PendingDeliveries;
+	};
+
+	struct FPendingFill
+	{
+		FMarketFill Fill;
+		UInventoryItemData* ItemData = nullptr;
+	};
+
+	/** Account of an inventory, by component or else by PersistenceKey. INDEX_NONE if it never traded */
+	int32 FindTrader(const UInventoryComponent* Inventory) const;
+
+	/** Account of an inventory, created on first use and moved over to a new component with the same PersistenceKey */
+	int32 FindOrAddTrader(UInventoryComponent* Inventory);
+
+	FMarketOrderBook& FindOrAddBook(UInventoryItemData* ItemData);
+
+	/** Match an order and queue its fills for settlement */
+	FMarketOrderId SubmitOrder(UInventoryItemData* ItemData, EMarketSide Side, int32 Trader, int64 Price, int32 Quantity);
+
+	/** Return the escrow of a cancelled order: currency to the balance, items as a delivery */
+	void RefundOrder(UInventoryItemData* ItemData, const FMarketOrderInfo& Cancelled);
+
+	/** Queue items for delivery to a trader */
+	void QueueDelivery(int32 Trader, UInventoryItemData* ItemData, int32 Quantity);
+
+	/**
+	 * Deliver to a trader whose inventory is gone or has ended play: hangars take them in their database,
+	 * saved inventories are saved with them, anything else stays queued for the next inventory with the
+	 * same PersistenceKey. False if still queued
+	 */
+	bool DeliverToStoredInventory(FTraderAccount& Account);
+
+	/** Cancel every resting order, return its escrow and settle */
+	void CancelRestingOrders();
+
+	void HandlePostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void HandleWorldBeginTearDown(UWorld* World);
+
+	/** Item types with a book, keeps the data assets referenced */
+	UPROPERTY()
+	TArray<TObjectPtr<UInventoryItemData>> TradedItemTypes;
+
+private:
+	TMap<const UInventoryItemData*, TUniquePtr<FMarketOrderBook>> OrderBooks;
+
+	TArray<FTraderAccount> Traders;
+	TMap<TObjectKey<UInventoryComponent>, int32> TraderLookup;
+	TMap<FName, int32> TraderByKey;
+
+	TArray<FPendingFill> PendingFills;
+	TArray<int32> TradersWithDeliveries;
+
+	/** Scratch buffer for fills of the order being matched */
+	TArray<FMarketFill> FillScratch;
+
+	/** Set in Deinitialize: inventories no longer store changes themselves, deliveries go through their stores */
+	bool bInventoriesEnded = false;
+
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle TearDownHandle;
+};
@@ -14,6 +14,7 @@ public class Outercorp : ModuleRules
 			"Engine",
 			"InputCore",
 			"EnhancedInput",
+			"NetCore",
 			"AIModule",
 			"StateTreeModule",
 			"GameplayStateTreeModule",
@@ -22,7 +23,11 @@ public class Outercorp : ModuleRules
 			"SlateCore"
 		});
 
-		PrivateDependencyModuleNames.AddRange(new string[] { });
+		PrivateDependencyModuleNames.AddRange(new string[] {
+			"AssetRegistry",
+			"ImageCore",
+			"SQLiteCore"
+		});
 
 		PublicIncludePaths.AddRange(new string[] {
 			"Outercorp",
@@ -3,6 +3,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 /** Main log category used across the project */
-DECLARE_LOG_CATEGORY_EXTERN(LogOutercorp, Log, All);
\ No newline at end of file
+DECLARE_LOG_CATEGORY_EXTERN(LogOutercorp, Log, All);
+
+/** Stat group for inventory and item services (use "stat Inventory") */
+DECLARE_STATS_GROUP(TEXT("Inventory"), STATGROUP_Inventory, STATCAT_Advanced);
\ No newline at end of file
@@ -60,9 +60,30 @@ void AOutercorpCharacter::BeginPlay()
 		CrosshairWidget = CreateWidget<UUserWidget>(GetWorld(), CrosshairWidgetClass);
 		if (CrosshairWidget)
 		{
+			// The crosshair never takes input, keep it out of hit testing (UOutercorpHUDWidget subclasses also do this themselves)
+			CrosshairWidget->SetVisibility(ESlateVisibility::HitTestInvisible);
 			CrosshairWidget->AddToViewport();
 		}
 	}
+
+	// Build the inventory window up front so the first open does not hitch
+	if (IsLocallyControlled())
+	{
+		EnsureInventoryWidget();
+	}
+}
+
+void AOutercorpCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Removing the window destructs it, which unbinds it from the inventory component
+	if (InventoryWidget)
+	{
+		InventoryWidget->OnInventoryClosed.RemoveAll(this);
+		InventoryWidget->RemoveFromParent();
+		InventoryWidget = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AOutercorpCharacter::SetupPlayerInputComponent(UInputComponent *PlayerInputComponent)
@@ -148,37 +169,51 @@ void AOutercorpCharacter::ToggleInventory()
 	}
 
 	// If inventory is open, close it
-	if (InventoryWidget && InventoryWidget->IsInViewport())
+	if (InventoryWidget && InventoryWidget->IsOpen())
 	{
 		InventoryWidget->CloseInventory();
+		return;
 	}
-	else
+
+	// The window is kept alive between opens, only its visibility changes
+	EnsureInventoryWidget();
+	if (!InventoryWidget)
 	{
-		// Always recreate the widget to avoid delegate issues
-		if (InventoryWidgetClass && InventoryComponent)
-		{
-			InventoryWidget = CreateWidget<UInventoryWidget>(GetWorld(), InventoryWidgetClass);
-			if (InventoryWidget)
-			{
-				// Bind to close event
-				InventoryWidget->OnInventoryClosed.AddDynamic(this, &AOutercorpCharacter::OnInventoryWidgetClosed);
-
-				InventoryWidget->InitializeInventory(InventoryComponent);
-				InventoryWidget->AddToViewport(1);
-
-				// Set input mode to UI only - blocks all game input
-				if (APlayerController *PC = Cast<APlayerController>(GetController()))
-				{
-					FInputModeUIOnly InputMode;
-					InputMode.SetLockMouseToViewportBehavior(EMouseLockMode::DoNotLock);
-					PC->SetInputMode(InputMode);
-					PC->SetShowMouseCursor(true);
-				}
-
-				// Set focus to the widget after adding to viewport
-				InventoryWidget->SetKeyboardFocus();
-			}
-		}
+		return;
+	}
+
+	InventoryWidget->OpenInventory();
+
+	// Set input mode to UI only - blocks all game input
+	if (APlayerController *PC = Cast<APlayerController>(GetController()))
+	{
+		FInputModeUIOnly InputMode;
+		InputMode.SetLockMouseToViewportBehavior(EMouseLockMode::DoNotLock);
+		PC->SetInputMode(InputMode);
+		PC->SetShowMouseCursor(true);
+	}
+
+	// Set focus to the widget after it is visible
+	InventoryWidget->SetKeyboardFocus();
+}
+
+void AOutercorpCharacter::EnsureInventoryWidget()
+{
+	if (InventoryWidget || !InventoryWidgetClass || !InventoryComponent)
+	{
+		return;
+	}
+
+	InventoryWidget = CreateWidget<UInventoryWidget>(GetWorld(), InventoryWidgetClass);
+	if (InventoryWidget)
+	{
+		// Bind to close event
+		InventoryWidget->OnInventoryClosed.AddDynamic(this, &AOutercorpCharacter::OnInventoryWidgetClosed);
+
+		// Start hidden, ToggleInventory makes it visible
+		InventoryWidget->SetVisibility(ESlateVisibility::Collapsed);
+		InventoryWidget->InitializeInventory(InventoryComponent);
+		InventoryWidget->AddToViewport(1);
 	}
 }
 
@@ -48,7 +48,7 @@ class AOutercorpCharacter : public ACharacter
 
 protected:
 
-	/** Crosshair widget class */
+	/** Crosshair widget class (derive from UOutercorpHUDWidget so it is cached and does not tick) */
 	UPROPERTY(EditDefaultsOnly, Category="UI")
 	TSubclassOf<UUserWidget> CrosshairWidgetClass;
 
@@ -81,6 +81,7 @@ public:
 
 	/** Called when the game starts or when spawned */
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 protected:
 
@@ -114,6 +115,9 @@ protected:
 	UFUNCTION()
 	void OnInventoryWidgetClosed();
 
+	/** Create the inventory window once, it is shown and hidden afterwards */
+	void EnsureInventoryWidget();
+
 protected:
 
 	/** Set up input action bindings */
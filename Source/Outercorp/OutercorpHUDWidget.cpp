@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "OutercorpHUDWidget.h"
+#include "Components/InvalidationBox.h"
+#include "Components/RetainerBox.h"
+
+void UOutercorpHUDWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	// The HUD is drawn over the game, keeping it out of hit testing also keeps it out of the hit test grid
+	SetVisibility(ESlateVisibility::HitTestInvisible);
+
+	if (StaticContent)
+	{
+		StaticContent->SetCanCache(true);
+	}
+
+	if (RetainedContent)
+	{
+		RetainedContent->SetRetainRendering(true);
+		RetainedContent->RequestRender();
+	}
+}
+
+void UOutercorpHUDWidget::RequestRetainedRedraw()
+{
+	if (RetainedContent)
+	{
+		RetainedContent->RequestRender();
+	}
+}
@@ -0,0 +1,39 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "OutercorpHUDWidget.generated.h"
+
+class UInvalidationBox;
+class URetainerBox;
+
+/**
+ * Base class for always-on HUD layers such as the crosshair
+ * The HUD never takes input and does not tick. Anything that changes rarely goes inside
+ * StaticContent (cached, repainted only when one of its widgets is invalidated) or
+ * RetainedContent (rendered to a texture and redrawn on demand). Widgets that change
+ * every frame, e.g. animated hit markers, belong outside both so they don't dirty the cache.
+ */
+UCLASS(Abstract, meta = (DisableNativeTick))
+class OUTERCORP_API UOutercorpHUDWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void NativeConstruct() override;
+
+	/** Cached layer for content that rarely changes */
+	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
+	TObjectPtr<UInvalidationBox> StaticContent;
+
+	/** Render-target layer for content that is expensive to paint but rarely changes (enable Render On Invalidation and disable Render On Phase in the designer) */
+	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
+	TObjectPtr<URetainerBox> RetainedContent;
+
+public:
+	/** Redraw RetainedContent on the next frame, after changing something inside it */
+	UFUNCTION(BlueprintCallable, Category = "HUD")
+	void RequestRetainedRedraw();
+};
@@ -6,6 +6,8 @@
 #include "Engine/LocalPlayer.h"
 #include "InputMappingContext.h"
 #include "OutercorpCameraManager.h"
+#include "InventoryComponent.h"
+#include "InventoryPredictionComponent.h"
 #include "Blueprint/UserWidget.h"
 #include "Outercorp.h"
 #include "Widgets/Input/SVirtualJoystick.h"
@@ -14,6 +16,8 @@ AOutercorpPlayerController::AOutercorpPlayerController()
 {
 	// set the player camera manager class
 	PlayerCameraManagerClass = AOutercorpCameraManager::StaticClass();
+
+	InventoryPrediction = CreateDefaultSubobject<UInventoryPredictionComponent>(TEXT("InventoryPrediction"));
 }
 
 void AOutercorpPlayerController::BeginPlay()
@@ -74,3 +78,57 @@ bool AOutercorpPlayerController::ShouldUseTouchControls() const
 	// are we on a mobile platform? Should we force touch?
 	return SVirtualJoystick::ShouldDisplayTouchInterface() || bForceTouchControls;
 }
+
+void AOutercorpPlayerController::ServerObserveInventory_Implementation(UInventoryComponent* Inventory, bool bObserve)
+{
+	if (!Inventory)
+	{
+		return;
+	}
+
+	if (!bObserve)
+	{
+		Inventory->ReleaseContents(this);
+		return;
+	}
+
+	// Clients can name any inventory, only send what this player could have opened
+	if (!Inventory->CanBeOpenedBy(this))
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("%s asked for the contents of %s, which it can't open"), *GetName(), *GetPathNameSafe(Inventory));
+		return;
+	}
+
+	// Loads hangars, then subscribes this player
+	Inventory->RequestContents(this);
+}
+
+void AOutercorpPlayerController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	UpdateInventoryOwners(InPawn);
+}
+
+void AOutercorpPlayerController::OnUnPossess()
+{
+	APawn* PreviousPawn = GetPawn();
+
+	Super::OnUnPossess();
+
+	UpdateInventoryOwners(PreviousPawn);
+}
+
+void AOutercorpPlayerController::UpdateInventoryOwners(AActor* Actor)
+{
+	if (!Actor)
+	{
+		return;
+	}
+
+	TInlineComponentArray<UInventoryComponent*> Inventories(Actor);
+	for (UInventoryComponent* Inventory : Inventories)
+	{
+		Inventory->UpdateOwnerObserver();
+	}
+}
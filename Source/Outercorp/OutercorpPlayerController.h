@@ -8,6 +8,8 @@
 
 class UInputMappingContext;
 class UUserWidget;
+class UInventoryComponent;
+class UInventoryPredictionComponent;
 
 /**
  *  Simple first person Player Controller
@@ -24,8 +26,16 @@ public:
 	/** Constructor */
 	AOutercorpPlayerController();
 
+	/** Start or stop receiving an inventory's contents, sent when its window opens or closes */
+	UFUNCTION(Server, Reliable)
+	void ServerObserveInventory(UInventoryComponent* Inventory, bool bObserve);
+
 protected:
 
+	/** Predicts this player's inventory drag-drop operations */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Inventory")
+	TObjectPtr<UInventoryPredictionComponent> InventoryPrediction;
+
 	/** Input Mapping Contexts */
 	UPROPERTY(EditAnywhere, Category="Input|Input Mappings")
 	TArray<UInputMappingContext*> DefaultMappingContexts;
@@ -52,6 +62,13 @@ protected:
 	/** Input mapping context setup */
 	virtual void SetupInputComponent() override;
 
+	/** The possessed pawn's inventories replicate to this player */
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+
+	/** Let the inventories of an actor re-evaluate who owns them */
+	static void UpdateInventoryOwners(AActor* Actor);
+
 	/** Returns true if the player should use UMG touch controls */
 	bool ShouldUseTouchControls() const;
 };
@@ -0,0 +1,230 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "StatModifierGraph.h"
+#include "Outercorp.h"
+
+FStatModifierGraph::FStatModifierGraph()
+{
+}
+
+void FStatModifierGraph::SetBaseValue(FName Stat, float Value)
+{
+	const int32 StatIndex = FindOrAddStat(Stat);
+	if (Stats[StatIndex].BaseValue != Value)
+	{
+		Stats[StatIndex].BaseValue = Value;
+		MarkDirty(StatIndex);
+	}
+}
+
+FStatModifierHandle FStatModifierGraph::AddModifier(const FItemStatModifier& Modifier)
+{
+	FStatModifierHandle Handle;
+	if (Modifier.Stat.IsNone())
+	{
+		return Handle;
+	}
+
+	const int32 TargetStat = FindOrAddStat(Modifier.Stat);
+	const int32 SourceStat = Modifier.SourceStat.IsNone() ? INDEX_NONE : FindOrAddStat(Modifier.SourceStat);
+
+	int32 ModifierIndex = FreeModifier;
+	if (ModifierIndex != INDEX_NONE)
+	{
+		FreeModifier = Modifiers[ModifierIndex].NextFree;
+	}
+	else
+	{
+		ModifierIndex = Modifiers.AddDefaulted();
+	}
+
+	FModifier& Entry = Modifiers[ModifierIndex];
+	Entry.TargetStat = TargetStat;
+	Entry.SourceStat = SourceStat;
+	Entry.Op = Modifier.Op;
+	Entry.Value = Modifier.Value;
+	Entry.bActive = true;
+	Entry.NextFree = INDEX_NONE;
+
+	Stats[TargetStat].Modifiers.Add(ModifierIndex);
+	if (SourceStat != INDEX_NONE)
+	{
+		Stats[SourceStat].Dependents.Add(TargetStat);
+	}
+
+	MarkDirty(TargetStat);
+
+	Handle.Index = ModifierIndex;
+	Handle.Generation = Entry.Generation;
+	return Handle;
+}
+
+void FStatModifierGraph::RemoveModifier(FStatModifierHandle& Handle)
+{
+	if (!Modifiers.IsValidIndex(Handle.Index))
+	{
+		Handle.Invalidate();
+		return;
+	}
+
+	FModifier& Entry = Modifiers[Handle.Index];
+	if (!Entry.bActive || Entry.Generation != Handle.Generation)
+	{
+		Handle.Invalidate();
+		return;
+	}
+
+	Stats[Entry.TargetStat].Modifiers.RemoveSingleSwap(Handle.Index, EAllowShrinking::No);
+	if (Entry.SourceStat != INDEX_NONE)
+	{
+		Stats[Entry.SourceStat].Dependents.RemoveSingleSwap(Entry.TargetStat, EAllowShrinking::No);
+	}
+
+	MarkDirty(Entry.TargetStat);
+
+	Entry.bActive = false;
+	++Entry.Generation;
+	Entry.NextFree = FreeModifier;
+	FreeModifier = Handle.Index;
+
+	Handle.Invalidate();
+}
+
+float FStatModifierGraph::GetValue(FName Stat)
+{
+	const int32* StatIndex = StatLookup.Find(Stat);
+	return StatIndex ? EvaluateStat(*StatIndex) : 0.0f;
+}
+
+void FStatModifierGraph::Evaluate(TArray<FName>* OutChangedStats)
+{
+	for (int32 StatIndex : PendingStats)
+	{
+		FStat& Stat = Stats[StatIndex];
+		EvaluateStat(StatIndex);
+
+		if (OutChangedStats && Stat.Value != Stat.ReportedValue)
+		{
+			OutChangedStats->Add(Stat.Name);
+		}
+
+		Stat.bPendingReport = false;
+	}
+
+	PendingStats.Reset();
+}
+
+float FStatModifierGraph::GetStackingPenalty(int32 StackIndex)
+{
+	// exp(-(n / 2.67)^2), precomputed; modules past the 8th contribute practically nothing
+	static const float Penalties[] = { 1.0f, 0.869f, 0.571f, 0.283f, 0.106f, 0.03f, 0.006f, 0.001f };
+	return StackIndex < UE_ARRAY_COUNT(Penalties) ? Penalties[StackIndex] : 0.0f;
+}
+
+int32 FStatModifierGraph::FindOrAddStat(FName Stat)
+{
+	if (const int32* Existing = StatLookup.Find(Stat))
+	{
+		return *Existing;
+	}
+
+	const int32 StatIndex = Stats.AddDefaulted();
+	Stats[StatIndex].Name = Stat;
+	Stats[StatIndex].bPendingReport = true;
+	StatLookup.Add(Stat, StatIndex);
+	PendingStats.Add(StatIndex);
+	return StatIndex;
+}
+
+void FStatModifierGraph::MarkDirty(int32 StatIndex)
+{
+	TArray<int32, TInlineAllocator<16>> Stack;
+	Stack.Add(StatIndex);
+
+	while (Stack.Num() > 0)
+	{
+		const int32 Current = Stack.Pop(EAllowShrinking::No);
+		FStat& Stat = Stats[Current];
+
+		if (!Stat.bPendingReport)
+		{
+			Stat.bPendingReport = true;
+			Stat.ReportedValue = Stat.Value;
+			PendingStats.Add(Current);
+		}
+
+		// A dirty stat's dependents are already dirty, so propagation stops here
+		if (Stat.bDirty && Current != StatIndex)
+		{
+			continue;
+		}
+
+		Stat.bDirty = true;
+		Stack.Append(Stat.Dependents);
+	}
+}
+
+float FStatModifierGraph::EvaluateStat(int32 StatIndex)
+{
+	FStat& Stat = Stats[StatIndex];
+	if (!Stat.bDirty)
+	{
+		return Stat.Value;
+	}
+
+	if (Stat.bEvaluating)
+	{
+		UE_LOG(LogOutercorp, Warning, TEXT("Stat modifier cycle detected on '%s'"), *Stat.Name.ToString());
+		return Stat.Value;
+	}
+
+	Stat.bEvaluating = true;
+
+	float Additive = 0.0f;
+	float Multiplier = 1.0f;
+	TArray<float, TInlineAllocator<8>> Bonuses;
+	TArray<float, TInlineAllocator<8>> Penalties;
+
+	for (int32 ModifierIndex : Stat.Modifiers)
+	{
+		const FModifier& Modifier = Modifiers[ModifierIndex];
+
+		float Value = Modifier.Value;
+		if (Modifier.SourceStat != INDEX_NONE)
+		{
+			Value *= EvaluateStat(Modifier.SourceStat);
+		}
+
+		switch (Modifier.Op)
+		{
+			case EStatModifierOp::Additive:
+				Additive += Value;
+				break;
+			case EStatModifierOp::Multiplicative:
+				Multiplier *= Value;
+				break;
+			case EStatModifierOp::StackingPenalized:
+				(Value >= 0.0f ? Bonuses : Penalties).Add(Value);
+				break;
+		}
+	}
+
+	// Strongest modifiers apply first; bonuses and penalties are penalized separately
+	Bonuses.Sort([](float A, float B) { return A > B; });
+	Penalties.Sort([](float A, float B) { return A < B; });
+
+	for (int32 i = 0; i < Bonuses.Num(); ++i)
+	{
+		Multiplier *= 1.0f + Bonuses[i] * GetStackingPenalty(i);
+	}
+	for (int32 i = 0; i < Penalties.Num(); ++i)
+	{
+		Multiplier *= 1.0f + Penalties[i] * GetStackingPenalty(i);
+	}
+
+	Stat.Value = (Stat.BaseValue + Additive) * Multiplier;
+	Stat.bDirty = false;
+	Stat.bEvaluating = false;
+
+	return Stat.Value;
+}
@@ -0,0 +1,99 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryItemData.h"
+
+/**
+ * Handle to a modifier registered in a FStatModifierGraph
+ */
+struct FStatModifierHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Generation = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; Generation = 0; }
+};
+
+/**
+ * Dependency graph of stats and the modifiers applied to them
+ * Final value = (Base + sum(Additive)) * product(Multiplicative) * stacking penalized bonuses.
+ * A modifier with a SourceStat scales its value by that stat, which makes the target
+ * depend on the source. Changing a base value or modifier only dirties the affected stat
+ * and its dependents; values are recomputed lazily on read or in one pass by Evaluate.
+ */
+class OUTERCORP_API FStatModifierGraph
+{
+public:
+	FStatModifierGraph();
+
+	/** Set the unmodified value of a stat */
+	void SetBaseValue(FName Stat, float Value);
+
+	/** Register a modifier, dirtying its target stat */
+	FStatModifierHandle AddModifier(const FItemStatModifier& Modifier);
+
+	/** Unregister a modifier, dirtying its target stat */
+	void RemoveModifier(FStatModifierHandle& Handle);
+
+	/** Final value of a stat, recomputing it (and its sources) if dirty */
+	float GetValue(FName Stat);
+
+	/** Check if any stat changed since the last Evaluate */
+	bool HasPendingChanges() const { return PendingStats.Num() > 0; }
+
+	/** Recompute every dirty stat, optionally returning the stats whose value changed */
+	void Evaluate(TArray<FName>* OutChangedStats = nullptr);
+
+	/** Number of known stats */
+	int32 NumStats() const { return Stats.Num(); }
+
+	/** Effectiveness of the Nth strongest stacking penalized modifier (Eve Online curve) */
+	static float GetStackingPenalty(int32 StackIndex);
+
+private:
+	struct FStat
+	{
+		FName Name;
+		float BaseValue = 0.0f;
+		float Value = 0.0f;
+		float ReportedValue = 0.0f;
+		bool bDirty = true;
+		bool bPendingReport = false;
+		bool bEvaluating = false;
+
+		/** Modifiers targeting this stat */
+		TArray<int32> Modifiers;
+
+		/** Stats that have a modifier sourced from this stat (one entry per modifier) */
+		TArray<int32> Dependents;
+	};
+
+	struct FModifier
+	{
+		int32 TargetStat = INDEX_NONE;
+		int32 SourceStat = INDEX_NONE;
+		EStatModifierOp Op = EStatModifierOp::Additive;
+		float Value = 0.0f;
+		uint32 Generation = 1;
+		bool bActive = false;
+		int32 NextFree = INDEX_NONE;
+	};
+
+	int32 FindOrAddStat(FName Stat);
+
+	/** Flag a stat and everything depending on it as dirty */
+	void MarkDirty(int32 StatIndex);
+
+	float EvaluateStat(int32 StatIndex);
+
+	TArray<FStat> Stats;
+	TMap<FName, int32> StatLookup;
+	TArray<FModifier> Modifiers;
+	int32 FreeModifier = INDEX_NONE;
+
+	/** Stats dirtied since the last Evaluate */
+	TArray<int32> PendingStats;
+};
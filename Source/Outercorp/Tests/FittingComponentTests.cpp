@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "FittingComponent.h"
+#include "InventoryItemData.h"
+#include "OutercorpTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	UInventoryItemData* MakeModule(const TCHAR* ItemID, EFittingSlotType Slot)
+	{
+		UInventoryItemData* Item = NewObject<UInventoryItemData>(GetTransientPackage());
+		Item->ItemID = ItemID;
+		Item->FittingSlot = Slot;
+		Item->MaxStackSize = 10;
+		return Item;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFittingSlotQuantityTest, "Outercorp.Fitting.OneModulePerSlot",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFittingSlotQuantityTest::RunTest(const FString& Parameters)
+{
+	FOutercorpTestWorld TestWorld;
+
+	UInventoryItemData* Turret = MakeModule(TEXT("Turret"), EFittingSlotType::High);
+
+	UFittingComponent* Fitting = NewObject<UFittingComponent>(TestWorld.Get());
+	Fitting->SlotLayout = {EFittingSlotType::High, EFittingSlotType::High, EFittingSlotType::Low};
+	Fitting->SetMaxSlots(Fitting->SlotLayout.Num());
+
+	UInventoryComponent* Cargo = NewObject<UInventoryComponent>(TestWorld.Get());
+	Cargo->SetMaxSlots(4);
+	int32 Slot = INDEX_NONE;
+	Cargo->AddItem(Turret, 10, Slot);
+
+	TestFalse(TEXT("Three turrets don't fit two high slots"), Fitting->AddItem(Turret, 3, Slot));
+	TestTrue(TEXT("One turret fits"), Fitting->AddItem(Turret, 1, Slot));
+	TestEqual(TEXT("Added as a single module"), Fitting->GetItemAtSlot(Slot).Quantity, 1);
+
+	// Neither stacking onto the fitted turret nor a transfer of a whole stack fits more than one per slot
+	TArray<FItemQuantity> Rejected;
+	Fitting->AddItems({FItemQuantity(Turret, 5)}, Rejected);
+	TestEqual(TEXT("Bulk add fills the free high slot with one"), Fitting->GetItemCount(Turret), 2);
+	TestEqual(TEXT("The rest is rejected"), Rejected.Num() > 0 ? Rejected[0].Quantity : 0, 4);
+
+	Fitting->RemoveItemAtSlot(1);
+	TestTrue(TEXT("Transfer into a free slot"), Cargo->TransferItem(0, Fitting, 1));
+	TestEqual(TEXT("Only one module moved"), Fitting->GetItemAtSlot(1).Quantity, 1);
+	TestEqual(TEXT("The rest stays in cargo"), Cargo->GetItemCount(Turret), 9);
+
+	TestFalse(TEXT("Transfer onto a fitted module is refused"), Cargo->TransferItem(0, Fitting, 0));
+	TestFalse(TEXT("Fitted modules don't merge"), Fitting->MergeStacks(1, 0));
+
+	TestTrue(TEXT("Moving between fitted slots swaps"), Fitting->MoveItem(1, 0));
+	TestEqual(TEXT("First slot holds one"), Fitting->GetItemAtSlot(0).Quantity, 1);
+	TestEqual(TEXT("Second slot holds one"), Fitting->GetItemAtSlot(1).Quantity, 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFittingCapacityTest, "Outercorp.Fitting.CapacityFollowsLayout",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFittingCapacityTest::RunTest(const FString& Parameters)
+{
+	FOutercorpTestWorld TestWorld;
+
+	UInventoryItemData* Plating = MakeModule(TEXT("Plating"), EFittingSlotType::Low);
+	FItemStatModifier& Armor = Plating->StatModifiers.AddDefaulted_GetRef();
+	Armor.Stat = TEXT("Armor");
+	Armor.Value = 100.0f;
+
+	UFittingComponent* Fitting = NewObject<UFittingComponent>(TestWorld.Get());
+	Fitting->SlotLayout = {EFittingSlotType::Low};
+	Fitting->SetMaxSlots(1);
+
+	Fitting->SetMaxSlots(3);
+	TestEqual(TEXT("A capacity other than the layout's is refused"), Fitting->MaxSlots, 1);
+
+	// Slots added after the first resize still contribute their modules' stats
+	Fitting->SlotLayout.Add(EFittingSlotType::Low);
+	Fitting->SetMaxSlots(2);
+	int32 Slot = INDEX_NONE;
+	Fitting->AddItem(Plating, 1, Slot);
+	Fitting->AddItem(Plating, 1, Slot);
+	TestEqual(TEXT("Second plate fitted in the new slot"), Slot, 1);
+	TestEqual(TEXT("Both plates count"), Fitting->GetStatValue(TEXT("Armor")), 200.0f);
+
+	// Shrinking back once the new slot is empty
+	Fitting->RemoveItemAtSlot(1);
+	Fitting->SlotLayout.Pop();
+	Fitting->SetMaxSlots(1);
+	TestEqual(TEXT("Only the remaining plate counts"), Fitting->GetStatValue(TEXT("Armor")), 100.0f);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
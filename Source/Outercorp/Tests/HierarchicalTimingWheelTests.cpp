@@ -0,0 +1,127 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HierarchicalTimingWheel.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr uint64 LevelSpan1 = uint64(1) << FHierarchicalTimingWheel::BitsPerLevel;
+	constexpr uint64 LevelSpan2 = uint64(1) << (2 * FHierarchicalTimingWheel::BitsPerLevel);
+	constexpr uint64 LevelSpan3 = uint64(1) << (3 * FHierarchicalTimingWheel::BitsPerLevel);
+
+	FGuid MakeTimerKey(int32 Index)
+	{
+		return FGuid(0, 0, 0, static_cast<uint32>(Index + 1));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHierarchicalTimingWheelCascadeTest, "Outercorp.TimingWheel.CascadeBoundaries",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FHierarchicalTimingWheelCascadeTest::RunTest(const FString& Parameters)
+{
+	// Either side of every level boundary, from starts on and just before a bucket wrap
+	const TArray<uint64> Delays = { 1, 2, LevelSpan1 - 1, LevelSpan1, LevelSpan1 + 1, 2 * LevelSpan1, LevelSpan2 - 1, LevelSpan2, LevelSpan2 + 1,
+		LevelSpan2 + LevelSpan1, LevelSpan3 - 1, LevelSpan3, LevelSpan3 + 1, LevelSpan3 + LevelSpan1 + 1 };
+	const TArray<uint64> Starts = { 0, 1, LevelSpan1 - 1, 1000, LevelSpan2 - 1, LevelSpan3 - 1, 5 * LevelSpan3 + 12345 };
+
+	// Uneven steps, so some expiries fall mid-step and some exactly on a step's end
+	constexpr uint64 Step = 4093;
+
+	for (const uint64 Start : Starts)
+	{
+		FHierarchicalTimingWheel Wheel;
+		Wheel.Reset(Start);
+		for (int32 i = 0; i < Delays.Num(); ++i)
+		{
+			Wheel.Schedule(MakeTimerKey(i), i, Start + Delays[i]);
+		}
+		TestEqual(FString::Printf(TEXT("Start %llu: all pending"), Start), Wheel.Num(), Delays.Num());
+
+		TArray<int32> NumFired;
+		NumFired.Init(0, Delays.Num());
+		int32 NumLate = 0;
+		int32 NumOutOfOrder = 0;
+		uint64 PreviousTarget = Start;
+		uint64 LastExpiry = 0;
+		TArray<FTimingWheelEntry> Fired;
+		while (!Wheel.IsEmpty())
+		{
+			const uint64 Target = PreviousTarget + Step;
+			Fired.Reset();
+			Wheel.Advance(Target, Fired);
+			for (const FTimingWheelEntry& Entry : Fired)
+			{
+				++NumFired[Entry.Tag];
+				NumLate += (Entry.ExpiryTick != Start + Delays[Entry.Tag] || Entry.ExpiryTick <= PreviousTarget || Entry.ExpiryTick > Target) ? 1 : 0;
+				NumOutOfOrder += Entry.ExpiryTick < LastExpiry ? 1 : 0;
+				NumOutOfOrder += Entry.Key != MakeTimerKey(Entry.Tag) ? 1 : 0;
+				LastExpiry = Entry.ExpiryTick;
+			}
+			PreviousTarget = Target;
+		}
+
+		TestTrue(FString::Printf(TEXT("Start %llu: every timer fired once"), Start), !NumFired.ContainsByPredicate([](int32 Count) { return Count != 1; }));
+		TestEqual(FString::Printf(TEXT("Start %llu: every timer fired on its tick"), Start), NumLate, 0);
+		TestEqual(FString::Printf(TEXT("Start %llu: timers fired in tick order with their keys"), Start), NumOutOfOrder, 0);
+		TestEqual(FString::Printf(TEXT("Start %llu: wheel at the last target"), Start), Wheel.GetCurrentTick(), PreviousTarget);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHierarchicalTimingWheelCancelTest, "Outercorp.TimingWheel.CancelAndClamp",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FHierarchicalTimingWheelCancelTest::RunTest(const FString& Parameters)
+{
+	FHierarchicalTimingWheel Wheel;
+	Wheel.Reset(1000);
+	TArray<FTimingWheelEntry> Fired;
+
+	// Cancelled after a cascade moved it down a level
+	FTimingWheelHandle Cascaded = Wheel.Schedule(MakeTimerKey(0), 0, 1000 + LevelSpan2 + 500);
+	const FTimingWheelHandle Kept = Wheel.Schedule(MakeTimerKey(1), 1, 1000 + LevelSpan2 + 600);
+	Wheel.Advance(1000 + LevelSpan2 + 100, Fired);
+	TestEqual(TEXT("Nothing due yet"), Fired.Num(), 0);
+	TestEqual(TEXT("Expiry survives the cascade"), Wheel.GetExpiryTick(Cascaded), 1000 + LevelSpan2 + 500);
+
+	const FTimingWheelHandle StaleCopy = Cascaded;
+	TestTrue(TEXT("Cancel after cascade"), Wheel.Cancel(Cascaded));
+	TestFalse(TEXT("Cancelled handle invalidated"), Cascaded.IsValid());
+	TestEqual(TEXT("One left pending"), Wheel.Num(), 1);
+
+	// The freed node is reused; the old handle must not reach the new timer
+	FTimingWheelHandle Reused = Wheel.Schedule(MakeTimerKey(2), 2, 1000 + LevelSpan2 + 700);
+	TestEqual(TEXT("Node reused"), Reused.Index, StaleCopy.Index);
+	FTimingWheelHandle Stale = StaleCopy;
+	TestFalse(TEXT("Stale handle cancels nothing"), Wheel.Cancel(Stale));
+	TestEqual(TEXT("Stale handle has no expiry"), Wheel.GetExpiryTick(StaleCopy), uint64(0));
+
+	Wheel.Advance(1000 + LevelSpan2 + 1000, Fired);
+	if (TestEqual(TEXT("Only the live timers fired"), Fired.Num(), 2))
+	{
+		TestEqual(TEXT("Kept timer first"), Fired[0].Tag, 1);
+		TestEqual(TEXT("Reused node's timer second"), Fired[1].Tag, 2);
+	}
+	TestFalse(TEXT("Fired timer can't be cancelled"), Wheel.Cancel(Reused));
+	TestEqual(TEXT("Fired handle has no expiry"), Wheel.GetExpiryTick(Kept), uint64(0));
+
+	// Due times in the past fire on the next tick, far ones at the top level's reach
+	const uint64 Now = Wheel.GetCurrentTick();
+	FTimingWheelHandle Past = Wheel.Schedule(MakeTimerKey(3), 3, Now - 10);
+	FTimingWheelHandle Far = Wheel.Schedule(MakeTimerKey(4), 4, Now + (uint64(1) << 40));
+	TestEqual(TEXT("Past due clamped to the next tick"), Wheel.GetExpiryTick(Past), Now + 1);
+	TestEqual(TEXT("Far due clamped to the maximum delay"), Wheel.GetExpiryTick(Far), Now + FHierarchicalTimingWheel::MaxDelayTicks);
+
+	Fired.Reset();
+	Wheel.Advance(Now + 1, Fired);
+	TestTrue(TEXT("Past due fired on the next tick"), Fired.Num() == 1 && Fired[0].Tag == 3);
+	TestTrue(TEXT("Far timer cancelled"), Wheel.Cancel(Far));
+	TestTrue(TEXT("Wheel empty"), Wheel.IsEmpty());
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
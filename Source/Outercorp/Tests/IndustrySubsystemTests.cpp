@@ -0,0 +1,298 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "IndustryRecipe.h"
+#include "IndustrySubsystem.h"
+#include "InventoryComponent.h"
+#include "OutercorpTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	UInventoryItemData* MakeIndustryItem(const TCHAR* ItemID, EItemCategory Category)
+	{
+		UInventoryItemData* Item = NewObject<UInventoryItemData>(GetTransientPackage());
+		Item->ItemID = ItemID;
+		Item->Category = Category;
+		Item->MaxStackSize = MAX_int32;
+		Item->Weight = 0.0f;
+		return Item;
+	}
+
+	UIndustryRecipe* MakeRecipe(UInventoryItemData* Input, UInventoryItemData* Output)
+	{
+		UIndustryRecipe* Recipe = NewObject<UIndustryRecipe>(GetTransientPackage());
+		Recipe->Inputs.Emplace(Input, 1);
+		Recipe->Outputs.Emplace(Output, 2);
+		Recipe->Duration = 1.0f;
+		return Recipe;
+	}
+
+	UInventoryComponent* MakeInventory(UWorld* World, int32 NumSlots)
+	{
+		UInventoryComponent* Inventory = NewObject<UInventoryComponent>(World);
+		Inventory->SetMaxSlots(NumSlots);
+		return Inventory;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIndustryRecipeReleaseTest, "Outercorp.Industry.RecipeRelease",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FIndustryRecipeReleaseTest::RunTest(const FString& Parameters)
+{
+	FOutercorpTestWorld TestWorld;
+	UIndustrySubsystem* Industry = TestWorld.Get()->GetSubsystem<UIndustrySubsystem>();
+	if (!TestNotNull(TEXT("Industry subsystem"), Industry))
+	{
+		return false;
+	}
+
+	UInventoryItemData* Ore = MakeIndustryItem(TEXT("Ore"), EItemCategory::Resource);
+	UInventoryItemData* Plate = MakeIndustryItem(TEXT("Plate"), EItemCategory::Resource);
+	UIndustryRecipe* Recipe = MakeRecipe(Ore, Plate);
+
+	UInventoryComponent* Source = MakeInventory(TestWorld.Get(), 4);
+	UInventoryComponent* Destination = MakeInventory(TestWorld.Get(), 4);
+	int32 Slot = INDEX_NONE;
+	Source->AddItem(Ore, 10, Slot);
+
+	const FGuid Finished = Industry->StartJob(Recipe, Source, Destination, 1);
+	const FGuid Cancelled = Industry->StartJob(Recipe, Source, Destination, 1);
+	TestEqual(TEXT("One recipe entry for two jobs"), Industry->GetNumActiveRecipes(), 1);
+
+	Industry->CancelJob(Cancelled);
+	TestEqual(TEXT("Still used by the running job"), Industry->GetNumActiveRecipes(), 1);
+
+	TestWorld.AdvanceTime(2.0);
+	Industry->Tick(2.0f);
+	TestEqual(TEXT("Job delivered"), Industry->GetJobState(Finished), EIndustryJobState::None);
+	TestEqual(TEXT("Outputs delivered"), Destination->GetItemCount(Plate), 2);
+	TestEqual(TEXT("Recipe released after its last job"), Industry->GetNumActiveRecipes(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIndustryCancelRefundTest, "Outercorp.Industry.CancelRefundDeferred",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FIndustryCancelRefundTest::RunTest(const FString& Parameters)
+{
+	FOutercorpTestWorld TestWorld;
+	UIndustrySubsystem* Industry = TestWorld.Get()->GetSubsystem<UIndustrySubsystem>();
+	if (!TestNotNull(TEXT("Industry subsystem"), Industry))
+	{
+		return false;
+	}
+
+	UInventoryItemData* Ore = MakeIndustryItem(TEXT("Ore"), EItemCategory::Resource);
+	UInventoryItemData* Plate = MakeIndustryItem(TEXT("Plate"), EItemCategory::Resource);
+	UIndustryRecipe* Recipe = MakeRecipe(Ore, Plate);
+
+	UInventoryComponent* Source = MakeInventory(TestWorld.Get(), 1);
+	UInventoryComponent* Destination = MakeInventory(TestWorld.Get(), 1);
+	int32 Slot = INDEX_NONE;
+	Source->AddItem(Ore, 3, Slot);
+
+	// The job takes every input, then something else fills the only slot
+	const FGuid JobID = Industry->StartJob(Recipe, Source, Destination, 3);
+	TestEqual(TEXT("Inputs reserved"), Source->GetItemCount(Ore), 0);
+	Source->AddItem(Plate, 1, Slot);
+
+	TestTrue(TEXT("Cancel accepted"), Industry->CancelJob(JobID));
+	TestEqual(TEXT("Refund kept on the job"), Industry->GetJobState(JobID), EIndustryJobState::Cancelled);
+	TestEqual(TEXT("Recipe still referenced"), Industry->GetNumActiveRecipes(), 1);
+	TestFalse(TEXT("Retry fails while still full"), Industry->DeliverJob(JobID));
+
+	Source->RemoveItems(Plate, 1);
+	TestTrue(TEXT("Retry refunds once there is room"), Industry->DeliverJob(JobID));
+	TestEqual(TEXT("Every input back"), Source->GetItemCount(Ore), 3);
+	TestEqual(TEXT("Job forgotten"), Industry->GetJobState(JobID), EIndustryJobState::None);
+	TestEqual(TEXT("Recipe released"), Industry->GetNumActiveRecipes(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIndustryRunsOverflowTest, "Outercorp.Industry.RejectsOverflowingRuns",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FIndustryRunsOverflowTest::RunTest(const FString& Parameters)
+{
+	FOutercorpTestWorld TestWorld;
+	UIndustrySubsystem* Industry = TestWorld.Get()->GetSubsystem<UIndustrySubsystem>();
+	if (!TestNotNull(TEXT("Industry subsystem"), Industry))
+	{
+		return false;
+	}
+
+	UInventoryItemData* Ore = MakeIndustryItem(TEXT("Ore"), EItemCategory::Resource);
+	UInventoryItemData* Plate = MakeIndustryItem(TEXT("Plate"), EItemCategory::Resource);
+	UIndustryRecipe* Recipe = MakeRecipe(Ore, Plate);
+
+	UInventoryComponent* Source = MakeInventory(TestWorld.Get(), 4);
+	UInventoryComponent* Destination = MakeInventory(TestWorld.Get(), 4);
+	int32 Slot = INDEX_NONE;
+	Source->AddItem(Ore, 10, Slot);
+
+	// 3 * 1431655766 wraps to 2 in int32, which would reserve two ore for over four billion
+	Recipe->Inputs[0].Quantity = 3;
+	TestFalse(TEXT("Wrapping input total refused"), Industry->StartJob(Recipe, Source, Destination, 1431655766).IsValid());
+	TestEqual(TEXT("No input taken"), Source->GetItemCount(Ore), 10);
+
+	// Inputs fit but the outputs, two per run, don't
+	Recipe->Inputs[0].Quantity = 1;
+	TestFalse(TEXT("Overflowing output total refused"), Industry->StartJob(Recipe, Source, Destination, MAX_int32 / 2 + 1).IsValid());
+	TestEqual(TEXT("Still no input taken"), Source->GetItemCount(Ore), 10);
+
+	// Entries of the same type are totalled before the check
+	Recipe->Inputs.Emplace(Ore, MAX_int32);
+	TestFalse(TEXT("Overflowing merged inputs refused"), Industry->StartJob(Recipe, Source, Destination, 1).IsValid());
+
+	TestEqual(TEXT("No job started"), Industry->GetNumRunningJobs(), 0);
+	TestEqual(TEXT("No recipe held"), Industry->GetNumActiveRecipes(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIndustryShutdownTest, "Outercorp.Industry.ShutdownConservesItems",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FIndustryShutdownTest::RunTest(const FString& Parameters)
+{
+	FOutercorpTestWorld TestWorld;
+	UIndustrySubsystem* Industry = TestWorld.Get()->GetSubsystem<UIndustrySubsystem>();
+	if (!TestNotNull(TEXT("Industry subsystem"), Industry))
+	{
+		return false;
+	}
+
+	UInventoryItemData* Ore = MakeIndustryItem(TEXT("Ore"), EItemCategory::Resource);
+	UInventoryItemData* Plate = MakeIndustryItem(TEXT("Plate"), EItemCategory::Resource);
+	UInventoryItemData* Crate = MakeIndustryItem(TEXT("Crate"), EItemCategory::Misc);
+	Crate->MaxStackSize = 1;
+	UIndustryRecipe* Recipe = MakeRecipe(Ore, Plate);
+
+	UInventoryComponent* Source = MakeInventory(TestWorld.Get(), 2);
+	UInventoryComponent* Destination = MakeInventory(TestWorld.Get(), 1);
+	int32 Slot = INDEX_NONE;
+	Source->AddItem(Ore, 10, Slot);
+	Destination->AddItem(Crate, 1, Slot);
+
+	// Finishes while the destination is full
+	const FGuid ReadyJob = Industry->StartJob(Recipe, Source, Destination, 2);
+	TestWorld.AdvanceTime(3.0);
+	Industry->Tick(3.0f);
+	TestEqual(TEXT("Outputs waiting"), Industry->GetJobState(ReadyJob), EIndustryJobState::Ready);
+
+	const FGuid RunningJob = Industry->StartJob(Recipe, Source, Destination, 3);
+	TestEqual(TEXT("Still running"), Industry->GetJobState(RunningJob), EIndustryJobState::Running);
+
+	// Cancelled while the source is full
+	const FGuid CancelledJob = Industry->StartJob(Recipe, Source, Destination, 5);
+	Source->AddItem(Crate, 1, Slot);
+	Source->AddItem(Crate, 1, Slot);
+	Industry->CancelJob(CancelledJob);
+	TestEqual(TEXT("Refund waiting"), Industry->GetJobState(CancelledJob), EIndustryJobState::Cancelled);
+	TestEqual(TEXT("Every input reserved"), Source->GetItemCount(Ore), 0);
+
+	Source->RemoveItems(Crate, 2);
+	Destination->RemoveItems(Crate, 1);
+
+	TestWorld.Destroy();
+
+	TestEqual(TEXT("Inputs of the running and cancelled jobs returned"), Source->GetItemCount(Ore), 8);
+	TestEqual(TEXT("Outputs of the finished job delivered"), Destination->GetItemCount(Plate), 4);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIndustryBenchmark, "Outercorp.Industry.Benchmark.100kJobs",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FIndustryBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumJobs = 100000;
+	constexpr int32 NumDestinations = 100;
+	constexpr int32 MaxRuns = 3600;
+
+	FOutercorpTestWorld TestWorld;
+	UIndustrySubsystem* Industry = TestWorld.Get()->GetSubsystem<UIndustrySubsystem>();
+	if (!TestNotNull(TEXT("Industry subsystem"), Industry))
+	{
+		return false;
+	}
+
+	UInventoryItemData* Ore = MakeIndustryItem(TEXT("Ore"), EItemCategory::Resource);
+	UInventoryItemData* Plate = MakeIndustryItem(TEXT("Plate"), EItemCategory::Resource);
+	UIndustryRecipe* Recipe = MakeRecipe(Ore, Plate);
+
+	// Runs are spread over an hour, so jobs finish throughout the run
+	int64 TotalRuns = 0;
+	for (int32 i = 0; i < NumJobs; ++i)
+	{
+		TotalRuns += 1 + (i * 7919) % MaxRuns;
+	}
+
+	UInventoryComponent* Source = MakeInventory(TestWorld.Get(), 1);
+	int32 Slot = INDEX_NONE;
+	Source->AddItem(Ore, static_cast<int32>(TotalRuns), Slot);
+
+	TArray<UInventoryComponent*> Destinations;
+	for (int32 i = 0; i < NumDestinations; ++i)
+	{
+		Destinations.Add(MakeInventory(TestWorld.Get(), 1));
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumJobs; ++i)
+	{
+		Industry->StartJob(Recipe, Source, Destinations[i % NumDestinations], 1 + (i * 7919) % MaxRuns);
+	}
+	const double StartElapsed = FPlatformTime::Seconds() - StartTime;
+	TestEqual(TEXT("Every job running"), Industry->GetNumRunningJobs(), NumJobs);
+
+	// A frame in which nothing is due should not depend on how many jobs are waiting
+	constexpr int32 NumIdleFrames = 1000;
+	const double IdleStart = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumIdleFrames; ++i)
+	{
+		Industry->Tick(0.0f);
+	}
+	const double IdleElapsed = FPlatformTime::Seconds() - IdleStart;
+
+	double CompleteElapsed = 0.0;
+	double WorstFrame = 0.0;
+	int32 NumFrames = 0;
+	while (Industry->GetNumRunningJobs() > 0 && NumFrames < MaxRuns * 2)
+	{
+		TestWorld.AdvanceTime(1.0);
+
+		const double FrameStart = FPlatformTime::Seconds();
+		Industry->Tick(1.0f);
+		const double FrameElapsed = FPlatformTime::Seconds() - FrameStart;
+
+		CompleteElapsed += FrameElapsed;
+		WorstFrame = FMath::Max(WorstFrame, FrameElapsed);
+		++NumFrames;
+	}
+
+	int64 Delivered = 0;
+	for (const UInventoryComponent* Destination : Destinations)
+	{
+		Delivered += Destination->GetItemCount(Plate);
+	}
+
+	AddInfo(FString::Printf(TEXT("StartJob: %.2f ms for %d jobs (%.2f us each)"), StartElapsed * 1000.0, NumJobs, StartElapsed * 1000000.0 / NumJobs));
+	AddInfo(FString::Printf(TEXT("Idle frame with %d jobs waiting: %.3f us"), NumJobs, IdleElapsed * 1000000.0 / NumIdleFrames));
+	AddInfo(FString::Printf(TEXT("Completion: %.2f ms over %d frames, worst frame %.3f ms"), CompleteElapsed * 1000.0, NumFrames, WorstFrame * 1000.0));
+
+	TestEqual(TEXT("Every job finished"), Industry->GetNumRunningJobs(), 0);
+	TestEqual(TEXT("Every output delivered"), Delivered, TotalRuns * 2);
+	TestEqual(TEXT("Recipe released"), Industry->GetNumActiveRecipes(), 0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
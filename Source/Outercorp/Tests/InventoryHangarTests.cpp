@@ -0,0 +1,143 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "InventoryHangarDatabase.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int32 NumBenchmarkItemTypes = 200;
+
+	FName MakeHangarKey(int32 Index)
+	{
+		return FName(TEXT("BenchmarkHangar"), Index);
+	}
+
+	FInventorySnapshotSlot MakeStack(int32 Hangar, int32 Slot)
+	{
+		FInventorySnapshotSlot Stack;
+		Stack.SlotIndex = Slot;
+		Stack.ItemID = FName(TEXT("HangarItem"), (Hangar * 31 + Slot) % NumBenchmarkItemTypes);
+		Stack.Quantity = 1 + (Hangar + Slot) % 1000;
+		Stack.InstanceID = FGuid(static_cast<uint32>(Hangar), static_cast<uint32>(Slot), 0, 1);
+		if (Slot % 10 == 0)
+		{
+			Stack.Metadata.Emplace(TEXT("Durability"), FString::FromInt(Slot));
+		}
+		return Stack;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryHangarBenchmark, "Outercorp.Hangar.Benchmark.1MStacks",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FInventoryHangarBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumHangars = 10000;
+	constexpr int32 SlotsPerHangar = 100;
+	constexpr int32 HangarsPerBatch = 100;
+	constexpr int32 NumReads = 1000;
+
+	const FString Directory = FPaths::AutomationTransientDir() / TEXT("InventoryHangar");
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	const FString Filename = Directory / TEXT("Benchmark.db");
+
+	double WriteElapsed = 0.0;
+	double UpdateElapsed = 0.0;
+	double FindElapsed = 0.0;
+	double ReadElapsed = 0.0;
+	{
+		FInventoryHangarDatabase Database(Filename);
+		if (!TestTrue(TEXT("Database open"), Database.IsOpen()))
+		{
+			return false;
+		}
+
+		// Batches the size a busy flush would make
+		bool bAllWritten = true;
+		const double WriteStart = FPlatformTime::Seconds();
+		for (int32 First = 0; First < NumHangars; First += HangarsPerBatch)
+		{
+			FInventoryHangarBatch Batch;
+			for (int32 Hangar = First; Hangar < First + HangarsPerBatch; ++Hangar)
+			{
+				FInventoryHangarBatch::FInventoryRows& Rows = Batch.Inventories.AddDefaulted_GetRef();
+				Rows.PersistenceKey = MakeHangarKey(Hangar);
+				Rows.MaxSlots = SlotsPerHangar;
+				Rows.Slots.Reserve(SlotsPerHangar);
+				for (int32 Slot = 0; Slot < SlotsPerHangar; ++Slot)
+				{
+					Rows.Slots.Add(MakeStack(Hangar, Slot));
+				}
+			}
+			bAllWritten &= Database.WriteBatch(Batch);
+		}
+		WriteElapsed = FPlatformTime::Seconds() - WriteStart;
+		TestTrue(TEXT("Every batch written"), bAllWritten);
+
+		// A typical flush: a few dirty slots in many hangars
+		FInventoryHangarBatch Dirty;
+		for (int32 Hangar = 0; Hangar < NumHangars; Hangar += 10)
+		{
+			FInventoryHangarBatch::FInventoryRows& Rows = Dirty.Inventories.AddDefaulted_GetRef();
+			Rows.PersistenceKey = MakeHangarKey(Hangar);
+			for (int32 Slot = 0; Slot < 10; ++Slot)
+			{
+				FInventorySnapshotSlot Stack = MakeStack(Hangar, Slot);
+				Stack.Quantity += 1;
+				Rows.Slots.Add(Stack);
+			}
+		}
+		const double UpdateStart = FPlatformTime::Seconds();
+		TestTrue(TEXT("Dirty rows written"), Database.WriteBatch(Dirty));
+		UpdateElapsed = FPlatformTime::Seconds() - UpdateStart;
+
+		const FName SearchedItem(TEXT("HangarItem"), 7);
+		const double FindStart = FPlatformTime::Seconds();
+		const TArray<FInventoryHangarStack> Found = Database.FindStacks(SearchedItem);
+		FindElapsed = FPlatformTime::Seconds() - FindStart;
+
+		int32 Expected = 0;
+		for (int32 Hangar = 0; Hangar < NumHangars; ++Hangar)
+		{
+			for (int32 Slot = 0; Slot < SlotsPerHangar; ++Slot)
+			{
+				Expected += (Hangar * 31 + Slot) % NumBenchmarkItemTypes == 7 ? 1 : 0;
+			}
+		}
+		TestEqual(TEXT("Search finds every stack of the type"), Found.Num(), Expected);
+
+		// Lazy loads of hangars as players open them
+		int32 NumBadReads = 0;
+		const double ReadStart = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumReads; ++i)
+		{
+			const int32 Hangar = (i * 7919) % NumHangars;
+			FInventorySnapshot Snapshot;
+			if (!Database.ReadInventory(MakeHangarKey(Hangar), Snapshot) || Snapshot.Slots.Num() != SlotsPerHangar || Snapshot.MaxSlots != SlotsPerHangar
+				|| Snapshot.Slots.Last().InstanceID != MakeStack(Hangar, SlotsPerHangar - 1).InstanceID)
+			{
+				++NumBadReads;
+			}
+		}
+		ReadElapsed = FPlatformTime::Seconds() - ReadStart;
+		TestEqual(TEXT("Every hangar reads back whole"), NumBadReads, 0);
+	}
+
+	const int64 NumStacks = static_cast<int64>(NumHangars) * SlotsPerHangar;
+	const int64 FileSize = IFileManager::Get().FileSize(*Filename);
+	AddInfo(FString::Printf(TEXT("Wrote %lld stacks in %d transactions: %.2f s, %.0f rows/s, %.1f MB on disk"),
+		NumStacks, NumHangars / HangarsPerBatch, WriteElapsed, NumStacks / WriteElapsed, FileSize / (1024.0 * 1024.0)));
+	AddInfo(FString::Printf(TEXT("Flush of %d dirty rows across %d hangars: %.2f ms"), NumHangars, NumHangars / 10, UpdateElapsed * 1000.0));
+	AddInfo(FString::Printf(TEXT("FindStacks across all hangars: %.2f ms"), FindElapsed * 1000.0));
+	AddInfo(FString::Printf(TEXT("ReadInventory of a %d-slot hangar: %.3f ms average over %d reads"), SlotsPerHangar, ReadElapsed * 1000.0 / NumReads, NumReads));
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
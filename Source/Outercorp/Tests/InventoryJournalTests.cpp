@@ -0,0 +1,299 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "InventoryArchive.h"
+#include "InventoryJournal.h"
+#include "InventorySaveSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	FString GetTestJournalDirectory()
+	{
+		const FString Directory = FPaths::AutomationTransientDir() / TEXT("InventoryJournal");
+		IFileManager::Get().DeleteDirectory(*Directory, false, true);
+		return Directory;
+	}
+
+	/** Slot Index % 20 of one inventory, emptied every seventh record */
+	FInventoryJournalRecord MakeRecord(int32 Index)
+	{
+		FInventoryJournalRecord Record;
+		Record.Type = FInventoryJournalRecord::EType::SetSlot;
+		Record.PersistenceKey = TEXT("JournalTest");
+		Record.Slot.SlotIndex = Index % 20;
+		if (Index % 7 != 0)
+		{
+			Record.Slot.ItemID = FName(TEXT("JournalItem"), Index % 5);
+			Record.Slot.Quantity = Index + 1;
+			Record.Slot.InstanceID = FGuid(Index, Index % 5, 0x4A4F55, 0x524E4C);
+			Record.Slot.Metadata.Emplace(TEXT("Durability"), FString::FromInt(Index));
+		}
+		return Record;
+	}
+
+	bool SameSlots(const FInventorySnapshot& A, const FInventorySnapshot& B)
+	{
+		if (A.Slots.Num() != B.Slots.Num())
+		{
+			return false;
+		}
+
+		for (int32 i = 0; i < A.Slots.Num(); ++i)
+		{
+			const FInventorySnapshotSlot& SlotA = A.Slots[i];
+			const FInventorySnapshotSlot& SlotB = B.Slots[i];
+			if (SlotA.SlotIndex != SlotB.SlotIndex || SlotA.ItemID != SlotB.ItemID || SlotA.Quantity != SlotB.Quantity
+				|| SlotA.InstanceID != SlotB.InstanceID || SlotA.Metadata != SlotB.Metadata)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryJournalCrashTest, "Outercorp.Journal.CrashInjection",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInventoryJournalCrashTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumRecords = 300;
+
+	const FString Directory = GetTestJournalDirectory();
+
+	// What recovery starts from: the last snapshot written before the journal
+	FInventorySnapshot Base;
+	Base.PersistenceKey = TEXT("JournalTest");
+	for (int32 i = 0; i < 20; i += 3)
+	{
+		FInventorySnapshotSlot& Slot = Base.Slots.AddDefaulted_GetRef();
+		Slot.SlotIndex = i;
+		Slot.ItemID = TEXT("BaseItem");
+		Slot.Quantity = 1;
+	}
+
+	TArray<FInventoryJournalRecord> Expected;
+	TArray<int32> RecordEnds;
+	{
+		TArray<uint8> Bytes;
+		InventoryArchive::EncodeJournalHeader(Bytes);
+		for (int32 i = 0; i < NumRecords; ++i)
+		{
+			Expected.Add(MakeRecord(i));
+			InventoryArchive::EncodeJournalRecord(Expected.Last(), Bytes);
+			RecordEnds.Add(Bytes.Num());
+		}
+	}
+
+	{
+		FInventoryJournal Journal(Directory, 0, 0.001f);
+
+		for (int32 i = 0; i < 100; ++i)
+		{
+			Journal.Append(Expected[i]);
+		}
+		TestTrue(TEXT("First group committed"), Journal.Flush());
+
+		// Every write stops halfway, as on a full disk
+		Journal.NumWritesToFail = MAX_int32;
+		for (int32 i = 100; i < 200; ++i)
+		{
+			Journal.Append(Expected[i]);
+		}
+		TestFalse(TEXT("Flush reports the failed writes"), Journal.Flush());
+
+		// The disk has room again: the kept records go out first, then the new ones
+		Journal.NumWritesToFail = 0;
+		for (int32 i = 200; i < NumRecords; ++i)
+		{
+			Journal.Append(Expected[i]);
+		}
+		TestTrue(TEXT("Kept records committed on retry"), Journal.Flush());
+	}
+
+	TArray<uint8> Bytes;
+	if (!TestTrue(TEXT("Segment written"), FFileHelper::LoadFileToArray(Bytes, *FInventoryJournal::GetSegmentFilename(Directory, 0))))
+	{
+		return false;
+	}
+
+	TArray<FInventoryJournalRecord> Records;
+	TestTrue(TEXT("No torn record left by the failed writes"), InventoryArchive::DecodeJournal(Bytes, Records));
+	TestEqual(TEXT("Every record on disk once"), Records.Num(), NumRecords);
+	TestEqual(TEXT("Segment holds exactly the records"), Bytes.Num(), RecordEnds.Last());
+
+	// Timers and RemoveItemByInstanceID callers find a recovered stack by its instance ID
+	int32 NumLostInstanceIDs = 0;
+	for (int32 i = 0; i < Records.Num() && i < Expected.Num(); ++i)
+	{
+		NumLostInstanceIDs += Records[i].Slot.InstanceID != Expected[i].Slot.InstanceID ? 1 : 0;
+	}
+	TestEqual(TEXT("Instance IDs survive the journal"), NumLostInstanceIDs, 0);
+
+	FInventorySnapshot Replayed = Base;
+	FInventorySnapshot Reference = Base;
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		InventoryArchive::ApplyJournalRecord(Replayed, Records[i]);
+	}
+	for (const FInventoryJournalRecord& Record : Expected)
+	{
+		InventoryArchive::ApplyJournalRecord(Reference, Record);
+	}
+	TestTrue(TEXT("Replay in order gives the final state"), SameSlots(Replayed, Reference));
+
+	// A crash can cut the segment anywhere: recovery must replay exactly the whole records before the cut
+	int32 NumBadCuts = 0;
+	int32 NumComplete = 0;
+	for (int32 Cut = RecordEnds[0] - 1; Cut <= Bytes.Num(); ++Cut)
+	{
+		while (NumComplete < RecordEnds.Num() && RecordEnds[NumComplete] <= Cut)
+		{
+			++NumComplete;
+		}
+
+		TArray<FInventoryJournalRecord> Recovered;
+		const bool bWhole = InventoryArchive::DecodeJournal(TConstArrayView<uint8>(Bytes.GetData(), Cut), Recovered);
+		const bool bAtBoundary = NumComplete > 0 && RecordEnds[NumComplete - 1] == Cut;
+		if (Recovered.Num() != NumComplete || bWhole != bAtBoundary)
+		{
+			++NumBadCuts;
+		}
+	}
+	TestEqual(TEXT("Every cut recovers the records before it"), NumBadCuts, 0);
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryJournalRecoveryTest, "Outercorp.Journal.RecoverNeverSaved",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInventoryJournalRecoveryTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumRecords = 50;
+
+	const FString Directory = GetTestJournalDirectory();
+
+	// JournalTest has no save file; Resized was saved once, then grew before the crash
+	FInventorySnapshot Saved;
+	Saved.PersistenceKey = TEXT("Resized");
+	Saved.MaxSlots = 10;
+	Saved.Slots.AddDefaulted_GetRef().ItemID = TEXT("BaseItem");
+	Saved.Slots.Last().Quantity = 1;
+	{
+		TArray<uint8> Bytes;
+		InventoryArchive::Encode(Saved, Bytes);
+		TestTrue(TEXT("Save written"), FFileHelper::SaveArrayToFile(Bytes, *UInventorySaveSubsystem::GetSaveFilename(Saved.PersistenceKey, Directory)));
+	}
+
+	FInventorySnapshot Expected;
+	Expected.PersistenceKey = TEXT("JournalTest");
+	{
+		FInventoryJournal Journal(Directory, 0, 0.001f);
+		for (int32 i = 0; i < NumRecords; ++i)
+		{
+			const FInventoryJournalRecord Record = MakeRecord(i);
+			Journal.Append(Record);
+			InventoryArchive::ApplyJournalRecord(Expected, Record);
+		}
+
+		FInventoryJournalRecord Capacity;
+		Capacity.Type = FInventoryJournalRecord::EType::SetCapacity;
+		Capacity.PersistenceKey = Saved.PersistenceKey;
+		Capacity.MaxSlots = 30;
+		Journal.Append(Capacity);
+
+		FInventoryJournalRecord Grown;
+		Grown.PersistenceKey = Saved.PersistenceKey;
+		Grown.Slot.SlotIndex = 25;
+		Grown.Slot.ItemID = TEXT("GrownItem");
+		Grown.Slot.Quantity = 3;
+		Journal.Append(Grown);
+
+		TestTrue(TEXT("Journal committed"), Journal.Flush());
+	}
+
+	// The crash cut the next group commit short
+	{
+		const FString SegmentFilename = FInventoryJournal::GetSegmentFilename(Directory, 0);
+		TArray<uint8> Bytes;
+		TestTrue(TEXT("Segment written"), FFileHelper::LoadFileToArray(Bytes, *SegmentFilename));
+		const int32 Whole = Bytes.Num();
+		InventoryArchive::EncodeJournalRecord(MakeRecord(NumRecords), Bytes);
+		Bytes.SetNum(Whole + (Bytes.Num() - Whole) / 2);
+		FFileHelper::SaveArrayToFile(Bytes, *SegmentFilename);
+	}
+
+	TestTrue(TEXT("Recovery wrote every inventory"), UInventorySaveSubsystem::RecoverJournal(Directory, FInventoryJournal::FindSegments(Directory)));
+	TestEqual(TEXT("Replayed segments deleted"), FInventoryJournal::FindSegments(Directory).Num(), 0);
+
+	// The rebuilt save has no capacity but must still decode with its slots
+	TArray<uint8> Bytes;
+	FInventorySnapshot Recovered;
+	FString Error;
+	TestTrue(TEXT("Never saved inventory written"), FFileHelper::LoadFileToArray(Bytes, *UInventorySaveSubsystem::GetSaveFilename(Expected.PersistenceKey, Directory)));
+	if (!InventoryArchive::Decode(Bytes, Recovered, Error))
+	{
+		AddError(FString::Printf(TEXT("Never saved inventory doesn't decode: %s"), *Error));
+	}
+	TestEqual(TEXT("Capacity unknown"), Recovered.MaxSlots, 0);
+	TestTrue(TEXT("Never saved inventory has the journaled slots"), Expected.Slots.Num() > 0 && SameSlots(Recovered, Expected));
+
+	TestTrue(TEXT("Resized inventory written"), FFileHelper::LoadFileToArray(Bytes, *UInventorySaveSubsystem::GetSaveFilename(Saved.PersistenceKey, Directory)));
+	TestTrue(TEXT("Resized inventory decodes"), InventoryArchive::Decode(Bytes, Recovered, Error));
+	TestEqual(TEXT("Journaled capacity applied"), Recovered.MaxSlots, 30);
+	TestTrue(TEXT("Saved and journaled slots"), Recovered.Slots.Num() == 2 && Recovered.Slots[1].SlotIndex == 25);
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryJournalBenchmark, "Outercorp.Journal.Benchmark.Throughput",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FInventoryJournalBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumRecords = 200000;
+
+	const FString Directory = GetTestJournalDirectory();
+
+	TArray<FInventoryJournalRecord> Records;
+	Records.Reserve(NumRecords);
+	for (int32 i = 0; i < NumRecords; ++i)
+	{
+		Records.Add(MakeRecord(i));
+	}
+
+	double AppendElapsed = 0.0;
+	double TotalElapsed = 0.0;
+	{
+		FInventoryJournal Journal(Directory, 0, 0.05f);
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (const FInventoryJournalRecord& Record : Records)
+		{
+			Journal.Append(Record);
+		}
+		AppendElapsed = FPlatformTime::Seconds() - StartTime;
+
+		TestTrue(TEXT("Everything committed"), Journal.Flush());
+		TotalElapsed = FPlatformTime::Seconds() - StartTime;
+	}
+
+	const int64 FileSize = IFileManager::Get().FileSize(*FInventoryJournal::GetSegmentFilename(Directory, 0));
+	AddInfo(FString::Printf(TEXT("Append: %.2f ms for %d records (%.3f us each, on the calling thread)"), AppendElapsed * 1000.0, NumRecords, AppendElapsed * 1000000.0 / NumRecords));
+	AddInfo(FString::Printf(TEXT("Appended and synced: %.2f ms, %.0f records/s, %.2f MB/s (%lld bytes)"),
+		TotalElapsed * 1000.0, NumRecords / TotalElapsed, FileSize / TotalElapsed / (1024.0 * 1024.0), FileSize));
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
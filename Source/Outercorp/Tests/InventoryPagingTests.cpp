@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "InventoryArchive.h"
+#include "InventoryComponent.h"
+#include "InventoryItemData.h"
+#include "OutercorpTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	UInventoryItemData* MakePagingItem(const TCHAR* ItemID, int32 MaxStackSize)
+	{
+		UInventoryItemData* Item = NewObject<UInventoryItemData>(GetTransientPackage());
+		Item->ItemID = ItemID;
+		Item->MaxStackSize = MaxStackSize;
+		return Item;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPagingUncatalogedTest, "Outercorp.Paging.KeepsUncatalogedItems",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInventoryPagingUncatalogedTest::RunTest(const FString& Parameters)
+{
+	FOutercorpTestWorld TestWorld;
+
+	// Transient item types, no catalog knows them
+	UInventoryItemData* Ore = MakePagingItem(TEXT("Ore"), 100);
+	UInventoryItemData* Blueprint = MakePagingItem(TEXT("Blueprint"), 1);
+
+	UInventoryComponent* Inventory = NewObject<UInventoryComponent>(TestWorld.Get());
+	Inventory->SetMaxSlots(8);
+	int32 Slot = INDEX_NONE;
+	Inventory->AddItem(Ore, 150, Slot);
+	Inventory->AddItem(Blueprint, 2, Slot);
+	const FGuid BlueprintID = Inventory->GetItemAtSlot(Slot).InstanceID;
+
+	TArray<uint8> Blob;
+	Inventory->PageOut(Blob);
+	TestTrue(TEXT("Paged out"), Inventory->IsPagedOut());
+
+	FInventorySnapshot Snapshot;
+	FString Error;
+	if (!TestTrue(TEXT("Page decodes"), InventoryArchive::Decode(Blob, Snapshot, Error)))
+	{
+		return false;
+	}
+
+	Inventory->PageIn(Snapshot, nullptr);
+	TestFalse(TEXT("Paged in"), Inventory->IsPagedOut());
+	TestEqual(TEXT("Every ore back"), Inventory->GetItemCount(Ore), 150);
+	TestEqual(TEXT("Every blueprint back"), Inventory->GetItemCount(Blueprint), 2);
+	TestEqual(TEXT("Stacks keep their slots and identity"), Inventory->FindSlotByInstanceID(BlueprintID), Slot);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,569 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "GameFramework/DefaultPawn.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/CoreNet.h"
+#include "InventoryComponent.h"
+#include "InventoryItemData.h"
+#include "InventoryReplication.h"
+#include "InventoryTestPackageMap.h"
+#include "InventoryTestPredictionComponent.h"
+#include "OutercorpTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** 150 ms round trips with some jitter, one packet in ten lost */
+	constexpr double OneWayLatency = 0.075;
+	constexpr double LatencyJitter = 0.02;
+	constexpr float PacketLoss = 0.1f;
+
+	/** Server net update rate */
+	constexpr double NetUpdateInterval = 1.0 / 30.0;
+
+	constexpr int32 NumPredictionItemTypes = 4;
+	constexpr int32 ContainerSlots = 16;
+	constexpr int32 BackpackSlots = 8;
+
+	/**
+	 * Connections between the server and its clients, run in virtual time
+	 * Reliable messages are resent a round trip after each loss and never overtake each other, as
+	 * reliable RPCs; unreliable ones are just gone when lost, as property updates the server sends again.
+	 */
+	class FSimulatedNetwork
+	{
+	public:
+		explicit FSimulatedNetwork(int32 Seed)
+			: Random(Seed)
+		{
+		}
+
+		/** Send in order after the last message on the same channel, whose arrival time LastArrival tracks */
+		void SendReliable(double& LastArrival, TFunction<void()> Deliver)
+		{
+			double Delay = GetDelay();
+			while (Random.FRand() < PacketLoss)
+			{
+				Delay += 2.0 * OneWayLatency;
+			}
+			LastArrival = FMath::Max(LastArrival, Now + Delay);
+			Schedule(LastArrival, MoveTemp(Deliver));
+		}
+
+		void SendUnreliable(TFunction<void()> Deliver)
+		{
+			if (Random.FRand() >= PacketLoss)
+			{
+				Schedule(Now + GetDelay(), MoveTemp(Deliver));
+			}
+		}
+
+		/** Deliver everything due by Time, in arrival order */
+		void RunUntil(double Time)
+		{
+			while (Messages.Num() > 0 && Messages.HeapTop().Time <= Time)
+			{
+				FMessage Message;
+				Messages.HeapPop(Message, FArrivesEarlier());
+				Now = Message.Time;
+				Message.Deliver();
+			}
+			Now = FMath::Max(Now, Time);
+		}
+
+		bool IsIdle() const { return Messages.Num() == 0; }
+
+		double GetTime() const { return Now; }
+
+	private:
+		struct FMessage
+		{
+			double Time = 0.0;
+			int64 Order = 0;
+			TFunction<void()> Deliver;
+		};
+
+		struct FArrivesEarlier
+		{
+			bool operator()(const FMessage& A, const FMessage& B) const
+			{
+				return A.Time < B.Time || (A.Time == B.Time && A.Order < B.Order);
+			}
+		};
+
+		double GetDelay()
+		{
+			return OneWayLatency + LatencyJitter * (2.0 * Random.FRand() - 1.0);
+		}
+
+		void Schedule(double Time, TFunction<void()> Deliver)
+		{
+			Messages.HeapPush({ Time, NextOrder++, MoveTemp(Deliver) }, FArrivesEarlier());
+		}
+
+		FRandomStream Random;
+		TArray<FMessage> Messages;
+		int64 NextOrder = 0;
+		double Now = 0.0;
+	};
+
+	/** The replicated contents of one inventory as the server sent them at one net update */
+	struct FContentsUpdate
+	{
+		struct FEntry
+		{
+			int32 ReplicationID = INDEX_NONE;
+			int32 ReplicationKey = INDEX_NONE;
+			TArray<uint8> Bits;
+			int64 NumBits = 0;
+		};
+
+		uint32 ChangeSerial = 0;
+		TArray<FEntry> Entries;
+	};
+
+	/** One server inventory as one client has it */
+	struct FReplicatedView
+	{
+		UInventoryComponent* ServerInventory = nullptr;
+		UInventoryComponent* ClientInventory = nullptr;
+		uint32 ReceivedSerial = 0;
+	};
+
+	/** A player with the server's and their own copy of everything they see */
+	struct FSimulatedClient
+	{
+		UInventoryTestPredictionComponent* ServerPrediction = nullptr;
+		UInventoryTestPredictionComponent* Prediction = nullptr;
+		UInventoryComponent* Backpack = nullptr;
+		UInventoryComponent* Container = nullptr;
+		TArray<FReplicatedView> Views;
+		double LastArrivalOnServer = 0.0;
+		double LastArrivalOnClient = 0.0;
+
+		/** Operations that named their stack by slot alone */
+		TSet<int32> KeysByPredictedStack;
+	};
+
+	UInventoryItemData* MakePredictionItem(int32 Index)
+	{
+		UInventoryItemData* Item = NewObject<UInventoryItemData>(GetTransientPackage());
+		Item->ItemID = FName(TEXT("PredictionItem"), Index);
+		Item->MaxStackSize = 50;
+		return Item;
+	}
+
+	UInventoryComponent* MakeInventory(AActor* Owner, int32 NumSlots)
+	{
+		UInventoryComponent* Inventory = NewObject<UInventoryComponent>(Owner);
+		Inventory->SetMaxSlots(NumSlots);
+		return Inventory;
+	}
+
+	/** Entries go through the wire format, item types as references through the package map */
+	FContentsUpdate CaptureUpdate(const UInventoryComponent* Inventory, UPackageMap* Map)
+	{
+		FContentsUpdate Update;
+		Update.ChangeSerial = Inventory->GetChangeSerial();
+		for (const FInventoryReplicatedSlot& Slot : Inventory->GetReplicatedContents()->Slots.Slots)
+		{
+			FInventoryReplicatedSlot Copy = Slot;
+			FNetBitWriter Writer(Map, 1 << 12);
+			bool bSuccess = false;
+			Copy.SerializeWithCatalog(Writer, Map, nullptr, bSuccess);
+
+			FContentsUpdate::FEntry& Entry = Update.Entries.AddDefaulted_GetRef();
+			Entry.ReplicationID = Slot.ReplicationID;
+			Entry.ReplicationKey = Slot.ReplicationKey;
+			Entry.Bits = *Writer.GetBuffer();
+			Entry.NumBits = Writer.GetNumBits();
+		}
+		return Update;
+	}
+
+	/** Apply an update the way the fast array does: removes, then adds, then changes, then the serial's OnRep */
+	void ApplyUpdate(UInventoryComponent* Inventory, const FContentsUpdate& Update, UPackageMap* Map)
+	{
+		UInventoryReplicatedContents* Contents = Inventory->GetReplicatedContents();
+		FInventoryReplicatedSlots& Slots = Contents->Slots;
+
+		for (int32 i = Slots.Slots.Num() - 1; i >= 0; --i)
+		{
+			const int32 ReplicationID = Slots.Slots[i].ReplicationID;
+			if (!Update.Entries.ContainsByPredicate([ReplicationID](const FContentsUpdate::FEntry& Entry) { return Entry.ReplicationID == ReplicationID; }))
+			{
+				Slots.Slots[i].PreReplicatedRemove(Slots);
+				Slots.Slots.RemoveAt(i);
+			}
+		}
+
+		TArray<int32> Added;
+		TArray<int32> Changed;
+		for (const FContentsUpdate::FEntry& Entry : Update.Entries)
+		{
+			int32 Index = Slots.Slots.IndexOfByPredicate([&Entry](const FInventoryReplicatedSlot& Slot) { return Slot.ReplicationID == Entry.ReplicationID; });
+			if (Index == INDEX_NONE)
+			{
+				Index = Slots.Slots.AddDefaulted();
+				Slots.Slots[Index].ReplicationID = Entry.ReplicationID;
+				Added.Add(Index);
+			}
+			else if (Slots.Slots[Index].ReplicationKey != Entry.ReplicationKey)
+			{
+				Changed.Add(Index);
+			}
+			else
+			{
+				continue;
+			}
+
+			Slots.Slots[Index].ReplicationKey = Entry.ReplicationKey;
+			TArray<uint8> Bits = Entry.Bits;
+			FNetBitReader Reader(Map, Bits.GetData(), Entry.NumBits);
+			bool bSuccess = false;
+			Slots.Slots[Index].SerializeWithCatalog(Reader, Map, nullptr, bSuccess);
+		}
+
+		for (const int32 Index : Added)
+		{
+			Slots.Slots[Index].PostReplicatedAdd(Slots);
+		}
+		for (const int32 Index : Changed)
+		{
+			Slots.Slots[Index].PostReplicatedChange(Slots);
+		}
+
+		Contents->ChangeSerial = Update.ChangeSerial;
+		Contents->ProcessEvent(Contents->FindFunctionChecked(TEXT("OnRep_ChangeSerial")), nullptr);
+	}
+
+	bool SameContents(const UInventoryComponent* A, const UInventoryComponent* B)
+	{
+		const int32 NumSlots = FMath::Max(A->GetItems().Num(), B->GetItems().Num());
+		for (int32 i = 0; i < NumSlots; ++i)
+		{
+			const FInventoryItem ItemA = A->GetItems().IsValidIndex(i) ? A->GetItems()[i] : FInventoryItem();
+			const FInventoryItem ItemB = B->GetItems().IsValidIndex(i) ? B->GetItems()[i] : FInventoryItem();
+			if (ItemA.IsValid() != ItemB.IsValid() || (ItemA.IsValid() && (ItemA.ItemData != ItemB.ItemData || ItemA.Quantity != ItemB.Quantity)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void CountQuantities(const UInventoryComponent* Inventory, TMap<UInventoryItemData*, int32>& InOutQuantities)
+	{
+		for (const FInventoryItem& Item : Inventory->GetItems())
+		{
+			if (Item.IsValid())
+			{
+				InOutQuantities.FindOrAdd(Item.ItemData) += Item.Quantity;
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPredictionLatencyLossTest, "Outercorp.Prediction.MultiClientLatencyLoss",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInventoryPredictionLatencyLossTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumClients = 3;
+	constexpr int32 OperationsPerClient = 150;
+
+	FOutercorpTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+	UInventoryTestPackageMap* Map = NewObject<UInventoryTestPackageMap>();
+	FSimulatedNetwork Network(1234);
+	FRandomStream Random(42);
+
+	TArray<UInventoryItemData*> ItemTypes;
+	for (int32 i = 0; i < NumPredictionItemTypes; ++i)
+	{
+		ItemTypes.Add(MakePredictionItem(i));
+	}
+
+	// A station container everyone works on, and a backpack each
+	UInventoryComponent* ServerContainer = MakeInventory(World->SpawnActor<AActor>(), ContainerSlots);
+	for (int32 Slot = 0; Slot < 12; ++Slot)
+	{
+		int32 OutSlot = INDEX_NONE;
+		ServerContainer->AddItem(ItemTypes[Slot % NumPredictionItemTypes], 10 + Slot, OutSlot);
+	}
+
+	TArray<UInventoryComponent*> ServerInventories = { ServerContainer };
+	TArray<FSimulatedClient> Clients;
+	Clients.SetNum(NumClients);
+	for (int32 ClientIndex = 0; ClientIndex < NumClients; ++ClientIndex)
+	{
+		FSimulatedClient& Client = Clients[ClientIndex];
+
+		// Standing at the container, everything is spawned at the origin
+		APlayerController* ServerPlayer = World->SpawnActor<APlayerController>();
+		ServerPlayer->SetPawn(World->SpawnActor<APawn>());
+		Client.ServerPrediction = NewObject<UInventoryTestPredictionComponent>(ServerPlayer);
+
+		UInventoryComponent* ServerBackpack = MakeInventory(World->SpawnActor<AActor>(), BackpackSlots);
+		for (int32 Slot = 0; Slot < 4; ++Slot)
+		{
+			int32 OutSlot = INDEX_NONE;
+			ServerBackpack->AddItem(ItemTypes[(ClientIndex + Slot) % NumPredictionItemTypes], 5 + Slot, OutSlot);
+		}
+		ServerContainer->AddObserver(ServerPlayer);
+		ServerBackpack->AddObserver(ServerPlayer);
+		ServerInventories.Add(ServerBackpack);
+
+		APlayerController* Player = World->SpawnActor<APlayerController>();
+		Player->SetRole(ROLE_AutonomousProxy);
+		Client.Prediction = NewObject<UInventoryTestPredictionComponent>(Player);
+		Client.Prediction->PredictionTimeout = 3600.0f;
+
+		AActor* ClientShip = World->SpawnActor<AActor>();
+		ClientShip->SetRole(ROLE_SimulatedProxy);
+		Client.Backpack = MakeInventory(ClientShip, BackpackSlots);
+		AActor* ClientStation = World->SpawnActor<AActor>();
+		ClientStation->SetRole(ROLE_SimulatedProxy);
+		Client.Container = MakeInventory(ClientStation, ContainerSlots);
+
+		Client.Views.Add({ ServerContainer, Client.Container });
+		Client.Views.Add({ ServerBackpack, Client.Backpack });
+		for (FReplicatedView& View : Client.Views)
+		{
+			ApplyUpdate(View.ClientInventory, CaptureUpdate(View.ServerInventory, Map), Map);
+			View.ReceivedSerial = View.ServerInventory->GetChangeSerial();
+		}
+	}
+
+	TMap<UInventoryItemData*, int32> QuantitiesBefore;
+	for (const UInventoryComponent* Inventory : ServerInventories)
+	{
+		CountQuantities(Inventory, QuantitiesBefore);
+	}
+
+	int32 NumAccepted = 0;
+	int32 NumRejected = 0;
+	int32 NumByPredictedStack = 0;
+	int32 NumByPredictedStackAccepted = 0;
+	for (FSimulatedClient& Client : Clients)
+	{
+		Client.Prediction->OnSendOperation = [&Network, &Client, &NumByPredictedStack](const FInventoryPredictedOperation& Operation)
+		{
+			// Inventories resolve to the server's copies, as net GUIDs would
+			FInventoryPredictedOperation OnServer = Operation;
+			for (const FReplicatedView& View : Client.Views)
+			{
+				if (Operation.SourceInventory == View.ClientInventory)
+				{
+					OnServer.SourceInventory = View.ServerInventory;
+				}
+				if (Operation.TargetInventory == View.ClientInventory)
+				{
+					OnServer.TargetInventory = View.ServerInventory;
+				}
+			}
+
+			if (Operation.SourceNetInstanceID == 0)
+			{
+				++NumByPredictedStack;
+				Client.KeysByPredictedStack.Add(Operation.PredictionKey);
+			}
+
+			Network.SendReliable(Client.LastArrivalOnServer, [&Client, OnServer]()
+			{
+				Client.ServerPrediction->ReceiveOperation(OnServer);
+			});
+		};
+
+		Client.ServerPrediction->OnSendResult = [&Network, &Client, &NumAccepted, &NumRejected, &NumByPredictedStackAccepted](int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial)
+		{
+			++(bAccepted ? NumAccepted : NumRejected);
+			if (bAccepted && Client.KeysByPredictedStack.Contains(PredictionKey))
+			{
+				++NumByPredictedStackAccepted;
+			}
+
+			Network.SendReliable(Client.LastArrivalOnClient, [&Client, PredictionKey, bAccepted, SourceChangeSerial, TargetChangeSerial]()
+			{
+				Client.Prediction->ReceiveResult(PredictionKey, bAccepted, SourceChangeSerial, TargetChangeSerial);
+			});
+		};
+	}
+
+	// Net updates go out while a client is behind; lost or overtaken ones are sent again by the next
+	double NextNetUpdate = 0.0;
+	const auto AdvanceTo = [&](double Time)
+	{
+		while (NextNetUpdate <= Time)
+		{
+			Network.RunUntil(NextNetUpdate);
+			for (FSimulatedClient& Client : Clients)
+			{
+				for (int32 ViewIndex = 0; ViewIndex < Client.Views.Num(); ++ViewIndex)
+				{
+					const FReplicatedView& View = Client.Views[ViewIndex];
+					if (View.ServerInventory->GetChangeSerial() == View.ReceivedSerial)
+					{
+						continue;
+					}
+
+					Network.SendUnreliable([&Client, ViewIndex, Map, Update = CaptureUpdate(View.ServerInventory, Map)]()
+					{
+						FReplicatedView& Received = Client.Views[ViewIndex];
+						if (static_cast<int32>(Update.ChangeSerial - Received.ReceivedSerial) > 0)
+						{
+							ApplyUpdate(Received.ClientInventory, Update, Map);
+							Received.ReceivedSerial = Update.ChangeSerial;
+						}
+					});
+				}
+			}
+			NextNetUpdate += NetUpdateInterval;
+		}
+		Network.RunUntil(Time);
+	};
+
+	// Players drag stacks around as they see them, faster than results come back
+	int32 NumRequested = 0;
+	int32 NumRefusedLocally = 0;
+	for (int32 Step = 0; Step < OperationsPerClient; ++Step)
+	{
+		for (FSimulatedClient& Client : Clients)
+		{
+			UInventoryComponent* Source = Random.FRand() < 0.5f ? Client.Backpack : Client.Container;
+			TArray<int32> Occupied;
+			for (int32 Slot = 0; Slot < Source->GetItems().Num(); ++Slot)
+			{
+				if (Source->GetItems()[Slot].IsValid())
+				{
+					Occupied.Add(Slot);
+				}
+			}
+			if (Occupied.Num() == 0)
+			{
+				continue;
+			}
+
+			const int32 SourceSlot = Occupied[Random.RandRange(0, Occupied.Num() - 1)];
+			UInventoryComponent* Target = Random.FRand() < 0.5f ? Client.Backpack : Client.Container;
+			const int32 TargetSlot = Random.RandRange(0, Target->MaxSlots - 1);
+			if (Target == Source && TargetSlot == SourceSlot)
+			{
+				continue;
+			}
+
+			const int32 SourceQuantity = Source->GetItems()[SourceSlot].Quantity;
+			const bool bSplit = Target == Source && SourceQuantity > 1 && !Target->GetItems()[TargetSlot].IsValid() && Random.FRand() < 0.3f;
+			++(Client.Prediction->RequestTransfer(Source, SourceSlot, Target, TargetSlot, bSplit ? SourceQuantity / 2 : -1, bSplit) ? NumRequested : NumRefusedLocally);
+		}
+		AdvanceTo(Network.GetTime() + Random.FRandRange(0.02f, 0.1f));
+	}
+
+	const auto IsSettled = [&Network, &Clients]()
+	{
+		if (!Network.IsIdle())
+		{
+			return false;
+		}
+		for (const FSimulatedClient& Client : Clients)
+		{
+			if (Client.Prediction->GetNumPendingOperations() > 0)
+			{
+				return false;
+			}
+			for (const FReplicatedView& View : Client.Views)
+			{
+				if (View.ServerInventory->GetChangeSerial() != View.ReceivedSerial)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	};
+
+	const double GiveUpTime = Network.GetTime() + 60.0;
+	while (!IsSettled() && Network.GetTime() < GiveUpTime)
+	{
+		AdvanceTo(Network.GetTime() + NetUpdateInterval);
+	}
+	TestTrue(TEXT("Every operation answered and every update delivered"), IsSettled());
+
+	int32 NumDiverged = 0;
+	for (const FSimulatedClient& Client : Clients)
+	{
+		for (const FReplicatedView& View : Client.Views)
+		{
+			NumDiverged += SameContents(View.ServerInventory, View.ClientInventory) ? 0 : 1;
+		}
+	}
+	TestEqual(TEXT("Every client sees what the server has"), NumDiverged, 0);
+
+	TMap<UInventoryItemData*, int32> QuantitiesAfter;
+	for (const UInventoryComponent* Inventory : ServerInventories)
+	{
+		CountQuantities(Inventory, QuantitiesAfter);
+	}
+	TestTrue(TEXT("No items created or lost"), QuantitiesBefore.OrderIndependentCompareEqual(QuantitiesAfter));
+
+	TestEqual(TEXT("Every request answered"), NumAccepted + NumRejected, NumRequested);
+	TestTrue(TEXT("Operations on stacks still in flight accepted"), NumByPredictedStackAccepted > 0);
+
+	// A player can't name a stack by slot alone unless their own operation left it there
+	{
+		APlayerController* Intruder = World->SpawnActor<APlayerController>();
+		// Has a root component, so it can be moved
+		APawn* IntruderPawn = World->SpawnActor<ADefaultPawn>();
+		Intruder->SetPawn(IntruderPawn);
+		UInventoryTestPredictionComponent* IntruderPrediction = NewObject<UInventoryTestPredictionComponent>(Intruder);
+		ServerContainer->AddObserver(Intruder);
+
+		TOptional<bool> bLastAccepted;
+		IntruderPrediction->OnSendResult = [&bLastAccepted](int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial)
+		{
+			bLastAccepted = bAccepted;
+		};
+
+		const int32 SourceSlot = ServerContainer->GetItems().IndexOfByPredicate([](const FInventoryItem& Item) { return Item.IsValid(); });
+		const int32 TargetSlot = ServerContainer->GetItems().IndexOfByPredicate([](const FInventoryItem& Item) { return !Item.IsValid(); });
+		if (TestTrue(TEXT("Container has a stack and a free slot"), SourceSlot != INDEX_NONE && TargetSlot != INDEX_NONE))
+		{
+			FInventoryPredictedOperation Operation;
+			Operation.PredictionKey = 1;
+			Operation.SourceInventory = ServerContainer;
+			Operation.SourceSlot = SourceSlot;
+			Operation.TargetInventory = ServerContainer;
+			Operation.TargetSlot = TargetSlot;
+			IntruderPrediction->ReceiveOperation(Operation);
+			TestTrue(TEXT("Slot-only operation on someone else's stack rejected"), bLastAccepted.IsSet() && !bLastAccepted.GetValue());
+
+			Operation.PredictionKey = 2;
+			Operation.SourceNetInstanceID = ServerContainer->GetNetInstanceID(SourceSlot);
+			IntruderPrediction->ReceiveOperation(Operation);
+			TestTrue(TEXT("Same operation with the stack's ID accepted"), bLastAccepted.IsSet() && bLastAccepted.GetValue());
+
+			// Walked off with the window still open
+			IntruderPawn->SetActorLocation(FVector(ServerContainer->OpenRange * 2.0f, 0.0f, 0.0f));
+			Operation.PredictionKey = 3;
+			Operation.SourceSlot = TargetSlot;
+			Operation.TargetSlot = SourceSlot;
+			Operation.SourceNetInstanceID = ServerContainer->GetNetInstanceID(TargetSlot);
+			bLastAccepted.Reset();
+			IntruderPrediction->ReceiveOperation(Operation);
+			TestTrue(TEXT("Operation from out of range rejected"), bLastAccepted.IsSet() && !bLastAccepted.GetValue());
+
+			ServerContainer->RemoveObserversOutOfRange();
+			TestFalse(TEXT("Observer out of range dropped"), ServerContainer->IsObservedBy(Intruder));
+			TestTrue(TEXT("Observers in range kept"), ServerContainer->IsObservedBy(Clients[0].ServerPrediction->GetOwner<APlayerController>()));
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("%d clients, %.1f s: %d operations sent (%d on stacks still in flight, %d of them accepted), %d accepted, %d rejected, %d refused locally"),
+		NumClients, Network.GetTime(), NumRequested, NumByPredictedStack, NumByPredictedStackAccepted, NumAccepted, NumRejected, NumRefusedLocally));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
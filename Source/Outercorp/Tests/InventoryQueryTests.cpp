@@ -0,0 +1,77 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "InventoryItemData.h"
+#include "InventoryQuery.h"
+#include "InventorySearchIndex.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	UInventoryItemData* MakeQueryItem(const TCHAR* Name, EItemCategory Category, EItemRarity Rarity, float Weight)
+	{
+		UInventoryItemData* Item = NewObject<UInventoryItemData>(GetTransientPackage());
+		Item->ItemID = FName(Name);
+		Item->ItemName = FText::FromString(Name);
+		Item->Category = Category;
+		Item->Rarity = Rarity;
+		Item->Weight = Weight;
+		Item->MaxStackSize = 100;
+		return Item;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryQueryDocumentedExampleTest, "Outercorp.Query.DocumentedExample",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInventoryQueryDocumentedExampleTest::RunTest(const FString& Parameters)
+{
+	// The example from FInventoryQueryPlan's doc comment, each slot but the first failing one term
+	TArray<FInventoryItem> Items;
+	Items.Emplace(MakeQueryItem(TEXT("Lead Slug"), EItemCategory::Ammunition, EItemRarity::Rare, 0.1f), 10);
+	Items.Emplace(MakeQueryItem(TEXT("Lead Pellet"), EItemCategory::Ammunition, EItemRarity::Common, 0.1f), 10);
+	Items.Emplace(MakeQueryItem(TEXT("Lead Ingot"), EItemCategory::Resource, EItemRarity::Epic, 1.0f), 10);
+	Items.Emplace(MakeQueryItem(TEXT("Lead Shell"), EItemCategory::Ammunition, EItemRarity::Legendary, 8.0f), 10);
+	Items.Emplace(MakeQueryItem(TEXT("Iron Slug"), EItemCategory::Ammunition, EItemRarity::Epic, 0.1f), 10);
+	Items.AddDefaulted();
+
+	FInventorySearchIndex Index;
+	Index.Build(Items);
+
+	const FInventoryQueryPlan Plan = FInventoryQueryPlan::Compile(TEXT("cat:ammo rarity>=rare weight<5 lead"));
+	TestEqual(TEXT("No errors"), Plan.Errors.Num(), 0);
+	TestEqual(TEXT("Name text"), Plan.NameText, FString(TEXT("lead")));
+	TestEqual(TEXT("Category and rarity terms"), Plan.FacetTerms.Num(), 2);
+	TestEqual(TEXT("Weight term"), Plan.RangeTerms.Num(), 1);
+	if (Plan.FacetTerms.Num() == 2)
+	{
+		TestEqual(TEXT("ammo is Ammunition"), Plan.FacetTerms[0].ValueMask, 1u << static_cast<int32>(EItemCategory::Ammunition));
+		TestEqual(TEXT("rare and up"), Plan.FacetTerms[1].ValueMask,
+			(1u << static_cast<int32>(EItemRarity::Rare)) | (1u << static_cast<int32>(EItemRarity::Epic)) | (1u << static_cast<int32>(EItemRarity::Legendary)));
+	}
+
+	FInventorySearchResult NameResult;
+	TBitArray<> Matches;
+	Plan.Evaluate(Index, NameResult, Matches);
+	for (int32 SlotIndex = 0; SlotIndex < Items.Num(); ++SlotIndex)
+	{
+		const bool bExpected = SlotIndex == 0;
+		TestEqual(FString::Printf(TEXT("Slot %d matches"), SlotIndex), Matches.IsValidIndex(SlotIndex) && Matches[SlotIndex], bExpected);
+		TestEqual(FString::Printf(TEXT("Slot %d matches alone"), SlotIndex), Plan.EvaluateSlot(Index, NameResult, SlotIndex), bExpected);
+	}
+
+	// Plurals and prefixes of aliases while typing
+	TestEqual(TEXT("cat:weapons"), FInventoryQueryPlan::Compile(TEXT("cat:weapons")).FacetTerms.Num(), 1);
+	TestEqual(TEXT("cat:armou"), FInventoryQueryPlan::Compile(TEXT("cat:armou")).FacetTerms.Num(), 1);
+
+	// A value naming nothing is an error, not an empty result
+	const FInventoryQueryPlan Unknown = FInventoryQueryPlan::Compile(TEXT("cat:gizmo rarity:mythic lead"));
+	TestEqual(TEXT("Both unknown values reported"), Unknown.Errors.Num(), 2);
+	TestEqual(TEXT("Unknown values left out"), Unknown.FacetTerms.Num(), 0);
+	TestEqual(TEXT("Name text kept"), Unknown.NameText, FString(TEXT("lead")));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
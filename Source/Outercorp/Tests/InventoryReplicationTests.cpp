@@ -0,0 +1,299 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Engine/GameInstance.h"
+#include "UObject/CoreNet.h"
+#include "InventoryItemCatalog.h"
+#include "InventoryItemData.h"
+#include "InventoryReplication.h"
+#include "InventoryTestPackageMap.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int32 NumReplicationItemTypes = 40;
+
+	/** The fast array's header: array and base replication keys, delete and change counts */
+	constexpr int64 FastArrayHeaderBits = 4 * 32;
+
+	/** Sent ahead of every changed or deleted entry */
+	constexpr int64 ReplicationIDBits = 32;
+
+	UInventoryItemData* MakeReplicationItem(int32 Index)
+	{
+		UInventoryItemData* Item = NewObject<UInventoryItemData>(GetTransientPackage());
+		Item->ItemID = FName(TEXT("ReplicationItem"), Index);
+		Item->Weight = 0.5f;
+		return Item;
+	}
+
+	TArray<UInventoryItemData*> MakeItemTypes()
+	{
+		TArray<UInventoryItemData*> ItemTypes;
+		for (int32 i = 0; i < NumReplicationItemTypes; ++i)
+		{
+			ItemTypes.Add(MakeReplicationItem(i));
+		}
+		return ItemTypes;
+	}
+
+	UInventoryItemCatalogSubsystem* MakeCatalog(const TArray<UInventoryItemData*>& ItemTypes, bool bLoaded = true)
+	{
+		// Game instance subsystems can only live in a game instance
+		UGameInstance* GameInstance = NewObject<UGameInstance>(GetTransientPackage());
+		UInventoryItemCatalogSubsystem* Catalog = NewObject<UInventoryItemCatalogSubsystem>(GameInstance);
+		Catalog->NetMetadataKeys = { TEXT("Durability"), TEXT("Bound") };
+		Catalog->SetItemsForTests(ItemTypes, bLoaded);
+		return Catalog;
+	}
+
+	/** Every tenth stack carries known keys, every tenth offset by five a free-form string */
+	FInventoryItem MakeStack(const TArray<UInventoryItemData*>& ItemTypes, int32 Slot)
+	{
+		FInventoryItem Item(ItemTypes[Slot % ItemTypes.Num()], 1 + (Slot * 37) % 500);
+		if (Slot % 10 == 0)
+		{
+			Item.InstanceMetadata.Add(TEXT("Durability"), FString::FromInt(100 - Slot % 100));
+			Item.InstanceMetadata.Add(TEXT("Bound"), TEXT("true"));
+		}
+		else if (Slot % 10 == 5)
+		{
+			Item.InstanceMetadata.Add(TEXT("Crafter"), FString::Printf(TEXT("Player%d"), Slot));
+		}
+		return Item;
+	}
+
+	/** Write Sent and read it into OutReceived, false if either side failed or the reader didn't end where the writer did */
+	bool RoundTrip(const FInventoryReplicatedSlot& Sent, FInventoryReplicatedSlot& OutReceived, UPackageMap* Map,
+		const UInventoryItemCatalogSubsystem* ServerCatalog, const UInventoryItemCatalogSubsystem* ClientCatalog)
+	{
+		FInventoryReplicatedSlot Copy = Sent;
+		FNetBitWriter Writer(Map, 1 << 16);
+		bool bWritten = false;
+		Copy.SerializeWithCatalog(Writer, Map, ServerCatalog, bWritten);
+
+		FNetBitReader Reader(Map, Writer.GetData(), Writer.GetNumBits());
+		bool bRead = false;
+		OutReceived.SerializeWithCatalog(Reader, Map, ClientCatalog, bRead);
+		return bWritten && bRead && !Writer.IsError() && !Reader.IsError() && Reader.AtEnd();
+	}
+
+	bool SameSlot(const FInventoryReplicatedSlot& A, const FInventoryReplicatedSlot& B)
+	{
+		if (A.SlotIndex != B.SlotIndex || A.NetInstanceID != B.NetInstanceID || A.ItemData != B.ItemData || A.Quantity != B.Quantity || A.Metadata.Num() != B.Metadata.Num())
+		{
+			return false;
+		}
+
+		for (int32 i = 0; i < A.Metadata.Num(); ++i)
+		{
+			if (A.Metadata[i].Key != B.Metadata[i].Key || !A.Metadata[i].Value.Equals(B.Metadata[i].Value, ESearchCase::CaseSensitive))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	FInventoryReplicatedSlot MakeEntry(UInventoryItemData* ItemData, int32 Quantity, TArray<FInventoryReplicatedMetadata> Metadata = TArray<FInventoryReplicatedMetadata>())
+	{
+		FInventoryReplicatedSlot Entry;
+		Entry.SlotIndex = 17;
+		Entry.NetInstanceID = 4242;
+		Entry.ItemData = ItemData;
+		Entry.Quantity = Quantity;
+		Entry.Metadata = MoveTemp(Metadata);
+		return Entry;
+	}
+
+	int64 GetSerializedBits(const FInventoryReplicatedSlot& Entry, const UInventoryItemCatalogSubsystem* Catalog)
+	{
+		FInventoryReplicatedSlot Copy = Entry;
+		FNetBitWriter Writer(nullptr, 1 << 16);
+		bool bSuccess = false;
+		Copy.SerializeWithCatalog(Writer, nullptr, Catalog, bSuccess);
+		return Writer.GetNumBits();
+	}
+
+	/** Replication ID to replication key of every entry, what a connection's last update acknowledged */
+	TMap<int32, int32> GetReplicationKeys(const FInventoryReplicatedSlots& Slots)
+	{
+		TMap<int32, int32> Keys;
+		for (const FInventoryReplicatedSlot& Entry : Slots.Slots)
+		{
+			Keys.Add(Entry.ReplicationID, Entry.ReplicationKey);
+		}
+		return Keys;
+	}
+
+	/** What one update carries to a connection that had acknowledged Acked, bunch and property framing aside */
+	struct FDeltaBits
+	{
+		int64 PayloadBits = 0;
+		int32 NumChanged = 0;
+		int32 NumDeleted = 0;
+
+		int64 GetTotalBits() const { return FastArrayHeaderBits + (NumChanged + NumDeleted) * ReplicationIDBits + PayloadBits; }
+	};
+
+	FDeltaBits MeasureDelta(const TMap<int32, int32>& Acked, const FInventoryReplicatedSlots& Slots, const UInventoryItemCatalogSubsystem* Catalog)
+	{
+		FDeltaBits Delta;
+		int32 NumKept = 0;
+		for (const FInventoryReplicatedSlot& Entry : Slots.Slots)
+		{
+			const int32* AckedKey = Acked.Find(Entry.ReplicationID);
+			NumKept += AckedKey ? 1 : 0;
+			if (!AckedKey || *AckedKey != Entry.ReplicationKey)
+			{
+				Delta.PayloadBits += GetSerializedBits(Entry, Catalog);
+				++Delta.NumChanged;
+			}
+		}
+		Delta.NumDeleted = Acked.Num() - NumKept;
+		return Delta;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryReplicationRoundTripTest, "Outercorp.Replication.SlotRoundTrip",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInventoryReplicationRoundTripTest::RunTest(const FString& Parameters)
+{
+	const TArray<UInventoryItemData*> ItemTypes = MakeItemTypes();
+	const UInventoryItemCatalogSubsystem* Catalog = MakeCatalog(ItemTypes);
+	UInventoryTestPackageMap* Map = NewObject<UInventoryTestPackageMap>();
+
+	const auto TestRoundTrip = [&](const TCHAR* What, const FInventoryReplicatedSlot& Sent)
+	{
+		FInventoryReplicatedSlot Received;
+		TestTrue(FString::Printf(TEXT("%s: serialized"), What), RoundTrip(Sent, Received, Map, Catalog, Catalog));
+		TestTrue(FString::Printf(TEXT("%s: received as sent"), What), SameSlot(Sent, Received));
+		TestEqual(FString::Printf(TEXT("%s: nothing left to resolve"), What), Received.PendingNetIndex, static_cast<int32>(INDEX_NONE));
+	};
+
+	TestRoundTrip(TEXT("Single item"), MakeEntry(ItemTypes[3], 1));
+	TestRoundTrip(TEXT("Stack"), MakeEntry(ItemTypes[7], 12345));
+	TestRoundTrip(TEXT("Known keys"), MakeEntry(ItemTypes[0], 1, { { TEXT("Durability"), TEXT("87") }, { TEXT("Bound"), TEXT("true") } }));
+	TestRoundTrip(TEXT("Unknown keys"), MakeEntry(ItemTypes[1], 3, { { TEXT("Charge"), TEXT("-12") }, { TEXT("Sealed"), TEXT("false") }, { TEXT("Crafter"), TEXT("Player 7") } }));
+
+	// Only canonical integers and lowercase booleans are packed, anything else must come back as written
+	TestRoundTrip(TEXT("Number-like strings"), MakeEntry(ItemTypes[2], 2, { { TEXT("Durability"), TEXT("007") }, { TEXT("Bound"), TEXT("True") }, { TEXT("Serial"), TEXT("-0") }, { TEXT("Empty"), FString() } }));
+	TestRoundTrip(TEXT("Extreme integers"), MakeEntry(ItemTypes[4], MAX_int32, { { TEXT("Min"), TEXT("-999999999999999999") }, { TEXT("Max"), TEXT("999999999999999999") } }));
+
+	// Types without a network index go as an object reference
+	UInventoryItemData* Uncatalogued = MakeReplicationItem(NumReplicationItemTypes);
+	TestRoundTrip(TEXT("Item reference"), MakeEntry(Uncatalogued, 5, { { TEXT("Durability"), TEXT("1") } }));
+	TestTrue(TEXT("Item reference went through the package map"), Map->Objects.Contains(Uncatalogued));
+
+	{
+		FInventoryReplicatedSlot Received;
+		TestFalse(TEXT("Item reference without a package map fails"), RoundTrip(MakeEntry(Uncatalogued, 1), Received, nullptr, Catalog, Catalog));
+	}
+
+	// A client whose catalog is still loading resolves the type once it has loaded
+	UInventoryItemCatalogSubsystem* ClientCatalog = MakeCatalog(ItemTypes, false);
+	FInventoryReplicatedSlots ClientSlots;
+	FInventoryReplicatedSlot& Received = ClientSlots.Slots.AddDefaulted_GetRef();
+	const FInventoryReplicatedSlot Sent = MakeEntry(ItemTypes[9], 4, { { TEXT("Bound"), TEXT("false") } });
+	TestTrue(TEXT("Received while loading"), RoundTrip(Sent, Received, Map, Catalog, ClientCatalog));
+	TestNull(TEXT("Type unresolved while loading"), Received.ItemData.Get());
+	TestEqual(TEXT("Type kept for later"), Received.PendingNetIndex, Catalog->GetNetIndex(ItemTypes[9]));
+	TestEqual(TEXT("Nothing resolves before the load"), ClientSlots.ResolvePendingItems(ClientCatalog), 0);
+
+	ClientCatalog->SetItemsForTests(ItemTypes);
+	TestEqual(TEXT("Resolved after the load"), ClientSlots.ResolvePendingItems(ClientCatalog), 1);
+	TestTrue(TEXT("Resolved entry matches what was sent"), SameSlot(Sent, ClientSlots.Slots[0]));
+	TestEqual(TEXT("Nothing left pending"), ClientSlots.ResolvePendingItems(ClientCatalog), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryReplicationBandwidthBenchmark, "Outercorp.Replication.Benchmark.BitsPerMutation",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FInventoryReplicationBandwidthBenchmark::RunTest(const FString& Parameters)
+{
+	const TArray<UInventoryItemData*> ItemTypes = MakeItemTypes();
+	const UInventoryItemCatalogSubsystem* Catalog = MakeCatalog(ItemTypes);
+
+	// A backpack and a hangar
+	for (const int32 NumSlots : { 30, 5000 })
+	{
+		// Four slots in five hold a stack, so slots 4, 9, 14... start empty
+		TArray<FInventoryItem> Items;
+		Items.SetNum(NumSlots);
+		FInventoryReplicatedSlots Mirror;
+		for (int32 i = 0; i < NumSlots; ++i)
+		{
+			if (i % 5 != 4)
+			{
+				Items[i] = MakeStack(ItemTypes, i);
+				Mirror.SetSlot(i, Items[i]);
+			}
+		}
+
+		// What a new observer is sent
+		const int64 InitialBits = MeasureDelta(TMap<int32, int32>(), Mirror, Catalog).GetTotalBits();
+		AddInfo(FString::Printf(TEXT("%d slots, %d stacks: initial send %lld bits (%.1f KB)"), NumSlots, Mirror.Slots.Num(), InitialBits, InitialBits / 8192.0));
+
+		const auto Measure = [&](const TCHAR* Mutation, TFunctionRef<void()> Mutate)
+		{
+			const TMap<int32, int32> Acked = GetReplicationKeys(Mirror);
+			Mutate();
+			const FDeltaBits Delta = MeasureDelta(Acked, Mirror, Catalog);
+			const int64 FullBits = MeasureDelta(TMap<int32, int32>(), Mirror, Catalog).GetTotalBits();
+
+			AddInfo(FString::Printf(TEXT("%d slots, %s: %lld bits (%lld payload, %d changed, %d removed) against %lld for the whole array"),
+				NumSlots, Mutation, Delta.GetTotalBits(), Delta.PayloadBits, Delta.NumChanged, Delta.NumDeleted, FullBits));
+			TestTrue(FString::Printf(TEXT("%d slots, %s: only the touched entries are sent"), NumSlots, Mutation), Delta.NumChanged + Delta.NumDeleted <= 2);
+		};
+
+		Measure(TEXT("quantity change"), [&]()
+		{
+			Items[1].Quantity += 1;
+			Mirror.SetSlot(1, Items[1]);
+		});
+
+		Measure(TEXT("new stack"), [&]()
+		{
+			Items[4] = FInventoryItem(ItemTypes[3], 1);
+			Mirror.SetSlot(4, Items[4]);
+		});
+
+		Measure(TEXT("durability change"), [&]()
+		{
+			Items[0].InstanceMetadata.Add(TEXT("Durability"), TEXT("97"));
+			Mirror.SetSlot(0, Items[0]);
+		});
+
+		Measure(TEXT("move to an empty slot"), [&]()
+		{
+			Items[9] = Items[8];
+			Items[8] = FInventoryItem();
+			Mirror.SetSlot(9, Items[9]);
+			Mirror.SetSlot(8, Items[8]);
+		});
+
+		Measure(TEXT("split"), [&]()
+		{
+			const int32 Half = Items[13].Quantity / 2;
+			Items[13].Quantity -= Half;
+			Items[14] = FInventoryItem(Items[13].ItemData, Half);
+			Mirror.SetSlot(13, Items[13]);
+			Mirror.SetSlot(14, Items[14]);
+		});
+
+		Measure(TEXT("removed stack"), [&]()
+		{
+			Items[2] = FInventoryItem();
+			Mirror.SetSlot(2, Items[2]);
+		});
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/CoreNet.h"
+#include "InventoryTestPackageMap.generated.h"
+
+/**
+ * Package map for serialization tests, without a connection
+ * Objects go as their index in a table shared by the writing and the reading side.
+ */
+UCLASS(Transient)
+class UInventoryTestPackageMap : public UPackageMap
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID = nullptr) override
+	{
+		uint32 Index = Ar.IsSaving() ? static_cast<uint32>(Objects.AddUnique(Obj)) : 0;
+		Ar.SerializeIntPacked(Index);
+		if (Ar.IsLoading())
+		{
+			Obj = Objects.IsValidIndex(static_cast<int32>(Index)) ? Objects[Index].Get() : nullptr;
+		}
+		return true;
+	}
+
+	/** Every object serialized so far */
+	UPROPERTY()
+	TArray<TObjectPtr<UObject>> Objects;
+};
@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryPredictionComponent.h"
+#include "InventoryTestPredictionComponent.generated.h"
+
+/**
+ * Prediction component for tests, without a connection
+ * Operations and answers go to callbacks instead of RPCs, which carry them to the other side's
+ * component over a simulated network and hand them in through ReceiveOperation and ReceiveResult.
+ */
+UCLASS()
+class UInventoryTestPredictionComponent : public UInventoryPredictionComponent
+{
+	GENERATED_BODY()
+
+public:
+	TFunction<void(const FInventoryPredictedOperation&)> OnSendOperation;
+	TFunction<void(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial)> OnSendResult;
+
+	/** An operation arrived from the client (server side) */
+	void ReceiveOperation(const FInventoryPredictedOperation& Operation)
+	{
+		ExecuteOperation(Operation);
+	}
+
+	/** An answer arrived from the server (client side) */
+	void ReceiveResult(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial)
+	{
+		HandleOperationResult(PredictionKey, bAccepted, SourceChangeSerial, TargetChangeSerial);
+	}
+
+protected:
+	virtual void SendOperation(const FInventoryPredictedOperation& Operation) override
+	{
+		OnSendOperation(Operation);
+	}
+
+	virtual void SendResult(int32 PredictionKey, bool bAccepted, uint32 SourceChangeSerial, uint32 TargetChangeSerial) override
+	{
+		OnSendResult(PredictionKey, bAccepted, SourceChangeSerial, TargetChangeSerial);
+	}
+};
@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "InventoryComponent.h"
+#include "LootTable.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	UInventoryItemData* MakeLootItem(int32 Index)
+	{
+		UInventoryItemData* Item = NewObject<UInventoryItemData>(GetTransientPackage());
+		Item->ItemID = FName(TEXT("LootItem"), Index);
+		Item->Rarity = static_cast<EItemRarity>(Index % 5);
+		Item->Category = static_cast<EItemCategory>(Index % 7);
+		Item->MaxStackSize = (Index % 3 == 0) ? 1 : 100;
+		Item->Weight = 0.1f;
+		return Item;
+	}
+
+	/** 64 items across rarities and categories, plus a nested table of 16 more rolled up to 3 times */
+	ULootTable* MakeBenchmarkTable()
+	{
+		ULootTable* Nested = NewObject<ULootTable>(GetTransientPackage());
+		for (int32 i = 0; i < 16; ++i)
+		{
+			FLootTableEntry& Entry = Nested->Entries.AddDefaulted_GetRef();
+			Entry.Item = MakeLootItem(1000 + i);
+			Entry.Weight = 1.0f + i;
+			Entry.MaxQuantity = 5;
+		}
+
+		ULootTable* Table = NewObject<ULootTable>(GetTransientPackage());
+		Table->MinRolls = 2;
+		Table->MaxRolls = 6;
+		Table->RarityWeightScale.Add(EItemRarity::Legendary, 0.05f);
+		Table->RarityWeightScale.Add(EItemRarity::Epic, 0.2f);
+		for (int32 i = 0; i < 64; ++i)
+		{
+			FLootTableEntry& Entry = Table->Entries.AddDefaulted_GetRef();
+			Entry.Item = MakeLootItem(i);
+			Entry.Weight = 1.0f + (i % 10);
+			Entry.MaxQuantity = 20;
+		}
+
+		FLootTableEntry& NestedEntry = Table->Entries.AddDefaulted_GetRef();
+		NestedEntry.SubTable = Nested;
+		NestedEntry.Weight = 8.0f;
+		NestedEntry.MaxQuantity = 3;
+
+		return Table;
+	}
+
+	UInventoryComponent* MakeContainer()
+	{
+		UInventoryComponent* Container = NewObject<UInventoryComponent>(GetTransientPackage());
+		Container->SetMaxSlots(30);
+		return Container;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLootTableDeterminismTest, "Outercorp.Loot.Determinism",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FLootTableDeterminismTest::RunTest(const FString& Parameters)
+{
+	const ULootTable* Table = MakeBenchmarkTable();
+
+	TArray<FItemQuantity> First;
+	TArray<FItemQuantity> Second;
+	FRandomStream FirstStream(1234);
+	FRandomStream SecondStream(1234);
+	Table->RollLoot(FirstStream, First);
+	Table->RollLoot(SecondStream, Second);
+
+	TestTrue(TEXT("A roll produces loot"), First.Num() > 0);
+	if (TestEqual(TEXT("Same seed, same number of stacks"), Second.Num(), First.Num()))
+	{
+		for (int32 i = 0; i < First.Num(); ++i)
+		{
+			TestTrue(FString::Printf(TEXT("Same seed, same stack %d"), i), First[i].ItemData == Second[i].ItemData && First[i].Quantity == Second[i].Quantity);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLootTableBenchmark, "Outercorp.Loot.Benchmark.10kContainers",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FLootTableBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumContainers = 10000;
+
+	const ULootTable* Table = MakeBenchmarkTable();
+
+	TArray<UInventoryComponent*> Containers;
+	Containers.Reserve(NumContainers);
+	for (int32 i = 0; i < NumContainers; ++i)
+	{
+		Containers.Add(MakeContainer());
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	Table->GenerateLootBatch(Containers, 42);
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	int64 NumStacks = 0;
+	for (const UInventoryComponent* Container : Containers)
+	{
+		NumStacks += Container->GetOccupiedSlots();
+	}
+
+	AddInfo(FString::Printf(TEXT("Generated loot for %d containers (%lld stacks) in %.2f ms, %.2f us per container"),
+		NumContainers, NumStacks, Elapsed * 1000.0, Elapsed * 1000000.0 / NumContainers));
+	TestTrue(TEXT("Containers received loot"), NumStacks >= NumContainers);
+
+	// GenerateLoot per container for comparison, reusing one container (includes clearing it)
+	UInventoryComponent* Single = MakeContainer();
+	const double SingleStart = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumContainers; ++i)
+	{
+		Single->ClearInventory();
+		Table->GenerateLoot(Single, i);
+	}
+	const double SingleElapsed = FPlatformTime::Seconds() - SingleStart;
+	AddInfo(FString::Printf(TEXT("GenerateLoot one container at a time: %.2f ms for %d rolls"), SingleElapsed * 1000.0, NumContainers));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,310 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "InventoryComponent.h"
+#include "InventoryItemData.h"
+#include "MarketOrderBook.h"
+#include "MarketSubsystem.h"
+#include "OutercorpTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Prices around 100, so most orders cross the spread */
+	int64 RandomPrice(FRandomStream& Random)
+	{
+		return 100 + Random.RandRange(-10, 10);
+	}
+
+	UInventoryItemData* MakeCommodity(FName ItemID)
+	{
+		UInventoryItemData* Item = NewObject<UInventoryItemData>(GetTransientPackage());
+		Item->ItemID = ItemID;
+		Item->MaxStackSize = MAX_int32;
+		Item->Weight = 0.0f;
+		return Item;
+	}
+
+	UInventoryComponent* MakeTrader(UWorld* World, int32 NumSlots)
+	{
+		UInventoryComponent* Trader = NewObject<UInventoryComponent>(World);
+		Trader->SetMaxSlots(NumSlots);
+		return Trader;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMarketBenchmark, "Outercorp.Market.Benchmark.50kOrders",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FMarketBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumOrders = 50000;
+	constexpr int32 CancelPercent = 20;
+
+	// The book on its own: every unit submitted is filled, cancelled or still resting
+	{
+		FRandomStream Random(42);
+		FMarketOrderBook Book;
+		TArray<FMarketFill> Fills;
+		TArray<FMarketOrderId> Placed;
+
+		int64 Submitted[2] = {0, 0};
+		int64 Cancelled[2] = {0, 0};
+		int64 Filled = 0;
+		int32 NumFills = 0;
+		bool bFillsWithinLimits = true;
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumOrders; ++i)
+		{
+			FMarketOrderInfo Info;
+			if (Placed.Num() > 0 && Random.RandRange(0, 99) < CancelPercent)
+			{
+				const int32 Index = Random.RandRange(0, Placed.Num() - 1);
+				if (Book.CancelOrder(Placed[Index], Info))
+				{
+					Cancelled[static_cast<int32>(Info.Side)] += Info.RemainingQuantity;
+				}
+				Placed.RemoveAtSwap(Index);
+				continue;
+			}
+
+			const EMarketSide Side = Random.RandRange(0, 1) == 0 ? EMarketSide::Buy : EMarketSide::Sell;
+			const int32 Quantity = Random.RandRange(1, 20);
+			Submitted[static_cast<int32>(Side)] += Quantity;
+
+			Fills.Reset();
+			const FMarketOrderId OrderId = Book.SubmitOrder(Side, Random.RandRange(0, 99), RandomPrice(Random), Quantity, Fills);
+			if (Book.GetOrder(OrderId, Info))
+			{
+				Placed.Add(OrderId);
+			}
+
+			for (const FMarketFill& Fill : Fills)
+			{
+				Filled += Fill.Quantity;
+				bFillsWithinLimits &= Fill.Price <= Fill.BuyerLimitPrice;
+			}
+			NumFills += Fills.Num();
+		}
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+		TArray<FMarketOrderInfo> Resting;
+		Book.CancelAllOrders(Resting);
+		for (const FMarketOrderInfo& Info : Resting)
+		{
+			Cancelled[static_cast<int32>(Info.Side)] += Info.RemainingQuantity;
+		}
+
+		AddInfo(FString::Printf(TEXT("Order book: %d inserts and cancels in %.2f ms (%.3f us each), %d fills"),
+			NumOrders, Elapsed * 1000.0, Elapsed * 1000000.0 / NumOrders, NumFills));
+
+		TestTrue(TEXT("Orders crossed"), NumFills > 0);
+		TestTrue(TEXT("No buyer paid above their limit"), bFillsWithinLimits);
+		TestEqual(TEXT("Buy units filled or cancelled"), Submitted[static_cast<int32>(EMarketSide::Buy)], Filled + Cancelled[static_cast<int32>(EMarketSide::Buy)]);
+		TestEqual(TEXT("Sell units filled or cancelled"), Submitted[static_cast<int32>(EMarketSide::Sell)], Filled + Cancelled[static_cast<int32>(EMarketSide::Sell)]);
+		TestEqual(TEXT("Book empty"), Book.NumOrders(), 0);
+	}
+
+	// The market: escrow, end-of-frame settlement and the refund of resting orders at teardown
+	constexpr int32 NumTraders = 100;
+	constexpr int32 NumItemTypes = 4;
+	constexpr int32 OrdersPerFrame = 100;
+	constexpr int32 StartingItems = 1000;
+	constexpr int64 StartingBalance = 1000000;
+
+	FOutercorpTestWorld TestWorld;
+	UMarketSubsystem* Market = TestWorld.Get()->GetSubsystem<UMarketSubsystem>();
+	if (!TestNotNull(TEXT("Market subsystem"), Market))
+	{
+		return false;
+	}
+
+	TArray<UInventoryItemData*> ItemTypes;
+	for (int32 i = 0; i < NumItemTypes; ++i)
+	{
+		ItemTypes.Add(MakeCommodity(FName(TEXT("Commodity"), i)));
+	}
+
+	TArray<UInventoryComponent*> Traders;
+	for (int32 i = 0; i < NumTraders; ++i)
+	{
+		UInventoryComponent* Trader = MakeTrader(TestWorld.Get(), NumItemTypes);
+		for (UInventoryItemData* ItemData : ItemTypes)
+		{
+			int32 Slot = INDEX_NONE;
+			Trader->AddItem(ItemData, StartingItems, Slot);
+		}
+		Market->Deposit(Trader, StartingBalance);
+		Traders.Add(Trader);
+	}
+
+	auto CountItems = [&Traders, &ItemTypes]()
+	{
+		int64 Total = 0;
+		for (const UInventoryComponent* Trader : Traders)
+		{
+			for (const UInventoryItemData* ItemData : ItemTypes)
+			{
+				Total += Trader->GetItemCount(ItemData);
+			}
+		}
+		return Total;
+	};
+
+	auto CountBalances = [Market, &Traders]()
+	{
+		int64 Total = 0;
+		for (UInventoryComponent* Trader : Traders)
+		{
+			Total += Market->GetBalance(Trader);
+		}
+		return Total;
+	};
+
+	struct FPlacedOrder
+	{
+		UInventoryComponent* Trader = nullptr;
+		UInventoryItemData* ItemData = nullptr;
+		int64 OrderId = 0;
+	};
+
+	FRandomStream Random(7);
+	TArray<FPlacedOrder> Placed;
+	int32 NumTrades = 0;
+	Market->OnTradesSettled.AddWeakLambda(Market, [&NumTrades](const TArray<FMarketTrade>& Trades)
+	{
+		NumTrades += Trades.Num();
+	});
+
+	double OrderElapsed = 0.0;
+	double SettleElapsed = 0.0;
+	double WorstSettle = 0.0;
+	int32 NumCancels = 0;
+
+	for (int32 i = 0; i < NumOrders; ++i)
+	{
+		const double OrderStart = FPlatformTime::Seconds();
+		if (Placed.Num() > 0 && Random.RandRange(0, 99) < CancelPercent)
+		{
+			const int32 Index = Random.RandRange(0, Placed.Num() - 1);
+			const FPlacedOrder& Order = Placed[Index];
+			NumCancels += Market->CancelOrder(Order.Trader, Order.ItemData, Order.OrderId) ? 1 : 0;
+			Placed.RemoveAtSwap(Index);
+		}
+		else
+		{
+			FPlacedOrder& Order = Placed.AddDefaulted_GetRef();
+			Order.Trader = Traders[Random.RandRange(0, NumTraders - 1)];
+			Order.ItemData = ItemTypes[Random.RandRange(0, NumItemTypes - 1)];
+
+			const int32 Quantity = Random.RandRange(1, 20);
+			const int64 Price = RandomPrice(Random);
+			Order.OrderId = Random.RandRange(0, 1) == 0
+				? Market->PlaceBuyOrder(Order.Trader, Order.ItemData, Quantity, Price)
+				: Market->PlaceSellOrder(Order.Trader, Order.ItemData, Quantity, Price);
+			if (Order.OrderId == 0)
+			{
+				Placed.Pop();
+			}
+		}
+		OrderElapsed += FPlatformTime::Seconds() - OrderStart;
+
+		// End of a frame
+		if ((i + 1) % OrdersPerFrame == 0)
+		{
+			const double SettleStart = FPlatformTime::Seconds();
+			Market->SettlePendingTrades();
+			const double FrameElapsed = FPlatformTime::Seconds() - SettleStart;
+			SettleElapsed += FrameElapsed;
+			WorstSettle = FMath::Max(WorstSettle, FrameElapsed);
+		}
+	}
+	Market->SettlePendingTrades();
+
+	AddInfo(FString::Printf(TEXT("Market: %d orders and cancels in %.2f ms (%.3f us each), %d cancelled, %d trades"),
+		NumOrders, OrderElapsed * 1000.0, OrderElapsed * 1000000.0 / NumOrders, NumCancels, NumTrades));
+	AddInfo(FString::Printf(TEXT("Settlement: %.2f ms over %d frames, worst frame %.3f ms"),
+		SettleElapsed * 1000.0, NumOrders / OrdersPerFrame, WorstSettle * 1000.0));
+
+	const int64 TotalItems = static_cast<int64>(NumTraders) * NumItemTypes * StartingItems;
+	const int64 TotalBalance = static_cast<int64>(NumTraders) * StartingBalance;
+
+	TestTrue(TEXT("Orders traded"), NumTrades > 0);
+
+	// Cancelling whatever still rests returns all escrow, so everything balances out once settled
+	for (const FPlacedOrder& Order : Placed)
+	{
+		Market->CancelOrder(Order.Trader, Order.ItemData, Order.OrderId);
+	}
+	Placed.Reset();
+	Market->SettlePendingTrades();
+	TestEqual(TEXT("Every item accounted for after settlement"), CountItems(), TotalItems);
+	TestEqual(TEXT("Every unit of currency accounted for after settlement"), CountBalances(), TotalBalance);
+
+	// Leave orders resting, priced apart so they don't cross: they are refunded when teardown begins, before inventories end play
+	for (int32 i = 0; i < OrdersPerFrame; ++i)
+	{
+		UInventoryComponent* Trader = Traders[i % NumTraders];
+		UInventoryItemData* ItemData = ItemTypes[i % NumItemTypes];
+		if (i % 2 == 0)
+		{
+			Market->PlaceBuyOrder(Trader, ItemData, 10, 50);
+		}
+		else
+		{
+			Market->PlaceSellOrder(Trader, ItemData, 10, 150);
+		}
+	}
+	Market->SettlePendingTrades();
+	TestTrue(TEXT("Items in escrow"), CountItems() < TotalItems);
+	TestTrue(TEXT("Currency in escrow"), CountBalances() < TotalBalance);
+
+	TestWorld.Get()->BeginTearingDown();
+	TestEqual(TEXT("Every item back after the teardown refund"), CountItems(), TotalItems);
+	TestEqual(TEXT("Every unit of currency back after the teardown refund"), CountBalances(), TotalBalance);
+
+	TestWorld.Destroy();
+	TestEqual(TEXT("Deinitialize refunds nothing twice"), CountItems(), TotalItems);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMarketOverflowingPriceTest, "Outercorp.Market.RejectsOverflowingPrice",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMarketOverflowingPriceTest::RunTest(const FString& Parameters)
+{
+	FOutercorpTestWorld TestWorld;
+	UMarketSubsystem* Market = TestWorld.Get()->GetSubsystem<UMarketSubsystem>();
+	if (!TestNotNull(TEXT("Market subsystem"), Market))
+	{
+		return false;
+	}
+
+	UInventoryItemData* Ore = MakeCommodity(TEXT("Ore"));
+	UInventoryComponent* Buyer = MakeTrader(TestWorld.Get(), 1);
+	UInventoryComponent* Seller = MakeTrader(TestWorld.Get(), 1);
+	int32 Slot = INDEX_NONE;
+	Seller->AddItem(Ore, 100, Slot);
+	Market->Deposit(Buyer, 1000);
+
+	// Price * Quantity wraps negative in int64, which would pass the balance check and mint currency
+	const int64 HugePrice = MAX_int64 / 2 + 1;
+	TestEqual(TEXT("Overflowing buy order rejected"), Market->PlaceBuyOrder(Buyer, Ore, 4, HugePrice), static_cast<int64>(0));
+	TestEqual(TEXT("Overflowing sell order rejected"), Market->PlaceSellOrder(Seller, Ore, 4, HugePrice), static_cast<int64>(0));
+	Market->SettlePendingTrades();
+
+	TestEqual(TEXT("Buyer's balance unchanged"), Market->GetBalance(Buyer), static_cast<int64>(1000));
+	TestEqual(TEXT("Seller's items unchanged"), Seller->GetItemCount(Ore), 100);
+
+	// The largest price that fits is still an ordinary order, refused only for lack of funds
+	TestEqual(TEXT("Unaffordable buy order refused"), Market->PlaceBuyOrder(Buyer, Ore, 4, MAX_int64 / 4), static_cast<int64>(0));
+	TestEqual(TEXT("Balance still unchanged"), Market->GetBalance(Buyer), static_cast<int64>(1000));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,64 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+/**
+ * Game world that lives for the scope of an automation test
+ * World subsystems are created and initialized; nothing ticks on its own, tests call Tick
+ * themselves and move time forward with AdvanceTime.
+ */
+class FOutercorpTestWorld
+{
+public:
+	FOutercorpTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->AddToRoot();
+	}
+
+	~FOutercorpTestWorld()
+	{
+		Destroy();
+	}
+
+	UWorld* Get() const { return World; }
+
+	/**
+	 * Tear the world down as the engine does, deinitializing its subsystems. Objects created in it stay
+	 * valid until the next garbage collection, so tests can check what subsystems left in them
+	 */
+	void Destroy()
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		World->BeginTearingDown();
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+		World = nullptr;
+	}
+
+	/** Move world time forward, as if DeltaSeconds of frames had passed */
+	void AdvanceTime(double DeltaSeconds)
+	{
+		World->TimeSeconds += DeltaSeconds;
+		World->RealTimeSeconds += DeltaSeconds;
+	}
+
+private:
+	UWorld* World = nullptr;
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS